@@ -327,7 +327,7 @@ void Extension::SendBinaryToServer(int subchannel)
 	if (subchannel > 255 || subchannel < 0)
 		CreateError("Error: Send Binary to Server was called with invalid subchannel %i; it must be between 0 and 255.", subchannel);
 	else
-		Cli.sendserver(subchannel, std::string_view(SendMsg, SendMsgSize), 2);
+		Cli.sendserver(subchannel, SendMsg, SendMsgSize, 2);
 
 	if (AutomaticallyClearBinary)
 		SendMsg_Clear();
@@ -341,7 +341,7 @@ void Extension::SendBinaryToChannel(int subchannel)
 	else if (selChannel->readonly())
 		CreateError("Error: Send Binary to Channel was called with read-only channel \"%s\".", selChannel->name().c_str());
 	else
-		selChannel->send(subchannel, std::string_view(SendMsg, SendMsgSize), 2);
+		selChannel->send(subchannel, SendMsg, SendMsgSize, 2);
 
 	if (AutomaticallyClearBinary)
 		SendMsg_Clear();
@@ -355,7 +355,7 @@ void Extension::SendBinaryToPeer(int subchannel)
 	else if (selPeer->readonly())
 		CreateError("Error: Send Binary to Peer was called with a read-only peer.");
 	else
-		selPeer->send(subchannel, std::string_view(SendMsg, SendMsgSize), 2);
+		selPeer->send(subchannel, SendMsg, SendMsgSize, 2);
 
 	if (AutomaticallyClearBinary)
 		SendMsg_Clear();
@@ -365,7 +365,7 @@ void Extension::BlastBinaryToServer(int subchannel)
 	if (subchannel > 255 || subchannel < 0)
 		CreateError("Error: Blast Binary to Server was called with invalid subchannel %i; it must be between 0 and 255.", subchannel);
 	else
-		Cli.blastserver(subchannel, std::string_view(SendMsg, SendMsgSize), 2);
+		Cli.blastserver(subchannel, SendMsg, SendMsgSize, 2);
 
 	if (AutomaticallyClearBinary)
 		SendMsg_Clear();
@@ -379,7 +379,7 @@ void Extension::BlastBinaryToChannel(int subchannel)
 	else if (selChannel->readonly())
 		CreateError("Error: Blast Binary to Channel was called with read-only channel \"%s\".", selChannel->name().c_str());
 	else
-		selChannel->blast(subchannel, std::string_view(SendMsg, SendMsgSize), 2);
+		selChannel->blast(subchannel, SendMsg, SendMsgSize, 2);
 
 	if (AutomaticallyClearBinary)
 		SendMsg_Clear();
@@ -393,7 +393,7 @@ void Extension::BlastBinaryToPeer(int subchannel)
 	else if (selPeer->readonly())
 		CreateError("Error: Blast Binary to Peer was called with a read-only peer.");
 	else
-		selPeer->blast(subchannel, std::string_view(SendMsg, SendMsgSize), 2);
+		selPeer->blast(subchannel, SendMsg, SendMsgSize, 2);
 
 	if (AutomaticallyClearBinary)
 		SendMsg_Clear();
@@ -464,10 +464,12 @@ void Extension::SendMsg_AddBinaryFromAddress(unsigned int address, int size)
 }
 void Extension::SendMsg_Clear()
 {
-	if (SendMsg)
+	// Keep the memory for the next message, unless it's unusually large
+	if (SendMsg && SendMsgCapacity > 64 * 1024)
 	{
-		free(SendMsg);
+		free(SendMsg - lacewing::relayclient::messageheadroom);
 		SendMsg = NULL;
+		SendMsgCapacity = 0;
 	}
 	SendMsgSize = 0;
 }
@@ -620,12 +622,16 @@ void Extension::SendMsg_CompressBinary()
 	// 4: precursor lw_ui32 with uncompressed size, required by Relay
 	// 256: if compression results in larger message, it shouldn't be *that* much larger.
 
-	unsigned char * output_buffer = (unsigned char *)malloc(4 + SendMsgSize +  256);
-	if (!output_buffer)
+	// The compressed message replaces SendMsg, so it needs the same headroom before it.
+	constexpr size_t headroom = lacewing::relayclient::messageheadroom;
+	const size_t outputCapacity = 4 + SendMsgSize + 256;
+	char * output_allocation = (char *)malloc(headroom + outputCapacity);
+	if (!output_allocation)
 	{
 		deflateEnd(&strm);
-		return CreateError("Error with compressing send binary, could not allocate %u bytes of memory.", 4U + SendMsgSize + 256U);
+		return CreateError("Error with compressing send binary, could not allocate %zu bytes of memory.", headroom + outputCapacity);
 	}
+	unsigned char * output_buffer = (unsigned char *)output_allocation + headroom;
 
 	// Store size as precursor - required by Relay
 	*(lw_ui32 *)output_buffer = SendMsgSize;
@@ -634,38 +640,42 @@ void Extension::SendMsg_CompressBinary()
 	strm.avail_in = SendMsgSize;
 
 	// Allocate memory for compression
-	strm.avail_out = SendMsgSize - 4;
+	strm.avail_out = outputCapacity - 4;
 	strm.next_out = output_buffer + 4;
 
 	ret = deflate(&strm, Z_FINISH);
 	if (ret != Z_STREAM_END)
 	{
 		const char *strmMsg = strm.msg ? strm.msg : "(no description)";
-		free(output_buffer);
+		free(output_allocation);
 		deflateEnd(&strm);
 		return CreateError("Error with compressing send binary, deflate() returned %i. Zlib error: %hs.", ret, strmMsg);
 	}
 
 	deflateEnd(&strm);
 
-	char * output_bufferResize = (char *)realloc(output_buffer, 4 + strm.total_out);
-	if (!output_bufferResize)
-	{
-		free(output_buffer); // realloc will not free on error
-		CreateError("Error with compressing send binary, reallocating memory to remove excess space after compression failed with error %i.", errno);
-		return;
-	}
+	// The excess space is kept as capacity for adding to the compressed message.
+	free(SendMsg - headroom);
 
-	free(SendMsg);
-
-	SendMsg = output_bufferResize;
+	SendMsg = (char *)output_buffer;
 	SendMsgSize = 4 + strm.total_out;
+	SendMsgCapacity = outputCapacity;
 }
 void Extension::RecvMsg_DecompressBinary()
 {
 	if (threadData->receivedMsg.content.size() <= 4)
 		return CreateError("Cannot decompress received binary; message is too small.");
 
+	// Lacewing provides a precursor to the compressed data, with uncompressed size.
+	lw_ui32 expectedUncompressedSize = *(lw_ui32 *)threadData->receivedMsg.content.data();
+	if (expectedUncompressedSize > globals->maxDecompressedSize)
+	{
+		return CreateError("Decompression failed; message anticipated to be too large. Expected %u byte output, maximum is %zu bytes.",
+			expectedUncompressedSize, globals->maxDecompressedSize);
+	}
+
+	const std::string_view inputData(threadData->receivedMsg.content.data() + sizeof(lw_ui32), threadData->receivedMsg.content.size() - sizeof(lw_ui32));
+
 	z_stream strm = { };
 	int ret = inflateInit(&strm);
 	if (ret)
@@ -674,39 +684,66 @@ void Extension::RecvMsg_DecompressBinary()
 		return CreateError("Decompression failed; error %d: %hs with initiating decompression.", ret, strmMsg);
 	}
 
-	// Lacewing provides a precursor to the compressed data, with uncompressed size.
-	lw_ui32 expectedUncompressedSize = *(lw_ui32 *)threadData->receivedMsg.content.data();
-	if (expectedUncompressedSize > 0x0F000000U)
-		return CreateError("Decompression failed; message anticipated to be too large. Expected %u byte output.", expectedUncompressedSize);
-
-	const std::string_view inputData(threadData->receivedMsg.content.data() + sizeof(lw_ui32), threadData->receivedMsg.content.size() - sizeof(lw_ui32));
-
-	std::unique_ptr<unsigned char[]> output_buffer;
+	// The precursor is only a claim by the sender, so don't allocate it all up front.
+	// Inflate in chunks straight into the output, growing it as it fills, up to the expected size.
+	std::string output;
+	size_t requested = (std::max)((size_t)4096, (std::min)((size_t)expectedUncompressedSize, (size_t)1024 * 1024));
 	try {
-		output_buffer = std::make_unique<unsigned char[]>(expectedUncompressedSize);
+		output.resize(requested);
+
+		strm.next_in = (unsigned char *)inputData.data();
+		strm.avail_in = inputData.size();
+		while (true)
+		{
+			if (strm.total_out == output.size())
+			{
+				// One byte over, so inflate can finish a message of exactly the expected size
+				if (output.size() > expectedUncompressedSize)
+				{
+					inflateEnd(&strm);
+					return CreateError("Decompression failed; message decompresses to more than the expected %u bytes.", expectedUncompressedSize);
+				}
+				requested = (std::min)(output.size() * 2, (size_t)expectedUncompressedSize + 1);
+				output.resize(requested);
+			}
+
+			strm.next_out = (unsigned char *)output.data() + strm.total_out;
+			strm.avail_out = output.size() - strm.total_out;
+			ret = inflate(&strm, Z_NO_FLUSH);
+			if (ret == Z_STREAM_END)
+				break;
+
+			// Z_BUF_ERROR with space left in output means the input ended early
+			if (strm.avail_in == 0 && strm.avail_out != 0 && (ret == Z_OK || ret == Z_BUF_ERROR))
+			{
+				inflateEnd(&strm);
+				return CreateError("Decompression failed; compressed data ended early.");
+			}
+			if (ret != Z_OK && ret != Z_BUF_ERROR)
+			{
+				const char * strmMsg = strm.msg ? strm.msg : "(no description)";
+				inflateEnd(&strm);
+				return CreateError("Error with decompression, inflate() returned error %i. Zlib description: %hs.", ret, strmMsg);
+			}
+		}
 	}
 	catch (std::bad_alloc)
 	{
 		inflateEnd(&strm);
-		return CreateError("Decompression failed; could not allocate enough memory. Requested %u bytes.", expectedUncompressedSize);
+		return CreateError("Decompression failed; could not allocate enough memory. Requested %zu bytes.", requested);
 	}
 
-	strm.next_in = (unsigned char *)inputData.data();
-	strm.avail_in = inputData.size();
-	strm.avail_out = expectedUncompressedSize;
-	strm.next_out = output_buffer.get();
-	ret = inflate(&strm, Z_FINISH);
-	if (ret < Z_OK)
+	inflateEnd(&strm);
+
+	if (strm.total_out != expectedUncompressedSize)
 	{
-		const char *strmMsg = strm.msg ? strm.msg : "(no description)";
-		inflateEnd(&strm);
-		return CreateError("Error with decompression, inflate() returned error %i. Zlib description: %hs.", ret, strmMsg);
+		return CreateError("Decompression failed; message decompressed to %lu bytes, but was expected to be %u bytes.",
+			strm.total_out, expectedUncompressedSize);
 	}
-
-	inflateEnd(&strm);
+	output.resize(strm.total_out);
 
 	// Used to assign all exts in a questionable way, but threadData is now std::shared_ptr, so no need.
-	threadData->receivedMsg.content.assign((char *)output_buffer.get(), expectedUncompressedSize);
+	threadData->receivedMsg.content = std::move(output);
 	threadData->receivedMsg.cursor = 0;
 }
 void Extension::RecvMsg_MoveCursor(int position)
@@ -825,16 +862,15 @@ void Extension::SendMsg_Resize(int newSize)
 	if (newSize < 0)
 		return CreateError("Cannot change size of binary to send: new size is under 0 bytes.");
 
-	char * NewMsg = (char *)realloc(SendMsg, newSize);
-	if (!NewMsg)
+	// An exact size, as the user is likely to fill it in rather than add to it
+	if ((size_t)newSize > SendMsgCapacity && !SendMsg_Sub_Reserve(newSize, true))
 	{
 		return CreateError("Cannot change size of binary to send: reallocation of memory failed. Size has not been modified.");
 	}
 	// Clear new bytes to 0
 	if ((size_t)newSize > SendMsgSize)
-		memset(NewMsg + SendMsgSize, 0, newSize - SendMsgSize);
+		memset(SendMsg + SendMsgSize, 0, newSize - SendMsgSize);
 
-	SendMsg = NewMsg;
 	SendMsgSize = newSize;
 }
 void Extension::SetDestroySetting(int enabled)
@@ -843,3 +879,47 @@ void Extension::SetDestroySetting(int enabled)
 		return CreateError("Invalid setting passed to SetDestroySetting, expecting 0 or 1.");
 	globals->fullDeleteEnabled = enabled != 0;
 }
+void Extension::SetMaxDecompressedSize(int size)
+{
+	if (size <= 0)
+		return CreateError("Cannot set maximum decompressed size: size %i is not above 0 bytes.", size);
+	globals->maxDecompressedSize = size;
+}
+void Extension::SendMsg_Reserve(int size)
+{
+	if (size < 0)
+		return CreateError("Cannot reserve memory for binary to send: size %i is under 0 bytes.", size);
+
+	if (!SendMsg_Sub_Reserve(size, true))
+		return CreateError("Cannot reserve memory for binary to send: allocation of %i bytes failed. The message has not been modified.", size);
+}
+void Extension::SendMsg_AddBinaryArrayFromAddress(unsigned int address, int elementSize, int count, int stride)
+{
+	// Address is checked in SendMsg_Sub_AddData()
+	if (elementSize < 0 || count < 0)
+		return CreateError("Add binary array failed: element size %i or count %i is less than 0.", elementSize, count);
+	if (stride == 0)
+		stride = elementSize;
+	else if (stride < elementSize)
+		return CreateError("Add binary array failed: stride %i is less than the element size %i.", stride, elementSize);
+
+	if (elementSize == 0 || count == 0)
+		return;
+	// On 32-bit, the total can be too large for size_t, and wrap round to a size that fits
+	if ((size_t)count > SIZE_MAX / elementSize || (size_t)elementSize * count > SIZE_MAX - SendMsgSize)
+		return CreateError("Add binary array failed: %i elements of %i bytes is too large. The message has not been modified.", count, elementSize);
+	const size_t total = (size_t)elementSize * count;
+
+	// Contiguous elements can go in one copy
+	if (stride == elementSize)
+		return SendMsg_Sub_AddData((void *)(long)address, total);
+
+	if (!IsValidPtr((void *)(long)address))
+		return CreateError("Add binary array failed: pointer %p supplied is invalid. The message has not been modified.", (void *)(long)address);
+	if (!SendMsg_Sub_Reserve(SendMsgSize + total))
+		return CreateError("Add binary array failed: allocation of %zu more bytes failed. The message has not been modified.", total);
+
+	const char * from = (const char *)(long)address;
+	for (int i = 0; i < count; ++i, from += stride)
+		SendMsg_Sub_AddData(from, elementSize);
+}
@@ -3,7 +3,7 @@
 
 const TCHAR * Extension::Error()
 {
-	return Runtime.CopyString(UTF8ToTString(threadData->error.text).c_str());
+	return Runtime.CopyUTF8String(threadData->error.text.data(), threadData->error.text.size());
 }
 const TCHAR * Extension::ReplacedExprNoParams()
 {
@@ -29,7 +29,7 @@ const TCHAR * Extension::RecvMsg_ReadAsString()
 		return Runtime.CopyString(_T(""));
 	}
 
-	return Runtime.CopyString(UTF8ToTString(threadData->receivedMsg.content).c_str());
+	return Runtime.CopyUTF8String(threadData->receivedMsg.content.data(), threadData->receivedMsg.content.size());
 }
 int Extension::RecvMsg_ReadAsInteger()
 {
@@ -97,6 +97,9 @@ Extension::Extension(RUNDATA * _rdPtr, EDITDATA * edPtr, CreateObjectInfo * cobP
 		LinkAction(73, Connect);
 		LinkAction(74, SendMsg_Resize);
 		LinkAction(75, SetDestroySetting);
+		LinkAction(76, SendMsg_Reserve);
+		LinkAction(77, SendMsg_AddBinaryArrayFromAddress);
+		LinkAction(78, SetMaxDecompressedSize);
 	}
 	{
 		LinkCondition(0, AlwaysTrue /* OnError */);
@@ -554,21 +557,49 @@ void Extension::SendMsg_Sub_AddData(const void * data, size_t size)
 	if (!size)
 		return;
 
-	char * newptr = (char *)realloc(SendMsg, SendMsgSize + size);
+	// Adding part of the message to itself; it may move when reserving
+	const bool isInsideMsg = SendMsg && data >= SendMsg && data < SendMsg + SendMsgSize;
+	const size_t offsetInMsg = isInsideMsg ? (const char *)data - SendMsg : 0;
 
-	// Failed to reallocate memory
-	if (!newptr)
+	if (!SendMsg_Sub_Reserve(SendMsgSize + size))
 		return CreateError("Received error number %u with reallocating memory to append to binary message. The message has not been modified.", errno);
 
+	if (isInsideMsg)
+		data = SendMsg + offsetInMsg;
+
 	// memcpy_s does not allow copying from what's already inside SendMsg; memmove_s does.
 
 	// If we failed to copy memory.
-	if (memmove_s(newptr + SendMsgSize, size, data, size))
+	if (memmove_s(SendMsg + SendMsgSize, SendMsgCapacity - SendMsgSize, data, size))
 		return CreateError("Received error number %u with copying memory into newly allocated binary message. The message has not been modified.", errno);
 
-	SendMsg = newptr;
 	SendMsgSize += size;
 }
+bool Extension::SendMsg_Sub_Reserve(size_t capacity, bool exact /* = false */)
+{
+	if (capacity <= SendMsgCapacity && (!exact || capacity == SendMsgCapacity))
+		return true;
+
+	// Grow geometrically, so adding a message piece by piece doesn't reallocate on every add.
+	// An exact size can shrink the buffer, but never below what's already in it.
+	if (!exact)
+		capacity = (std::max)(capacity, (std::max)(SendMsgCapacity * 2, (size_t)256));
+	else if (capacity < SendMsgSize)
+	{
+		capacity = SendMsgSize;
+		if (capacity == SendMsgCapacity)
+			return true;
+	}
+
+	constexpr size_t headroom = lacewing::relayclient::messageheadroom;
+	char * newptr = (char *)realloc(SendMsg ? SendMsg - headroom : nullptr, headroom + capacity);
+	if (!newptr)
+		return false;
+
+	SendMsg = newptr + headroom;
+	SendMsgCapacity = capacity;
+	return true;
+}
 bool Extension::IsValidPtr(const void * data)
 {
 	// Common error memory addresses; null pointer (0x0), uninitalized filler memory (0xCC/0xCD),
@@ -1151,7 +1182,7 @@ long Extension::Expression(int ID, RUNDATA * rdPtr, long param)
 GlobalInfo::GlobalInfo(Extension * e, EDITDATA * edPtr)
 	: _objEventPump(lacewing::eventpump_new(), eventpumpdeleter),
 	_client(_objEventPump.get()),
-	_sendMsg(nullptr), _sendMsgSize(0),
+	_sendMsg(nullptr), _sendMsgSize(0), _sendMsgCapacity(0),
 	_automaticallyClearBinary(edPtr->automaticClear), _thread(nullptr),
 	lastDestroyedExtSelectedChannel(), lastDestroyedExtSelectedPeer()
 {
@@ -1199,6 +1230,9 @@ GlobalInfo::~GlobalInfo() noexcept(false)
 	if (!pendingDelete)
 		MarkAsPendingDelete();
 
+	if (_sendMsg)
+		free(_sendMsg - lacewing::relayclient::messageheadroom);
+
 	// Holders trying to use MarkAsPendingDelete() secure themselves with this lock,
 	// so we don't delete in the MarkAsPendingDelete() but in dtor only
 	DeleteCriticalSection(&lock);
@@ -50,6 +50,7 @@ public:
 	#define SendMsg						globals->_sendMsg
 	#define DenyReasonBuffer			globals->_denyReasonBuffer
 	#define SendMsgSize					globals->_sendMsgSize
+	#define SendMsgCapacity				globals->_sendMsgCapacity
 	#define AutomaticallyClearBinary	globals->_automaticallyClearBinary
 	#define GlobalID					globals->_globalID
 	#define HostIP						globals->_hostIP
@@ -61,6 +62,7 @@ public:
 	void CreateError(_Printf_format_string_ const char * errU8, ...);
 
 	void SendMsg_Sub_AddData(const void *, size_t);
+	bool SendMsg_Sub_Reserve(size_t capacity, bool exact = false);
 	bool IsValidPtr(const void *);
 	void ClearThreadData();
 
@@ -144,6 +146,9 @@ public:
 		void Connect(const TCHAR * Hostname);
 		void SendMsg_Resize(int NewSize);
 		void SetDestroySetting(int enabled);
+		void SendMsg_Reserve(int Size);
+		void SendMsg_AddBinaryArrayFromAddress(unsigned int Address, int ElementSize, int Count, int Stride);
+		void SetMaxDecompressedSize(int Size);
 
 	/// Conditions
 
@@ -315,10 +320,13 @@ struct GlobalInfo
 	// Server's IP address, set during connect.
 	std::string _hostIP;
 
-	// Binary message to send
+	// Binary message to send. Allocated with lacewing::relayclient::messageheadroom bytes before it,
+	// so Lacewing can write its message header there and send without copying the binary.
 	char * _sendMsg;
 	// Number of bytes in binary message to send (sendMsg)
 	size_t _sendMsgSize;
+	// Number of bytes allocated for sendMsg, not including the headroom
+	size_t _sendMsgCapacity;
 	
 	// Previous name of this client, as UTF-8
 	std::string _previousName;
@@ -352,6 +360,8 @@ struct GlobalInfo
 	bool timeoutWarningEnabled;
 	// If no Bluewing exists after DestroyRunObject, clean up this GlobalInfo
 	bool fullDeleteEnabled;
+	// Largest output Decompress received binary will produce, in bytes
+	size_t maxDecompressedSize = 0x0F000000U;
 	// Used to determine if an error event happened in a Fusion event, e.g. user put in bad parameter.
 	// Fusion code always runs in main thread, but errors can occur outside of user input.
 	std::thread::id mainThreadID;
@@ -3,7 +3,7 @@
 
 const TCHAR * Extension::Error()
 {
-	return Runtime.CopyString(!threadData->error.text.empty() ? UTF8ToTString(threadData->error.text).c_str() : _T(""));
+	return Runtime.CopyUTF8String(threadData->error.text.data(), threadData->error.text.size());
 }
 unsigned int Extension::Channel_Count()
 {
@@ -22,7 +22,7 @@ const TCHAR * Extension::RecvMsg_ReadAsString()
 	
 	// RecvMsg_Sub_ReadString expects size in code points or a null terminator,
 	// but in a text message neither is present, so we'll just directly convert.
-	return Runtime.CopyString(UTF8ToTString(threadData->receivedMsg.content).c_str());
+	return Runtime.CopyUTF8String(threadData->receivedMsg.content.data(), threadData->receivedMsg.content.size());
 }
 int Extension::RecvMsg_ReadAsInteger()
 {
@@ -41,7 +41,7 @@ unsigned int Extension::Client_ID()
 }
 const TCHAR * Extension::RequestedClientName()
 {
-	return Runtime.CopyString(UTF8ToTString(threadData->requested.name).c_str());
+	return Runtime.CopyUTF8String(threadData->requested.name.data(), threadData->requested.name.size());
 }
 const TCHAR * Extension::RequestedChannelName()
 {
@@ -49,7 +49,7 @@ const TCHAR * Extension::RequestedChannelName()
 	if (threadData->CondTrig[0] == 4)
 		CreateError("Requested channel name is not available in a Leave Channel Request. Use Channel_Name$() instead.");
 
-	return Runtime.CopyString(UTF8ToTString(threadData->requested.name).c_str());
+	return Runtime.CopyUTF8String(threadData->requested.name.data(), threadData->requested.name.size());
 }
 unsigned int Extension::Client_ConnectionTime()
 {
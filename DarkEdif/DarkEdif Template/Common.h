@@ -4,6 +4,8 @@
 #define MMFEXT		// MMF2, MMF2 Dev
 // #define PROEXT	// MMF2 Dev only
 
+// #define DARKEDIF_ACE_PROFILER	// Time every action, condition and expression; see Edif::Profiler in Edif.h
+
 #ifdef RUN_ONLY
 	#define CurLang (*::SDK->json.u.object.values[::SDK->json.u.object.length - 1].value)
 #else
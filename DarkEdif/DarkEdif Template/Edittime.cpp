@@ -123,6 +123,9 @@ BOOL FusionAPI GetProperties(mv * mV, EDITDATA * edPtr, BOOL bMasterItem)
 		InitialisePropertiesFromJSON(mV, edPtr);
 		mvInvalidateObject(mV, edPtr);
 	}
+	// Properties saved flat by older DarkEdif, or by an older version of the extension with other properties
+	else if (MigrateProps(mV, edPtr))
+		mvInvalidateObject(mV, edPtr);
 
 	// OK
 	return TRUE;
@@ -157,7 +160,7 @@ BOOL FusionAPI GetPropCheck(mv * mV, EDITDATA * edPtr, unsigned int PropID_)
 	if (CurLang["Properties"].type == json_null || CurLang["Properties"].u.array.length <= PropID)
 		return FALSE;
 
-	return (edPtr->DarkEdif_Props[PropID >> 3] >> (PropID % 8) & 1);
+	return edPtr->IsPropChecked(PropID);
 }
 
 // Called by Fusion after a property has been modified.
@@ -0,0 +1,84 @@
+// DarkEdifJSONCompiler: compiles an extension's runtime JSON, as minified by DarkEdifPreBuildTool,
+// into a compiled JSON image (see json_compiled_header in json.h), which the extension then loads
+// with json_load_compiled() instead of parsing the JSON text.
+//
+// The image doesn't depend on the platform or architecture this tool is built for. It's part of
+// AllExts VS2019.sln, and FusionSDK.props builds it and runs it on every Runtime build, embedding
+// the image; a missing or mismatched image falls back on the JSON text.
+//
+// Usage: DarkEdifJSONCompiler <minified JSON file> <output image file>
+
+#include "JSONCompiler.h"
+#include <cstdio>
+#include <chrono>
+
+int main(int argc, char ** argv)
+{
+	if (argc != 3)
+	{
+		fprintf(stderr, "Usage: DarkEdifJSONCompiler <minified JSON file> <output image file>\n");
+		return 2;
+	}
+
+	FILE * file = fopen(argv[1], "rb");
+	if (!file)
+	{
+		fprintf(stderr, "DarkEdifJSONCompiler: couldn't open %s.\n", argv[1]);
+		return 1;
+	}
+
+	std::vector<char> text;
+	char buffer[16384];
+	size_t read;
+	while ((read = fread(buffer, 1, sizeof(buffer), file)) > 0)
+		text.insert(text.end(), buffer, buffer + read);
+	fclose(file);
+
+	char error[256];
+	json_settings settings = {};
+
+	auto parseStart = std::chrono::steady_clock::now();
+	json_value * root = json_parse_ex(&settings, text.data(), text.size(), error, sizeof(error));
+	auto parseEnd = std::chrono::steady_clock::now();
+
+	if (!root)
+	{
+		fprintf(stderr, "DarkEdifJSONCompiler: couldn't parse %s: %s\n", argv[1], error);
+		return 1;
+	}
+
+	JSONCompiler compiler;
+	std::vector<char> image = compiler.Compile(root);
+
+	auto loadStart = std::chrono::steady_clock::now();
+	json_value * loaded = json_load_compiled(image.data(), image.size(), error, sizeof(error));
+	auto loadEnd = std::chrono::steady_clock::now();
+
+	if (!loaded || !JSONSame(*root, *loaded))
+	{
+		fprintf(stderr, "DarkEdifJSONCompiler: compiled image doesn't match %s%s%s.\n", argv[1], loaded ? "" : ": ", loaded ? "" : error);
+		return 1;
+	}
+
+	const json_compiled_header * header = (const json_compiled_header *)image.data();
+	printf("DarkEdifJSONCompiler: %u values, %zu bytes of JSON -> %zu byte image (%zu bytes of strings, one allocation).\n"
+		"Parse took %lld us; compiled load took %lld us.\n",
+		header->value_count, text.size(), image.size(), compiler.StringBytes(),
+		(long long)std::chrono::duration_cast<std::chrono::microseconds>(parseEnd - parseStart).count(),
+		(long long)std::chrono::duration_cast<std::chrono::microseconds>(loadEnd - loadStart).count());
+
+	json_value_free(loaded);
+	json_value_free(root);
+
+	file = fopen(argv[2], "wb");
+	if (!file || fwrite(image.data(), 1, image.size(), file) != image.size())
+	{
+		fprintf(stderr, "DarkEdifJSONCompiler: couldn't write %s.\n", argv[2]);
+		if (file)
+			fclose(file);
+		return 1;
+	}
+
+	fclose(file);
+	return 0;
+}
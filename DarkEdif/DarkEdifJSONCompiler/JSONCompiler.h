@@ -0,0 +1,189 @@
+#pragma once
+
+// Lays out a parsed json_value tree as a compiled JSON image; see json_compiled_header in json.h.
+// Used by DarkEdifJSONCompiler, and by the harness in Lib/Shared/test.
+
+#include "json.h"
+#include <cstdint>
+#include <cstring>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+static_assert(sizeof(json_compiled_header) == 32 && sizeof(json_compiled_value) == 16 &&
+	sizeof(json_compiled_member) == 8, "Compiled JSON records must have no padding");
+
+class JSONCompiler
+{
+	std::vector<const json_value *> values;
+	std::unordered_map<const json_value *, unsigned int> indexOf;
+	std::vector<json_compiled_member> members;
+	std::vector<unsigned int> elements;
+	std::string strings;
+	std::unordered_map<std::string, unsigned int> stringAt;
+
+	// Depth first, so parents come before their children
+	void Collect(const json_value * value)
+	{
+		indexOf[value] = (unsigned int)values.size();
+		values.push_back(value);
+
+		if (value->type == json_object)
+		{
+			for (unsigned int i = 0; i < value->u.object.length; ++i)
+				Collect(value->u.object.values[i].value);
+		}
+		else if (value->type == json_array)
+		{
+			for (unsigned int i = 0; i < value->u.array.length; ++i)
+				Collect(value->u.array.values[i]);
+		}
+	}
+
+	// Merges duplicate strings, e.g. the many "Title" and "Parameters" member names
+	unsigned int AddString(const json_char * str, size_t length)
+	{
+		std::string key(str, length);
+		auto found = stringAt.find(key);
+		if (found != stringAt.end())
+			return found->second;
+
+		unsigned int at = (unsigned int)strings.size();
+		strings.append(key);
+		strings.push_back('\0');
+		stringAt.emplace(std::move(key), at);
+		return at;
+	}
+
+	template<class T>
+	static void Append(std::vector<char> &image, const T * items, size_t count)
+	{
+		image.insert(image.end(), (const char *)items, (const char *)(items + count));
+	}
+
+public:
+
+	std::vector<char> Compile(const json_value * root)
+	{
+		Collect(root);
+
+		std::vector<json_compiled_value> records(values.size());
+
+		for (size_t i = 0; i < values.size(); ++i)
+		{
+			const json_value * value = values[i];
+			json_compiled_value &record = records[i];
+			std::uint64_t bits = 0;
+
+			record.type = value->type;
+
+			switch (value->type)
+			{
+				case json_object:
+					record.length = value->u.object.length;
+					record.data[0] = (unsigned int)members.size();
+					for (unsigned int j = 0; j < value->u.object.length; ++j)
+					{
+						const json_char * name = value->u.object.values[j].name;
+						members.push_back({ AddString(name, strlen(name)), indexOf.at(value->u.object.values[j].value) });
+					}
+					break;
+				case json_array:
+					record.length = value->u.array.length;
+					record.data[0] = (unsigned int)elements.size();
+					for (unsigned int j = 0; j < value->u.array.length; ++j)
+						elements.push_back(indexOf.at(value->u.array.values[j]));
+					break;
+				case json_string:
+					record.length = value->u.string.length;
+					record.data[0] = AddString(value->u.string.ptr, value->u.string.length);
+					break;
+				case json_integer:
+				case json_double:
+					if (value->type == json_integer)
+						bits = (std::uint64_t)value->u.integer;
+					else
+						memcpy(&bits, &value->u.dbl, sizeof(bits));
+					record.data[0] = (unsigned int)bits;
+					record.data[1] = (unsigned int)(bits >> 32);
+					break;
+				case json_boolean:
+					record.data[0] = value->u.boolean ? 1 : 0;
+					break;
+				default:
+					break;
+			}
+		}
+
+		// The string table always ends in a terminator, even with no strings
+		if (strings.empty())
+			strings.push_back('\0');
+
+		json_compiled_header header = {};
+		header.magic = json_compiled_magic;
+		header.version = json_compiled_version;
+		header.value_count = (unsigned int)records.size();
+		header.member_count = (unsigned int)members.size();
+		header.element_count = (unsigned int)elements.size();
+		header.strings_size = (unsigned int)strings.size();
+		header.size = (unsigned int)(sizeof(header) + records.size() * sizeof(json_compiled_value) +
+			members.size() * sizeof(json_compiled_member) + elements.size() * sizeof(unsigned int) + strings.size());
+
+		// The records are all unsigned ints, which on the platforms Fusion runs on are little-endian
+		std::vector<char> image;
+		image.reserve(header.size);
+		Append(image, &header, 1);
+		Append(image, records.data(), records.size());
+		Append(image, members.data(), members.size());
+		Append(image, elements.data(), elements.size());
+		Append(image, strings.data(), strings.size());
+		return image;
+	}
+
+	size_t StringBytes() const
+	{
+		return strings.size();
+	}
+};
+
+// Whether two trees read the same, and every object member can be looked up by name
+static bool JSONSame(const json_value &a, const json_value &b)
+{
+	if (a.type != b.type)
+		return false;
+
+	switch (a.type)
+	{
+		case json_object:
+			if (a.u.object.length != b.u.object.length)
+				return false;
+			for (unsigned int i = 0; i < a.u.object.length; ++i)
+			{
+				if (strcmp(a.u.object.values[i].name, b.u.object.values[i].name) ||
+					!JSONSame(*a.u.object.values[i].value, *b.u.object.values[i].value) ||
+					&a[(const json_char *)a.u.object.values[i].name] == &json_value_none ||
+					b.u.object.values[i].value->parent != &b)
+				{
+					return false;
+				}
+			}
+			return true;
+		case json_array:
+			if (a.u.array.length != b.u.array.length)
+				return false;
+			for (unsigned int i = 0; i < a.u.array.length; ++i)
+				if (!JSONSame(*a.u.array.values[i], *b.u.array.values[i]) || b.u.array.values[i]->parent != &b)
+					return false;
+			return true;
+		case json_string:
+			return a.u.string.length == b.u.string.length && !memcmp(a.u.string.ptr, b.u.string.ptr, a.u.string.length + 1);
+		case json_integer:
+			return a.u.integer == b.u.integer;
+		case json_double:
+			return !memcmp(&a.u.dbl, &b.u.dbl, sizeof(a.u.dbl));
+		case json_boolean:
+			return a.u.boolean == b.u.boolean;
+		default:
+			return true;
+	}
+}
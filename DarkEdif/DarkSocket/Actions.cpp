@@ -166,6 +166,7 @@ void Extension::ClientShutdownSocket(int SocketID)
 	ThreadSafe_Start();
 	Senders.push_back(RevCarryMsg(Commands::SHUTDOWNTHREAD, SocketID));
 	ThreadSafe_End();
+	Loop->Wake();
 }
 // ID = 5
 void Extension::ClientSend(int SocketID, TCHAR * Message)
@@ -175,8 +176,11 @@ void Extension::ClientSend(int SocketID, TCHAR * Message)
 	// Send formed packet
 	if (_tcscmp(Message, _T("PACKET")) == 0)
 	{
-		r.Message = PacketFormLocation;
-		r.MessageSize = PacketFormSize;
+		// Copied, as the packet can be changed or freed before the event loop sends it
+		r.Message = malloc(PacketFormSize);
+		if (r.Message)
+			memcpy(r.Message, PacketFormLocation, PacketFormSize);
+		r.MessageSize = r.Message ? PacketFormSize : 0;
 	}
 	// Otherwise send the text
 	else
@@ -184,8 +188,9 @@ void Extension::ClientSend(int SocketID, TCHAR * Message)
 		r.Message = _tcsdup(Message);
 		r.MessageSize = (_tcslen(Message) + 1) * sizeof(TCHAR);
 	}
-	Senders.push_back(r);
+	Senders.push_back(std::move(r));
 	ThreadSafe_End();
+	Loop->Wake();
 }
 // ID = 6
 void Extension::ClientGoIndependent(int SocketID)
@@ -193,6 +198,7 @@ void Extension::ClientGoIndependent(int SocketID)
 	ThreadSafe_Start();
 	Senders.push_back(RevCarryMsg(Commands::GOINDEPENDENT, SocketID));
 	ThreadSafe_End();
+	Loop->Wake();
 }
 // ID = 7
 void Extension::ClientReceiveOnly(int SocketID)
@@ -200,15 +206,17 @@ void Extension::ClientReceiveOnly(int SocketID)
 	ThreadSafe_Start();
 	Senders.push_back(RevCarryMsg(Commands::RECEIVEONLY, SocketID));
 	ThreadSafe_End();
+	Loop->Wake();
 }
 // ID = 8
 void Extension::ClientLinkFileOutput(int SocketID, TCHAR * File)
 {
 	ThreadSafe_Start();
 	RevCarryMsg r(Commands::LINKOUTPUTTOFILE, SocketID);
-	r.Message = File;
-	Senders.push_back(r);
+	r.Message = _tcsdup(File);
+	Senders.push_back(std::move(r));
 	ThreadSafe_End();
+	Loop->Wake();
 }
 // ID = 9
 void Extension::ClientUnlinkFileOutput(int SocketID)
@@ -216,6 +224,7 @@ void Extension::ClientUnlinkFileOutput(int SocketID)
 	ThreadSafe_Start();
 	Senders.push_back(RevCarryMsg(Commands::UNLINKFILEOUTPUT, SocketID));
 	ThreadSafe_End();
+	Loop->Wake();
 }
 // ID = 10
 void Extension::ClientMMF2Report(int SocketID, int OnOrOff)
@@ -223,6 +232,7 @@ void Extension::ClientMMF2Report(int SocketID, int OnOrOff)
 	ThreadSafe_Start();
 	Senders.push_back(RevCarryMsg(OnOrOff ? Commands::MMFREPORTON : Commands::MMFREPORTOFF, SocketID));
 	ThreadSafe_End();
+	Loop->Wake();
 }
 
 
@@ -324,6 +334,7 @@ void Extension::ServerShutdownSocket(int SocketID)
 	ThreadSafe_Start();
 	Senders.push_back(RevCarryMsg(Commands::SHUTDOWNTHREAD, SocketID));
 	ThreadSafe_End();
+	Loop->Wake();
 }
 // ID = 14
 void Extension::ServerSend(int SocketID, TCHAR * Message)
@@ -333,8 +344,11 @@ void Extension::ServerSend(int SocketID, TCHAR * Message)
 	// Send formed packet
 	if (_tcscmp(Message, _T("PACKET")) == 0)
 	{
-		r.Message = PacketFormLocation;
-		r.MessageSize = PacketFormSize;
+		// Copied, as the packet can be changed or freed before the event loop sends it
+		r.Message = malloc(PacketFormSize);
+		if (r.Message)
+			memcpy(r.Message, PacketFormLocation, PacketFormSize);
+		r.MessageSize = r.Message ? PacketFormSize : 0;
 	}
 	// Otherwise send the text
 	else
@@ -342,8 +356,9 @@ void Extension::ServerSend(int SocketID, TCHAR * Message)
 		r.Message = _tcsdup(Message);
 		r.MessageSize = (_tcslen(Message) + 1) * sizeof(TCHAR);
 	}
-	Senders.push_back(r);
+	Senders.push_back(std::move(r));
 	ThreadSafe_End();
+	Loop->Wake();
 }
 // ID = 15
 void Extension::ServerGoIndependent(int SocketID)
@@ -351,6 +366,7 @@ void Extension::ServerGoIndependent(int SocketID)
 	ThreadSafe_Start();
 	Senders.push_back(RevCarryMsg(Commands::GOINDEPENDENT, SocketID));
 	ThreadSafe_End();
+	Loop->Wake();
 }
 // ID = 16
 void Extension::ServerAutoAccept(int SocketID, int OnOrOff)
@@ -358,13 +374,17 @@ void Extension::ServerAutoAccept(int SocketID, int OnOrOff)
 	ThreadSafe_Start();
 	Senders.push_back(RevCarryMsg(OnOrOff ? Commands::AUTOACCEPTSETON : Commands::AUTOACCEPTSETOFF, SocketID));
 	ThreadSafe_End();
+	Loop->Wake();
 }
 // ID = 17
 void Extension::ServerLinkFileOutput(int SocketID, TCHAR * File)
 {
 	ThreadSafe_Start();
-	Senders.push_back(RevCarryMsg(Commands::LINKOUTPUTTOFILE, SocketID));
+	RevCarryMsg r(Commands::LINKOUTPUTTOFILE, SocketID);
+	r.Message = _tcsdup(File);
+	Senders.push_back(std::move(r));
 	ThreadSafe_End();
+	Loop->Wake();
 }
 // ID = 18
 void Extension::ServerUnlinkFileOutput(int SocketID)
@@ -372,6 +392,7 @@ void Extension::ServerUnlinkFileOutput(int SocketID)
 	ThreadSafe_Start();
 	Senders.push_back(RevCarryMsg(Commands::UNLINKFILEOUTPUT, SocketID));
 	ThreadSafe_End();
+	Loop->Wake();
 }
 // ID = 19
 void Extension::ServerMMF2Report(int SocketID, int OnOrOff)
@@ -379,6 +400,7 @@ void Extension::ServerMMF2Report(int SocketID, int OnOrOff)
 	ThreadSafe_Start();
 	Senders.push_back(RevCarryMsg(OnOrOff ? Commands::MMFREPORTON : Commands::MMFREPORTOFF, SocketID));
 	ThreadSafe_End();
+	Loop->Wake();
 }
 
 
@@ -20,6 +20,9 @@
 #include <iphlpapi.h>
 //#include <af_irda.h>
 #include <atomic>
+#include <mutex>
+#include <vector>
+#include <string>
 
 #pragma comment(lib, "ws2_32.lib")
 
@@ -80,14 +83,15 @@ struct RUNDATA
 
 // This code allows threads to be terminated in DestroyRunObject or elsewhere.
 // Terminating threads should not be used, as a memory leak of the variables is very probable.
+// Either way, the threads are kept in SetupThreads, so ~Extension can wait for them to finish using it.
 #ifdef AllowTermination
-#define TermPush(CreateT)	SocketThreadList.push_back(CreateT)
+#define TermPush(CreateT)	SocketThreadList.push_back(Unreferenced_TrackThread(CreateT))
 #define NullStoredHandle(id) ThreadSafe_Start(); \
 							 Extension->SocketThreadList[id] = NULL; \
 							 ThreadSafe_End()
 //#define TerminateOnEnd // Define this to have DestroyRunObject run TerminateThread() on all the threads.
 #else
-#define TermPush(CreateT) CreateT
+#define TermPush(CreateT) Unreferenced_TrackThread(CreateT)
 #define NullStoredHandle(id)
 #endif
 
@@ -105,7 +109,8 @@ struct RUNDATA
 //Macros for Thread Safety
 #define ThreadSafe_Start() while (Extension->threadsafe){Sleep(0);} Extension->LastLockFile = ##__FILE__; Extension->LastLockLine = __LINE__; Extension->threadsafe=true
 #define ThreadSafe_End() Extension->threadsafe=false
-#define CallEvent(var) while (Extension->nogevent) {Sleep(0);} Extension->nogevent=true; Extension->Runtime.GenerateEvent(var); Extension->nogevent=false
+// Events can only be generated on the MMF2 thread, so queue them for Extension::Handle()
+#define CallEvent(var) Extension->Unreferenced_QueueEvent(var, SocketID)
 
 #define Explode(foo) Extension->Unreferenced_Error(_T(foo), SocketID)	// Simplifying
 #define Report(foo) Extension->Unreferenced_Report(_T(foo), SocketID)	// Ditto
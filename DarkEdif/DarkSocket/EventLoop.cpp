@@ -0,0 +1,527 @@
+#define NoExt // Extension is not native, so declare this so "common.h" knows
+#include "Common.h"
+#undef NoExt
+#include <algorithm>
+// ============================================================================
+//
+// EVENT LOOP
+//
+// ============================================================================
+
+// Most one socket is read in one go, so a busy socket can't hold up the others
+#define MaxReadPerWake (256 * 1024)
+// How long WSAPoll() waits when nothing happens; also how often a dropped Rehandle() is repeated
+#define IdleWaitMS 100
+
+EventLoop::EventLoop(Extension * Ext) :
+	Ext(Ext), Thread(NULL), WakeSocket(INVALID_SOCKET), Stop(false), Woken(false), RecvBuffer(64 * 1024)
+{
+	// Sending one byte to a loopback socket connected to itself wakes WSAPoll().
+	// If it can't be set up, the loop checks for commands every 10ms instead, like the old threads.
+	WakeSocket = socket(AF_INET, SOCK_DGRAM, IPPROTO_UDP);
+	if (WakeSocket != INVALID_SOCKET)
+	{
+		sockaddr_in Address;
+		ZeroMemory(&Address, sizeof(Address));
+		Address.sin_family = AF_INET;
+		Address.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+		int AddressSize = sizeof(Address);
+		unsigned long UL = 1;
+
+		if (bind(WakeSocket, (sockaddr *)&Address, sizeof(Address)) != 0 ||
+			getsockname(WakeSocket, (sockaddr *)&Address, &AddressSize) != 0 ||
+			connect(WakeSocket, (sockaddr *)&Address, AddressSize) != 0 ||
+			ioctlsocket(WakeSocket, FIONBIO, &UL) != 0)
+		{
+			closesocket(WakeSocket);
+			WakeSocket = INVALID_SOCKET;
+		}
+	}
+
+	Thread = CreateThread(NULL, NULL, (LPTHREAD_START_ROUTINE)&LoopThread, this, NULL, NULL);
+}
+
+EventLoop::~EventLoop()
+{
+	Stop = true;
+	Wake();
+	WaitForSingleObject(Thread, INFINITE);
+	CloseHandle(Thread);
+
+	// Set up after the loop stopped
+	std::vector<LoopSocket *> Late;
+	{
+		std::lock_guard<std::mutex> lock(AddedLock);
+		Late.swap(Added);
+	}
+	for (LoopSocket * Socket : Late)
+	{
+		Close(Socket, false);
+		delete Socket;
+	}
+	if (WakeSocket != INVALID_SOCKET)
+		closesocket(WakeSocket);
+}
+
+void EventLoop::Add(LoopSocket * Socket)
+{
+	{
+		std::lock_guard<std::mutex> lock(AddedLock);
+		Added.push_back(Socket);
+	}
+	Wake();
+}
+
+void EventLoop::Wake()
+{
+	// One wake datagram waiting is enough
+	if (WakeSocket != INVALID_SOCKET && !Woken.exchange(true))
+		send(WakeSocket, "", 1, 0);
+}
+
+DWORD WINAPI EventLoop::LoopThread(EventLoop * Loop)
+{
+	std::vector<WSAPOLLFD> Polled;
+	std::vector<std::pair<LoopSocket *, size_t>> Owners; // Socket, and the index of the peer or SIZE_MAX for the socket itself
+	const bool Wakeable = Loop->WakeSocket != INVALID_SOCKET;
+
+	while (!Loop->Stop)
+	{
+		Polled.clear();
+		Owners.clear();
+		if (Wakeable)
+		{
+			Polled.push_back({ Loop->WakeSocket, POLLRDNORM, 0 });
+			Owners.emplace_back(nullptr, SIZE_MAX);
+		}
+		for (LoopSocket * Socket : Loop->Sockets)
+		{
+			// While not auto-accepting, new peers wait in the listen() backlog
+			if (!Socket->Listening || Socket->AutoAccept)
+			{
+				Polled.push_back({ Socket->Socket, (SHORT)(POLLRDNORM | (Socket->Unsent.empty() ? 0 : POLLWRNORM)), 0 });
+				Owners.emplace_back(Socket, SIZE_MAX);
+			}
+			for (size_t i = 0; i < Socket->Peers.size(); ++i)
+			{
+				Polled.push_back({ Socket->Peers[i].socket, (SHORT)(POLLRDNORM | (Socket->Peers[i].Unsent.empty() ? 0 : POLLWRNORM)), 0 });
+				Owners.emplace_back(Socket, i);
+			}
+		}
+
+		int Ready = 0;
+		if (Polled.empty() || (Ready = WSAPoll(Polled.data(), (ULONG)Polled.size(), Wakeable ? IdleWaitMS : 10)) == SOCKET_ERROR)
+		{
+			Sleep(10);
+			Ready = 0;
+		}
+
+		// Woken is cleared before draining, so a Wake() from now on sends another datagram
+		if (Wakeable && (Polled[0].revents || Ready == 0))
+		{
+			Loop->Woken = false;
+			char Drain[16];
+			while (recv(Loop->WakeSocket, Drain, sizeof(Drain), 0) > 0)
+				;
+		}
+
+		if (Loop->Stop)
+			break;
+
+		{
+			std::lock_guard<std::mutex> lock(Loop->AddedLock);
+			Loop->Sockets.insert(Loop->Sockets.end(), Loop->Added.begin(), Loop->Added.end());
+			Loop->Added.clear();
+		}
+
+		for (size_t i = Wakeable ? 1 : 0; i < Polled.size(); ++i)
+		{
+			const SHORT Events = Polled[i].revents;
+			LoopSocket * Socket = Owners[i].first;
+			if (!Events || Socket->Closed)
+				continue;
+
+			if (Owners[i].second == SIZE_MAX)
+			{
+				if ((Events & POLLWRNORM) && !Loop->Send(Socket->Socket, Socket->Unsent, "", 0))
+				{
+					Extension * Extension = Loop->Ext;
+					int SocketID = Socket->SocketID;
+					Explode("send() failed!");
+				}
+				if (!(Events & (POLLRDNORM | POLLHUP | POLLERR | POLLNVAL)))
+					continue;
+				if (Socket->Listening)
+					Loop->Accept(Socket);
+				else
+					Loop->Received(Socket, nullptr, Loop->Receive(Socket->Socket, Socket->Received));
+			}
+			else
+			{
+				ClientAccessNode * Peer = &Socket->Peers[Owners[i].second];
+				if (Peer->socket == INVALID_SOCKET)
+					continue;
+				if ((Events & POLLWRNORM) && !Loop->Send(Peer->socket, Peer->Unsent, "", 0))
+				{
+					Extension * Extension = Loop->Ext;
+					int SocketID = Socket->SocketID;
+					Explode("send() to peer failed!");
+				}
+				if (Events & (POLLRDNORM | POLLHUP | POLLERR | POLLNVAL))
+					Loop->Received(Socket, Peer, Loop->Receive(Peer->socket, Socket->Received));
+			}
+		}
+
+		Loop->RunCommands();
+
+		// Remove what was closed, now nothing refers to it by index
+		for (auto s = Loop->Sockets.begin(); s != Loop->Sockets.end(); )
+		{
+			if ((*s)->Closed)
+			{
+				delete *s;
+				s = Loop->Sockets.erase(s);
+				continue;
+			}
+			std::vector<ClientAccessNode> &Peers = (*s)->Peers;
+			Peers.erase(std::remove_if(Peers.begin(), Peers.end(),
+				[](const ClientAccessNode &Peer) { return Peer.socket == INVALID_SOCKET; }), Peers.end());
+			++s;
+		}
+
+		// Repeat a Rehandle() that MMF2 may have dropped; see Extension::Handle()
+		if (Ready == 0)
+		{
+			bool Waiting;
+			{
+				std::lock_guard<std::mutex> lock(Loop->Ext->QueuedEventsLock);
+				Waiting = !Loop->Ext->QueuedEvents.empty();
+			}
+			if (Waiting)
+				Loop->Ext->Runtime.Rehandle();
+		}
+	}
+
+	// The extension is being destroyed, so no events
+	for (LoopSocket * Socket : Loop->Sockets)
+	{
+		Loop->Close(Socket, false);
+		delete Socket;
+	}
+	Loop->Sockets.clear();
+	return 0;
+}
+
+LoopSocket * EventLoop::Find(int SocketID)
+{
+	for (LoopSocket * Socket : Sockets)
+		if (Socket->SocketID == SocketID && !Socket->Closed)
+			return Socket;
+	return nullptr;
+}
+
+void EventLoop::RunCommands()
+{
+	Extension * Extension = Ext;
+	std::vector<std::pair<LoopSocket *, RevCarryMsg>> Pending;
+
+	ThreadSafe_Start();
+	for (size_t i = 0; i < Extension->Senders.size(); )
+	{
+		// Not set up yet, or closed
+		LoopSocket * Socket = Find(Extension->Senders[i].Socket);
+		if (!Socket)
+		{
+			++i;
+			continue;
+		}
+
+		// Independent sockets can't be contacted, so their commands are dropped
+		if (!Socket->Independent)
+			Pending.emplace_back(Socket, std::move(Extension->Senders[i]));
+		Extension->Senders.erase(Extension->Senders.begin() + i);
+	}
+	ThreadSafe_End();
+
+	// Run outside of threadsafe so Report() functions don't lock up
+	for (auto &p : Pending)
+		if (!p.first->Closed)
+			RunCommand(p.first, p.second);
+}
+
+void EventLoop::RunCommand(LoopSocket * Socket, RevCarryMsg &Command)
+{
+	Extension * Extension = Ext;
+	int SocketID = Socket->SocketID;
+
+	// What does MMF2 want us to do?
+	switch (Command.Cmd)
+	{
+		// Command to close the socket
+		case Commands::SHUTDOWNTHREAD:
+			Report("Socket closed by SHUTDOWNTHREAD");
+			Close(Socket);
+			break;
+
+		// Command to send a message; what send() can't take now goes when the socket is writable
+		case Commands::SENDMSG:
+			if (!Socket->Listening)
+			{
+				if (!Send(Socket->Socket, Socket->Unsent, (char *)Command.Message, Command.MessageSize))
+					Explode("send() failed!");
+			}
+			else
+			{
+				bool Located = false;
+				for (ClientAccessNode &Peer : Socket->Peers)
+				{
+					if (Peer.socket == INVALID_SOCKET || (Command.Client != _T("") && Peer.FriendlyName != Command.Client))
+						continue;
+					Located = true;
+					if (!Send(Peer.socket, Peer.Unsent, (char *)Command.Message, Command.MessageSize))
+						Explode("Selected the socket, but the send() operation failed!");
+				}
+				if (!Located)
+					Explode("Send operation couldn't locate the applicable client(s)!");
+			}
+			break;
+
+		// Command to switch to receiving only.
+		case Commands::RECEIVEONLY:
+			Report("Now using shutdown() so we don't send data. But we can receive.");
+			if (shutdown(Socket->Socket, SD_SEND) == SOCKET_ERROR)
+			{
+				Explode("shutdown() failed!");
+				Close(Socket);
+			}
+			else
+				Report("Shutdown operation completed.");
+			break;
+
+		// Ignore any further commands from MMF2.
+		case Commands::GOINDEPENDENT:
+			Report("Socket is now independent and cannot be contacted.");
+			Socket->Independent = true;
+			break;
+
+		// Commands to accept new peers, or leave them waiting
+		case Commands::AUTOACCEPTSETON:
+			Report("Auto-accept enabled.");
+			Socket->AutoAccept = true;
+			break;
+		case Commands::AUTOACCEPTSETOFF:
+			Report("Auto-accept disabled; new peers will wait until it is enabled.");
+			Socket->AutoAccept = false;
+			break;
+
+		// Command to copy the received data to a file
+		case Commands::LINKOUTPUTTOFILE:
+			Report("Linking received messages to file.");
+			if (Socket->OutputFile)
+				fclose(Socket->OutputFile);
+			Socket->OutputFile = _tfopen((TCHAR *)Command.Message, _T("ab"));
+			if (!Socket->OutputFile)
+				Explode("Could not open the file to link received messages to.");
+			break;
+
+		// Command to stop copying the received data to a file
+		case Commands::UNLINKFILEOUTPUT:
+			Report("Received messages unlinked from file.");
+			if (Socket->OutputFile)
+				fclose(Socket->OutputFile);
+			Socket->OutputFile = nullptr;
+			break;
+
+		// Command to stop reporting messages to MMF2 (disconnection will still be reported)
+		case Commands::MMFREPORTOFF:
+			if (Socket->OutputFile)
+				Report("No MMF2 report enabled, outputting to file only.");
+			else
+				Report("No MMF2 report enabled, no file output either!"
+						"You will not receive any received messages from this socket.");
+			Socket->MMF2Report = false;
+			break;
+
+		// Command to re-start the reporting of messages to MMF2
+		case Commands::MMFREPORTON:
+			Socket->MMF2Report = true;
+			Report("MMF2 report re-enabled.");
+			break;
+
+		// Unrecognised command.
+		default:
+			Explode("Unrecognised command!");
+	}
+}
+
+void EventLoop::Accept(LoopSocket * Socket)
+{
+	Extension * Extension = Ext;
+	int SocketID = Socket->SocketID;
+	char temp[256];
+
+	while (true)
+	{
+		ClientAccessNode Peer;
+		int Size = sizeof(Peer.sockaddr);
+		Peer.socket = accept(Socket->Socket, (sockaddr *)&Peer.sockaddr, &Size);
+		if (Peer.socket == INVALID_SOCKET)
+		{
+			// No more waiting, or one gave up before we got to it
+			int Error = WSAGetLastError();
+			if (Error != WSAEWOULDBLOCK && Error != WSAECONNRESET)
+			{
+				sprintf_s(temp, sizeof(temp), "Error with accept(): %i. Server continues to run.", Error);
+				Explode(temp);
+			}
+			return;
+		}
+
+		// Accepted sockets should take on the listening socket's non-blocking mode, but make sure
+		unsigned long UL = 1;
+		if (ioctlsocket(Peer.socket, FIONBIO, &UL) != 0)
+		{
+			Explode("Non-blocking mode could not be set for a new peer; disconnected it.");
+			closesocket(Peer.socket);
+			continue;
+		}
+
+		Peer.FriendlyName = _T("Not set.");
+		Socket->Peers.push_back(std::move(Peer));
+		CallEvent(MF2C_SERVER_CLIENT_CONNECTED);
+	}
+}
+
+// Reads what's waiting into Into. Returns 0 if it's all read, -1 if the connection was closed,
+// or the WSA error recv() failed with.
+int EventLoop::Receive(SOCKET From, std::string &Into)
+{
+	for (size_t Read = 0; Read < MaxReadPerWake; )
+	{
+		int iResult = recv(From, RecvBuffer.data(), (int)RecvBuffer.size(), 0);
+		if (iResult > 0)
+		{
+			Into.append(RecvBuffer.data(), iResult);
+			Read += iResult;
+		}
+		else if (iResult == 0)
+			return -1;
+		else
+			return WSAGetLastError() == WSAEWOULDBLOCK ? 0 : WSAGetLastError();
+	}
+	// The rest is left for the next WSAPoll(), which will still say it's readable
+	return 0;
+}
+
+void EventLoop::Received(LoopSocket * Socket, ClientAccessNode * Peer, int Result)
+{
+	Extension * Extension = Ext;
+	int SocketID = Socket->SocketID;
+	char temp[256];
+
+	// Whatever arrived before a disconnect or error still goes to MMF2
+	if (!Socket->Received.empty())
+	{
+		if (Socket->MMF2Report)
+			ReturnToMMF(Socket->ReturnType, SocketID, (void *)Socket->Received.data(), (int)Socket->Received.size());
+		if (Socket->OutputFile)
+			fwrite(Socket->Received.data(), 1, Socket->Received.size(), Socket->OutputFile);
+		Socket->Received.clear();
+	}
+
+	if (Result == 0)
+		return;
+
+	// A peer leaving doesn't affect the server or its other peers
+	if (Peer)
+	{
+		if (Result != -1)
+		{
+			sprintf_s(temp, sizeof(temp), "recv() from a peer failed with error %i. Peer disconnected.", Result);
+			Report(temp);
+		}
+		closesocket(Peer->socket);
+		Peer->socket = INVALID_SOCKET;
+		CallEvent(MF2C_SERVER_CLIENT_DISCONNECTED);
+		return;
+	}
+
+	switch (Result)
+	{
+		case -1:
+		case WSAENOTCONN:
+		case WSAESHUTDOWN:
+		case WSAECONNABORTED:
+		case WSAECONNRESET:
+		case WSAENETRESET:
+			Report("Connection was closed.");
+			break;
+		case WSAENETDOWN:
+		case WSAETIMEDOUT:
+			Explode("Network error and/or timeout. (WSAENETDOWN or WSAETIMEDOUT)\n"
+					"According to MSDN:\n"
+					"\"The connection has been dropped because of a network failure or because the peer system failed to respond.\"\n"
+					"So uh, have fun debugging. Socket closed.");
+			break;
+		case WSAEMSGSIZE:
+			Explode("Buffer too small for datagram; the rest of it was lost. Socket remains open.");
+			return;
+		default:
+			// Error that is rare and unhandled; closed, as WSAPoll() would keep reporting it
+			sprintf_s(temp, sizeof(temp), "recv() function failed, with unusual error %i. Socket closed.", Result);
+			Explode(temp);
+			break;
+	}
+	Close(Socket);
+}
+
+// Sends what it can without waiting, and keeps the rest in Unsent for when the socket is writable.
+// Returns false if send() failed.
+bool EventLoop::Send(SOCKET To, std::string &Unsent, const char * Data, size_t Size)
+{
+	// Anything new goes behind what's already waiting
+	const bool Queued = !Unsent.empty();
+	if (Queued)
+	{
+		Unsent.append(Data, Size);
+		Data = Unsent.data();
+		Size = Unsent.size();
+	}
+
+	size_t Sent = 0;
+	while (Sent < Size)
+	{
+		int iResult = send(To, Data + Sent, (int)(Size - Sent), 0);
+		if (iResult == SOCKET_ERROR)
+		{
+			if (WSAGetLastError() != WSAEWOULDBLOCK)
+				return false;
+			break;
+		}
+		Sent += iResult;
+	}
+
+	if (Queued)
+		Unsent.erase(0, Sent);
+	else
+		Unsent.assign(Data + Sent, Size - Sent);
+	return true;
+}
+
+void EventLoop::Close(LoopSocket * Socket, bool Event /* = true */)
+{
+	Extension * Extension = Ext;
+	int SocketID = Socket->SocketID;
+
+	for (ClientAccessNode &Peer : Socket->Peers)
+		if (Peer.socket != INVALID_SOCKET)
+			closesocket(Peer.socket);
+	closesocket(Socket->Socket);
+	if (Socket->OutputFile)
+		fclose(Socket->OutputFile);
+	Socket->OutputFile = nullptr;
+	Socket->Closed = true;
+
+	if (Event)
+		CallEvent(Socket->ReturnType == CLIENT_RETURN ? MF2C_CLIENT_ON_DISCONNECT : MF2C_SERVER_SOCKET_DONE);
+}
@@ -119,6 +119,9 @@ Extension::Extension(RUNDATA * _rdPtr, EDITDATA * edPtr, CreateObjectInfo * cobP
 				"This means possible undefined behaviour, including crashes.");
 	}
 
+	// Receives for all the sockets, so MMF2 never waits on them
+	Loop = new EventLoop(this);
+
 }
 
 Extension::~Extension()
@@ -139,6 +142,17 @@ Extension::~Extension()
 		}
 	}
 #endif
+	// The initialise threads use this Extension and hand their socket to Loop, so let them finish first
+	for (HANDLE Thread : SetupThreads)
+	{
+		WaitForSingleObject(Thread, INFINITE);
+		CloseHandle(Thread);
+	}
+	SetupThreads.clear();
+
+	// Closes the sockets, so do it before WSACleanup()
+	delete Loop;
+
 	if (PacketFormLocation)
 		free(PacketFormLocation);
 
@@ -148,8 +162,47 @@ Extension::~Extension()
 
 REFLAG Extension::Handle()
 {
-	// Will not be called next loop
-	return REFLAG::ONE_SHOT;
+	// Generate the events the socket threads queued, now we're on the MMF2 thread
+	std::vector<QueuedEvent> Events;
+	{
+		std::lock_guard<std::mutex> lock(QueuedEventsLock);
+		Events.swap(QueuedEvents);
+	}
+
+	for (QueuedEvent &e : Events)
+	{
+		// Popups from the socket threads are shown here, so they don't hold up the event loop
+		if (!e.PopupText.empty())
+			MessageBox(NULL, e.PopupText.c_str(), e.PopupTitle.c_str(), MB_OK);
+		if (e.Condition == -1)
+			continue;
+
+		// Debug events don't change which socket the last event was for
+		if (e.Condition != MF2C_DEBUG_ON_ERROR && e.Condition != MF2C_DEBUG_ON_NEW_STATUS)
+		{
+			ThreadSafe_Start();
+			LastReturnSocketID = e.SocketID;
+			LastReturnType = e.ReturnType;
+			if (e.Condition == MF2C_CLIENT_RECEIVED_MESSAGE || e.Condition == MF2C_SERVER_RECEIVED_MESSAGE)
+			{
+				LastMessage = std::move(e.Message);
+				CarryMsg c;
+				c.ClientOrServer = e.ReturnType;
+				c.Message = (void *)LastMessage.c_str();
+				c.MessageSize = (int)LastMessage.size();
+				c.Socket = e.SocketID;
+				Returns.clear();
+				Returns.push_back(c);
+			}
+			ThreadSafe_End();
+		}
+		CallEvent(e.Condition);
+	}
+
+	// Unreferenced_QueueEvent() calls Rehandle() to wake us, but that can be lost if it lands just as
+	// MMF2 applies this ONE_SHOT; so keep handling while events arrive, and the event loop repeats the
+	// Rehandle() while any are left waiting.
+	return Events.empty() ? REFLAG::ONE_SHOT : REFLAG::NONE;
 }
 
 
@@ -12,7 +12,7 @@ public:
 	Edif::Runtime Runtime;
 
 	static const int MinimumBuild = 252;
-	static const int Version = 3;
+	static const int Version = 4;
 
 	static const OEFLAGS OEFLAGS = OEFLAGS::VALUES;
 	static const OEPREFS OEPREFS = OEPREFS::NONE;
@@ -43,6 +43,11 @@ public:
 	bool LastReturnType;					// Indicates the last message was from a client or server
 	std::vector<CarryMsg> Returns;			// Carries a message from the client/server->MMF2
 	std::vector<RevCarryMsg> Senders;		// Carries a message from MMF2->the client/server
+	std::string LastMessage;				// Holds the message Returns[0] points to
+	std::mutex QueuedEventsLock;			// Guards QueuedEvents
+	std::vector<QueuedEvent> QueuedEvents;	// Events from the socket threads, for Handle() to generate
+	EventLoop * Loop;						// Receives for all sockets, and runs their commands from MMF2
+	std::vector<HANDLE> SetupThreads;		// Initialise threads still running; ~Extension waits for them
 	int NewSocketID;						// The new socket ID is assigned here.
 	bool UsePopups;							// This defines whether Report/Explode use popups.
  	WSADATA wsaData;						// Holds WSAStartup() information.
@@ -66,6 +71,10 @@ public:
 		void Unreferenced_Error(TCHAR * error, int SocketID);
 		void Unreferenced_Report(TCHAR * report, int SocketID);
 		void Unreferenced_ReturnToMMF(int ReturnAsI, int SocketID, void * Msg, int MsgLength);
+		void Unreferenced_QueueEvent(int Condition, int SocketID, const void * Msg = nullptr, size_t MsgLength = 0);
+		void Unreferenced_QueuePopup(const TCHAR * Title, const TCHAR * Text, int SocketID);
+		void Unreferenced_QueueEvent(QueuedEvent && e);
+		HANDLE Unreferenced_TrackThread(HANDLE Thread);
 		unsigned long Unreferenced_WorkOutInAddr(TCHAR * t);
 
 	/// Actions
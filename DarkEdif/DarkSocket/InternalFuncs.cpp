@@ -187,8 +187,12 @@ void Extension::Unreferenced_Report(TCHAR * report = _T("Unknown report..."), in
 		{
 			TCHAR title [512];
 			sprintf_s(title, 512, "DarkSocket - Latest Report from %i:", SocketID);
-			MessageBox(NULL, report, title, MB_OK);
+			Unreferenced_QueuePopup(title, report, SocketID);
 		}
+
+		// Not on the MMF2 thread, so let Handle() generate the event
+		Unreferenced_QueueEvent(MF2C_DEBUG_ON_NEW_STATUS, SocketID);
+		return;
 	}
 
 	CallEvent(MF2C_DEBUG_ON_NEW_STATUS);
@@ -224,8 +228,13 @@ void Extension::Unreferenced_Error(TCHAR * error, int SocketID)
 		{
 			TCHAR title [255];
 			sprintf_s(title, 255, "DarkSocket - Latest Error from %i:", SocketID);
-			MessageBox(NULL, error, title, MB_OK);
+			Unreferenced_QueuePopup(title, error, SocketID);
 		}
+
+		// Not on the MMF2 thread, so let Handle() generate the events
+		Unreferenced_QueueEvent(MF2C_DEBUG_ON_ERROR, SocketID);
+		Unreferenced_QueueEvent(MF2C_DEBUG_ON_NEW_STATUS, SocketID);
+		return;
 	}
 	CallEvent(MF2C_DEBUG_ON_ERROR);
 	CallEvent(MF2C_DEBUG_ON_NEW_STATUS);
@@ -234,28 +243,64 @@ void Extension::Unreferenced_Error(TCHAR * error, int SocketID)
 // Return - For threads reporting things to MMF2
 void Extension::Unreferenced_ReturnToMMF(int ReturnAsI, int SocketID, void * Msg, int Length)
 {
-	bool ReturnAs = false;
+	// Msg is copied, so the thread can reuse its buffer; Handle() puts it in Returns
+	Unreferenced_QueueEvent(ReturnAsI != 0 ? MF2C_SERVER_RECEIVED_MESSAGE : MF2C_CLIENT_RECEIVED_MESSAGE, SocketID, Msg, Length);
+}
+
+// Queue - For threads generating events; Handle() generates them on the MMF2 thread
+void Extension::Unreferenced_QueueEvent(int Condition, int SocketID, const void * Msg, size_t MsgLength)
+{
+	QueuedEvent e;
+	e.Condition = Condition;
+	e.SocketID = SocketID;
+	e.ReturnType = Condition >= MF2C_SERVER_RECEIVED_MESSAGE ? SERVER_RETURN : CLIENT_RETURN;
+	if (Msg)
+		e.Message.assign((const char *)Msg, MsgLength);
+	Unreferenced_QueueEvent(std::move(e));
+}
+
+// Popup - For threads; a message box would stop the event loop until it's closed, so Handle() shows it
+void Extension::Unreferenced_QueuePopup(const TCHAR * Title, const TCHAR * Text, int SocketID)
+{
+	QueuedEvent e;
+	e.SocketID = SocketID;
+	e.PopupTitle = Title;
+	e.PopupText = Text;
+	Unreferenced_QueueEvent(std::move(e));
+}
 
-	if (ReturnAsI != 0)
+void Extension::Unreferenced_QueueEvent(QueuedEvent && e)
+{
+	bool WasEmpty;
 	{
-		ReturnAs = true;
-		ReturnAsI = MF2C_SERVER_RECEIVED_MESSAGE;
+		std::lock_guard<std::mutex> lock(QueuedEventsLock);
+		WasEmpty = QueuedEvents.empty();
+		QueuedEvents.push_back(std::move(e));
 	}
-	else
+
+	// Handle() returns ONE_SHOT, so ask for it to run again
+	if (WasEmpty)
+		Runtime.Rehandle();
+}
+
+// Keeps an initialise thread for ~Extension to wait on, closing those that have finished
+HANDLE Extension::Unreferenced_TrackThread(HANDLE Thread)
+{
+#ifndef AllowTermination // SocketThreadList may still refer to them
+	for (auto t = SetupThreads.begin(); t != SetupThreads.end(); )
 	{
-		ReturnAsI = MF2C_CLIENT_RECEIVED_MESSAGE;
+		if (WaitForSingleObject(*t, 0) == WAIT_OBJECT_0)
+		{
+			CloseHandle(*t);
+			t = SetupThreads.erase(t);
+		}
+		else
+			++t;
 	}
-
-	ThreadSafe_Start();
-	// New struct in the vector queue
-	CarryMsg c;
-	// Set variables in the struct
-	c.ClientOrServer = ReturnAs;
-	c.Message = Msg;
-	c.Socket = SocketID;
-	Returns.push_back(c);
-	ThreadSafe_End();
-	CallEvent(ReturnAsI);
+#endif
+	if (Thread)
+		SetupThreads.push_back(Thread);
+	return Thread;
 }
 
 // Gets some server thing.
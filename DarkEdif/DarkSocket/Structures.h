@@ -75,6 +75,30 @@ struct RevCarryMsg
 		free(Message);
 		Message = nullptr;
 	}
+	// Message is owned, so the queue can only move these about
+	RevCarryMsg(const RevCarryMsg &) = delete;
+	RevCarryMsg & operator=(const RevCarryMsg &) = delete;
+	RevCarryMsg(RevCarryMsg && r) : Cmd(r.Cmd), Socket(r.Socket), Message(r.Message), MessageSize(r.MessageSize), Client(std::move(r.Client)) {
+		r.Message = nullptr;
+	}
+	RevCarryMsg & operator=(RevCarryMsg && r) {
+		std::swap(Cmd, r.Cmd);
+		std::swap(Socket, r.Socket);
+		std::swap(Message, r.Message);
+		std::swap(MessageSize, r.MessageSize);
+		std::swap(Client, r.Client);
+		return *this;
+	}
+};
+
+// Event from another thread, waiting for Extension::Handle() to generate it on the MMF2 thread
+struct QueuedEvent
+{
+	int Condition = -1;
+	int SocketID = -1;
+	bool ReturnType = CLIENT_RETURN;
+	std::string Message; // For received message events
+	std::tstring PopupTitle, PopupText; // If set, Handle() shows it in a message box first
 };
 
 struct ClientAccessNode
@@ -82,6 +106,59 @@ struct ClientAccessNode
 	SOCKET socket;
 	SOCKADDR_STORAGE sockaddr;
 	std::tstring FriendlyName;
+	std::string Unsent; // Sent by MMF2, but not yet taken by send()
+};
+
+// A set-up socket, owned by the event loop from then on
+struct LoopSocket
+{
+	int SocketID;
+	SOCKET Socket;
+	bool ReturnType;		// CLIENT_RETURN or SERVER_RETURN
+	bool Listening = false;	// Server stream socket; peers are accepted from it
+	bool Independent = false, MMF2Report = true, AutoAccept = true, Closed = false;
+	FILE * OutputFile = nullptr;
+	std::string Received, Unsent;
+	std::vector<ClientAccessNode> Peers;
+
+	LoopSocket(int SocketID, SOCKET Socket, bool ReturnType) : SocketID(SocketID), Socket(Socket), ReturnType(ReturnType) {}
+};
+
+// One thread watches every socket with WSAPoll(), rather than a thread per socket polling recv()
+// between sleeps. The initialise threads hand their socket over with Add() once it's set up, and
+// actions queue commands in Extension::Senders, then Wake() the loop to run them.
+class EventLoop
+{
+public:
+	EventLoop(Extension * Ext);
+	~EventLoop(); // Stops the loop, and closes all its sockets
+
+	// Hands a set-up, non-blocking socket to the loop. Initialise threads call it, so ~Extension
+	// waits for them before deleting the loop.
+	void Add(LoopSocket * Socket);
+	// Makes the loop look at Extension::Senders now, rather than when a socket is next ready
+	void Wake();
+
+private:
+	Extension * Ext;
+	HANDLE Thread;
+	SOCKET WakeSocket;	// Loopback UDP socket connected to itself; a datagram wakes WSAPoll()
+	std::atomic<bool> Stop, Woken;
+
+	std::mutex AddedLock;
+	std::vector<LoopSocket *> Added;	// Set up, waiting to be picked up by the loop thread
+	std::vector<LoopSocket *> Sockets;	// Loop thread only
+	std::vector<char> RecvBuffer;		// Loop thread only; big enough for any datagram
+
+	static DWORD WINAPI LoopThread(EventLoop * Loop);
+	LoopSocket * Find(int SocketID);
+	void RunCommands();
+	void RunCommand(LoopSocket * Socket, RevCarryMsg &Command);
+	void Accept(LoopSocket * Socket);
+	int Receive(SOCKET From, std::string &Into);
+	void Received(LoopSocket * Socket, ClientAccessNode * Peer, int Result);
+	bool Send(SOCKET To, std::string &Unsent, const char * Data, size_t Size);
+	void Close(LoopSocket * Socket, bool Event = true);
 };
 
 DWORD WINAPI ClientThread(StructPassThru * Parameters);
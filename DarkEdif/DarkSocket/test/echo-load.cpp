@@ -0,0 +1,233 @@
+// Latency and throughput test for a DarkSocket echo server.
+//
+// Point it at a Fusion app that starts a DarkSocket TCP server and sends each message back. On
+// "On server received message", the app should echo the bytes exactly, not as text:
+//	Create new packet of size LastMessageSize(
+//	Copy LastMessageSize( bytes from LastMessageAddress( to FormPacket_Address(
+//	Send message to client from server socket GetSocketIDForLastEvent(, message "PACKET"
+// A packet is sent to every peer of the socket, so use one connection per server.
+//
+// The test connects once and sends printable text. It times round trips one message at a time,
+// then how fast messages echo with several in flight. It checks every byte comes back in order,
+// and fails if anything differs or the connection drops.
+//
+// Run "echo-load -s port" to start a plain echo server on that port. It uses one poll() thread,
+// as DarkSocket's event loop does, but has no Fusion frame in the way. That gives a baseline for
+// the network stack alone, and lets the client be checked without Fusion.
+//
+// Usage: echo-load [-n messages] [-b bytes per message] [-w messages in flight] host port
+//		  echo-load -s port
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <vector>
+
+#include <netdb.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <poll.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+static int failures = 0;
+
+static void check(bool passed, const char * what)
+{
+	printf("%s: %s\n", passed ? "pass" : "FAIL", what);
+
+	if (!passed)
+		++failures;
+}
+
+static double NowUS()
+{
+	return std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+// Message i of Bytes printable characters, different for each message so a lost or repeated
+// message shows; printable, so it reads in LastMessageText$( too
+static std::string Message(long i, size_t Bytes)
+{
+	std::string Text(Bytes, ' ');
+	for (size_t j = 0; j < Bytes; ++j)
+		Text[j] = (char)('!' + (i * 31 + j) % 94);
+	return Text;
+}
+
+static bool SendAll(int Socket, const std::string &Text)
+{
+	for (size_t Sent = 0; Sent < Text.size(); )
+	{
+		const ssize_t Result = send(Socket, Text.data() + Sent, Text.size() - Sent, MSG_NOSIGNAL);
+		if (Result <= 0)
+			return false;
+		Sent += Result;
+	}
+	return true;
+}
+
+// Reads exactly Expected.size() bytes, returning false if they differ or the connection drops
+static bool ReceiveSame(int Socket, const std::string &Expected, std::vector<char> &Buffer)
+{
+	Buffer.resize(std::max(Buffer.size(), Expected.size()));
+	for (size_t Read = 0; Read < Expected.size(); )
+	{
+		const ssize_t Result = recv(Socket, Buffer.data() + Read, Expected.size() - Read, 0);
+		if (Result <= 0)
+			return false;
+		Read += Result;
+	}
+	return !memcmp(Buffer.data(), Expected.data(), Expected.size());
+}
+
+static int Connect(const char * Host, const char * Port)
+{
+	addrinfo Hints = {}, * Result;
+	Hints.ai_socktype = SOCK_STREAM;
+	if (getaddrinfo(Host, Port, &Hints, &Result))
+		return -1;
+
+	int Socket = -1;
+	for (addrinfo * a = Result; a && Socket == -1; a = a->ai_next)
+	{
+		Socket = socket(a->ai_family, a->ai_socktype, a->ai_protocol);
+		if (Socket != -1 && connect(Socket, a->ai_addr, a->ai_addrlen))
+		{
+			close(Socket);
+			Socket = -1;
+		}
+	}
+	freeaddrinfo(Result);
+
+	const int On = 1;
+	if (Socket != -1)
+		setsockopt(Socket, IPPROTO_TCP, TCP_NODELAY, &On, sizeof(On));
+	return Socket;
+}
+
+// Echoes everything every peer sends, from one poll() thread
+static int Serve(const char * Port)
+{
+	const int Listener = socket(AF_INET6, SOCK_STREAM, 0), Off = 0, On = 1;
+	setsockopt(Listener, IPPROTO_IPV6, IPV6_V6ONLY, &Off, sizeof(Off));
+	setsockopt(Listener, SOL_SOCKET, SO_REUSEADDR, &On, sizeof(On));
+
+	sockaddr_in6 Address = {};
+	Address.sin6_family = AF_INET6;
+	Address.sin6_port = htons((unsigned short)atoi(Port));
+	if (bind(Listener, (sockaddr *)&Address, sizeof(Address)) || listen(Listener, SOMAXCONN))
+	{
+		perror("echo-load: bind or listen");
+		return 1;
+	}
+	printf("Echoing on port %s\n", Port);
+
+	std::vector<pollfd> Polled = { { Listener, POLLIN, 0 } };
+	std::vector<char> Buffer(64 * 1024);
+	while (true)
+	{
+		if (poll(Polled.data(), Polled.size(), -1) < 0)
+			continue;
+
+		for (size_t i = Polled.size(); i-- > 1; )
+		{
+			if (!Polled[i].revents)
+				continue;
+
+			// Peers read all they're sent, so a blocking send() only waits on the network
+			const ssize_t Read = recv(Polled[i].fd, Buffer.data(), Buffer.size(), 0);
+			if (Read <= 0 || !SendAll(Polled[i].fd, std::string(Buffer.data(), Read)))
+			{
+				close(Polled[i].fd);
+				Polled.erase(Polled.begin() + i);
+			}
+		}
+
+		if (Polled[0].revents)
+		{
+			const int Peer = accept(Listener, nullptr, nullptr);
+			if (Peer != -1)
+			{
+				setsockopt(Peer, IPPROTO_TCP, TCP_NODELAY, &On, sizeof(On));
+				Polled.push_back({ Peer, POLLIN, 0 });
+			}
+		}
+	}
+}
+
+int main(int argc, char ** argv)
+{
+	long Messages = 2000;
+	size_t Bytes = 64;
+	int Window = 16, Option;
+
+	while ((Option = getopt(argc, argv, "n:b:w:s:")) != -1)
+	{
+		switch (Option)
+		{
+			case 'n': Messages = std::max(1L, atol(optarg)); break;
+			case 'b': Bytes = std::max(1L, atol(optarg)); break;
+			case 'w': Window = std::max(1, atoi(optarg)); break;
+			case 's': return Serve(optarg);
+			default: optind = argc + 1; break;
+		}
+	}
+	if (optind + 2 != argc)
+	{
+		fprintf(stderr, "Usage: echo-load [-n messages] [-b bytes per message] [-w messages in flight] host port\n"
+			"       echo-load -s port\n");
+		return 2;
+	}
+
+	const int Socket = Connect(argv[optind], argv[optind + 1]);
+	if (Socket == -1)
+	{
+		fprintf(stderr, "echo-load: couldn't connect to %s port %s\n", argv[optind], argv[optind + 1]);
+		return 1;
+	}
+	std::vector<char> Buffer;
+
+	// One at a time
+	std::vector<double> Latencies;
+	bool Same = true;
+	const double Start = NowUS();
+	for (long i = 0; i < Messages && Same; ++i)
+	{
+		const std::string Text = Message(i, Bytes);
+		const double Sent = NowUS();
+		Same = SendAll(Socket, Text) && ReceiveSame(Socket, Text, Buffer);
+		Latencies.push_back(NowUS() - Sent);
+	}
+	const double PingPong = NowUS() - Start;
+	check(Same, "one at a time: every message echoes back the same");
+
+	std::sort(Latencies.begin(), Latencies.end());
+	const auto At = [&](double Fraction) { return Latencies[(size_t)(Fraction * (Latencies.size() - 1))]; };
+	printf("  %zu round trips of %zu bytes: %.0f per second; p50 %.0f us, p90 %.0f us, p99 %.0f us, max %.0f us\n",
+		Latencies.size(), Bytes, Latencies.size() / PingPong * 1e6, At(0.5), At(0.9), At(0.99), Latencies.back());
+
+	// Several in flight. The echo comes back as a stream, however the server splits it, so each
+	// message read back frees room for one more to be sent.
+	long Sent = 0, Echoed = 0;
+	const double Start2 = NowUS();
+	for (; Sent < std::min<long>(Window, Messages) && Same; ++Sent)
+		Same = SendAll(Socket, Message(Messages + Sent, Bytes));
+	for (; Echoed < Messages && Same; ++Echoed)
+	{
+		Same = ReceiveSame(Socket, Message(Messages + Echoed, Bytes), Buffer);
+		if (Same && Sent < Messages)
+			Same = SendAll(Socket, Message(Messages + Sent++, Bytes));
+	}
+	const double Flight = NowUS() - Start2;
+	check(Same, "in flight: every message echoes back the same, in order");
+	printf("  %ld messages of %zu bytes, %d in flight: %.0f per second, %.2f MB/s each way\n",
+		Echoed, Bytes, Window, Echoed / Flight * 1e6, Echoed * Bytes / Flight);
+
+	close(Socket);
+	printf(failures ? "%d failed\n" : "all passed\n", failures);
+	return failures ? 1 : 0;
+}
@@ -18,14 +18,20 @@ void Extension::SetOutputFile(const TCHAR * fileP, int describeAppI = 0)
 	// Duplicate variables
 	std::tstring file(fileP);
 
+	// Nothing may be writing to the old file, or rotating it, while it's swapped
+	std::unique_lock<std::mutex> outputLock;
+
 	// If file handle is valid, output closing message
 	if (data->fileHandle)
 	{
 		// No grab of file handle - OutputNow() will need it
 		OutputNow(1, -1, "*** Log closed. ***");
+		if (data->asyncLog)
+			data->asyncLog->Flush();
 
 		// Acquire lock
 		OpenLock();
+		outputLock = std::unique_lock<std::mutex>(data->outputLock);
 
 		// Close file
 		fclose(data->fileHandle);
@@ -35,6 +41,7 @@ void Extension::SetOutputFile(const TCHAR * fileP, int describeAppI = 0)
 	{
 		// Just acquire lock
 		OpenLock();
+		outputLock = std::unique_lock<std::mutex>(data->outputLock);
 	}
 
 	// Get handle to file
@@ -69,8 +76,12 @@ void Extension::SetOutputFile(const TCHAR * fileP, int describeAppI = 0)
 		fputs("\r\n", data->fileHandle);
 
 	fflush(data->fileHandle);
+	data->logPath = file;
+	if (data->logRotation)
+		data->logRotation->Opened(ftell(data->fileHandle));
 
 	// Close lock
+	outputLock.unlock();
 	CloseLock();
 
 	// Report success
@@ -89,7 +100,14 @@ void Extension::SetOutputFile(const TCHAR * fileP, int describeAppI = 0)
 			<< _T("File first opened from frame #") << rhPtr->App->nCurrentFrame
 			<< _T("(") << rhPtr->Frame->name << _T(")\r\n");
 		std::string str2 = TStringToUTF8(str.str());
-		fputs(str2.c_str(), data->fileHandle);
+		if (data->asyncLog) // Keep it after the log opened line
+			data->asyncLog->Push("", 0, str2.data(), str2.size(), true, false, true);
+		else
+		{
+			std::lock_guard<std::mutex> outputLock(data->outputLock);
+			if (data->fileHandle)
+				fputs(str2.c_str(), data->fileHandle);
+		}
 
 		// Close lock
 		CloseLock();
@@ -146,17 +164,50 @@ void Extension::OutputNow(int intensity, int line, std::string textToOutputU8)
 		return;
 	}
 
-	// Get time (if blank, remove tab for time also)
-	if (data->timeFormat[0] != _T('\0'))
+	// Get time; the formatted time is cached, as it only changes once a second
+	const bool showTime = data->timeFormat[0] != _T('\0');
+	if (showTime)
+	{
+		time_t now = time(NULL);
+		if (now != data->rawtime)
+		{
+			data->rawtime = now;
+			data->timeinfo = localtime(&data->rawtime);
+			_tcsftime(data->realTime, std::size(data->realTime), data->timeFormat, data->timeinfo);
+			data->realTimeU8 = TStringToUTF8(data->realTime);
+		}
+	}
+
+	// Asynchronous: preformat the line and leave the writing to the writer thread
+	if (data->asyncLog)
 	{
-		time(&data->rawtime);
-		data->timeinfo = localtime(&data->rawtime);
-		_tcsftime(data->realTime, std::size(data->realTime), data->timeFormat, data->timeinfo);
-		std::string realTimeU8 = TStringToUTF8(data->realTime);
+		// If blank time format, remove tab for time also
+		char prefix[512];
+		int prefixLength = showTime ?
+			sprintf_s(prefix, "%i\t%i\t%.480s\t", intensity, line, data->realTimeU8.c_str()) :
+			sprintf_s(prefix, "%i\t%i\t", intensity, line);
+		data->asyncLog->Push(prefix, prefixLength, textToOutputU8.data(), textToOutputU8.size(),
+			data->fileHandle != NULL, data->consoleEnabled);
+
+		// Important lines (e.g. crash reports) are on disk before we carry on.
+		// The writer thread doesn't take our lock, so it's fine to wait with it.
+		if (intensity >= data->asyncLog->flushIntensity)
+			data->asyncLog->Flush();
+		CloseLock();
+		return;
+	}
+
+	// Synchronous: write it now. The async writer may still be finishing if async logging was just
+	// turned off, and rotation swaps the file, so hold the output lock.
+	std::lock_guard<std::mutex> outputLock(data->outputLock);
 
+	// If blank time format, remove tab for time also
+	int written = 0;
+	if (showTime)
+	{
 		// Output
 		if (data->fileHandle)
-			fprintf_s(data->fileHandle, "%i\t%i\t%s\t%s\r\n", intensity, line, realTimeU8.c_str(), textToOutputU8.c_str());
+			written = fprintf_s(data->fileHandle, "%i\t%i\t%s\t%s\r\n", intensity, line, data->realTimeU8.c_str(), textToOutputU8.c_str());
 
 		// Console wants colourisin'
 		if (data->consoleEnabled)
@@ -171,7 +222,7 @@ void Extension::OutputNow(int intensity, int line, std::string textToOutputU8)
 	else
 	{
 		if (data->fileHandle)
-			fprintf_s(data->fileHandle, "%i\t%i\t%s\r\n", intensity, line, textToOutputU8.c_str());
+			written = fprintf_s(data->fileHandle, "%i\t%i\t%s\r\n", intensity, line, textToOutputU8.c_str());
 
 		// Console wants colourisin'
 		if (data->consoleEnabled)
@@ -189,6 +240,8 @@ void Extension::OutputNow(int intensity, int line, std::string textToOutputU8)
 		fflush(data->fileHandle);
 	if (data->consoleEnabled)
 		std::wcout.flush();
+	if (data->logRotation && written > 0)
+		data->logRotation->Wrote(written);
 	CloseLock();
 }
 void Extension::SetOutputTimeFormat(TCHAR * format)
@@ -204,6 +257,7 @@ void Extension::SetOutputTimeFormat(TCHAR * format)
 	OpenLock();
 
 	_tcscpy_s(data->timeFormat, 255, format);
+	data->rawtime = 0; // Reformat the cached time on next output
 
 	// Close lock
 	CloseLock();
@@ -295,6 +349,8 @@ void Extension::SetConsoleOnOff(int OnOff)
 		else // Close down a console
 		{
 			SetConsoleCtrlHandler(HandlerRoutine, FALSE);
+			if (data->asyncLog)
+				data->asyncLog->Flush();
 
 			data->releaseConsoleInput = true;
 
@@ -375,3 +431,72 @@ void Extension::SetDumpFile(const TCHAR * path, int flags)
 		CloseLock();
 	}
 }
+
+void Extension::SetAsyncLogging(int onOff, int flushIntensity)
+{
+	// Can't continue if Data failed to initialise
+	if (!data)
+		return;
+
+	OpenLock();
+	AsyncLog * asyncLog = data->asyncLog;
+	if ((onOff != 0) == (asyncLog != NULL))
+	{
+		if (asyncLog)
+			asyncLog->flushIntensity = flushIntensity;
+		CloseLock();
+		return;
+	}
+
+	if (onOff)
+	{
+		data->asyncLog = new AsyncLog(data);
+		data->asyncLog->flushIntensity = flushIntensity;
+		CloseLock();
+		return;
+	}
+
+	// Turning off: stop taking new lines, then let the writer finish what it has
+	data->asyncLog = NULL;
+	CloseLock();
+
+	const std::uint64_t dropped = asyncLog->Dropped();
+	delete asyncLog;
+
+	if (dropped > 0)
+	{
+		std::stringstream str;
+		str << "Asynchronous logging dropped " << dropped << " lines, as they were output faster than they could be written.";
+		OutputNow(5, -1, str.str());
+	}
+}
+
+void Extension::SetLogRotation(int maxSizeKB, int intervalMinutes, int keepCount)
+{
+	// Can't continue if Data failed to initialise
+	if (!data)
+		return;
+
+	if (maxSizeKB < 0 || intervalMinutes < 0 || keepCount < 0)
+	{
+		OutputNow(5, -1, "Log rotation settings can't be negative.");
+		return;
+	}
+
+	OpenLock();
+	if (!data->logRotation)
+	{
+		// Keep writers out while the rotation is set up
+		std::lock_guard<std::mutex> outputLock(data->outputLock);
+
+		LogRotation * logRotation = new LogRotation(data);
+		if (data->fileHandle)
+			logRotation->Opened(ftell(data->fileHandle));
+		data->logRotation = logRotation;
+	}
+
+	data->logRotation->maxBytes = maxSizeKB * 1024ULL;
+	data->logRotation->maxSeconds = intervalMinutes * 60U;
+	data->logRotation->keepCount = keepCount;
+	CloseLock();
+}
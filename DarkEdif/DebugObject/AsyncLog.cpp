@@ -0,0 +1,105 @@
+#include "Common.h"
+
+AsyncLog::AsyncLog(GlobalData * data) :
+	data(data), stop(false)
+{
+	fileBatch.reserve(64 * 1024);
+
+	wakeEvent = CreateEvent(NULL, FALSE, FALSE, NULL);
+	thread = CreateThread(NULL, NULL, WriterThread, this, NULL, NULL);
+}
+
+AsyncLog::~AsyncLog()
+{
+	stop = true;
+	SetEvent(wakeEvent);
+	WaitForSingleObject(thread, INFINITE);
+	CloseHandle(thread);
+	CloseHandle(wakeEvent);
+}
+
+bool AsyncLog::Push(const char * prefix, size_t prefixLength, const char * text, size_t textLength,
+	bool toFile, bool toConsole, bool raw /* = false */)
+{
+	// The writer wakes by itself every so often; only hurry it along when a batch is worth writing
+	bool wakeWriter;
+	const bool pushed = ring.Push(prefix, prefixLength, text, textLength, toFile, toConsole, raw, wakeWriter);
+	if (wakeWriter)
+		SetEvent(wakeEvent);
+	return pushed;
+}
+
+bool AsyncLog::Flush(DWORD timeoutMS /* = 2000 */)
+{
+	SetEvent(wakeEvent);
+	return ring.Flushed(std::chrono::milliseconds(timeoutMS));
+}
+
+DWORD WINAPI AsyncLog::WriterThread(void * asyncLog)
+{
+	AsyncLog * log = (AsyncLog *)asyncLog;
+	while (true)
+	{
+		WaitForSingleObject(log->wakeEvent, 50);
+
+		// Read stop first, so everything pushed before the destructor ran is written
+		const bool stopping = log->stop;
+		log->WriteOut();
+		if (stopping)
+			break;
+	}
+	return 0;
+}
+
+void AsyncLog::WriteOut()
+{
+	std::lock_guard<std::mutex> lock(data->outputLock);
+	bool wroteConsole = false;
+
+	const size_t popped = ring.Pop([&](const LogRing::Line &line) {
+		if (line.toFile && data->fileHandle)
+		{
+			fileBatch.append(line.text, line.length);
+			if (!line.raw)
+				fileBatch.append("\r\n", 2);
+		}
+
+		// Console wants colourisin'
+		if (line.toConsole && data->consoleOut)
+		{
+			SetConsoleTextAttribute(data->consoleOut, 0x0A);
+			wprintf_s(L"%s", UTF8ToWide(std::string_view(line.text, line.prefixLength)).c_str());
+			SetConsoleTextAttribute(data->consoleOut, 0x0B);
+			wprintf_s(L"%s\r\n", UTF8ToWide(std::string_view(line.text + line.prefixLength, line.length - line.prefixLength)).c_str());
+			SetConsoleTextAttribute(data->consoleOut, 0x07);
+			wroteConsole = true;
+		}
+
+		if (fileBatch.size() >= 60 * 1024 && data->fileHandle)
+			WriteBatch();
+	});
+
+	// One write and one flush per batch, rather than per line
+	if (!fileBatch.empty())
+	{
+		if (data->fileHandle)
+			WriteBatch();
+		fileBatch.clear();
+	}
+	if (popped)
+	{
+		if (data->fileHandle)
+			fflush(data->fileHandle);
+		if (wroteConsole)
+			std::wcout.flush();
+		ring.Written();
+	}
+}
+
+void AsyncLog::WriteBatch()
+{
+	fwrite(fileBatch.data(), 1, fileBatch.size(), data->fileHandle);
+	if (data->logRotation)
+		data->logRotation->Wrote(fileBatch.size());
+	fileBatch.clear();
+}
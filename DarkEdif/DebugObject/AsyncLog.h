@@ -0,0 +1,45 @@
+#pragma once
+#include <atomic>
+#include <mutex>
+#include <string>
+#include <cstdint>
+#include "LogRing.h"
+
+struct GlobalData;
+
+// Asynchronous logging: OutputNow() preformats each line and pushes it onto a bounded ring,
+// and a background thread writes the ring out in batches, so the frame loop never waits on disk I/O.
+// Multiple threads can push (the main thread, the console input thread, the crash handler);
+// only the writer thread pops.
+class AsyncLog
+{
+public:
+	AsyncLog(GlobalData * data);
+	~AsyncLog(); // Writes out everything pushed so far, then stops the writer thread
+
+	// Pushes a line; prefix is written in the console's prefix colour. Raw lines are written to file
+	// as-is, without a line ending. Returns false if the ring is full, and counts the drop.
+	bool Push(const char * prefix, size_t prefixLength, const char * text, size_t textLength,
+		bool toFile, bool toConsole, bool raw = false);
+
+	// Waits for everything pushed so far to be written and flushed, up to the timeout; the writer
+	// wakes the caller when it is. Must not be called while holding GlobalData::outputLock.
+	bool Flush(DWORD timeoutMS = 2000);
+
+	// Lines dropped because the ring was full
+	std::uint64_t Dropped() const { return ring.Dropped(); }
+
+	// Lines with at least this intensity are flushed before OutputNow() returns
+	std::atomic<int> flushIntensity { 5 };
+
+private:
+	GlobalData * data;
+	LogRing ring;
+	std::atomic<bool> stop;
+	HANDLE wakeEvent, thread;
+	std::string fileBatch;
+
+	static DWORD WINAPI WriterThread(void * asyncLog);
+	void WriteOut();
+	void WriteBatch();
+};
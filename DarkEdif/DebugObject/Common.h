@@ -31,6 +31,11 @@
 #define MULTI_THREADING
 #include "MultiThreading.h"
 #include <atomic>
+#include "AsyncLog.h"
+#include "LogRotation.h"
+
+#include "zlib.h"
+#pragma comment(lib, "..\\Lib\\Windows\\zlib.lib")
 
 // edPtr : Used at edittime and saved in the MFA/CCN/EXE files
 struct EDITDATA
@@ -70,13 +75,18 @@ struct RUNDATA
 	*/
 };
 struct GlobalData {
-	FILE * fileHandle;
+	std::atomic<FILE *> fileHandle;	// Change or write to it only while holding outputLock
+	std::mutex outputLock;			// Held while writing to the log or rotating it, by OutputNow() or the async writer
 	std::atomic<bool> readingThis, releaseConsoleInput;
 	bool debugEnabled, doMsgBoxIfPathNotSet, consoleEnabled;
-	time_t rawtime;
+	time_t rawtime;				// Time realTime was formatted for; it's reformatted at most once a second
 	struct tm * timeinfo;
 	TCHAR timeFormat[128];
 	TCHAR realTime[128];
+	std::string realTimeU8;
+	AsyncLog * asyncLog;		// Null unless asynchronous logging is on
+	std::tstring logPath;		// Path of the open log file
+	LogRotation * logRotation;	// Null unless log rotation is on
 	unsigned char numUsages;
 	HANDLE consoleIn, consoleOut;
 	std::tstring consoleReceived;
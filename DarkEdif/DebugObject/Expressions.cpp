@@ -10,3 +10,8 @@ const TCHAR * Extension::CommandMinusName(void)
 	return Runtime.CopyString((data->consoleReceived.find(_T(' ')) == std::tstring::npos ? _T("") :
 				data->consoleReceived.c_str() + data->consoleReceived.find(_T(' ')) + 1));
 }
+
+int Extension::DroppedLogLines(void)
+{
+	return data->asyncLog ? (int)data->asyncLog->Dropped() : 0;
+}
@@ -34,6 +34,8 @@ Extension::Extension(RUNDATA * _rdPtr, EDITDATA * edPtr, CreateObjectInfo * cobP
 	LinkAction(10, CauseCrash_ArrayOutOfBoundsWrite);
 	LinkAction(11, SetConsoleOnOff);
 	LinkAction(12, SetDumpFile);
+	LinkAction(13, SetAsyncLogging);
+	LinkAction(14, SetLogRotation);
 
 	LinkCondition(0, AlwaysTrue /* OnAnyConsoleInput */);
 	LinkCondition(1, OnSpecificConsoleInput);
@@ -44,6 +46,7 @@ Extension::Extension(RUNDATA * _rdPtr, EDITDATA * edPtr, CreateObjectInfo * cobP
 
 	LinkExpression(0, FullCommand);
 	LinkExpression(1, CommandMinusName);
+	LinkExpression(2, DroppedLogLines);
 
 	if (edPtr->IsPropChecked(4))
 		MessageBoxA(NULL, "Pause for debugger property is enabled; attach your debugger now then continue the process.", "DebugObject - Information", MB_OK | MB_ICONASTERISK);
@@ -79,10 +82,19 @@ Extension::~Extension()
 	// Are we the last using this Data?
 	if ((--data->numUsages) == 0)
 	{
-		// Close resources
-		if (data->fileHandle)
-			fclose(data->fileHandle);
-		data->fileHandle = NULL;
+		// Close resources; the async writer finishes writing first
+		delete data->asyncLog;
+		data->asyncLog = NULL;
+		{
+			std::lock_guard<std::mutex> outputLock(data->outputLock);
+			if (data->fileHandle)
+				fclose(data->fileHandle);
+			data->fileHandle = NULL;
+		}
+
+		// Waits for rotated logs to finish compressing
+		delete data->logRotation;
+		data->logRotation = NULL;
 
 		// Close MMF pointer to Data
 		Runtime.WriteGlobal(GlobalID, NULL);
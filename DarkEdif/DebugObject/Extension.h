@@ -10,7 +10,8 @@ public:
 
 	GlobalData * data;
 	static const int MinimumBuild = 256;
-	static const int Version = 14;
+	static const int Version = 15;
+	// b15: Added asynchronous logging, log rotation
 	// b14: Added more details to crash information
 	// b13: Fixed message box about properties failing to convert
 	// b12: Fixed use of tcsdup in expressions, upgrade to SDK v5
@@ -68,6 +69,8 @@ public:
 		void CauseCrash_ArrayOutOfBoundsWrite();
 		void SetConsoleOnOff(int onOff);
 		void SetDumpFile(const TCHAR * path, int flags);
+		void SetAsyncLogging(int onOff, int flushIntensity);
+		void SetLogRotation(int maxSizeKB, int intervalMinutes, int keepCount);
 
 	/// Conditions
 		const bool AlwaysTrue() const;
@@ -76,6 +79,7 @@ public:
 	/// Expressions
 		const TCHAR * FullCommand();
 		const TCHAR * CommandMinusName();
+		int DroppedLogLines();
 
 		void LoadDataVariable();
 
@@ -0,0 +1,154 @@
+#pragma once
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <mutex>
+
+// The ring of preformatted lines behind AsyncLog. It's a bounded multi-producer queue (after
+// Dmitry Vyukov's): each record's sequence says whose turn it is. A record at position pos is free
+// for a producer when sequence == pos, and ready for the writer when sequence == pos + 1; the
+// writer hands it back with pos + capacity.
+// Only needs the standard library, so it can be tested away from Fusion; waking the writer is left
+// to AsyncLog.
+class LogRing
+{
+public:
+	static const size_t capacity = 2048; // Power of two; about half a MB of records
+
+	// A line as the writer sees it; text is prefixLength bytes of prefix, then the rest
+	struct Line
+	{
+		const char * text;
+		size_t prefixLength, length;
+		bool toFile, toConsole, raw;
+	};
+
+	LogRing() : records(new Record[capacity]), pushPos(0), popPos(0), dropped(0), written(0)
+	{
+		for (size_t i = 0; i < capacity; ++i)
+		{
+			records[i].sequence = i;
+			records[i].longText = NULL;
+		}
+	}
+	~LogRing()
+	{
+		for (size_t i = 0; i < capacity; ++i)
+			free(records[i].longText);
+		delete[] records;
+	}
+
+	// Pushes a line. Returns false if the ring is full, and counts the drop. Sets wakeWriter when
+	// the writer should be woken rather than left to wake by itself: when the ring is full, or
+	// a batch is worth writing.
+	bool Push(const char * prefix, size_t prefixLength, const char * text, size_t textLength,
+		bool toFile, bool toConsole, bool raw, bool &wakeWriter)
+	{
+		// Claim a record
+		Record * record;
+		size_t pos = pushPos.load(std::memory_order_relaxed);
+		while (true)
+		{
+			record = &records[pos & (capacity - 1)];
+			const std::intptr_t diff = (std::intptr_t)record->sequence.load(std::memory_order_acquire) - (std::intptr_t)pos;
+			if (diff == 0)
+			{
+				if (pushPos.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed))
+					break;
+			}
+			else if (diff < 0) // The writer hasn't got this far round yet; the ring is full
+			{
+				++dropped;
+				wakeWriter = true;
+				return false;
+			}
+			else
+				pos = pushPos.load(std::memory_order_relaxed);
+		}
+
+		record->toFile = toFile;
+		record->toConsole = toConsole;
+		record->raw = raw;
+		record->length = prefixLength + textLength;
+
+		if (record->length > sizeof(record->text) && (record->longText = (char *)malloc(record->length)) == NULL)
+			record->length = sizeof(record->text); // Out of memory; keep what fits
+
+		char * to = record->longText ? record->longText : record->text;
+		record->prefixLength = prefixLength = (std::min)(prefixLength, record->length);
+		memcpy(to, prefix, prefixLength);
+		memcpy(to + prefixLength, text, record->length - prefixLength);
+
+		record->sequence.store(pos + 1, std::memory_order_release);
+
+		wakeWriter = (pos & 63) == 0;
+		return true;
+	}
+
+	// Writer only: passes each line that's ready to write(const Line &), in the order pushed, and
+	// frees its record. Returns the number of lines popped.
+	template<class Write>
+	size_t Pop(Write && write)
+	{
+		const size_t start = popPos;
+		while (true)
+		{
+			Record &record = records[popPos & (capacity - 1)];
+			if (record.sequence.load(std::memory_order_acquire) != popPos + 1)
+				break;
+
+			write(Line { record.longText ? record.longText : record.text, record.prefixLength, record.length,
+				record.toFile, record.toConsole, record.raw });
+
+			free(record.longText);
+			record.longText = NULL;
+			record.sequence.store(popPos + capacity, std::memory_order_release);
+			++popPos;
+		}
+		return popPos - start;
+	}
+
+	// Writer only: every line popped so far has been written and flushed; wakes Flushed() waiters
+	void Written()
+	{
+		{
+			std::lock_guard<std::mutex> lock(writtenLock);
+			written = popPos;
+		}
+		writtenChanged.notify_all();
+	}
+
+	// Waits for every line pushed before the call to be Written(), up to the timeout
+	bool Flushed(std::chrono::milliseconds timeout)
+	{
+		const size_t target = pushPos.load();
+		std::unique_lock<std::mutex> lock(writtenLock);
+		return writtenChanged.wait_for(lock, timeout, [&] { return written >= target; });
+	}
+
+	// Lines dropped because the ring was full
+	std::uint64_t Dropped() const { return dropped; }
+
+private:
+	struct Record
+	{
+		std::atomic<size_t> sequence;
+		bool toFile, toConsole, raw;
+		size_t prefixLength, length;
+		char * longText; // Used instead of text when the line doesn't fit
+		char text[232];
+	};
+
+	Record * records;
+	std::atomic<size_t> pushPos;
+	size_t popPos;
+	std::atomic<std::uint64_t> dropped;
+
+	std::mutex writtenLock;
+	std::condition_variable writtenChanged;
+	size_t written; // Guarded by writtenLock
+};
@@ -0,0 +1,184 @@
+#include "Common.h"
+#include <algorithm>
+#include <vector>
+
+LogRotation::LogRotation(GlobalData * data) :
+	maxBytes(0), maxSeconds(0), keepCount(0), data(data), bytes(0), openedAt(time(NULL)), stop(false)
+{
+	wakeEvent = CreateEvent(NULL, FALSE, FALSE, NULL);
+	thread = CreateThread(NULL, NULL, CompressThread, this, NULL, NULL);
+	SetThreadPriority(thread, THREAD_PRIORITY_BELOW_NORMAL);
+}
+
+LogRotation::~LogRotation()
+{
+	stop = true;
+	SetEvent(wakeEvent);
+	WaitForSingleObject(thread, INFINITE);
+	CloseHandle(thread);
+	CloseHandle(wakeEvent);
+}
+
+void LogRotation::Opened(std::uint64_t size)
+{
+	bytes = size;
+	openedAt = time(NULL);
+}
+
+void LogRotation::Wrote(size_t written)
+{
+	bytes += written;
+
+	const std::uint64_t maxBytes = this->maxBytes;
+	const unsigned int maxSeconds = this->maxSeconds;
+	if ((maxBytes && bytes >= maxBytes) || (maxSeconds && (unsigned int)(time(NULL) - openedAt) >= maxSeconds))
+		Rotate();
+}
+
+void LogRotation::Rotate()
+{
+	if (!data->fileHandle || data->logPath.empty())
+		return;
+
+	fclose(data->fileHandle);
+	data->fileHandle = NULL;
+
+	// Date and time in the name sorts archives oldest first
+	const time_t now = time(NULL);
+	struct tm local;
+	localtime_s(&local, &now);
+	TCHAR stamp[32];
+	_tcsftime(stamp, std::size(stamp), _T("%Y%m%d-%H%M%S"), &local);
+
+	std::tstring segment = data->logPath + _T(".") + stamp;
+	for (int i = 2; _taccess(segment.c_str(), 0) == 0 || _taccess((segment + _T(".gz")).c_str(), 0) == 0; ++i)
+		segment = data->logPath + _T(".") + stamp + _T("-") + std::to_tstring(i);
+
+	if (_trename(data->logPath.c_str(), segment.c_str()) == 0)
+	{
+		std::lock_guard<std::mutex> lock(pendingLock);
+		pending.emplace_back(segment, data->logPath);
+		SetEvent(wakeEvent);
+	}
+
+	// If the rename failed, start the log over rather than letting it grow forever
+	data->fileHandle = _tfsopen(data->logPath.c_str(), _T("wb"), _SH_DENYNO);
+	bytes = 0;
+	openedAt = now;
+}
+
+DWORD WINAPI LogRotation::CompressThread(void * logRotation)
+{
+	LogRotation * rotation = (LogRotation *)logRotation;
+	while (true)
+	{
+		WaitForSingleObject(rotation->wakeEvent, INFINITE);
+		const bool stopping = rotation->stop;
+
+		while (true)
+		{
+			std::pair<std::tstring, std::tstring> next;
+			{
+				std::lock_guard<std::mutex> lock(rotation->pendingLock);
+				if (rotation->pending.empty())
+					break;
+				next = std::move(rotation->pending.front());
+				rotation->pending.pop_front();
+			}
+
+			// If it can't be compressed, leave the segment as it is; it'll still count as an archive
+			Compress(next.first);
+			rotation->Prune(next.second);
+		}
+
+		if (stopping)
+			break;
+	}
+	return 0;
+}
+
+bool LogRotation::Compress(const std::tstring &segment)
+{
+	FILE * in = _tfsopen(segment.c_str(), _T("rb"), _SH_DENYWR);
+	if (!in)
+		return false;
+
+	const std::tstring archive = segment + _T(".gz");
+#ifdef _UNICODE
+	gzFile out = gzopen_w(archive.c_str(), "wb6");
+#else
+	gzFile out = gzopen(archive.c_str(), "wb6");
+#endif
+	if (!out)
+	{
+		fclose(in);
+		return false;
+	}
+
+	std::vector<char> buffer(64 * 1024);
+	bool ok = true;
+	size_t read;
+	while (ok && (read = fread(buffer.data(), 1, buffer.size(), in)) > 0)
+		ok = gzwrite(out, buffer.data(), (unsigned int)read) == (int)read;
+
+	ok = gzclose(out) == Z_OK && ok && !ferror(in);
+	fclose(in);
+
+	_tremove(ok ? segment.c_str() : archive.c_str());
+	return ok;
+}
+
+void LogRotation::Prune(const std::tstring &logPath)
+{
+	const unsigned int keepCount = this->keepCount;
+	if (keepCount == 0)
+		return;
+
+	// Rotated segments are named "<log file name>.<stamp>", or "<log file name>.<stamp>-<n>" from the
+	// second on in the same second, with ".gz" once compressed
+	const size_t slash = logPath.find_last_of(_T("\\/"));
+	const std::tstring folder = slash == std::tstring::npos ? std::tstring() : logPath.substr(0, slash + 1);
+	const size_t nameLength = logPath.size() - folder.size();
+	const size_t stampLength = std::size(_T("YYYYMMDD-HHMMSS")) - 1;
+
+	struct Archive
+	{
+		std::tstring path, stamp;
+		unsigned long sequence;
+	};
+	std::vector<Archive> archives;
+	WIN32_FIND_DATA find;
+	HANDLE findHandle = FindFirstFile((logPath + _T(".*")).c_str(), &find);
+	if (findHandle == INVALID_HANDLE_VALUE)
+		return;
+	do
+	{
+		if (find.dwFileAttributes & FILE_ATTRIBUTE_DIRECTORY)
+			continue;
+
+		// Skip unrelated files that happen to share the prefix, e.g. "Log.txt" for a log path of "Log"
+		const TCHAR * name = find.cFileName + nameLength + 1;
+		if (_tcslen(name) < stampLength || !_istdigit(name[0]))
+			continue;
+
+		TCHAR * end = (TCHAR *)name + stampLength;
+		unsigned long sequence = 1;
+		if (*end == _T('-'))
+			sequence = _tcstoul(end + 1, &end, 10);
+		if (*end != _T('\0') && _tcscmp(end, _T(".gz")))
+			continue;
+
+		archives.push_back({ folder + find.cFileName, std::tstring(name, stampLength), sequence });
+	} while (FindNextFile(findHandle, &find));
+	FindClose(findHandle);
+
+	if (archives.size() <= keepCount)
+		return;
+
+	// Oldest first; sorting the names would put "<stamp>-2" before "<stamp>.gz"
+	std::sort(archives.begin(), archives.end(), [](const Archive &a, const Archive &b) {
+		return a.stamp != b.stamp ? a.stamp < b.stamp : a.sequence < b.sequence;
+	});
+	for (size_t i = 0; i < archives.size() - keepCount; ++i)
+		_tremove(archives[i].path.c_str());
+}
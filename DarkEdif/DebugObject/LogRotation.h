@@ -0,0 +1,44 @@
+#pragma once
+#include <atomic>
+#include <mutex>
+#include <deque>
+#include <string>
+#include <utility>
+#include <cstdint>
+
+struct GlobalData;
+
+// Rotates the log file once it reaches a size or age, so a long-running app doesn't grow one huge log.
+// The finished segment is renamed to "<log path>.<date>-<time>" and gzip-compressed by a background
+// thread to "<segment>.gz", then archives beyond the retention count are deleted, oldest first.
+class LogRotation
+{
+public:
+	LogRotation(GlobalData * data);
+	~LogRotation(); // Finishes compressing any rotated segments
+
+	// Zero means no limit, or for keepCount, keep every archive
+	std::atomic<std::uint64_t> maxBytes;
+	std::atomic<unsigned int> maxSeconds, keepCount;
+
+	// Call when the log file is opened; size is what's already in it
+	void Opened(std::uint64_t size);
+
+	// Call after writing to the log file, holding GlobalData::outputLock; may rotate the file.
+	void Wrote(size_t bytes);
+
+private:
+	GlobalData * data;
+	std::uint64_t bytes;
+	time_t openedAt;
+
+	std::mutex pendingLock;
+	std::deque<std::pair<std::tstring, std::tstring>> pending; // Segment and the log path it came from
+	std::atomic<bool> stop;
+	HANDLE wakeEvent, thread;
+
+	void Rotate();
+	static DWORD WINAPI CompressThread(void * logRotation);
+	static bool Compress(const std::tstring &segment);
+	void Prune(const std::tstring &logPath);
+};
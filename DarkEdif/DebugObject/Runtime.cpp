@@ -32,6 +32,11 @@ void Extension::LoadDataVariable()
 		memset(data->timeFormat, 0, sizeof(data->timeFormat));
 		memset(data->realTime, 0, sizeof(data->realTime));
 		_tcscpy_s(data->timeFormat, std::size(data->timeFormat), _T("%X"));
+		data->rawtime = 0;
+		data->realTimeU8 = std::string();
+		data->asyncLog = NULL;
+		data->logPath = std::tstring();
+		data->logRotation = NULL;
 		data->numUsages = 1;
 		data->doMsgBoxIfPathNotSet = false;
 		data->consoleIn = NULL;
@@ -0,0 +1,88 @@
+#pragma once
+
+// The trampolines the Link macros register for each A/C/E function. Only needs the standard
+// library, so the conversions can be tested away from Fusion.
+
+#include <cstdint>
+#include <cstring>
+#include <type_traits>
+#include <utility>
+
+class Extension;
+
+namespace Edif
+{
+	// Calls a linked A/C/E function with its parameters, already read from Fusion as int-sized values.
+	// Returns the result as Fusion expects it: bools and integers as-is, float bits, or the string pointer.
+	typedef std::intptr_t (* ACEFunction)(Extension * Ext, const std::intptr_t * Params);
+
+	// Converts one parameter as read by ActionOrCondition() or Expression() to the C++ parameter type.
+	template<class T> inline T ACEParam(std::intptr_t Param)
+	{
+		typedef typename std::remove_cv<T>::type Type;
+
+		if constexpr (std::is_same<Type, float>::value)
+		{
+			// Fusion hands over floats as their bits in an int
+			std::int32_t Bits = (std::int32_t)Param;
+			float Value;
+			memcpy(&Value, &Bits, sizeof(Value));
+			return Value;
+		}
+		else if constexpr (std::is_pointer<Type>::value)
+			return reinterpret_cast<Type>(Param);
+		else
+			return (Type)Param;
+	}
+
+	// Converts the C++ function's return value back to what Fusion expects.
+	template<class T> inline std::intptr_t ACEReturn(T Value)
+	{
+		typedef typename std::remove_cv<T>::type Type;
+
+		if constexpr (std::is_same<Type, float>::value)
+		{
+			std::int32_t Bits;
+			memcpy(&Bits, &Value, sizeof(Bits));
+			return Bits;
+		}
+		else if constexpr (std::is_pointer<Type>::value)
+			return reinterpret_cast<std::intptr_t>(Value);
+		else
+			return (std::intptr_t)Value;
+	}
+
+	// Generates a typed trampoline for one A/C/E function at compile time, so it can be called
+	// through an ACEFunction without pushing its parameters by hand.
+	template<class Struct, auto Function, class Ret, class... Args>
+	struct ACEThunkImpl
+	{
+		static std::intptr_t Call(Extension * Ext, const std::intptr_t * Params)
+		{
+			return Invoke(static_cast<Struct *>(Ext), Params, std::index_sequence_for<Args...>());
+		}
+
+		template<std::size_t... I>
+		static std::intptr_t Invoke(Struct * Ext, const std::intptr_t * Params, std::index_sequence<I...>)
+		{
+			(void)Params;
+
+			if constexpr (std::is_void<Ret>::value)
+			{
+				(Ext->*Function)(ACEParam<Args>(Params[I])...);
+				return 0;
+			}
+			else
+				return ACEReturn<Ret>((Ext->*Function)(ACEParam<Args>(Params[I])...));
+		}
+	};
+
+	template<auto Function, class Type = decltype(Function)>
+	struct ACEThunk;
+
+	template<auto Function, class Ret, class Struct, class... Args>
+	struct ACEThunk<Function, Ret(Struct::*)(Args...)> : ACEThunkImpl<Struct, Function, Ret, Args...> { };
+
+	template<auto Function, class Ret, class Struct, class... Args>
+	struct ACEThunk<Function, Ret(Struct::*)(Args...) const> : ACEThunkImpl<Struct, Function, Ret, Args...> { };
+}
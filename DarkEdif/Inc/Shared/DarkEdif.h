@@ -59,6 +59,8 @@ Prop * GetProperty(EDITDATA *, size_t);
 
 void PropChangeChkbox(EDITDATA * edPtr, unsigned int PropID, const bool newValue);
 void PropChange(mv * mV, EDITDATA * &edPtr, unsigned int PropID, const void * newData, size_t newSize);
+// Moves properties saved flat, or for an older JSON, to chunks for the current one; true if moved
+bool MigrateProps(mv * mV, EDITDATA * &edPtr);
 char * PropIndex(EDITDATA * edPtr, unsigned int ID, unsigned int * size);
 
 #endif // NOPROPS
@@ -455,7 +457,7 @@ forLoopE(unsigned int ID, const _json_value &json, std::stringstream &str, Ret(S
 }
 
 template<class Ret, class Struct, class... Args>
-void LinkActionDebug(unsigned int ID, Ret(Struct::*Function)(Args...) const)
+void LinkActionDebug(unsigned int ID, Ret(Struct::*Function)(Args...) const, Edif::ACEFunction Thunk)
 {
 	std::stringstream str;
 	for (size_t k = 0; k < SDK->json.u.object.length; k++)
@@ -520,11 +522,11 @@ void LinkActionDebug(unsigned int ID, Ret(Struct::*Function)(Args...) const)
 		MessageBoxA(NULL, str.str().c_str(), extName, MB_OK);
 	}
 
-	SDK->ActionFunctions[ID] = Edif::MemberFunctionPointer(Function);
+	SDK->ActionFunctions[ID] = Thunk;
 }
 
 template<class Ret, class Struct, class... Args>
-void LinkConditionDebug(unsigned int ID, Ret(Struct::*Function)(Args...) const)
+void LinkConditionDebug(unsigned int ID, Ret(Struct::*Function)(Args...) const, Edif::ACEFunction Thunk)
 {
 	std::stringstream str;
 	for (size_t k = 0; k < SDK->json.u.object.length; k++)
@@ -580,11 +582,11 @@ void LinkConditionDebug(unsigned int ID, Ret(Struct::*Function)(Args...) const)
 		MessageBoxA(NULL, str.str().c_str(), extName, MB_OK);
 	}
 
-	SDK->ConditionFunctions[ID] = Edif::MemberFunctionPointer(Function);
+	SDK->ConditionFunctions[ID] = Thunk;
 }
 
 template<class Ret, class Struct, class... Args>
-void LinkExpressionDebug(unsigned int ID, Ret(Struct::*Function)(Args...) const)
+void LinkExpressionDebug(unsigned int ID, Ret(Struct::*Function)(Args...) const, Edif::ACEFunction Thunk)
 {
 	std::stringstream str;
 	for (size_t k = 0; k < SDK->json.u.object.length; k++)
@@ -684,7 +686,7 @@ void LinkExpressionDebug(unsigned int ID, Ret(Struct::*Function)(Args...) const)
 		MessageBoxA(NULL, str.str().c_str(), extName, MB_OK);
 	}
 
-	SDK->ExpressionFunctions[ID] = Edif::MemberFunctionPointer(Function);
+	SDK->ExpressionFunctions[ID] = Thunk;
 }
 
 // Combine the two:
@@ -693,19 +695,19 @@ void LinkExpressionDebug(unsigned int ID, Ret(Struct::*Function)(Args...) const)
 // to resolve ambiguity complaints between Extension::* and const Extension::*
 
 template<class Ret, class Struct, class... Args>
-void LinkActionDebug(unsigned int ID, Ret(Struct::*Function)(Args...))
+void LinkActionDebug(unsigned int ID, Ret(Struct::*Function)(Args...), Edif::ACEFunction Thunk)
 {
-	LinkActionDebug(ID, (Ret(Struct::*)(Args...) const)Function);
+	LinkActionDebug(ID, (Ret(Struct::*)(Args...) const)Function, Thunk);
 }
 template<class Ret, class Struct, class... Args>
-void LinkConditionDebug(unsigned int ID, Ret(Struct::*Function)(Args...))
+void LinkConditionDebug(unsigned int ID, Ret(Struct::*Function)(Args...), Edif::ACEFunction Thunk)
 {
-	LinkConditionDebug(ID, (Ret(Struct::*)(Args...) const)Function);
+	LinkConditionDebug(ID, (Ret(Struct::*)(Args...) const)Function, Thunk);
 }
 template<class Ret, class Struct, class... Args>
-void LinkExpressionDebug(unsigned int ID, Ret(Struct::*Function)(Args...))
+void LinkExpressionDebug(unsigned int ID, Ret(Struct::*Function)(Args...), Edif::ACEFunction Thunk)
 {
-	LinkExpressionDebug(ID, (Ret(Struct::*)(Args...) const)Function);
+	LinkExpressionDebug(ID, (Ret(Struct::*)(Args...) const)Function, Thunk);
 }
 
 #endif
@@ -7,6 +7,11 @@
 #include <vector>
 #include <list>
 #include <string>
+#include <cstdint>
+#include <cstring>
+#include <type_traits>
+#include <utility>
+#include <memory>
 
 #include "MMFMasterHeader.h"
 
@@ -24,6 +29,9 @@
 class Extension;
 
 #include "ObjectSelection.h"
+#include "ACEThunk.h"
+#include "PropertyLayout.h"
+#include "StringArena.h"
 
 #if EditorBuild
 #if defined(MMFEXT)
@@ -41,23 +49,23 @@ class Extension;
 #if defined(_DEBUG) && !defined(FAST_ACE_LINK)
 
 #define LinkAction(ID, Function) \
-	LinkActionDebug(ID, &Extension::Function);
+	LinkActionDebug(ID, &Extension::Function, &Edif::ACEThunk<&Extension::Function>::Call);
 
 #define LinkCondition(ID, Function) \
-	LinkConditionDebug(ID, &Extension::Function);
+	LinkConditionDebug(ID, &Extension::Function, &Edif::ACEThunk<&Extension::Function>::Call);
 
 #define LinkExpression(ID, Function) \
-	LinkExpressionDebug(ID, &Extension::Function);
+	LinkExpressionDebug(ID, &Extension::Function, &Edif::ACEThunk<&Extension::Function>::Call);
 
 #else
 #define LinkAction(ID, Function) \
-	SDK->ActionFunctions[ID] = Edif::MemberFunctionPointer(&Extension::Function);
+	SDK->ActionFunctions[ID] = &Edif::ACEThunk<&Extension::Function>::Call;
 
 #define LinkCondition(ID, Function) \
-	SDK->ConditionFunctions[ID] = Edif::MemberFunctionPointer(&Extension::Function);
+	SDK->ConditionFunctions[ID] = &Edif::ACEThunk<&Extension::Function>::Call;
 
 #define LinkExpression(ID, Function) \
-	SDK->ExpressionFunctions[ID] = Edif::MemberFunctionPointer(&Extension::Function);
+	SDK->ExpressionFunctions[ID] = &Edif::ACEThunk<&Extension::Function>::Call;
 #endif
 
 extern HINSTANCE hInstLib;
@@ -141,6 +149,21 @@ namespace Edif
 		};
 	}
 #endif // EditorBuild
+	// Everything needed to call an A/C/E, read from the JSON once when the SDK is created,
+	// so Action(), Condition() and Expression() only have to index an array.
+	struct ACEDescriptor
+	{
+		union ParamType {
+			Params p;		// Actions, conditions
+			ExpParams ep;	// Expressions
+		};
+
+		short			NumParams;		// Parameters read and passed to the function; from NumAutoProps if set
+		short			FloatFlags;		// If bit n is set, parameter n is a float
+		ExpReturnType	Returns;		// Expressions only
+		ParamType		Parameter[sizeof(short) * 8];
+	};
+
 	class SDK
 	{
 	public:
@@ -154,13 +177,19 @@ namespace Edif
 		std::vector<ACEInfo *>	ConditionInfos;
 		std::vector<ACEInfo *>	ExpressionInfos;
 
+		std::vector<ACEDescriptor> ActionDescriptors;
+		std::vector<ACEDescriptor> ConditionDescriptors;
+		std::vector<ACEDescriptor> ExpressionDescriptors;
+
 		void ** ActionJumps;
 		void ** ConditionJumps;
 		void ** ExpressionJumps;
 
-		std::vector<void *> ActionFunctions;
-		std::vector<void *> ConditionFunctions;
-		std::vector<void *> ExpressionFunctions;
+		std::vector<ACEFunction> ActionFunctions;
+		std::vector<ACEFunction> ConditionFunctions;
+		std::vector<ACEFunction> ExpressionFunctions;
+
+		Edif::PropertyLayouts PropertyLayouts;
 		mv * mV;
 
 #if EditorBuild
@@ -170,12 +199,45 @@ namespace Edif
 #endif
 	};
 
+#ifdef DARKEDIF_ACE_PROFILER
+	// Opt-in profiler for the actions, conditions and expressions called through the ACE tables.
+	// Define DARKEDIF_ACE_PROFILER in Common.h; the report is written to the temp folder as
+	// "<extension> ACE profile.txt" when the extension is unloaded, and Report() can be returned
+	// from an expression of your own to watch it live.
+	namespace Profiler
+	{
+		enum class ACEType : std::uint8_t
+		{
+			Action,
+			Condition,
+			Expression,
+		};
+		struct Entry
+		{
+			std::uint64_t Calls;
+			std::uint64_t Ticks;		// Time stamp counter ticks, summed over all calls
+			std::uint64_t MaxTicks;
+			std::uint64_t StringBytes;	// Bytes of strings returned, for expressions
+		};
+
+		// Totals for one ACE, summed over every thread that has called it
+		Entry Get(ACEType Type, unsigned int ID);
+		// One line per ACE that's been called, slowest total first
+		std::string Report();
+		// Writes Report() to the given file, or the temp folder if null
+		bool Dump(const TCHAR * Path = nullptr);
+	}
+#endif
+
 	class Runtime
 	{
 	protected:
 
 		RUNDATA * rdPtr;
 
+		// Storage for CopyString and friends; see StringArena.h
+		std::unique_ptr<StringArena> stringArena;
+
 	public:
 
 		long param1, param2;
@@ -192,6 +254,16 @@ namespace Edif
 		TCHAR * CopyString(const TCHAR *);
 		char * CopyStringEx(const char *);
 		wchar_t * CopyStringEx(const wchar_t *);
+		// Converts UTF-8 to TCHAR and copies it; repeat conversions of the same text are cached
+		TCHAR * CopyUTF8String(const char * utf8, size_t length);
+
+		// Counters for the string arena, reset only when the Runtime is destroyed
+		const StringArena::Stats & GetStringArenaStats() const;
+
+		// Keeps every string copied so far valid until the matching ReleaseStrings(), and frees the
+		// strings copied in between; Edif::Action and Edif::Condition call these around the extension
+		void HoldStrings();
+		void ReleaseStrings();
 
 		void Pause();
 		void Resume();
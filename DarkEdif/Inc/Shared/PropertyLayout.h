@@ -0,0 +1,397 @@
+#pragma once
+
+// Where each property's data is in EDITDATA::DarkEdif_Props, read from the JSON once when the SDK
+// is created, so PropIndex() doesn't have to walk and compare every property before it; and the
+// chunked layout properties are saved in. Only needs json.h and the standard library, so the
+// offsets and migrations can be tested away from Fusion.
+
+#include "json.h"
+
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace Edif
+{
+	struct PropertyLayout
+	{
+		enum class Types : std::uint8_t
+		{
+			Text,
+			Checkbox,
+			Folder,			// Includes Folder End
+			EditButton,
+			EditboxString,	// Null-terminated UTF-8, so variable size
+			EditboxNumber,	// unsigned int
+			ComboBox,		// unsigned int index of the selected item
+			Other,			// Not stored in DarkEdif_Props
+		};
+
+		Types			Type;
+		unsigned int	FixedOffset;	// Size of the fixed-size data before this property's, past the checkbox bits
+		unsigned int	FixedSize;		// Size of this property's data, if fixed
+		unsigned int	StringsBefore;	// Editbox String properties before this one, whose sizes vary per EDITDATA
+		std::string		Default;		// Data from DefaultState, as InitialisePropertiesFromJSON() writes it
+		bool			DefaultChecked;	// Checkbox bit from DefaultState or ChkDefault
+	};
+
+	// Properties used to be stored flat: the checkbox bits, then each property's data back to back,
+	// so resizing one string meant moving everything after it. They're now stored in chunks:
+	// the checkbox bits (still first, as extensions read them directly), a version-tagged header,
+	// a table of each property's chunk, then the chunks, with spare capacity for strings to grow into,
+	// and last a trailer saying where the header is. The header's place depends on how many checkbox
+	// bits the data was saved with, so without the trailer it could only be found by searching, which
+	// could mistake property data for it.
+	//
+	// Once the header is found, the data is always read as chunks. If the extension's properties
+	// have changed since it was saved, each property is read from the chunk with its ID if that has
+	// the same type, and gets its default otherwise; chunks past the current properties are dropped.
+	// Flat properties from older MFAs, which have no header, are still read. Either is moved to
+	// chunks for the current properties by MigrateProps(), when the properties are shown or changed.
+	struct PropChunkHeader
+	{
+		// "DEPc" in memory, built from bytes as multi-character literals are up to the compiler
+		static const std::uint32_t Magic = (std::uint32_t)'D' | (std::uint32_t)'E' << 8 |
+			(std::uint32_t)'P' << 16 | (std::uint32_t)'c' << 24;
+		static const std::uint16_t LatestVersion = 3;
+
+		std::uint32_t Magic_;
+		std::uint16_t Version;
+		std::uint16_t Count;		// Number of properties the data was saved for; one PropChunk each
+		std::uint32_t TypesHash;	// Of the properties' types, so a changed property list is spotted without the table
+	};
+	struct PropChunkTrailer
+	{
+		// "DEPt" in memory
+		static const std::uint32_t Magic = (std::uint32_t)'D' | (std::uint32_t)'E' << 8 |
+			(std::uint32_t)'P' << 16 | (std::uint32_t)'t' << 24;
+
+		std::uint32_t HeaderOffset;	// From the start of DarkEdif_Props
+		std::uint32_t Magic_;
+	};
+	struct PropChunk
+	{
+		std::uint32_t Offset;		// From the start of DarkEdif_Props
+		std::uint32_t Capacity;
+		std::uint8_t Type;			// PropertyLayout::Types the data was saved as
+		std::uint8_t Reserved[3];
+	};
+
+	// The layouts of all the extension's properties, indexed by property ID.
+	class PropertyLayouts
+	{
+		std::vector<PropertyLayout> Layouts;
+		std::uint32_t TypesHash = 0;
+
+		// The header is after the checkbox bits for Count properties, aligned
+		static size_t HeaderOffset(size_t Count)
+		{
+			return ((Count + 7) / 8 + 3) & ~(size_t)3;
+		}
+
+		static bool HasData(PropertyLayout::Types Type)
+		{
+			typedef PropertyLayout::Types Types;
+			return Type == Types::EditboxString || Type == Types::EditboxNumber || Type == Types::ComboBox;
+		}
+
+		// The chunk saved for property ID, if it's still the same type and within Props
+		static bool SavedChunk(const PropChunk * Table, const PropChunkHeader &Header, size_t PropsSize,
+			unsigned int ID, PropertyLayout::Types Type, PropChunk &Chunk)
+		{
+			if (ID >= Header.Count)
+				return false;
+
+			memcpy(&Chunk, &Table[ID], sizeof(Chunk));
+			return Chunk.Type == (std::uint8_t)Type && Chunk.Offset <= PropsSize && Chunk.Capacity <= PropsSize - Chunk.Offset;
+		}
+
+	public:
+
+		std::vector<unsigned int> StringIDs;				// IDs of the Editbox String properties, in order
+		std::unordered_map<std::string, unsigned int> IDs;	// Property title, as TitleKey(), to ID
+		size_t CheckboxBytes = 0;
+
+		const PropertyLayout &operator[](size_t ID) const { return Layouts[ID]; }
+		size_t size() const { return Layouts.size(); }
+
+		// Titles are matched as _stricmp() does: only ASCII letters ignore case, so the UTF-8 bytes of
+		// other characters are kept as they are.
+		static std::string TitleKey(const char * Title)
+		{
+			std::string Key(Title);
+			for (char &c : Key)
+			{
+				if (c >= 'A' && c <= 'Z')
+					c += 'a' - 'A';
+			}
+			return Key;
+		}
+
+		void Make(const json_value &Properties)
+		{
+			typedef PropertyLayout::Types Types;
+			unsigned int FixedOffset = 0;
+
+			CheckboxBytes = (Properties.u.array.length + 7) / 8;
+			Layouts.reserve(Properties.u.array.length);
+			TypesHash = 2166136261U;
+
+			for (unsigned int i = 0; i < Properties.u.array.length; ++i)
+			{
+				const json_value &JProp = Properties[i];
+				const char * Type = JProp["Type"];
+				PropertyLayout Layout = {};
+
+				if (!_stricmp(Type, "Text"))
+					Layout.Type = Types::Text;
+				else if (!_stricmp(Type, "Checkbox"))
+					Layout.Type = Types::Checkbox;
+				else if (!_strnicmp(Type, "Folder", sizeof("Folder") - 1))
+					Layout.Type = Types::Folder;
+				else if (!_stricmp(Type, "Edit button"))
+					Layout.Type = Types::EditButton;
+				else if (!_stricmp(Type, "Editbox String"))
+					Layout.Type = Types::EditboxString;
+				else if (!_stricmp(Type, "Editbox Number"))
+					Layout.Type = Types::EditboxNumber, Layout.FixedSize = sizeof(unsigned int);
+				else if (!_stricmp(Type, "Combo Box"))
+					Layout.Type = Types::ComboBox, Layout.FixedSize = sizeof(unsigned int);
+				else
+					Layout.Type = Types::Other;
+
+				Layout.FixedOffset = FixedOffset;
+				Layout.StringsBefore = (unsigned int)StringIDs.size();
+
+				FixedOffset += Layout.FixedSize;
+				if (Layout.Type == Types::EditboxString)
+					StringIDs.push_back(i);
+
+				MakeDefault(JProp, Layout);
+				TypesHash = (TypesHash ^ (std::uint8_t)Layout.Type) * 16777619U;
+
+				Layouts.push_back(Layout);
+
+				// The first property with a title wins
+				IDs.emplace(TitleKey(Properties[i]["Title"]), i);
+			}
+		}
+
+		// Defaults as InitialisePropertiesFromJSON() sets them; it warns about the JSON, so this doesn't
+		static void MakeDefault(const json_value &JProp, PropertyLayout &Layout)
+		{
+			typedef PropertyLayout::Types Types;
+			unsigned int Number = 0;
+
+			Layout.DefaultChecked = Layout.Type == Types::Checkbox ? (bool)JProp["DefaultState"] :
+				HasData(Layout.Type) && (bool)JProp["ChkDefault"];
+
+			if (Layout.Type == Types::EditboxString)
+			{
+				const bool Upper = !_stricmp(JProp["Case"], "Upper"), Lower = !_stricmp(JProp["Case"], "Lower");
+				Layout.Default = (const char *)JProp["DefaultState"];
+				for (char &c : Layout.Default)
+				{
+					if (Upper && c >= 'a' && c <= 'z')
+						c -= 'a' - 'A';
+					else if (Lower && c >= 'A' && c <= 'Z')
+						c += 'a' - 'A';
+				}
+				Layout.Default.push_back('\0');
+				return;
+			}
+
+			if (Layout.Type == Types::EditboxNumber)
+				Number = (unsigned int)((json_int_t)JProp["DefaultState"] & 0xFFFFFFFF);
+			else if (Layout.Type == Types::ComboBox)
+			{
+				// Index of the DefaultState item, or the first
+				const json_value &Items = JProp["Items"];
+				for (unsigned int j = 0; Items.type == json_array && j < Items.u.array.length; ++j)
+				{
+					if (JProp["DefaultState"].type == json_string && !_stricmp(JProp["DefaultState"], Items[j]))
+					{
+						Number = j;
+						break;
+					}
+				}
+			}
+			else
+				return;
+
+			Layout.Default.assign((const char *)&Number, sizeof(Number));
+		}
+
+		// Finds the chunk header where the trailer says, which must be after the checkbox bits for
+		// however many properties it was saved with, and returns the chunk table; or null if Props has
+		// no trailer and header, so is flat. Headers of other versions, or with a table that doesn't
+		// fit, are read as saving no properties.
+		static const PropChunk * FindChunks(const char * Props, size_t PropsSize, PropChunkHeader &Header)
+		{
+			PropChunkTrailer Trailer;
+			if (PropsSize < sizeof(Header) + sizeof(Trailer))
+				return nullptr;
+
+			const size_t DataSize = PropsSize - sizeof(Trailer);
+			memcpy(&Trailer, &Props[DataSize], sizeof(Trailer));
+			const size_t At = Trailer.HeaderOffset;
+			if (Trailer.Magic_ != PropChunkTrailer::Magic || At > DataSize - sizeof(Header))
+				return nullptr;
+
+			memcpy(&Header, &Props[At], sizeof(Header));
+			if (Header.Magic_ != PropChunkHeader::Magic || HeaderOffset(Header.Count) != At)
+				return nullptr;
+
+			if (Header.Version != PropChunkHeader::LatestVersion || (DataSize - At - sizeof(Header)) / sizeof(PropChunk) < Header.Count)
+				Header.Count = 0;
+			return (const PropChunk *)&Props[At + sizeof(Header)];
+		}
+
+		// Strings get half again their size spare, so most edits fit in place
+		static size_t ChunkCapacity(PropertyLayout::Types Type, size_t Size)
+		{
+			if (Type != PropertyLayout::Types::EditboxString)
+				return Size;
+			return (std::max<size_t>(Size + Size / 2, 16) + 15) & ~(size_t)15;
+		}
+
+		// The chunk table, if Props is in chunks for exactly these properties, all within Props; or
+		// null if it needs moving with Chunk() before it's changed.
+		PropChunk * Chunks(char * Props, size_t PropsSize) const
+		{
+			PropChunkHeader Header;
+			PropChunk Chunk;
+			const PropChunk * Table = FindChunks(Props, PropsSize, Header);
+			if (!Table || Header.Count != Layouts.size() || Header.TypesHash != TypesHash)
+				return nullptr;
+
+			for (unsigned int i = 0; i < Layouts.size(); ++i)
+			{
+				if (!SavedChunk(Table, Header, PropsSize - sizeof(PropChunkTrailer), i, Layouts[i].Type, Chunk))
+					return nullptr;
+			}
+			return const_cast<PropChunk *>(Table);
+		}
+
+		// Finds a property's data, however Props is laid out; see PropChunkHeader. With no Props,
+		// where the saved data has no chunk for the property, or flat data ends before it, this is
+		// its default, which is shared so mustn't be written to. Returns null for properties with no data of their own.
+		char * Find(char * Props, size_t PropsSize, unsigned int ID, unsigned int * size) const
+		{
+			const PropertyLayout &prop = Layouts[ID];
+			if (!HasData(prop.Type))
+				return nullptr;
+
+			PropChunkHeader Header;
+			const PropChunk * Table = PropsSize ? FindChunks(Props, PropsSize, Header) : nullptr;
+			char * Flat = PropsSize && !Table ? FlatIndex(Props, PropsSize, ID, size) : nullptr;
+			if (Flat)
+				return Flat;
+
+			PropChunk Chunk;
+			if (Table && SavedChunk(Table, Header, PropsSize - sizeof(PropChunkTrailer), ID, prop.Type, Chunk))
+			{
+				char * Current = &Props[Chunk.Offset];
+				const size_t Size = prop.Type == PropertyLayout::Types::EditboxString ? strnlen(Current, Chunk.Capacity) + 1 : prop.FixedSize;
+
+				// Strings must end within their chunk
+				if (Size <= Chunk.Capacity)
+				{
+					if (size)
+						*size = (unsigned int)Size;
+					return Current;
+				}
+			}
+
+			if (size)
+				*size = (unsigned int)prop.Default.size();
+			return const_cast<char *>(prop.Default.data());
+		}
+
+		// Whether a property's checkbox is ticked, however Props is laid out, as Find() reads them
+		bool IsChecked(const char * Props, size_t PropsSize, unsigned int ID) const
+		{
+			PropChunkHeader Header;
+			PropChunk Chunk;
+			const PropChunk * Table = PropsSize ? FindChunks(Props, PropsSize, Header) : nullptr;
+
+			if ((ID >> 3) >= PropsSize || (Table && !SavedChunk(Table, Header, PropsSize - sizeof(PropChunkTrailer), ID, Layouts[ID].Type, Chunk)))
+				return Layouts[ID].DefaultChecked;
+			return (Props[ID >> 3] >> (ID % 8)) & 1;
+		}
+
+		// Lays out Props in chunks for these properties, reading them as Find() and IsChecked() do;
+		// with no Props, every property gets its default.
+		std::string Chunk(char * Props, size_t PropsSize) const
+		{
+			const size_t HeaderAt = HeaderOffset(Layouts.size()), TableAt = HeaderAt + sizeof(PropChunkHeader);
+
+			std::string Out(TableAt + Layouts.size() * sizeof(PropChunk), '\0');
+
+			const PropChunkHeader Header = { PropChunkHeader::Magic, PropChunkHeader::LatestVersion, (std::uint16_t)Layouts.size(), TypesHash };
+			memcpy(&Out[HeaderAt], &Header, sizeof(Header));
+
+			for (unsigned int i = 0; i < Layouts.size(); ++i)
+			{
+				if (IsChecked(Props, PropsSize, i))
+					Out[i >> 3] |= (char)(1 << (i % 8));
+
+				unsigned int Size = 0;
+				const char * Data = Find(Props, PropsSize, i, &Size);
+				if (!Data)
+					Size = 0;
+
+				PropChunk Chunk = {};
+				Chunk.Offset = (std::uint32_t)Out.size();
+				Chunk.Capacity = (std::uint32_t)ChunkCapacity(Layouts[i].Type, Size);
+				Chunk.Type = (std::uint8_t)Layouts[i].Type;
+
+				Out.append(Data ? Data : "", Size);
+				Out.resize(Chunk.Offset + Chunk.Capacity, '\0');
+				memcpy(&Out[TableAt + i * sizeof(PropChunk)], &Chunk, sizeof(Chunk));
+			}
+
+			const PropChunkTrailer Trailer = { (std::uint32_t)HeaderAt, PropChunkTrailer::Magic };
+			Out.append((const char *)&Trailer, sizeof(Trailer));
+			return Out;
+		}
+
+		// Finds a property's data in the flat layout: the checkbox bits, then each property's data
+		// in order. Returns null for properties with no data of their own, or whose data doesn't
+		// end within Props, as data cut short or otherwise not flat can't be read past its end.
+		char * FlatIndex(char * Props, size_t PropsSize, unsigned int ID, unsigned int * size) const
+		{
+			typedef PropertyLayout::Types Types;
+			const PropertyLayout &prop = Layouts[ID];
+
+			// Read unchangable properties
+			if (prop.Type == Types::Text || prop.Type == Types::Checkbox || prop.Type == Types::Folder)
+				return nullptr;
+
+			// Fixed-size data offsets are known up front; only the strings before this property need measuring
+			size_t stringBytes = 0;
+
+			for (unsigned int i = 0; i < prop.StringsBefore; ++i)
+			{
+				const size_t At = CheckboxBytes + Layouts[StringIDs[i]].FixedOffset + stringBytes;
+				if (At >= PropsSize)
+					return nullptr;
+				stringBytes += strnlen(&Props[At], PropsSize - At) + 1;
+			}
+
+			const size_t At = CheckboxBytes + prop.FixedOffset + stringBytes;
+			if (At > PropsSize)
+				return nullptr;
+			const size_t Size = prop.Type == Types::EditboxString ? strnlen(&Props[At], PropsSize - At) + 1 : prop.FixedSize;
+			if (Size > PropsSize - At)
+				return nullptr;
+
+			if (size)
+				*size = (unsigned int)Size;
+			return &Props[At];
+		}
+	};
+}
@@ -0,0 +1,298 @@
+#pragma once
+
+// String arena used by Runtime::CopyString, CopyStringEx and CopyUTF8String.
+// String expressions used to take a fresh GET_STRING_SPACE_EX allocation (and often a fresh UTF-8
+// conversion) on every call, even when an expression returned the same text every time. Instead,
+// strings are copied into blocks owned by the extension, which are reused once Fusion is done
+// with the strings in them.
+//
+// Fusion holds at most MAX_INTERMEDIATERESULTS values while it evaluates an expression, and an
+// action or condition's parameters only until it returns. So the blocks are split into two
+// generations: once the current one has had StringsPerGeneration strings copied into it, the
+// arena moves to the other and reuses it. Every string stays valid until at least that many more
+// have been copied, however long a fastloop runs, and whatever their size; a generation grows
+// to fit what's copied into it.
+// Strings over MaxStringBytes aren't copied, so a generation's memory stays bounded; Copy()
+// returns null for them, and the caller allocates them from Fusion as before the arena.
+// Edif::Action and Edif::Condition call Hold() and Release() around the extension's function,
+// so strings from before it, such as its parameters, stay valid until it returns, whatever the
+// events it triggers copy; the strings copied while it ran are then done with.
+//
+// Within a generation, identical strings are returned from the same memory, and CopyUTF8String
+// remembers recent conversions by source pointer and length, checking the source text still
+// matches. Only needs the standard library, so it can be tested away from Fusion.
+
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+#include <memory>
+#include <vector>
+
+namespace Edif
+{
+	class StringArena
+	{
+	public:
+
+		static constexpr size_t StringsPerGeneration = 4096;	// Well over MAX_INTERMEDIATERESULTS
+		static constexpr size_t MaxStringBytes = 4096;			// So a generation holds at most 16 MB
+		static constexpr size_t MinBlockSize = 4096;
+
+		// Counters, reset only when the arena is destroyed
+		struct Stats
+		{
+			size_t Copies;				// Copy() calls
+			size_t DedupeHits;			// Copies that returned an identical string from the same generation
+			size_t ConversionHits;		// Conversions that were found already done
+			size_t BytesSaved;			// Bytes not copied or converted thanks to the above
+			size_t BytesCopied;			// Bytes written to the arena
+			size_t Flips;				// Times the arena moved to its other generation
+		};
+
+		// A conversion of source text, remembered by the caller; see FindConversion()
+		struct Conversion
+		{
+			const char * source;
+			size_t length;
+			const char * sourceCopy;
+			const char * result;
+			size_t resultBytes;
+		};
+
+	private:
+
+		struct Block
+		{
+			std::unique_ptr<char[]> data;
+			size_t size, used;
+		};
+		struct Generation
+		{
+			std::vector<Block> blocks;
+			size_t curBlock = 0, strings = 0, bytes = 0;
+		};
+		struct Generations
+		{
+			Generation gen[2];
+			int cur = 0;
+		};
+
+		Generations gens;
+		std::vector<Generations> held;	// Put aside by Hold(), innermost last
+		std::vector<Block> spare;		// Blocks of generations Release() is done with, for reuse
+
+		// Small direct-mapped caches, indexed by hash; a miss just overwrites the slot
+		static constexpr size_t CacheSize = 64;
+		struct Recent
+		{
+			unsigned int hash;
+			size_t bytes;
+			const char * at;
+		} recent[CacheSize] = {};
+		Conversion conversions[CacheSize] = {};
+
+		Stats stats = {};
+
+		// Entries may point into a generation that's about to be reused or put aside
+		void ClearCaches()
+		{
+			memset(recent, 0, sizeof(recent));
+			memset(conversions, 0, sizeof(conversions));
+		}
+
+		// Empties a generation for reuse. If it overflowed into more blocks, they're replaced with one
+		// big enough for it all; if it used under a quarter of its block, that's shrunk to fit, so a
+		// peak isn't held on to.
+		static void Recycle(Generation &g)
+		{
+			size_t total = 0;
+			for (const Block &b : g.blocks)
+				total += b.size;
+
+			const size_t want = std::max(MinBlockSize, (g.bytes + MinBlockSize - 1) & ~(MinBlockSize - 1));
+			if (g.blocks.size() > 1 || (!g.blocks.empty() && total / 4 > want))
+			{
+				g.blocks.clear();
+				g.blocks.push_back({ std::make_unique<char[]>(want), want, 0 });
+			}
+			for (Block &b : g.blocks)
+				b.used = 0;
+			g.curBlock = 0;
+			g.strings = 0;
+			g.bytes = 0;
+		}
+
+		Block NewBlock(size_t bytes)
+		{
+			for (size_t i = 0; i < spare.size(); ++i)
+			{
+				if (spare[i].size >= bytes)
+				{
+					Block b = std::move(spare[i]);
+					spare.erase(spare.begin() + i);
+					b.used = 0;
+					return b;
+				}
+			}
+
+			const size_t size = std::max<size_t>(MinBlockSize, bytes * 2);
+			return { std::make_unique<char[]>(size), size, 0 };
+		}
+
+		static unsigned int Hash(const char * data, size_t bytes)
+		{
+			unsigned int hash = 2166136261U;
+			for (size_t i = 0; i < bytes; ++i)
+				hash = (hash ^ (unsigned char)data[i]) * 16777619U;
+			return hash;
+		}
+
+	public:
+
+		const Stats & GetStats() const
+		{
+			return stats;
+		}
+
+		// Bytes of blocks the arena owns, for tests
+		size_t Capacity() const
+		{
+			size_t total = 0;
+			const auto add = [&](const Generations &g) {
+				for (const Generation &gen : g.gen)
+					for (const Block &b : gen.blocks)
+						total += b.size;
+			};
+			add(gens);
+			for (const Generations &g : held)
+				add(g);
+			for (const Block &b : spare)
+				total += b.size;
+			return total;
+		}
+
+		void Hold()
+		{
+			held.push_back(std::move(gens));
+			gens = Generations();
+			ClearCaches();
+		}
+
+		void Release()
+		{
+			if (held.empty())
+				return;
+
+			// Keep one generation's blocks to start the next Hold() with
+			for (Generation &g : gens.gen)
+			{
+				Recycle(g);
+				for (Block &b : g.blocks)
+				{
+					if (spare.size() < 2)
+						spare.push_back(std::move(b));
+				}
+			}
+
+			gens = std::move(held.back());
+			held.pop_back();
+			ClearCaches();
+		}
+
+		char * Alloc(size_t bytes)
+		{
+			// Keep every string aligned for wchar_t
+			bytes = (bytes + alignof(wchar_t) - 1) & ~(alignof(wchar_t) - 1);
+
+			Generation * g = &gens.gen[gens.cur];
+			if (g->strings >= StringsPerGeneration)
+			{
+				gens.cur ^= 1;
+				g = &gens.gen[gens.cur];
+				Recycle(*g);
+				ClearCaches();
+				++stats.Flips;
+			}
+
+			++g->strings;
+			g->bytes += bytes;
+
+			for (; g->curBlock < g->blocks.size(); ++g->curBlock)
+			{
+				Block &b = g->blocks[g->curBlock];
+				if (b.size - b.used >= bytes)
+				{
+					char * at = b.data.get() + b.used;
+					b.used += bytes;
+					return at;
+				}
+			}
+
+			// Existing blocks are never moved, as earlier strings may still be in use
+			g->blocks.push_back(NewBlock(bytes));
+			g->curBlock = g->blocks.size() - 1;
+			g->blocks.back().used = bytes;
+			return g->blocks.back().data.get();
+		}
+
+		// Copies bytes (which include the null terminator), or returns an identical copy made earlier.
+		// Returns null if bytes is over MaxStringBytes, without copying.
+		const char * Copy(const char * data, size_t bytes)
+		{
+			if (bytes > MaxStringBytes)
+				return nullptr;
+
+			++stats.Copies;
+			const unsigned int hash = Hash(data, bytes);
+			Recent &slot = recent[hash % CacheSize];
+			if (slot.at && slot.hash == hash && slot.bytes == bytes && !memcmp(slot.at, data, bytes))
+			{
+				++stats.DedupeHits;
+				stats.BytesSaved += bytes;
+				return slot.at;
+			}
+
+			char * at = Alloc(bytes);
+			memcpy(at, data, bytes);
+			stats.BytesCopied += bytes;
+
+			// Alloc() may have moved generations and cleared the cache
+			recent[hash % CacheSize] = { hash, bytes, at };
+			return at;
+		}
+
+		// The result of converting length bytes at source, if it was converted since the caches
+		// were last cleared and the text there hasn't changed
+		const char * FindConversion(const char * source, size_t length)
+		{
+			const Conversion &slot = conversions[((std::uintptr_t)source ^ length) % CacheSize];
+			if (!slot.result || slot.source != source || slot.length != length || memcmp(slot.sourceCopy, source, length))
+				return nullptr;
+
+			++stats.Copies;
+			++stats.ConversionHits;
+			stats.BytesSaved += slot.resultBytes;
+			return slot.result;
+		}
+
+		// Copies a conversion's result, remembering it for FindConversion(). Returns null if the
+		// result is over MaxStringBytes, as Copy() does; a source that long isn't remembered.
+		const char * AddConversion(const char * source, size_t length, const char * result, size_t resultBytes)
+		{
+			const char * copy = Copy(result, resultBytes);
+			if (!copy || length > MaxStringBytes)
+				return copy;
+
+			// Keep a copy of the source, so a reused buffer with new text isn't mistaken for the old
+			char * sourceCopy = Alloc(length);
+			memcpy(sourceCopy, source, length);
+
+			// If that moved generations, the result is in the other one, and a later move would reuse it
+			if (gens.gen[gens.cur].strings == 1)
+				return copy;
+
+			conversions[((std::uintptr_t)source ^ length) % CacheSize] = { source, length, sourceCopy, copy, resultBytes };
+			return copy;
+		}
+	};
+}
@@ -45,10 +45,45 @@
 
 #include <stdlib.h>
 
+/* Objects with at least this many members get a hash index of their member
+ * names, built when they're parsed; smaller ones are searched linearly.
+ */
+#ifndef json_index_min_length
+	#define json_index_min_length 8
+#endif
+
+/* FNV-1a, used to hash object member names */
+#define json_hash_offset 2166136261u
+#define json_hash_prime 16777619u
+
 #ifdef __cplusplus
 
 	#include <string.h>
 
+	/* An object member name with its hash worked out up front - at compile time
+	 * for a constexpr key - for lookups on hot paths.
+	 */
+	struct json_key
+	{
+		const json_char * name;
+		unsigned int hash;
+
+		static constexpr unsigned int hash_of (const json_char * str)
+		{
+			unsigned int hash = json_hash_offset;
+
+			for (; *str; ++ str)
+				hash = (hash ^ (unsigned char) *str) * json_hash_prime;
+
+			return hash;
+		}
+
+		explicit constexpr json_key (const json_char * name)
+			: name (name), hash (hash_of (name))
+		{
+		}
+	};
+
 	extern "C"
 	{
 
@@ -89,6 +124,15 @@ typedef enum
 
 extern const struct _json_value json_value_none;
 
+unsigned int json_hash (const json_char * name);
+
+/* Looks up an object member by name, where hash is json_hash (name). Returns
+ * null if there is no such member.
+ */
+const struct _json_value * json_object_find (const struct _json_value * object,
+											 const json_char * name,
+											 unsigned int hash);
+
 typedef struct _json_value
 {
 	struct _json_value * parent;
@@ -155,6 +199,9 @@ typedef struct _json_value
 
 	} _reserved;
 
+	/* Hash index of an object's members; see json_object_find */
+	unsigned int * _index;
+
 
 	/* Some C++ operator sugar */
 
@@ -182,11 +229,26 @@ typedef struct _json_value
 			if (type != json_object)
 				return json_value_none;
 
-			for (unsigned int i = 0; i < u.object.length; ++ i)
-				if (!strcmp (u.object.values [i].name, index))
-				  return *u.object.values [i].value;
+			if (u.object.length < json_index_min_length)
+			{
+				for (unsigned int i = 0; i < u.object.length; ++ i)
+					if (!strcmp (u.object.values [i].name, index))
+					  return *u.object.values [i].value;
+
+				return json_value_none;
+			}
 
-			return json_value_none;
+			const struct _json_value * value = json_object_find (this, index, json_key::hash_of (index));
+			return value ? *value : json_value_none;
+		 }
+
+		 inline const struct _json_value &operator [] (const json_key &key) const
+		 {
+			if (type != json_object)
+				return json_value_none;
+
+			const struct _json_value * value = json_object_find (this, key.name, key.hash);
+			return value ? *value : json_value_none;
 		 }
 
 		 inline operator const char * () const
@@ -246,6 +308,61 @@ typedef struct _json_value
 json_value * json_parse (const json_char * json,
 						 size_t length);
 
+/* Compiled JSON is a parsed json_value tree stored by DarkEdifJSONCompiler as
+ * fixed-size, little-endian records, which don't depend on json_value's layout
+ * or the size of a pointer, so an image from any build of the compiler loads in
+ * any build of the SDK. The image is the header, then a record per value in
+ * depth-first order (the root first, parents before their children), then the
+ * object member table, the array element table, and the string table, with
+ * duplicate strings merged. Records refer to each other by index, and to the
+ * tables and strings by position in them.
+ *
+ * json_load_compiled checks every index and position, and builds the tree in
+ * one allocation without parsing. If it fails, e.g. for an image from an older
+ * version, the caller should fall back on the JSON text.
+ */
+#define json_compiled_magic 0x434A4544 /* "DEJC" */
+#define json_compiled_version 2
+
+typedef struct
+{
+	unsigned int magic;
+	unsigned int version;
+	unsigned int size;				/* of the whole image, including this header */
+	unsigned int value_count;		/* records, straight after this header */
+	unsigned int member_count;		/* json_compiled_member entries, after the records */
+	unsigned int element_count;		/* array element record indexes, after the members */
+	unsigned int strings_size;		/* string table, after the elements, ending in a 0 */
+	unsigned int reserved;
+
+} json_compiled_header;
+
+typedef struct
+{
+	unsigned int type;		/* json_type */
+	unsigned int length;	/* members, elements, or string length */
+
+	/* json_object, json_array: position of the first member or element
+	 * json_string: position in the string table
+	 * json_integer, json_double: the 64-bit value, low word first
+	 * json_boolean: 0 or 1
+	 */
+	unsigned int data [2];
+
+} json_compiled_value;
+
+typedef struct
+{
+	unsigned int name;		/* position in the string table */
+	unsigned int value;		/* record index */
+
+} json_compiled_member;
+
+json_value * json_load_compiled (const void * image,
+								 size_t size,
+								 char * error_buf,
+								 size_t error_buf_len);
+
 typedef struct
 {
 	unsigned long used_memory;
@@ -4,6 +4,9 @@
 extern HINSTANCE hInstLib;
 extern Edif::SDK * SDK;
 
+// Looked up on every property access, so hashed once up front
+static constexpr json_key PropertiesKey("Properties");
+
 #if EditorBuild
 static const _json_value * StoredCurrentLanguage = &json_value_none;
 
@@ -255,6 +258,18 @@ bool CreateNewExpressionInfo(void)
 
 #ifndef NOPROPS
 
+// Properties are stored in chunks; see Edif::PropChunkHeader.
+static size_t PropsSize(EDITDATA * edPtr)
+{
+	return (size_t)edPtr->DarkEdif_Prop_Size < sizeof(EDITDATA) ? 0 : edPtr->DarkEdif_Prop_Size - sizeof(EDITDATA);
+}
+
+// Returns the chunk table if edPtr's properties are chunked for the current JSON, or null if they need moving.
+static Edif::PropChunk * GetPropChunks(EDITDATA * edPtr)
+{
+	return ::SDK->PropertyLayouts.Chunks(edPtr->DarkEdif_Props, PropsSize(edPtr));
+}
+
 #if EditorBuild
 
 using namespace Edif::Properties;
@@ -262,13 +277,10 @@ using namespace Edif::Properties;
 
 void InitialisePropertiesFromJSON(mv * mV, EDITDATA * edPtr)
 {
-	std::stringstream mystr;
-	char * chkboxes = (char *)calloc(size_t(ceil(CurLang["Properties"].u.array.length / 8.0f)), 1);
-
-	// Set default object settings from DefaultState.
-	for (unsigned int i = 0; i < CurLang["Properties"].u.array.length; ++i)
+	// Check the DefaultStates; the defaults themselves are read from them by Edif::PropertyLayouts
+	for (unsigned int i = 0; i < CurLang[PropertiesKey].u.array.length; ++i)
 	{
-		const json_value & JProp = CurLang["Properties"][i];
+		const json_value & JProp = CurLang[PropertiesKey][i];
 
 		// TODO: If default state is missing, say the name of the property for easy repair by dev
 		switch (::SDK->EdittimeProperties[i].Type_ID % 1000)
@@ -277,10 +289,6 @@ void InitialisePropertiesFromJSON(mv * mV, EDITDATA * edPtr)
 			{
 				if (JProp["DefaultState"].type != json_boolean)
 					MessageBoxA(NULL, "Invalid or no default checkbox value specified.", "DarkEdif setup warning", MB_OK | MB_ICONWARNING);
-
-				if (JProp["DefaultState"])
-					chkboxes[i >> 3] |= 1 << (i % 8);
-
 				break;
 			}
 
@@ -289,71 +297,33 @@ void InitialisePropertiesFromJSON(mv * mV, EDITDATA * edPtr)
 			{
 				if (JProp["DefaultState"].type != json_integer)
 					MessageBoxA(NULL, "Invalid or no default integer value specified.", "DarkEdif setup warning", MB_OK | MB_ICONWARNING);
-
-				unsigned int i = unsigned int(long long(JProp["DefaultState"]) & 0xFFFFFFFF);
-				mystr.write((char *)&i, sizeof(unsigned int)); // embedded nulls upset the << operator
-
-				if (JProp["ChkDefault"])
-					chkboxes[i >> 3] |= 1 << (i % 8);
-
 				break;
 			}
 
-			case PROPTYPE_STATIC:
-			case PROPTYPE_FOLDER:
-			case PROPTYPE_FOLDER_END:
-			case PROPTYPE_EDITBUTTON:
-				break; // do not store
-
-
 			case PROPTYPE_EDIT_STRING:
 			{
 				if (JProp["DefaultState"].type != json_string)
 					MessageBoxA(NULL, "Invalid or no default string value specified.", "DarkEdif - setup warning", MB_OK | MB_ICONWARNING);
-
-				// No casing change necessary
-				if (_stricmp(JProp["Case"], "Upper") && _stricmp(JProp["Case"], "Lower")) {
-					mystr << (const char *)(JProp["DefaultState"]) << char(0);
-				}
-				else
-				{
-					std::string dup(JProp["DefaultState"]);
-					std::transform(dup.begin(), dup.end(), dup.begin(), !_stricmp(JProp["Case"], "Upper") ? ::toupper : ::tolower);
-					mystr << dup << char(0);
-				}
-
-				if (JProp["ChkDefault"])
-					chkboxes[i >> 3] |= 1 << (i % 8);
-
 				break;
 			}
 
-
 			case PROPTYPE_COMBOBOX:
 			{
-				unsigned int i = 0U;
 				if (JProp["DefaultState"].type != json_string)
-					MessageBoxA(NULL, "Invalid or no default string specified.", "DarkEdif - setup warning", MB_OK | MB_ICONWARNING);
-				else
 				{
-					for (size_t j = 0; j < JProp["Items"].u.array.length; j++)
-					{
-						if (!_stricmp((const char *)JProp["DefaultState"], JProp["Items"][j]))
-						{
-							i = j;
-							goto ok;
-						}
-					}
-
-					MessageBoxA(NULL, "Specified a default string in a combobox property that does not exist in items list.",
-						"DarkEdif - setup warning", MB_OK | MB_ICONWARNING);
+					MessageBoxA(NULL, "Invalid or no default string specified.", "DarkEdif - setup warning", MB_OK | MB_ICONWARNING);
+					break;
 				}
-			ok:
-				mystr.write((char *)&i, sizeof(i));
 
-				if (JProp["ChkDefault"])
-					chkboxes[i >> 3] |= 1 << (i % 8);
+				for (size_t j = 0; j < JProp["Items"].u.array.length; j++)
+				{
+					if (!_stricmp((const char *)JProp["DefaultState"], JProp["Items"][j]))
+						goto ok;
+				}
 
+				MessageBoxA(NULL, "Specified a default string in a combobox property that does not exist in items list.",
+					"DarkEdif - setup warning", MB_OK | MB_ICONWARNING);
+			ok:
 				break;
 			}
 
@@ -363,23 +333,17 @@ void InitialisePropertiesFromJSON(mv * mV, EDITDATA * edPtr)
 		}
 	}
 
-	std::string mystr2(chkboxes, _msize(chkboxes));
-	mystr2 += mystr.str();
-
-	free(chkboxes);
-	mystr.clear();
+	const std::string props = ::SDK->PropertyLayouts.Chunk(nullptr, 0);
 
-	edPtr = (EDITDATA *) mvReAllocEditData(mV, edPtr, sizeof(EDITDATA) + mystr2.size());
+	edPtr = (EDITDATA *) mvReAllocEditData(mV, edPtr, sizeof(EDITDATA) + props.size());
 	if (!edPtr)
 	{
 		MessageBoxA(NULL, "Could not reallocate EDITDATA.\n\n*cough* MMF2's fault.", "DarkEdif - setup warning", MB_OK | MB_ICONWARNING);
 		return;
 	}
 
-	edPtr->DarkEdif_Prop_Size = sizeof(EDITDATA) + mystr2.size();
-
-	memset(edPtr->DarkEdif_Props, 0, mystr2.size());
-	memcpy(edPtr->DarkEdif_Props, mystr2.data(), mystr2.size());
+	edPtr->DarkEdif_Prop_Size = sizeof(EDITDATA) + props.size();
+	memcpy(edPtr->DarkEdif_Props, props.data(), props.size());
 }
 
 Prop * GetProperty(EDITDATA * edPtr, size_t ID)
@@ -394,11 +358,13 @@ Prop * GetProperty(EDITDATA * edPtr, size_t ID)
 		return nullptr;
 	}
 
-	const json_value &jsonItem = CurLang["Properties"][ID];
-	const char * curStr = jsonItem["Type"];
+	typedef Edif::PropertyLayout::Types Types;
+
+	const json_value &jsonItem = CurLang[PropertiesKey][ID];
+	const Types curType = ID < ::SDK->PropertyLayouts.size() ? ::SDK->PropertyLayouts[ID].Type : Types::Other;
 	Prop * ret = nullptr;
 	bool allConv = false;
-	if (!_stricmp(curStr, "Text") || !_stricmp(curStr, "Edit button"))
+	if (curType == Types::Text || curType == Types::EditButton)
 	{
 		ret = new Prop_Str(UTF8ToTString((const char *)jsonItem["DefaultState"], &allConv).c_str());
 		if (!allConv)
@@ -412,7 +378,7 @@ Prop * GetProperty(EDITDATA * edPtr, size_t ID)
 	unsigned int size;
 	char * Current = PropIndex(edPtr, ID, &size);
 
-	if (!_stricmp(curStr, "Editbox String"))
+	if (curType == Types::EditboxString)
 	{
 		ret = new Prop_Str(UTF8ToTString(Current, &allConv).c_str());
 		if (!allConv)
@@ -421,9 +387,9 @@ Prop * GetProperty(EDITDATA * edPtr, size_t ID)
 				"Characters will be replaced with filler.", "DarkEdif Property Error", MB_OK | MB_ICONWARNING);
 		}
 	}
-	else if (!_stricmp(curStr, "Editbox Number") || !_stricmp(curStr, "Combo Box"))
+	else if (curType == Types::EditboxNumber || curType == Types::ComboBox)
 		ret = new Prop_UInt(*(unsigned int *)Current);
-	else if (_stricmp(curStr, "Checkbox") && _strnicmp(curStr, "Folder", sizeof("Folder") - 1))
+	else if (curType != Types::Checkbox && curType != Types::Folder)
 		MessageBoxA(NULL, "Don't understand JSON property type, can't return Prop.", "DarkEdif Property Error", MB_OK | MB_ICONERROR);
 
 	return ret;
@@ -436,91 +402,100 @@ void PropChangeChkbox(EDITDATA * edPtr, unsigned int PropID, const bool newValue
 	// value for the Prop ID specified. Thus each char supports 8 properties.
 	int byteIndex = PropID >> 3, bitIndex = PropID % 8;
 
+	// Chunks saved for another JSON have a different number of checkbox bits; GetProperties() moves them first
+	Edif::PropChunkHeader header;
+	if (!GetPropChunks(edPtr) && Edif::PropertyLayouts::FindChunks(edPtr->DarkEdif_Props, PropsSize(edPtr), header))
+		return;
+
 	if (newValue)
 		edPtr->DarkEdif_Props[byteIndex] |= 1 << bitIndex;
 	else
 		edPtr->DarkEdif_Props[byteIndex] &= ~(1 << bitIndex);
 }
-void PropChange(mv * mV, EDITDATA * &edPtr, unsigned int PropID, const void * newPropValue, size_t newPropValueSize)
+
+bool MigrateProps(mv * mV, EDITDATA * &edPtr)
 {
-	unsigned int oldPropValueSize; // Set by PropIndex
-	const char * curTypeStr = CurLang["Properties"][PropID]["Type"];
-	char * oldPropValue = PropIndex(edPtr, PropID, &oldPropValueSize);
-	bool rearrangementRequired = false;
-
-	if (!_stricmp(curTypeStr, "Editbox String"))
-		rearrangementRequired = newPropValueSize != oldPropValueSize; // May need resizing
-	else if (!_stricmp(curTypeStr, "Editbox Number"))
-		rearrangementRequired = false; // Number of editbox, always same data size
-	else if (!_stricmp(curTypeStr, "Combo Box"))
-		rearrangementRequired = false; // Index of combo box Item, always same data size
-	else if (!_stricmp(curTypeStr, "Checkbox") || !_strnicmp(curTypeStr, "Folder", sizeof("Folder") - 1))
-		return; // Checkbox is handled by PropChangeChkbox(), folder has no possible changes
-	else
-		MessageBoxA(NULL, "Don't understand JSON property type, can't return Prop.", "DarkEdif Fatal Error", MB_OK | MB_ICONERROR);
+	if (GetPropChunks(edPtr))
+		return false;
 
-	if (!rearrangementRequired)
+	const std::string props = ::SDK->PropertyLayouts.Chunk(edPtr->DarkEdif_Props, PropsSize(edPtr));
+
+	EDITDATA * fusionNewEdPtr = (EDITDATA *)mvReAllocEditData(mV, edPtr, sizeof(EDITDATA) + props.size());
+	if (!fusionNewEdPtr)
 	{
-		memcpy(oldPropValue, newPropValue, newPropValueSize);
-		return;
+		MessageBoxA(NULL, "NULL returned from EDITDATA reallocation. Property changed cancelled.", "DarkEdif - Propery Error", MB_OK | MB_ICONERROR);
+		return false;
 	}
 
-	// Even an empty string should be 1 (null char). Warn if not.
-	if (oldPropValueSize == 0)
-		MessageBoxA(NULL, "Property size is 0!", "DarkEdif - Debug info", MB_OK | MB_ICONERROR);
+	memcpy(fusionNewEdPtr->DarkEdif_Props, props.data(), props.size());
+	fusionNewEdPtr->DarkEdif_Prop_Size = sizeof(EDITDATA) + props.size();
 
-	size_t beforeOldSize = sizeof(EDITDATA) +
-		(oldPropValue - edPtr->DarkEdif_Props); // Pointer to O|<P|O
-	size_t afterOldSize = edPtr->DarkEdif_Prop_Size - oldPropValueSize - beforeOldSize;			// Pointer to O|P>|O
-	size_t odps = edPtr->DarkEdif_Prop_Size;
+	edPtr = fusionNewEdPtr; // Inform caller of new address
+	return true;
+}
 
-	// Duplicate memory to another buffer (if new arragement is smaller - we can't just copy from old buffer after realloc)
-	char * newEdPtr = (char *)malloc(edPtr->DarkEdif_Prop_Size + (newPropValueSize - oldPropValueSize));
+// Gives a property's chunk room for at least newSize bytes, moving the chunks after it.
+static bool GrowPropChunk(mv * mV, EDITDATA * &edPtr, unsigned int PropID, size_t newSize)
+{
+	const Edif::PropChunk chunk = GetPropChunks(edPtr)[PropID];
+	const size_t oldEdPtrSize = edPtr->DarkEdif_Prop_Size;
+	const size_t growBy = Edif::PropertyLayouts::ChunkCapacity(::SDK->PropertyLayouts[PropID].Type, newSize) - chunk.Capacity;
 
-	if (!newEdPtr)
+	// Fusion keeps the existing data when reallocating, so only the part after the chunk needs moving
+	EDITDATA * fusionNewEdPtr = (EDITDATA *)mvReAllocEditData(mV, edPtr, oldEdPtrSize + growBy);
+	if (!fusionNewEdPtr)
 	{
-		MessageBoxA(NULL, "Out of memory attempting to rewrite properties!", "DarkEdif - Property Error", MB_OK | MB_ICONERROR);
-		return;
+		MessageBoxA(NULL, "NULL returned from EDITDATA reallocation. Property changed cancelled.", "DarkEdif - Propery Error", MB_OK | MB_ICONERROR);
+		return false;
 	}
-	((EDITDATA *)newEdPtr)->DarkEdif_Prop_Size = _msize(newEdPtr);
 
-	// Copy the part before new data into new address
-	memcpy(newEdPtr, edPtr, beforeOldSize);
+	char * props = fusionNewEdPtr->DarkEdif_Props;
+	const size_t chunkEnd = chunk.Offset + chunk.Capacity;
+	memmove(&props[chunkEnd + growBy], &props[chunkEnd], oldEdPtrSize - sizeof(EDITDATA) - chunkEnd);
 
-	// Copy the new data into new address
-	memcpy(newEdPtr + beforeOldSize, newPropValue, newPropValueSize);
+	fusionNewEdPtr->DarkEdif_Prop_Size = oldEdPtrSize + growBy;
 
-	// Copy the part after new data into new address
-	memcpy(newEdPtr + beforeOldSize + newPropValueSize,
-		oldPropValue + oldPropValueSize,
-		afterOldSize);
+	Edif::PropChunk * chunks = GetPropChunks(fusionNewEdPtr);
+	for (size_t i = 0; i < ::SDK->PropertyLayouts.size(); ++i)
+	{
+		if (i != PropID && chunks[i].Offset >= chunkEnd)
+			chunks[i].Offset += (std::uint32_t)growBy;
+	}
+	chunks[PropID].Capacity += (std::uint32_t)growBy;
 
-	// Reallocate edPtr
-	EDITDATA * fusionNewEdPtr = (EDITDATA *)mvReAllocEditData(mV, edPtr, _msize(newEdPtr));
-	if (!fusionNewEdPtr)
+	edPtr = fusionNewEdPtr; // Inform caller of new address
+	return true;
+}
+
+void PropChange(mv * mV, EDITDATA * &edPtr, unsigned int PropID, const void * newPropValue, size_t newPropValueSize)
+{
+	typedef Edif::PropertyLayout::Types Types;
+
+	const Types curType = PropID < ::SDK->PropertyLayouts.size() ? ::SDK->PropertyLayouts[PropID].Type : Types::Other;
+
+	if (curType == Types::Checkbox || curType == Types::Folder)
+		return; // Checkbox is handled by PropChangeChkbox(), folder has no possible changes
+	if (curType != Types::EditboxString && curType != Types::EditboxNumber && curType != Types::ComboBox)
 	{
-		MessageBoxA(NULL, "NULL returned from EDITDATA reallocation. Property changed cancelled.", "DarkEdif - Propery Error", MB_OK | MB_ICONERROR);
-		free(newEdPtr);
+		MessageBoxA(NULL, "Don't understand JSON property type, can't return Prop.", "DarkEdif Fatal Error", MB_OK | MB_ICONERROR);
 		return;
 	}
 
-	// Copy into edPtr (copy everything after eHeader, leave eHeader alone)
-	// eHeader::extSize and such will be changed by Fusion by mvReAllocEditData,
-	// so should not be considered ours to interact with
-	memcpy(((char *)fusionNewEdPtr) + sizeof(EDITDATA::eHeader),
-		newEdPtr + sizeof(EDITDATA::eHeader),
-		_msize(newEdPtr) - sizeof(EDITDATA::eHeader));
-	free(newEdPtr);
+	// Older MFAs have flat properties, or chunks for an older JSON; once moved, this and later changes are in place
+	MigrateProps(mV, edPtr);
+	if (!GetPropChunks(edPtr))
+		return;
 
-	edPtr = fusionNewEdPtr; // Inform caller of new address
+	// Editbox numbers and combo box indexes are always the same size; strings may need more room
+	if (newPropValueSize > GetPropChunks(edPtr)[PropID].Capacity && !GrowPropChunk(mV, edPtr, PropID, newPropValueSize))
+		return;
+
+	memcpy(&edPtr->DarkEdif_Props[GetPropChunks(edPtr)[PropID].Offset], newPropValue, newPropValueSize);
 }
 
 char * PropIndex(EDITDATA * edPtr, unsigned int ID, unsigned int * size)
 {
-	char * Current = &edPtr->DarkEdif_Props[(size_t)ceil(CurLang["Properties"].u.array.length / 8.0f)], * StartPos, * EndPos;
-
-	json_value j = CurLang["Properties"];
-	if (j.type != json_array)
+	if (ID >= ::SDK->PropertyLayouts.size())
 	{
 		char msgTitle [128] = {0};
 		Edif::GetExtensionName(msgTitle);
@@ -529,36 +504,7 @@ char * PropIndex(EDITDATA * edPtr, unsigned int ID, unsigned int * size)
 		return nullptr;
 	}
 
-	const char * curStr = (const char *)j[ID]["Type"];
-	// Read unchangable properties
-	if (!_stricmp(curStr, "Text") || !_stricmp(curStr, "Checkbox") || !_strnicmp(curStr, "Folder", sizeof("Folder") - 1))
-		return nullptr;
-	// if (curTypeStr == "other stuff")
-	//	return new Prop_XXX();
-
-	// Read changable properties
-	StartPos = Current; // For ID 0
-	unsigned int i = 0;
-	while (i <= ID)
-	{
-		curStr = (const char *)j[i]["Type"];
-
-		if (!_stricmp(curStr, "Editbox String"))
-			Current += strlen(Current) + 1;
-		else if (!_stricmp(curStr, "Editbox Number") || !_stricmp(curStr, "Combo Box"))
-			Current += sizeof(unsigned int);
-
-		if (i == ID - 1)
-			StartPos = Current;
-
-		++i;
-	}
-
-	EndPos = Current;
-
-	if (size)
-		*size = EndPos - StartPos;
-	return StartPos;
+	return ::SDK->PropertyLayouts.Find(edPtr->DarkEdif_Props, PropsSize(edPtr), ID, size);
 }
 
 #endif // NOPROPS
@@ -794,29 +740,30 @@ Prop_Str * Prop_Str_FromUTF8(const char * u8)
 // Returns property checked or unchecked.
 bool EDITDATA::IsPropChecked(int propID)
 {
-	return (DarkEdif_Props[propID >> 3] >> (propID % 8) & 1);
+	if (propID < 0 || (size_t)propID >= ::SDK->PropertyLayouts.size())
+		return false;
+	return ::SDK->PropertyLayouts.IsChecked(DarkEdif_Props, PropsSize(this), propID);
 }
 // Returns std::tstring property setting from property name.
 std::tstring EDITDATA::GetPropertyStr(const char * propName)
 {
-	const json_value &props = CurLang["Properties"];
-	for (size_t i = 0; i < props.u.array.length; i++)
-	{
-		if (!_stricmp(props[i]["Title"], propName))
-			return GetPropertyStr(i);
-	}
+	const auto found = ::SDK->PropertyLayouts.IDs.find(Edif::PropertyLayouts::TitleKey(propName));
+	if (found != ::SDK->PropertyLayouts.IDs.end())
+		return GetPropertyStr(found->second);
 	return _T("Property name not found.");
 }
 // Returns std::tstring property string from property ID.
 std::tstring EDITDATA::GetPropertyStr(int propID)
 {
-	if (propID < 0 || (size_t)propID > CurLang["Properties"].u.array.length)
+	typedef Edif::PropertyLayout::Types Types;
+
+	if (propID < 0 || (size_t)propID >= ::SDK->PropertyLayouts.size())
 		return _T("Property ID not found.");
 
-	const json_value &prop = CurLang["Properties"][propID];
-	if (!_stricmp(prop["Type"], "Combo Box"))
-		return UTF8ToTString((const char  *)prop["Items"][*(unsigned int *)PropIndex(this, propID, nullptr)]);
-	else if (!_stricmp(prop["Type"], "Editbox String"))
+	const Types type = ::SDK->PropertyLayouts[propID].Type;
+	if (type == Types::ComboBox)
+		return UTF8ToTString((const char  *)CurLang[PropertiesKey][propID]["Items"][*(unsigned int *)PropIndex(this, propID, nullptr)]);
+	else if (type == Types::EditboxString)
 	{
 		unsigned int propDataSize = 0;
 		char * propDataStart = PropIndex(this, propID, &propDataSize);
@@ -1,7 +1,8 @@
 #include "Common.h"
 #include "DarkEdif.h"
 
-Edif::Runtime::Runtime(RUNDATA * _rdPtr) : rdPtr(_rdPtr), ObjectSelection(_rdPtr->rHo.AdRunHeader)
+Edif::Runtime::Runtime(RUNDATA * _rdPtr) : rdPtr(_rdPtr), stringArena(std::make_unique<StringArena>()),
+	ObjectSelection(_rdPtr->rHo.AdRunHeader)
 {
 }
 
@@ -9,6 +10,21 @@ Edif::Runtime::~Runtime()
 {
 }
 
+const Edif::StringArena::Stats & Edif::Runtime::GetStringArenaStats() const
+{
+	return stringArena->GetStats();
+}
+
+void Edif::Runtime::HoldStrings()
+{
+	stringArena->Hold();
+}
+
+void Edif::Runtime::ReleaseStrings()
+{
+	stringArena->Release();
+}
+
 void Edif::Runtime::Rehandle()
 {
 	CallRunTimeFunction(rdPtr, RFUNCTION::REHANDLE, 0, 0);
@@ -29,33 +45,41 @@ void * Edif::Runtime::Allocate(size_t size)
 	return (void *) CallRunTimeFunction(rdPtr, RFUNCTION::GET_STRING_SPACE_EX, 0, size * sizeof(TCHAR));
 }
 
-TCHAR * Edif::Runtime::CopyString(const TCHAR * String)
+// Strings too long for the arena are copied into Fusion's string space, as they were before it
+static void * CopyToArenaOrFusion(Edif::Runtime * runtime, Edif::StringArena & arena, const void * data, size_t bytes)
 {
-	TCHAR * New = NULL;
-	New = (TCHAR *) Allocate(_tcslen(String) + 1);
-	_tcscpy(New, String);
+	if (const char * copy = arena.Copy((const char *)data, bytes))
+		return (void *)copy;
+	void * fusionCopy = runtime->Allocate((bytes + sizeof(TCHAR) - 1) / sizeof(TCHAR));
+	return fusionCopy ? memcpy(fusionCopy, data, bytes) : nullptr;
+}
 
-	return New;
+TCHAR * Edif::Runtime::CopyString(const TCHAR * String)
+{
+	return (TCHAR *)CopyToArenaOrFusion(this, *stringArena, String, (_tcslen(String) + 1) * sizeof(TCHAR));
 }
 
 char * Edif::Runtime::CopyStringEx(const char * String)
 {
-	char * New = NULL;
-	New = (char *)CallRunTimeFunction(rdPtr, RFUNCTION::GET_STRING_SPACE_EX, 0, (strlen(String) + 1) * sizeof(char));
-	strcpy(New, String);
-
-	return New;
+	return (char *)CopyToArenaOrFusion(this, *stringArena, String, (strlen(String) + 1) * sizeof(char));
 }
 
 wchar_t * Edif::Runtime::CopyStringEx(const wchar_t * String)
 {
-	wchar_t * New = NULL;
-	New = (wchar_t *)CallRunTimeFunction(rdPtr, RFUNCTION::GET_STRING_SPACE_EX, 0, (wcslen(String) + 1) * sizeof(wchar_t));
-	wcscpy(New, String);
-
-	return New;
+	return (wchar_t *)CopyToArenaOrFusion(this, *stringArena, String, (wcslen(String) + 1) * sizeof(wchar_t));
 }
 
+TCHAR * Edif::Runtime::CopyUTF8String(const char * utf8, size_t length)
+{
+	if (const char * found = stringArena->FindConversion(utf8, length))
+		return (TCHAR *)found;
+
+	const std::tstring converted = UTF8ToTString(std::string_view(utf8, length));
+	const size_t bytes = (converted.size() + 1) * sizeof(TCHAR);
+	if (const char * copy = stringArena->AddConversion(utf8, length, (const char *)converted.c_str(), bytes))
+		return (TCHAR *)copy;
+	return (TCHAR *)CopyToArenaOrFusion(this, *stringArena, converted.c_str(), bytes);
+}
 
 void Edif::Runtime::Pause()
 {
@@ -1,5 +1,13 @@
 #include "Common.h"
 
+#ifdef DARKEDIF_ACE_PROFILER
+#include <intrin.h>
+#include <atomic>
+#include <mutex>
+#include <algorithm>
+#include <fstream>
+#endif
+
 Edif::SDK * SDK = nullptr;
 
 
@@ -207,41 +215,62 @@ int Edif::Init(mv * mV)
 	char errorMsgTitle [MAX_PATH];
 	Edif::GetExtensionName(errorMsgTitle);
 
-	// Get JSON file
-	char * JSON;
-	size_t JSON_Size;
+	json_value * json = nullptr;
 
-	int result = Edif::GetDependency (JSON, JSON_Size, _T("json"), IDR_EDIF_JSON);
+#if defined(DARKEXT_JSON_COMPILED) && defined(IDR_EDIF_JSON_COMPILED)
+	// Get compiled JSON image, made by DarkEdifJSONCompiler; this loads without parsing.
+	// If it's missing, or from a different version of the compiler, fall back on the JSON file.
+	char * Image;
+	size_t Image_Size;
 
-	if (result == Edif::DependencyNotFound)
-	{
-		strcat_s(errorMsgTitle, " - Error");
+	int imageResult = Edif::GetDependency (Image, Image_Size, _T("jsonc"), IDR_EDIF_JSON_COMPILED);
 
-		MessageBoxA(0, "JSON file not found on disk or in MFX resources", errorMsgTitle, 0);
-		return -1;	// error, init failed
+	if (imageResult != Edif::DependencyNotFound)
+	{
+		json = json_load_compiled (Image, Image_Size, NULL, 0);
+		if ( imageResult != Edif::DependencyWasResource )
+			free(Image);
 	}
+#endif
 
-	Edif::ExternalJSON = (result == Edif::DependencyWasFile);
+	// Get JSON file
+	if (!json)
+	{
+		char * JSON;
+		size_t JSON_Size;
 
-	char * copy = (char *) malloc (JSON_Size + 1);
-	memcpy (copy, JSON, JSON_Size);
-	copy [JSON_Size] = 0;
-	if ( result != Edif::DependencyWasResource )
-		free(JSON);
+		int result = Edif::GetDependency (JSON, JSON_Size, _T("json"), IDR_EDIF_JSON);
 
-	char json_error [256];
+		if (result == Edif::DependencyNotFound)
+		{
+			strcat_s(errorMsgTitle, " - Error");
 
-	json_settings settings;
-	memset (&settings, 0, sizeof (settings));
+			MessageBoxA(0, "JSON file not found on disk or in MFX resources", errorMsgTitle, 0);
+			return -1;	// error, init failed
+		}
 
-	json_value * json = json_parse_ex (&settings, copy, JSON_Size, json_error, sizeof(json_error));
+		Edif::ExternalJSON = (result == Edif::DependencyWasFile);
 
-	if (!json)
-	{
-		strcat_s(errorMsgTitle, " - Error parsing JSON");
+		char * copy = (char *) malloc (JSON_Size + 1);
+		memcpy (copy, JSON, JSON_Size);
+		copy [JSON_Size] = 0;
+		if ( result != Edif::DependencyWasResource )
+			free(JSON);
+
+		char json_error [256];
+
+		json_settings settings;
+		memset (&settings, 0, sizeof (settings));
 
-		MessageBoxA(0, json_error, errorMsgTitle, MB_OK);
-		return -1;
+		json = json_parse_ex (&settings, copy, JSON_Size, json_error, sizeof(json_error));
+
+		if (!json)
+		{
+			strcat_s(errorMsgTitle, " - Error parsing JSON");
+
+			MessageBoxA(0, json_error, errorMsgTitle, MB_OK);
+			return -1;
+		}
 	}
 
 	// Workaround for subapp bug (cheers LB), where Init/Free is called more than once,
@@ -256,6 +285,27 @@ int Edif::Init(mv * mV)
 	return 0;	// no error
 }
 
+// Flattens the parts of an A/C/E's info and JSON that are needed on every call.
+static Edif::ACEDescriptor MakeDescriptor(const ACEInfo * Info, const json_value &JSON)
+{
+	Edif::ACEDescriptor Desc = {};
+
+	Desc.NumParams = Info->NumOfParams;
+	Desc.FloatFlags = Info->FloatFlags;
+	Desc.Returns = Info->Flags.ef;
+
+	// If this JSON variable is set, the ACE's function reads its parameters past the first NumAutoProps
+	// itself, using CNC_XX macros; see ActionOrCondition() and Expression().
+	const json_value &numAutoProps = JSON["NumAutoProps"];
+	if (numAutoProps.type == json_integer && numAutoProps.u.integer >= 0 && numAutoProps.u.integer < Desc.NumParams)
+		Desc.NumParams = (short)numAutoProps.u.integer;
+
+	for (int i = 0; i < Info->NumOfParams; ++i)
+		Desc.Parameter[i].p = Info->Parameter[i].p;
+
+	return Desc;
+}
+
 // Used for reading the icon image file
 PhiDLLImport BOOL FusionAPI ImportImageFromInputFile(CImageFilterMgr* pImgMgr, CInputFile* pf, cSurface* psf, LPDWORD pDWFilterID, DWORD dwFlags);
 
@@ -358,6 +408,20 @@ Edif::SDK::SDK(mv * mV, json_value &_json) : json (_json)
 		CreateNewExpressionInfo();
 	}
 
+	ActionDescriptors.reserve(ActionInfos.size());
+	for (size_t i = 0; i < ActionInfos.size(); ++ i)
+		ActionDescriptors.push_back(MakeDescriptor(ActionInfos[i], Actions[i]));
+
+	ConditionDescriptors.reserve(ConditionInfos.size());
+	for (size_t i = 0; i < ConditionInfos.size(); ++ i)
+		ConditionDescriptors.push_back(MakeDescriptor(ConditionInfos[i], Conditions[i]));
+
+	ExpressionDescriptors.reserve(ExpressionInfos.size());
+	for (size_t i = 0; i < ExpressionInfos.size(); ++ i)
+		ExpressionDescriptors.push_back(MakeDescriptor(ExpressionInfos[i], Expressions[i]));
+
+	PropertyLayouts.Make(Properties);
+
 	// Phi woz 'ere
 	#if EditorBuild
 	{
@@ -636,39 +700,211 @@ Edif::SDK::~SDK()
 #endif
 }
 
-int ActionOrCondition(void * Function, int ID, RUNDATA * rdPtr, long Params1, long Params2)
+#ifdef DARKEDIF_ACE_PROFILER
+// Each thread counts into its own tables, so recording a call takes no lock. The tables are
+// sized once from the ACE counts, so they never move while Report() reads them; each count has one
+// writer, so it's a relaxed atomic, which Report() can read safely and costs the writer the same
+// as a plain add. The lock only guards the list of threads, which Report() walks; a thread that
+// exits adds its counts to the retired totals first.
+struct ProfilerCount
+{
+	std::atomic<std::uint64_t> Calls, Ticks, MaxTicks, StringBytes;
+};
+struct ProfilerThread
+{
+	std::unique_ptr<ProfilerCount[]> Entries[3];
+	size_t Sizes[3];
+
+	ProfilerThread();
+	~ProfilerThread();
+};
+
+// Never freed, as threads may exit after static destructors have run
+static struct ProfilerShared
+{
+	std::mutex Lock;
+	std::vector<ProfilerThread *> Threads;
+	std::vector<Edif::Profiler::Entry> Retired[3];
+} &ProfilerState = *new ProfilerShared();
+static thread_local ProfilerThread ProfilerThisThread;
+
+// Time stamp counter and performance counter at load, to convert ticks to seconds when reporting
+static const std::uint64_t ProfilerStartTicks = __rdtsc();
+static const LARGE_INTEGER ProfilerStartTime = [] { LARGE_INTEGER l; QueryPerformanceCounter(&l); return l; }();
+
+static void ProfilerAdd(std::vector<Edif::Profiler::Entry> &To, const ProfilerThread &From, int Type)
+{
+	if (To.size() < From.Sizes[Type])
+		To.resize(From.Sizes[Type]);
+	for (size_t i = 0; i < From.Sizes[Type]; ++i)
+	{
+		const ProfilerCount &Count = From.Entries[Type][i];
+		To[i].Calls += Count.Calls.load(std::memory_order_relaxed);
+		To[i].Ticks += Count.Ticks.load(std::memory_order_relaxed);
+		To[i].MaxTicks = std::max<std::uint64_t>(To[i].MaxTicks, Count.MaxTicks.load(std::memory_order_relaxed));
+		To[i].StringBytes += Count.StringBytes.load(std::memory_order_relaxed);
+	}
+}
+
+// Threads are only counted once they call an ACE, by which point the SDK has read every ACE from the JSON
+ProfilerThread::ProfilerThread()
+{
+	const size_t Counts[3] = { ::SDK->ActionDescriptors.size(), ::SDK->ConditionDescriptors.size(), ::SDK->ExpressionDescriptors.size() };
+	for (int i = 0; i < 3; ++i)
+	{
+		Sizes[i] = Counts[i];
+		Entries[i] = std::make_unique<ProfilerCount[]>(Counts[i]);
+	}
+
+	std::lock_guard<std::mutex> lock(ProfilerState.Lock);
+	ProfilerState.Threads.push_back(this);
+}
+ProfilerThread::~ProfilerThread()
+{
+	std::lock_guard<std::mutex> lock(ProfilerState.Lock);
+	for (int i = 0; i < 3; ++i)
+		ProfilerAdd(ProfilerState.Retired[i], *this, i);
+	ProfilerState.Threads.erase(std::find(ProfilerState.Threads.begin(), ProfilerState.Threads.end(), this));
+}
+
+// Only this thread writes its counts, so a load and store is enough
+static void ProfilerBump(std::atomic<std::uint64_t> &Count, std::uint64_t By)
+{
+	Count.store(Count.load(std::memory_order_relaxed) + By, std::memory_order_relaxed);
+}
+
+static void ProfilerRecord(Edif::Profiler::ACEType Type, int ID, std::uint64_t StartTicks, std::uint64_t StringBytes = 0)
+{
+	const std::uint64_t Ticks = __rdtsc() - StartTicks;
+	ProfilerThread &Thread = ProfilerThisThread;
+	if ((size_t)ID >= Thread.Sizes[(int)Type])
+		return;
+
+	ProfilerCount &Count = Thread.Entries[(int)Type][ID];
+	ProfilerBump(Count.Calls, 1);
+	ProfilerBump(Count.Ticks, Ticks);
+	if (Ticks > Count.MaxTicks.load(std::memory_order_relaxed))
+		Count.MaxTicks.store(Ticks, std::memory_order_relaxed);
+	ProfilerBump(Count.StringBytes, StringBytes);
+}
+
+static std::vector<Edif::Profiler::Entry> ProfilerTotals(Edif::Profiler::ACEType Type)
+{
+	std::lock_guard<std::mutex> lock(ProfilerState.Lock);
+	std::vector<Edif::Profiler::Entry> Totals = ProfilerState.Retired[(int)Type];
+	for (const ProfilerThread * Thread : ProfilerState.Threads)
+		ProfilerAdd(Totals, *Thread, (int)Type);
+	return Totals;
+}
+
+Edif::Profiler::Entry Edif::Profiler::Get(ACEType Type, unsigned int ID)
+{
+	const std::vector<Entry> Totals = ProfilerTotals(Type);
+	return ID < Totals.size() ? Totals[ID] : Entry {};
+}
+
+std::string Edif::Profiler::Report()
+{
+	LARGE_INTEGER Now, Frequency;
+	QueryPerformanceCounter(&Now);
+	QueryPerformanceFrequency(&Frequency);
+	const double Seconds = (double)(Now.QuadPart - ProfilerStartTime.QuadPart) / Frequency.QuadPart;
+	const double TicksPerMicrosecond = Seconds > 0.0 ? (__rdtsc() - ProfilerStartTicks) / (Seconds * 1e6) : 1.0;
+
+	struct Line
+	{
+		ACEType Type;
+		unsigned int ID;
+		Entry Totals;
+	};
+	std::vector<Line> Lines;
+	for (int Type = 0; Type < 3; ++Type)
+	{
+		const std::vector<Entry> Totals = ProfilerTotals((ACEType)Type);
+		for (size_t ID = 0; ID < Totals.size(); ++ID)
+			if (Totals[ID].Calls > 0)
+				Lines.push_back({ (ACEType)Type, (unsigned int)ID, Totals[ID] });
+	}
+	std::sort(Lines.begin(), Lines.end(), [](const Line &a, const Line &b) { return a.Totals.Ticks > b.Totals.Ticks; });
+
+	static const char * const TypeNames[] = { "Action", "Condition", "Expression" };
+	static const char * const JSONNames[] = { "Actions", "Conditions", "Expressions" };
+
+	std::string Result;
+	char Buffer[512];
+	sprintf_s(Buffer, PROJECT_NAME " ACE profile, %.1f seconds:\r\n%-10s %4s %-40s %10s %12s %10s %10s %12s\r\n",
+		Seconds, "Type", "ID", "Name", "Calls", "Total ms", "Avg us", "Max us", "String bytes");
+	Result += Buffer;
+
+	for (const Line &L : Lines)
+	{
+		const char * Name = CurLang[JSONNames[(int)L.Type]][L.ID]["Title"];
+		sprintf_s(Buffer, "%-10s %4u %-40.40s %10llu %12.3f %10.3f %10.3f %12llu\r\n",
+			TypeNames[(int)L.Type], L.ID, Name ? Name : "", L.Totals.Calls,
+			L.Totals.Ticks / TicksPerMicrosecond / 1000.0,
+			L.Totals.Ticks / TicksPerMicrosecond / L.Totals.Calls,
+			L.Totals.MaxTicks / TicksPerMicrosecond,
+			L.Totals.StringBytes);
+		Result += Buffer;
+	}
+	return Result;
+}
+
+bool Edif::Profiler::Dump(const TCHAR * Path)
+{
+	TCHAR TempPath[MAX_PATH];
+	if (!Path)
+	{
+		if (!GetTempPath(MAX_PATH, TempPath) ||
+			_tcscat_s(TempPath, _T("") PROJECT_NAME _T(" ACE profile.txt")))
+		{
+			return false;
+		}
+		Path = TempPath;
+	}
+
+	std::ofstream File(Path, std::ios::binary);
+	File << Report();
+	return File.good();
+}
+
+// Writes the report when the extension is unloaded; the SDK and its JSON are never freed, so names are still readable
+static struct ProfilerDumpAtExit
 {
-	bool Condition = (SDK->ConditionFunctions.size() >= (unsigned int)ID+1) && (SDK->ConditionFunctions[ID] == Function);
-	int * Parameters;
+	~ProfilerDumpAtExit()
+	{
+		if (::SDK)
+			Edif::Profiler::Dump();
+	}
+} DumpAtExit;
+
+#endif // DARKEDIF_ACE_PROFILER
+
+static std::intptr_t ActionOrCondition(Edif::ACEFunction Function, const Edif::ACEDescriptor &Desc, RUNDATA * rdPtr, long Params1, long Params2)
+{
+	// Sized for the most parameters an ACE can have, so the thunk never reads past the end even if
+	// the JSON and C++ definition disagree on the count.
+	std::intptr_t Parameters[sizeof(Desc.Parameter) / sizeof(*Desc.Parameter)] = {};
 	int ParameterCount;
 
 	// Reset by CNC_GetParam(). CurrentParam being correct only matters if you have object parameters, though.
 	EventParam* saveCurParam = rdPtr->rHo.CurrentParam;
 
-	const ACEInfo * Info = Condition ? SDK->ConditionInfos[ID] : SDK->ActionInfos[ID];
-
-	ParameterCount = Info->NumOfParams;
-
-	// If this JSON variable is set, this func doesn't read all the ACE parameters, which allows advanced users to call
+	// If NumAutoProps is set in the JSON, this func doesn't read all the ACE parameters, which allows advanced users to call
 	// CNC_XX macros to get parameters themselves.
 	// Only useful when the dev decides to allow varying parameter type (e.g. float or int) and which type to
 	// read it as is determined at runtime.
-	// Since parameters can only be interpreted once per ACE, we can't read it in the ASM, and as we don't have
-	// it in the ASM, we can't pass it to the function.
+	// Since parameters can only be interpreted once per ACE, we can't read it here, and as we don't have
+	// it here, we can't pass it to the function.
 	// Worth noting that if all non-auto parameters are not interpreted, a crash will occur.
-	// Also, don't set NumAutoProps to negative.
-	const json_value &numAutoProps = CurLang[Condition ? "Conditions" : "Actions"][ID]["NumAutoProps"];
-	if (numAutoProps.type == json_integer)
-		ParameterCount = (int)numAutoProps.u.integer;
-
-	Parameters = (int *) alloca(sizeof(int) * ParameterCount);
+	ParameterCount = Desc.NumParams;
 
 	for (int i = 0; i < ParameterCount; ++ i)
 	{
-		switch (Info->Parameter[i].p)
+		switch (Desc.Parameter[i].p)
 		{
 			case Params::Expression:
-				Parameters[i] = (Info->FloatFlags & (1 << i)) ?
+				Parameters[i] = (Desc.FloatFlags & (1 << i)) ?
 								CNC_GetFloatParameter(rdPtr) :
 								CNC_GetIntParameter(rdPtr);
 				break;
@@ -690,49 +926,9 @@ int ActionOrCondition(void * Function, int ID, RUNDATA * rdPtr, long Params1, lo
 		}
 	}
 
-	void * Extension = rdPtr->pExtension;
 	rdPtr->rHo.CurrentParam = saveCurParam;
 
-	int Result;
-
-	__asm
-	{
-		pushad					; Start new register set (do not interfere with already existing registers)
-
-		mov ecx, ParameterCount ; Store ParameterCount in ecx
-
-		cmp ecx, 0				; If no parameters, call function immediately
-		je CallNow
-
-		mov edx, Parameters		; Otherwise store pointer to int * in Parameters
-
-		mov ebx, ecx			; Copy ecx, or ParameterCount, to ebx
-		shl ebx, 2				; Multiply parameter count by 2^2 (size of 32-bit variable)
-
-		add edx, ebx			; add (ParameterCount * 4) to Parameters, making edx point to Parameters[param count]
-		sub edx, 4				; subtract 4 from edx, making it 0-based (ending array index)
-
-		PushLoop:
-
-			push [edx]			; Push value pointed to by Parameters[edx]
-			sub edx, 4			; Decrement next loop`s Parameter index:	for (><; ><; edx -= 4)
-
-			dec ecx				; Decrement loop index:					 for (><; ><; ecx--)
-
-			cmp ecx, 0			; If ecx == 0, end loop:					for (><; ecx == 0; ><)
-			jne PushLoop		; Optimisation: "cmp ecx, 0 / jne" can be replaced with "jcxz"
-
-		CallNow:
-
-		mov ecx, Extension		; Move Extension to ecx
-		call Function			; Call the function inside Extension
-
-		mov Result, eax			; Function`s return is stored in eax; copy it to Result
-
-		popad					; End new register set (restore registers that existed before popad)
-	}
-
-	return Result;
+	return Function(rdPtr->pExtension, Parameters);
 }
 
 HMENU Edif::LoadMenuJSON(int BaseID, const json_value &Source, HMENU Parent)
@@ -781,40 +977,62 @@ HMENU Edif::LoadMenuJSON(int BaseID, const json_value &Source, HMENU Parent)
 	return Parent;
 }
 
+// Keeps the strings copied before an action or condition valid while it runs; see StringArena.h
+struct StringHold
+{
+	Edif::Runtime &Runtime;
+
+	StringHold(Edif::Runtime &Runtime) : Runtime(Runtime)
+	{
+		Runtime.HoldStrings();
+	}
+	~StringHold()
+	{
+		Runtime.ReleaseStrings();
+	}
+};
+
 long FusionAPI Edif::Condition(RUNDATA * rdPtr, long param1, long param2)
 {
 	int ID = rdPtr->rHo.EventNumber;
+	const StringHold Hold(rdPtr->pExtension->Runtime);
 
 	rdPtr->pExtension->Runtime.param1 = param1;
 	rdPtr->pExtension->Runtime.param2 = param2;
 
-	if (::SDK->ConditionFunctions.size() < (unsigned int)ID)
+	if (::SDK->ConditionDescriptors.size() <= (unsigned int)ID)
 		return rdPtr->pExtension->Condition(ID, rdPtr, param1, param2);
 
-	void * Function = ::SDK->ConditionFunctions[ID];
+	Edif::ACEFunction Function = ::SDK->ConditionFunctions[ID];
 
 	if (!Function)
 		return rdPtr->pExtension->Condition(ID, rdPtr, param1, param2);
 
-	int Result = ActionOrCondition(Function, ID, rdPtr, param1, param2);
-
-	return *(char *) &Result;
+#ifdef DARKEDIF_ACE_PROFILER
+	const std::uint64_t StartTicks = __rdtsc();
+	const long Result = (long)ActionOrCondition(Function, ::SDK->ConditionDescriptors[ID], rdPtr, param1, param2);
+	ProfilerRecord(Edif::Profiler::ACEType::Condition, ID, StartTicks);
+	return Result;
+#else
+	return (long)ActionOrCondition(Function, ::SDK->ConditionDescriptors[ID], rdPtr, param1, param2);
+#endif
 }
 
 short FusionAPI Edif::Action(RUNDATA * rdPtr, long param1, long param2)
 {
 	/* int ID = rdPtr->rHo.hoAdRunHeader->rh4.rh4ActionStart->evtNum; */
 	int ID = rdPtr->rHo.EventNumber;
+	const StringHold Hold(rdPtr->pExtension->Runtime);
 
 	rdPtr->pExtension->Runtime.param1 = param1;
 	rdPtr->pExtension->Runtime.param2 = param2;
 
-	if (::SDK->ActionFunctions.size() < (unsigned int)ID)
+	if (::SDK->ActionDescriptors.size() <= (unsigned int)ID)
 	{
 		rdPtr->pExtension->Action(ID, rdPtr, param1, param2);
 		return 0;
 	}
-	void * Function = ::SDK->ActionFunctions[ID];
+	Edif::ACEFunction Function = ::SDK->ActionFunctions[ID];
 
 	if (!Function)
 	{
@@ -822,7 +1040,13 @@ short FusionAPI Edif::Action(RUNDATA * rdPtr, long param1, long param2)
 		return 0;
 	}
 
-	ActionOrCondition(Function, ID, rdPtr, param1, param2);
+#ifdef DARKEDIF_ACE_PROFILER
+	const std::uint64_t StartTicks = __rdtsc();
+	ActionOrCondition(Function, ::SDK->ActionDescriptors[ID], rdPtr, param1, param2);
+	ProfilerRecord(Edif::Profiler::ACEType::Action, ID, StartTicks);
+#else
+	ActionOrCondition(Function, ::SDK->ActionDescriptors[ID], rdPtr, param1, param2);
+#endif
 
 	return 0;
 }
@@ -834,41 +1058,27 @@ long FusionAPI Edif::Expression(RUNDATA * rdPtr, long param)
 	rdPtr->pExtension->Runtime.param1 = param;
 	rdPtr->pExtension->Runtime.param2 = 0;
 
-	if (::SDK->ExpressionFunctions.size() < (unsigned int)ID)
+	if (::SDK->ExpressionDescriptors.size() <= (unsigned int)ID)
 		return rdPtr->pExtension->Expression(ID, rdPtr, param);
 
-	void * Function = ::SDK->ExpressionFunctions[ID];
+	Edif::ACEFunction Function = ::SDK->ExpressionFunctions[ID];
 
 	if (!Function)
 		return rdPtr->pExtension->Expression(ID, rdPtr, param);
 
-	void * Extension = rdPtr->pExtension;
+	const Edif::ACEDescriptor &Desc = ::SDK->ExpressionDescriptors[ID];
+	ExpReturnType ExpressionRet = Desc.Returns;
 
-	const ACEInfo * Info = ::SDK->ExpressionInfos[ID];
-	ExpReturnType ExpressionRet = Info->Flags.ef;
+	// As in ActionOrCondition(), NumAutoProps in the JSON lets the expression's function read
+	// the remaining parameters itself.
+	int ParameterCount = Desc.NumParams;
 
-	int ExpressionRet2 = (int)ExpressionRet;
-
-	int ParameterCount = Info->NumOfParams;
-
-	// If this JSON variable is set, this func doesn't read all the ACE parameters, which allows advanced users to call
-	// CNC_XX Expression macros to get parameters themselves.
-	// Only useful when the dev decides to allow varying parameter type (e.g. float or int) and which type to
-	// read it as is determined at runtime.
-	// Since parameters can only be interpreted once per ACE, we can't read it in the ASM, and as we don't have
-	// it in the ASM, we can't pass it to the function.
-	// Worth noting that if all non-auto parameters are not interpreted, a crash will occur.
-	// Also, don't set NumAutoProps to negative.
-	const json_value &numAutoProps = CurLang["Expressions"][ID]["NumAutoProps"];
-	if (numAutoProps.type == json_integer)
-		ParameterCount = (int)numAutoProps.u.integer;
-
-	int * Parameters = (int *) _alloca(sizeof(int) * ParameterCount);
+	std::intptr_t Parameters[sizeof(Desc.Parameter) / sizeof(*Desc.Parameter)] = {};
 
 	for (int i = 0; i < ParameterCount; ++ i)
 	{
 		// if i == 0 (first parameter of expression) we call GET_PARAM_1, else we call GET_PARAM_2
-		switch (Info->Parameter[i].ep)
+		switch (Desc.Parameter[i].ep)
 		{
 			case ExpParams::String:
 				Parameters[i] = CallRunTimeFunction(rdPtr, RFUNCTION::GET_PARAM_1+(i > 0), TYPE_STRING, param);
@@ -885,60 +1095,20 @@ long FusionAPI Edif::Expression(RUNDATA * rdPtr, long param)
 			// In 3rd parameter, use 2 for float; use 0 for long/int
 			// If you << 1, it has the same effect as multiplying by 2, only faster
 			case ExpParams::Integer:
-				Parameters[i] = CallRunTimeFunction(rdPtr, RFUNCTION::GET_PARAM_1+(i > 0), ((Info->FloatFlags & (1 << i)) != 0) << 1, param);
+				Parameters[i] = CallRunTimeFunction(rdPtr, RFUNCTION::GET_PARAM_1+(i > 0), ((Desc.FloatFlags & (1 << i)) != 0) << 1, param);
 				break;
 		}
 	}
 
-	int Result;
-	__asm
-	{
-		pushad
-
-		mov ecx, ParameterCount
-
-		cmp ecx, 0
-		je CallNow
-
-		mov edx, Parameters
-
-		mov ebx, ecx
-		shl ebx, 2
-
-		add edx, ebx
-		sub edx, 4
-
-	PushLoop:
-
-		push [edx]
-		sub edx, 4
-
-		dec ecx
-
-		cmp ecx, 0
-		jne PushLoop
-
-	CallNow:
-
-		mov ecx, Extension
-		call Function
-
-		mov ecx, ExpressionRet2
-
-		cmp ecx, 2
-		jne NotFloat
-
-		fstp Result
-		jmp End
-
-	NotFloat:
-
-		mov Result, eax
-
-	End:
-
-		popad
-	}
+	// Float results come back as their bits, as Fusion expects
+#ifdef DARKEDIF_ACE_PROFILER
+	const std::uint64_t StartTicks = __rdtsc();
+	long Result = (long)Function(rdPtr->pExtension, Parameters);
+	ProfilerRecord(Edif::Profiler::ACEType::Expression, ID, StartTicks,
+		ExpressionRet == ExpReturnType::String && Result ? (_tcslen((const TCHAR *)Result) + 1) * sizeof(TCHAR) : 0);
+#else
+	long Result = (long)Function(rdPtr->pExtension, Parameters);
+#endif
 
 	// Must be after the expression func is evaluated, as sub-expressions inside the
 	// expression func (e.g. from generating events) could change it to something else
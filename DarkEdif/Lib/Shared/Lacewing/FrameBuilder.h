@@ -147,6 +147,60 @@ public:
 		tosendsize = 0;
 	}
 
+	// Sends the frame built so far, followed by content that is still in the caller's buffer.
+	// The caller must leave relayclient::messageheadroom writable bytes before content; the frame
+	// header and fields are written there, so content goes out in one write without being copied
+	// into this builder first.
+	inline void sendinplace(lacewing::client client, char * content, size_t contentsize)
+	{
+		if (!contentsize)
+			return send(client);
+
+		// Same header layout as preparefortransmission(), but ending where content starts
+		lw_ui8 type = (lw_ui8)*(lw_ui32 *) buffer;
+		size_t fieldsize = size - 8;
+		size_t messagesize = fieldsize + contentsize;
+		assert(messagesize < 0xffffffff);
+
+		char * start = content - fieldsize;
+		memcpy(start, buffer + 8, fieldsize);
+
+		if (messagesize < 254)
+		{
+			start -= 2;
+			start[1] = (lw_ui8) messagesize;
+		}
+		else if (messagesize < 0xffff)
+		{
+			start -= 4;
+			(*(lw_ui8 *) (start + 1))  = 254;
+			(*(lw_ui16 *) (start + 2)) = (lw_ui16) messagesize;
+		}
+		else
+		{
+			start -= 6;
+			(*(lw_ui8 *) (start + 1))  = 255;
+			(*(lw_ui32 *) (start + 2)) = (lw_ui32) messagesize;
+		}
+		start[0] = type;
+
+		client->write(start, (content - start) + contentsize);
+		framereset();
+	}
+
+	// UDP version of the above; UDP frames have no size, the datagram's is used
+	inline void sendinplace(lacewing::udp udp, lacewing::address address, char * content, size_t contentsize)
+	{
+		if (!contentsize)
+			return send(udp, address);
+
+		char * start = content - size;
+		memcpy(start, buffer, size);
+
+		udp->send(address, start, size + contentsize);
+		framereset();
+	}
+
 };
 
 #endif
@@ -413,6 +413,19 @@ namespace lacewing
 		message.send(internal.socket);
 	}
 
+	void relayclient::sendserver(lw_ui8 subchannel, char * data, size_t size, lw_ui8 variant) const
+	{
+		relayclientinternal &internal = *((relayclientinternal *)internaltag);
+		framebuilder &message = internal.messageMF;
+
+		lacewing::writelock wl = lock.createWriteLock();
+
+		message.addheader (1, variant); /* binaryservermessage */
+		message.add (subchannel);
+
+		message.sendinplace(internal.socket, data, size);
+	}
+
 	void relayclient::blastserver(lw_ui8 subchannel, std::string_view data, lw_ui8 variant) const
 	{
 		relayclientinternal &internal = *((relayclientinternal *)internaltag);
@@ -427,6 +440,19 @@ namespace lacewing
 		message.send(internal.udp, internal.socket->server_address());
 	}
 
+	void relayclient::blastserver(lw_ui8 subchannel, char * data, size_t size, lw_ui8 variant) const
+	{
+		relayclientinternal &internal = *((relayclientinternal *)internaltag);
+		framebuilder &message = internal.messageMF;
+
+		lacewing::writelock wl = lock.createWriteLock();
+
+		message.addheader (1, variant, true, internal.id); /* binaryservermessage */
+		message.add (subchannel);
+
+		message.sendinplace(internal.udp, internal.socket->server_address(), data, size);
+	}
+
 	const std::vector<std::shared_ptr<relayclient::channel>> & relayclient::getchannels() const
 	{
 		lock.checkHoldsRead();
@@ -451,6 +477,23 @@ namespace lacewing
 		message.send(clientinternal.socket);
 	}
 
+	void relayclient::channel::send(lw_ui8 subchannel, char * data, size_t size, lw_ui8 variant) const
+	{
+		if (peers.empty() || _readonly)
+			return;
+
+		relayclientinternal &clientinternal = client;
+		framebuilder &message = clientinternal.messageMF;
+
+		lacewing::writelock wl = lock.createWriteLock();
+
+		message.addheader (2, variant); /* binarychannelmessage */
+		message.add <lw_ui8>(subchannel);
+		message.add <lw_ui16>(this->_id);
+
+		message.sendinplace(clientinternal.socket, data, size);
+	}
+
 	void relayclient::channel::blast(lw_ui8 subchannel, std::string_view data, lw_ui8 variant) const
 	{
 		if (peers.empty() || _readonly)
@@ -468,6 +511,22 @@ namespace lacewing
 		message.send(clientinternal.udp, clientinternal.socket->server_address());
 	}
 
+	void relayclient::channel::blast(lw_ui8 subchannel, char * data, size_t size, lw_ui8 variant) const
+	{
+		if (peers.empty() || _readonly)
+			return;
+
+		relayclientinternal &clientinternal = client;
+		framebuilder &message = clientinternal.messageMF;
+		lacewing::writelock wl = lock.createWriteLock();
+
+		message.addheader(2, variant, true, clientinternal.id); /* binarychannelmessage */
+		message.add <lw_ui8>(subchannel);
+		message.add <lw_ui16>(this->_id);
+
+		message.sendinplace(clientinternal.udp, clientinternal.socket->server_address(), data, size);
+	}
+
 	void relayclient::channel::peer::send(lw_ui8 subchannel, std::string_view data, lw_ui8 variant) const
 	{
 		if (_readonly)
@@ -486,6 +545,23 @@ namespace lacewing
 		message.send(clientinternal.socket);
 	}
 
+	void relayclient::channel::peer::send(lw_ui8 subchannel, char * data, size_t size, lw_ui8 variant) const
+	{
+		if (_readonly)
+			return;
+
+		relayclientinternal &clientinternal = channel.client;
+		framebuilder &message = clientinternal.messageMF;
+
+		lacewing::writelock wl = lock.createWriteLock();
+		message.addheader (3, variant); /* binarypeermessage */
+		message.add <lw_ui8>(subchannel);
+		message.add <lw_ui16>(channel._id);
+		message.add <lw_ui16>(_id);
+
+		message.sendinplace(clientinternal.socket, data, size);
+	}
+
 	void relayclient::channel::peer::blast(lw_ui8 subchannel, std::string_view data, lw_ui8 variant) const
 	{
 		if (_readonly)
@@ -505,6 +581,24 @@ namespace lacewing
 		message.send(internal.udp, internal.socket->server_address());
 	}
 
+	void relayclient::channel::peer::blast(lw_ui8 subchannel, char * data, size_t size, lw_ui8 variant) const
+	{
+		if (_readonly)
+			return;
+
+		relayclientinternal &internal = channel.client;
+		framebuilder &message = internal.messageMF;
+
+		lacewing::writelock wl = lock.createWriteLock();
+
+		message.addheader(3, variant, true, internal.id); /* binarypeermessage */
+		message.add <lw_ui8>(subchannel);
+		message.add <lw_ui16>(channel._id);
+		message.add <lw_ui16>(_id);
+
+		message.sendinplace(internal.udp, internal.socket->server_address(), data, size);
+	}
+
 	void relayclient::channel::leave() const
 	{
 		// Leaving channel aborted: already in readonly mode, which means we've already left
@@ -170,6 +170,7 @@ typedef lw_i8 lw_bool;
 	lw_import		 lw_bool  lw_path_exists		(const char * filename);
 	lw_import			void  lw_temp_path			(char * buffer);
 	lw_import	const char *  lw_guess_mimetype		(const char * filename);
+	lw_import			void  lw_register_mimetype	(const char * extension, const char * mimetype);
 	lw_import			void  lw_md5				(char * output, const char * input, size_t length);
 	lw_import			void  lw_md5_hex			(char * output, const char * input, size_t length);
 	lw_import			void  lw_sha1				(char * output, const char * input, size_t length);
@@ -245,6 +246,31 @@ typedef lw_i8 lw_bool;
 	lw_import	  void *  lw_pump_tag			(lw_pump);
 	lw_import		void  lw_pump_set_tag		(lw_pump, void *);
 
+	/* Heap buffers used by streams for queued data are counted against the
+	 * pump of their stream.  Buffers given up by one stream can be pooled for
+	 * reuse by others, up to a process-wide limit in bytes (0, the default,
+	 * disables pooling).
+	 */
+
+	typedef struct lw_pump_buffer_stats
+	{
+		size_t allocations;		/* buffers created by malloc */
+		size_t pool_hits;		/* buffers created by reusing a pooled one */
+		size_t reallocations;
+		size_t releases;		/* buffers freed or given back to the pool */
+		size_t shrinks;			/* buffers shrunk for being idle and oversized */
+
+		size_t bytes_held, peak_bytes_held;
+
+	} lw_pump_buffer_stats;
+
+	lw_import		void  lw_pump_get_buffer_stats		(lw_pump, lw_pump_buffer_stats *);
+	lw_import		void  lw_pump_reset_buffer_stats	(lw_pump);
+
+	lw_import		void  lw_heapbuffer_set_pool_limit	(size_t bytes);
+	lw_import	  size_t  lw_heapbuffer_pool_limit		();
+	lw_import	  size_t  lw_heapbuffer_pool_size		();
+
 	#ifdef _WIN32
 
 	typedef void (lw_callback * lw_pump_callback)
@@ -560,6 +586,23 @@ typedef lw_i8 lw_bool;
 	lw_import				void  lw_ws_enable_manual_finish  (lw_ws);
 	lw_import				long  lw_ws_idle_timeout		  (lw_ws);
 	lw_import				void  lw_ws_set_idle_timeout	  (lw_ws, long seconds);
+	lw_import				long  lw_ws_max_keepalive_requests (lw_ws);
+	lw_import				void  lw_ws_set_max_keepalive_requests (lw_ws, long max_requests);
+	lw_import				void  lw_ws_set_upload_limits	  (lw_ws, lw_i64 max_body_size, lw_i64 max_upload_size, size_t max_field_size);
+	lw_import				void  lw_ws_set_upload_buffer_size (lw_ws, size_t);
+	lw_import				void  lw_ws_enable_upload_autosave (lw_ws);
+	lw_import				void  lw_ws_set_file_cache_limits (lw_ws, size_t max_file_size, size_t max_total_size);
+	lw_import			  size_t  lw_ws_file_cache_size		  (lw_ws);
+	lw_import				void  lw_ws_set_compression		  (lw_ws, int level, size_t min_size);
+	lw_import				 int  lw_ws_compression_level	  (lw_ws);
+	lw_import				void  lw_ws_compression_stats	  (lw_ws, lw_i64 * bytes_in, lw_i64 * bytes_out);
+	lw_import				long  lw_ws_session_idle_lifetime (lw_ws);
+	lw_import				void  lw_ws_set_session_idle_lifetime (lw_ws, long seconds);
+	lw_import				long  lw_ws_session_max_lifetime  (lw_ws);
+	lw_import				void  lw_ws_set_session_max_lifetime (lw_ws, long seconds);
+	lw_import			  size_t  lw_ws_max_sessions		  (lw_ws);
+	lw_import				void  lw_ws_set_max_sessions	  (lw_ws, size_t);
+	lw_import			  size_t  lw_ws_session_count		  (lw_ws);
 	lw_import			  void *  lw_ws_tag					  (lw_ws);
 	lw_import				void  lw_ws_set_tag				  (lw_ws, void * tag);
 	lw_import			 lw_addr  lw_ws_req_addr			  (lw_ws_req);
@@ -572,6 +615,7 @@ typedef lw_i8 lw_bool;
 	lw_import				void  lw_ws_req_set_mimetype	  (lw_ws_req, const char * mimetype);
 	lw_import				void  lw_ws_req_set_mimetype_ex	  (lw_ws_req, const char * mimetype, const char * charset);
 	lw_import				void  lw_ws_req_guess_mimetype	  (lw_ws_req, const char * filename);
+	lw_import			 lw_bool  lw_ws_req_send_file		  (lw_ws_req, const char * filename);
 	lw_import				void  lw_ws_req_finish			  (lw_ws_req);
 	lw_import			  lw_i64  lw_ws_req_last_modified	  (lw_ws_req);
 	lw_import				void  lw_ws_req_set_last_modified (lw_ws_req, lw_i64);
@@ -607,6 +651,7 @@ typedef lw_i8 lw_bool;
 	lw_import		const char *  lw_ws_req_POST			  (lw_ws_req, const char * name);
 	lw_import		const char *  lw_ws_req_body			  (lw_ws_req);
 	lw_import				void  lw_ws_req_disable_cache	  (lw_ws_req);
+	lw_import				void  lw_ws_req_disable_compression (lw_ws_req);
 	lw_import				long  lw_ws_req_idle_timeout	  (lw_ws_req);
 	lw_import				void  lw_ws_req_set_idle_timeout  (lw_ws_req, long seconds);
 /*  lw_import				void  lw_ws_req_enable_dl_resuming (lw_ws_req);
@@ -618,6 +663,7 @@ typedef lw_i8 lw_bool;
 	lw_import		const char *  lw_ws_upload_header		  (lw_ws_upload, const char * name);
 	lw_import				void  lw_ws_upload_set_autosave	  (lw_ws_upload);
 	lw_import		const char *  lw_ws_upload_autosave_fname (lw_ws_upload);
+	lw_import			  lw_i64  lw_ws_upload_size			  (lw_ws_upload);
 	lw_import	lw_ws_upload_hdr  lw_ws_upload_hdr_first	  (lw_ws_upload);
 	lw_import		const char *  lw_ws_upload_hdr_name		  (lw_ws_upload_hdr);
 	lw_import		const char *  lw_ws_upload_hdr_value	  (lw_ws_upload_hdr);
@@ -749,6 +795,9 @@ struct _pump
 
 	void post (void * proc, void * parameter = 0);
 
+	lw_import void buffer_stats (lw_pump_buffer_stats &);
+	lw_import void reset_buffer_stats ();
+
 	lw_import void tag (void *);
 	lw_import void * tag ();
 };
@@ -1208,11 +1257,72 @@ struct _webserver
 
 	lw_import void enable_manual_finish ();
 
+	/* Connections left idle for idle_timeout seconds after a response are
+	 * closed.  0, the default, keeps them open until the client closes them.
+	 */
+
 	lw_import long idle_timeout ();
 	lw_import void idle_timeout (long sec);
 
+	/* Connections are closed after this many requests (0 for no limit) */
+
+	lw_import long max_keepalive_requests ();
+	lw_import void max_keepalive_requests (long max_requests);
+
+	/* Requests with bodies over max_body_size, uploads over max_upload_size
+	 * and form fields (kept in memory) over max_field_size are answered with
+	 * 413 and the connection closed.  0 means no limit.
+	 *
+	 * Autosaved uploads are handed to a writer thread in buffers of
+	 * upload_buffer_size bytes, and on_upload_post waits until their files are
+	 * complete.  If a file can't be written, or the disk falls too far
+	 * behind, the request is answered with 500 or 503 instead.
+	 * enable_upload_autosave autosaves all of them.
+	 */
+
+	lw_import void upload_limits (lw_i64 max_body_size, lw_i64 max_upload_size,
+								 size_t max_field_size = 1024 * 1024);
+
+	lw_import void upload_buffer_size (size_t);
+	lw_import void enable_upload_autosave ();
+
+	/* Files sent with webserver_request::send_file are cached: small ones
+	 * completely, up to max_total_size bytes, and larger ones by metadata only.
+	 */
+
+	lw_import void file_cache_limits (size_t max_file_size, size_t max_total_size);
+	lw_import size_t file_cache_size ();
+
+	/* Text responses of at least min_size bytes are compressed with gzip or
+	 * deflate for clients that accept it, and precompressed .gz siblings are
+	 * sent by send_file.  A level of 0 (the default) disables compression.
+	 */
+
+	lw_import void compression (int level = -1, size_t min_size = 256);
+	lw_import int compression_level ();
+
+	lw_import void compression_stats (lw_i64 &bytes_in, lw_i64 &bytes_out);
+
 	lw_import void session_close (const char * id);
 
+	/* Sessions are closed after being idle for session_idle_lifetime seconds,
+	 * or session_max_lifetime seconds after creation (0 for no limit).  When
+	 * max_sessions is reached, the least recently used session is closed.
+	 * Expired sessions are swept every 10 seconds while the webserver is
+	 * hosted.
+	 */
+
+	lw_import long session_idle_lifetime ();
+	lw_import void session_idle_lifetime (long sec);
+
+	lw_import long session_max_lifetime ();
+	lw_import void session_max_lifetime (long sec);
+
+	lw_import size_t max_sessions ();
+	lw_import void max_sessions (size_t);
+
+	lw_import size_t session_count ();
+
 	typedef void (lw_callback * hook_get) (webserver, webserver_request);
 	typedef void (lw_callback * hook_post) (webserver, webserver_request);
 	typedef void (lw_callback * hook_head) (webserver, webserver_request);
@@ -1270,6 +1380,13 @@ struct _webserver_request : public _stream
 
 	lw_import void guess_mimetype (const char * filename);
 
+	/* Responds with a file, from the webserver's file cache where possible,
+	 * answering If-None-Match/If-Modified-Since.  Returns false if the file
+	 * doesn't exist.
+	 */
+
+	lw_import bool send_file (const char * filename);
+
 	lw_import void finish ();
 
 	lw_import long idle_timeout ();
@@ -1281,6 +1398,12 @@ struct _webserver_request : public _stream
 
 	lw_import void disable_cache ();
 
+	/* Sends this response uncompressed.  Call before writing the body if a
+	 * stream (such as a file) will be written to the request.
+	 */
+
+	lw_import void disable_compression ();
+
 	lw_import void enable_download_resuming ();
 
 
@@ -1379,6 +1502,9 @@ struct _webserver_upload
 	lw_import void		 set_autosave ();
 	lw_import const char * autosave_filename ();
 
+	/* Bytes received so far */
+	lw_import lw_i64 size ();
+
 	lw_import const char * header (const char * name);
 
 	lw_import webserver_upload_header header_first ();
@@ -204,6 +204,11 @@ extern const char * const lwp_months [];
 
 time_t lwp_parse_time (const char *);
 
+/* Gets the size and modification time of a regular file with a single stat,
+ * returning false if it doesn't exist or isn't a file.
+ */
+lw_bool lwp_file_stat (const char * filename, lw_i64 * last_modified, size_t * size);
+
 lwp_socket lwp_create_server_socket (lw_filter, int type, int protocol, lw_error);
 
 #ifdef __cplusplus
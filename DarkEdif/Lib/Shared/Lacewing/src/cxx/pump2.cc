@@ -100,6 +100,16 @@ void _pump::post_remove (lw_pump_watch watch)
 	lw_pump_post_remove ((lw_pump) this, watch);
 }
 
+void _pump::buffer_stats (lw_pump_buffer_stats &stats)
+{
+	lw_pump_get_buffer_stats ((lw_pump) this, &stats);
+}
+
+void _pump::reset_buffer_stats ()
+{
+	lw_pump_reset_buffer_stats ((lw_pump) this);
+}
+
 void * _pump::tag ()
 {
 	return lw_pump_tag ((lw_pump) this);
@@ -120,11 +120,98 @@ void _webserver::idle_timeout (long sec)
 	lw_ws_set_idle_timeout ((lw_ws) this, sec);
 }
 
+long _webserver::max_keepalive_requests ()
+{
+	return lw_ws_max_keepalive_requests ((lw_ws) this);
+}
+
+void _webserver::max_keepalive_requests (long max_requests)
+{
+	lw_ws_set_max_keepalive_requests ((lw_ws) this, max_requests);
+}
+
+void _webserver::upload_limits (lw_i64 max_body_size, lw_i64 max_upload_size,
+								size_t max_field_size)
+{
+	lw_ws_set_upload_limits ((lw_ws) this, max_body_size,
+							 max_upload_size, max_field_size);
+}
+
+void _webserver::upload_buffer_size (size_t size)
+{
+	lw_ws_set_upload_buffer_size ((lw_ws) this, size);
+}
+
+void _webserver::enable_upload_autosave ()
+{
+	lw_ws_enable_upload_autosave ((lw_ws) this);
+}
+
+void _webserver::file_cache_limits (size_t max_file_size, size_t max_total_size)
+{
+	lw_ws_set_file_cache_limits ((lw_ws) this, max_file_size, max_total_size);
+}
+
+size_t _webserver::file_cache_size ()
+{
+	return lw_ws_file_cache_size ((lw_ws) this);
+}
+
+void _webserver::compression (int level, size_t min_size)
+{
+	lw_ws_set_compression ((lw_ws) this, level, min_size);
+}
+
+int _webserver::compression_level ()
+{
+	return lw_ws_compression_level ((lw_ws) this);
+}
+
+void _webserver::compression_stats (lw_i64 &bytes_in, lw_i64 &bytes_out)
+{
+	lw_ws_compression_stats ((lw_ws) this, &bytes_in, &bytes_out);
+}
+
 void _webserver::session_close (const char * id)
 {
 	lw_ws_session_close ((lw_ws) this, id);
 }
 
+long _webserver::session_idle_lifetime ()
+{
+	return lw_ws_session_idle_lifetime ((lw_ws) this);
+}
+
+void _webserver::session_idle_lifetime (long sec)
+{
+	lw_ws_set_session_idle_lifetime ((lw_ws) this, sec);
+}
+
+long _webserver::session_max_lifetime ()
+{
+	return lw_ws_session_max_lifetime ((lw_ws) this);
+}
+
+void _webserver::session_max_lifetime (long sec)
+{
+	lw_ws_set_session_max_lifetime ((lw_ws) this, sec);
+}
+
+size_t _webserver::max_sessions ()
+{
+	return lw_ws_max_sessions ((lw_ws) this);
+}
+
+void _webserver::max_sessions (size_t max_sessions)
+{
+	lw_ws_set_max_sessions ((lw_ws) this, max_sessions);
+}
+
+size_t _webserver::session_count ()
+{
+	return lw_ws_session_count ((lw_ws) this);
+}
+
 void _webserver::on_get (_webserver::hook_get hook)
 {
 	lw_ws_on_get ((lw_ws) this, (lw_ws_hook_get) hook);
@@ -216,6 +303,11 @@ void _webserver_request::guess_mimetype (const char * filename)
 	lw_ws_req_guess_mimetype ((lw_ws_req) this, filename);
 }
 
+bool _webserver_request::send_file (const char * filename)
+{
+	return lw_ws_req_send_file ((lw_ws_req) this, filename);
+}
+
 void _webserver_request::finish ()
 {
 	lw_ws_req_finish ((lw_ws_req) this);
@@ -251,6 +343,11 @@ void _webserver_request::disable_cache ()
 	lw_ws_req_disable_cache ((lw_ws_req) this);
 }
 
+void _webserver_request::disable_compression ()
+{
+	lw_ws_req_disable_compression ((lw_ws_req) this);
+}
+
 void _webserver_request::enable_download_resuming ()
 {
 	/* lw_ws_req_enable_download_resuming ((lw_ws_req) this); */
@@ -421,6 +518,11 @@ const char * _webserver_upload::autosave_filename ()
 	return lw_ws_upload_autosave_fname ((lw_ws_upload) this);
 }
 
+lw_i64 _webserver_upload::size ()
+{
+	return lw_ws_upload_size ((lw_ws_upload) this);
+}
+
 const char * _webserver_upload::header (const char * name)
 {
 	return lw_ws_upload_header ((lw_ws_upload) this, name);
@@ -54,7 +54,7 @@ const char * lw_version ()
 		 #define PACKAGE_VERSION "0.5.4"
 	  #endif
 
-	  sprintf (version, "liblacewing " PACKAGE_VERSION " (%s, %d-bit)",
+	  lwp_snprintf (version, sizeof (version) - 1, "liblacewing " PACKAGE_VERSION " (%.32s, %d-bit)",
 					 platform, ((int) sizeof(void *)) * 8);
 	}
 
@@ -77,7 +77,7 @@ void lw_dump (const char * buffer, size_t size)
 	size_t i;
 	int row_offset = 0, row_offset_c = 0, row = 0;
 
-	if (size == -1)
+	if (size == (size_t) -1)
 	  size = (lw_ui32) strlen (buffer);
 
 	fprintf (stderr, "=== " lwp_fmt_size " bytes @ %p ===\n", size, buffer);
@@ -219,6 +219,7 @@ void lwp_refcount_log_release(struct lwp_refcount * refcount)
 #else
  void lw_trace(const char * format, ...)
  {
+	(void) format;
  }
 #endif
 
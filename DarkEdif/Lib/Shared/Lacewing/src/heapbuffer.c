@@ -28,21 +28,293 @@
  */
 
 #include "common.h"
+#include "pump.h"
+
+/* Buffers are allocated in power-of-two size classes, so that a buffer given
+ * up by one connection can be reused by the next one needing the same class.
+ * Buffers larger than the biggest class still grow by doubling, but are never
+ * pooled.  Pooling is off until lw_heapbuffer_set_pool_limit is called.
+ */
+
+#define lwp_heapbuffer_min_class_bits  7	/* 128 bytes */
+#define lwp_heapbuffer_max_class_bits  20	/* 1 MB */
+
+#define lwp_heapbuffer_num_classes \
+	(lwp_heapbuffer_max_class_bits - lwp_heapbuffer_min_class_bits + 1)
+
+/* Number of resets in a row using under a quarter of a buffer before it's
+ * given back, rather than kept around by an idle connection.
+ */
+#define lwp_heapbuffer_shrink_resets  8
+
+/* pool_sync guards the pool and the buffer statistics of every pump, which
+ * are updated by whichever thread owns the buffer.  Not every program calls
+ * lwp_init (an event pump with only an fdstream doesn't), so it's created on
+ * first use, by whichever thread gets there first.
+ *
+ * pool_enabled is set while pool_limit isn't 0, so that buffers don't lock
+ * pool_sync to take from or give to a pool that's off.  pool_limit itself is
+ * only read under the lock.
+ */
+static lwp_heapbuffer pool [lwp_heapbuffer_num_classes] = { 0 };
+static size_t pool_size = 0, pool_limit = 0;
+static lw_sync volatile pool_sync = 0;
+static long volatile pool_enabled = 0;
+
+#ifdef _WIN32
+	#define load_pool_sync() ((lw_sync) InterlockedCompareExchangePointer \
+		((PVOID volatile *) &pool_sync, 0, 0))
+	#define set_pool_sync(sync) ((lw_sync) InterlockedCompareExchangePointer \
+		((PVOID volatile *) &pool_sync, (sync), 0))
+	#define load_pool_enabled() InterlockedCompareExchange (&pool_enabled, 0, 0)
+	#define store_pool_enabled(enabled) InterlockedExchange (&pool_enabled, (enabled))
+#else
+	#define load_pool_sync() __atomic_load_n (&pool_sync, __ATOMIC_ACQUIRE)
+	#define set_pool_sync(sync) __sync_val_compare_and_swap (&pool_sync, (lw_sync) 0, (sync))
+	#define load_pool_enabled() __atomic_load_n (&pool_enabled, __ATOMIC_ACQUIRE)
+	#define store_pool_enabled(enabled) __atomic_store_n (&pool_enabled, (enabled), __ATOMIC_RELEASE)
+#endif
+
+static lw_sync get_pool_sync ()
+{
+	lw_sync sync, existing;
+
+	if ((sync = load_pool_sync ()))
+	  return sync;
+
+	sync = lw_sync_new ();
+
+	/* If another thread created one meanwhile, use that instead */
+
+	if ((existing = set_pool_sync (sync)))
+	{
+	  lw_sync_delete (sync);
+	  return existing;
+	}
+
+	return sync;
+}
+
+void lwp_heapbuffer_init ()
+{
+	get_pool_sync ();
+}
+
+static size_t round_allocation (size_t length)
+{
+	size_t allocated = ((size_t) 1) << lwp_heapbuffer_min_class_bits;
+
+	while (allocated < length)
+	  allocated <<= 1;
+
+	return allocated;
+}
+
+/* Returns the pool class of an allocation, or -1 if it isn't poolable */
+
+static int size_class (size_t allocated)
+{
+	int bits = lwp_heapbuffer_min_class_bits;
+
+	while (bits <= lwp_heapbuffer_max_class_bits)
+	{
+	  if (allocated == (((size_t) 1) << bits))
+		 return bits - lwp_heapbuffer_min_class_bits;
+
+	  ++ bits;
+	}
+
+	return -1;
+}
+
+static lwp_heapbuffer pool_take (size_t allocated)
+{
+	lwp_heapbuffer buffer = 0;
+	lw_sync sync;
+	int index;
+
+	if (!load_pool_enabled () || (index = size_class (allocated)) == -1)
+	  return 0;
+
+	sync = get_pool_sync ();
+	lw_sync_lock (sync);
+
+	if (pool_limit && (buffer = pool [index]))
+	{
+	  pool [index] = buffer->next_free;
+	  pool_size -= sizeof (*buffer) + buffer->allocated;
+	}
+
+	lw_sync_release (sync);
+
+	return buffer;
+}
+
+static void pool_give (lwp_heapbuffer buffer)
+{
+	size_t size = sizeof (*buffer) + buffer->allocated;
+	int index = size_class (buffer->allocated);
+
+	if (index != -1 && load_pool_enabled ())
+	{
+	  lw_sync sync = get_pool_sync ();
+	  lw_sync_lock (sync);
+
+	  if (pool_limit && pool_size + size <= pool_limit)
+	  {
+		 buffer->next_free = pool [index];
+		 pool [index] = buffer;
+
+		 pool_size += size;
+		 buffer = 0;
+	  }
+
+	  lw_sync_release (sync);
+	}
+
+	free (buffer);
+}
+
+/* Counts a buffer event against a pump.  counter may be 0 if only the bytes
+ * held change.
+ */
+static void track (lw_pump pump, size_t * counter, size_t before, size_t after)
+{
+	lw_pump_buffer_stats * stats;
+	lw_sync sync;
+
+	if (!pump)
+	  return;
+
+	stats = &pump->buffer_stats;
+
+	sync = get_pool_sync ();
+	lw_sync_lock (sync);
+
+	if (counter)
+	  ++ *counter;
+
+	stats->bytes_held += after;
+	stats->bytes_held -= before;
+
+	if (stats->bytes_held > stats->peak_bytes_held)
+	  stats->peak_bytes_held = stats->bytes_held;
+
+	lw_sync_release (sync);
+}
+
+void lw_pump_get_buffer_stats (lw_pump ctx, lw_pump_buffer_stats * stats)
+{
+	lw_sync sync = get_pool_sync ();
+
+	lw_sync_lock (sync);
+	*stats = ctx->buffer_stats;
+	lw_sync_release (sync);
+}
+
+void lw_pump_reset_buffer_stats (lw_pump ctx)
+{
+	size_t bytes_held;
+	lw_sync sync = get_pool_sync ();
+
+	lw_sync_lock (sync);
+
+	bytes_held = ctx->buffer_stats.bytes_held;
+
+	memset (&ctx->buffer_stats, 0, sizeof (ctx->buffer_stats));
+
+	/* Buffers still alive are still held */
+
+	ctx->buffer_stats.bytes_held =
+		ctx->buffer_stats.peak_bytes_held = bytes_held;
+
+	lw_sync_release (sync);
+}
+
+void lw_heapbuffer_set_pool_limit (size_t limit)
+{
+	int i;
+	lwp_heapbuffer buffer;
+	lw_sync sync;
+
+	lwp_init ();
+
+	sync = get_pool_sync ();
+	lw_sync_lock (sync);
+
+	pool_limit = limit;
+	store_pool_enabled (limit != 0);
+
+	/* Drop whatever no longer fits under the new limit, biggest first */
+
+	for (i = lwp_heapbuffer_num_classes - 1; i >= 0 && pool_size > limit; -- i)
+	{
+	  while ((buffer = pool [i]) && pool_size > limit)
+	  {
+		 pool [i] = buffer->next_free;
+		 pool_size -= sizeof (*buffer) + buffer->allocated;
+
+		 free (buffer);
+	  }
+	}
+
+	lw_sync_release (sync);
+}
+
+size_t lw_heapbuffer_pool_limit ()
+{
+	size_t limit;
+	lw_sync sync;
+
+	lwp_init ();
+
+	sync = get_pool_sync ();
+	lw_sync_lock (sync);
+	limit = pool_limit;
+	lw_sync_release (sync);
+
+	return limit;
+}
+
+size_t lw_heapbuffer_pool_size ()
+{
+	size_t size;
+	lw_sync sync;
+
+	lwp_init ();
+
+	sync = get_pool_sync ();
+	lw_sync_lock (sync);
+	size = pool_size;
+	lw_sync_release (sync);
+
+	return size;
+}
 
 void lwp_heapbuffer_free (lwp_heapbuffer * ctx)
 {
 	if (!*ctx)
 	  return;
 
-	free (*ctx);
+	if ((*ctx)->pump)
+	{
+	  track ((*ctx)->pump, &(*ctx)->pump->buffer_stats.releases,
+				(*ctx)->allocated, 0);
+	}
+
+	pool_give (*ctx);
 	*ctx = 0;
 }
 
 lw_bool lwp_heapbuffer_add (lwp_heapbuffer * ctx, const char * buffer, size_t length)
 {
-	/* TODO: discard data before the offset (might save a realloc) */
+	return lwp_heapbuffer_add_ex (ctx, 0, buffer, length);
+}
 
-	if (length == -1)
+lw_bool lwp_heapbuffer_add_ex (lwp_heapbuffer * ctx, lw_pump pump,
+								 const char * buffer, size_t length)
+{
+	if (length == (size_t) -1)
 	  length = strlen (buffer);
 
 	if (length == 0)
@@ -50,35 +322,72 @@ lw_bool lwp_heapbuffer_add (lwp_heapbuffer * ctx, const char * buffer, size_t le
 
 	if (!*ctx)
 	{
-	  size_t init_alloc = (length * 3);
+	  size_t init_alloc = round_allocation (length);
+
+	  size_t * counter = pump ? &pump->buffer_stats.pool_hits : 0;
 
-	  if (! (*ctx = (lwp_heapbuffer) malloc (sizeof (**ctx) + init_alloc)))
-		 return lw_false;
+	  if (! (*ctx = pool_take (init_alloc)))
+	  {
+		 if (! (*ctx = (lwp_heapbuffer) malloc (sizeof (**ctx) + init_alloc)))
+			return lw_false;
+
+		 counter = pump ? &pump->buffer_stats.allocations : 0;
+	  }
 
 	  memset (*ctx, 0, sizeof (**ctx));
 
 	  (*ctx)->allocated = init_alloc;
+	  (*ctx)->pump = pump;
+
+	  track (pump, counter, 0, init_alloc);
 	}
 	else
 	{
 	  size_t new_length = (*ctx)->length + length;
 
+	  /* Discard data before the offset first - that might save a realloc */
+
+	  if (new_length > (*ctx)->allocated && (*ctx)->offset > 0)
+	  {
+		 (*ctx)->length -= (*ctx)->offset;
+
+		 memmove ((*ctx)->buffer, (*ctx)->buffer + (*ctx)->offset,
+					(*ctx)->length);
+
+		 (*ctx)->offset = 0;
+
+		 new_length = (*ctx)->length + length;
+	  }
+
 	  if (new_length > (*ctx)->allocated)
 	  {
-		 while (new_length > (*ctx)->allocated)
-			(*ctx)->allocated *= 3;
+		 size_t old_alloc = (*ctx)->allocated;
+		 size_t new_alloc = round_allocation (new_length);
+		 lwp_heapbuffer resized;
 
-		 if (! (*ctx = (lwp_heapbuffer) realloc
-					(*ctx, sizeof (**ctx) + (*ctx)->allocated)))
+		 if (! (resized = (lwp_heapbuffer) realloc
+					(*ctx, sizeof (**ctx) + new_alloc)))
 		 {
 			return lw_false;
 		 }
+
+		 *ctx = resized;
+		 (*ctx)->allocated = new_alloc;
+
+		 if ((*ctx)->pump)
+		 {
+			track ((*ctx)->pump, &(*ctx)->pump->buffer_stats.reallocations,
+					 old_alloc, new_alloc);
+		 }
 	  }
 	}
 
 	memcpy ((*ctx)->buffer + (*ctx)->length, buffer, length);
 	(*ctx)->length += length;
 
+	if ((*ctx)->length > (*ctx)->peak)
+	  (*ctx)->peak = (*ctx)->length;
+
 	return lw_true;
 }
 
@@ -104,7 +413,43 @@ void lwp_heapbuffer_reset (lwp_heapbuffer * ctx)
 	if (!*ctx)
 	  return;
 
-	(*ctx)->length = (*ctx)->offset = 0;
+	/* An oversized buffer that has stayed mostly empty for a while is shrunk
+	 * in place to fit its recent peak, so it stays with the same pump.
+	 */
+
+	if ((*ctx)->peak <= (*ctx)->allocated / 4
+		  && (*ctx)->allocated > round_allocation (0))
+	{
+	  if (++ (*ctx)->idle_resets >= lwp_heapbuffer_shrink_resets)
+	  {
+		 size_t old_alloc = (*ctx)->allocated;
+		 size_t new_alloc = round_allocation ((*ctx)->peak);
+		 lwp_heapbuffer resized;
+
+		 /* If the realloc fails, the buffer is just left as it was */
+
+		 if ((resized = (lwp_heapbuffer) realloc
+					(*ctx, sizeof (**ctx) + new_alloc)))
+		 {
+			*ctx = resized;
+			(*ctx)->allocated = new_alloc;
+
+			if ((*ctx)->pump)
+			{
+			  track ((*ctx)->pump, &(*ctx)->pump->buffer_stats.shrinks,
+						old_alloc, new_alloc);
+			}
+		 }
+
+		 (*ctx)->idle_resets = 0;
+	  }
+	}
+	else
+	{
+	  (*ctx)->idle_resets = 0;
+	}
+
+	(*ctx)->length = (*ctx)->offset = (*ctx)->peak = 0;
 }
 
 size_t lwp_heapbuffer_length (lwp_heapbuffer * ctx)
@@ -33,13 +33,35 @@
 typedef struct _lwp_heapbuffer
 {
 	size_t length, allocated, offset;
+
+	/* Largest length seen since the last reset, and how many resets in a row
+	 * have used under a quarter of the allocation.  Used to shrink oversized
+	 * buffers once a connection goes quiet.
+	 */
+	size_t peak;
+	int idle_resets;
+
+	/* Pump whose statistics this buffer counts towards (may be 0), and the
+	 * next buffer in the pool free list while the buffer is pooled.
+	 */
+	lw_pump pump;
+	struct _lwp_heapbuffer * next_free;
+
 	char buffer [1];
 
 } * lwp_heapbuffer;
 
+void lwp_heapbuffer_init ();
+
 lw_bool lwp_heapbuffer_add (lwp_heapbuffer *, const char * buffer, size_t length);
 void lwp_heapbuffer_addf (lwp_heapbuffer *, const char * format, ...);
 
+/* As lwp_heapbuffer_add, but if the buffer has to be created, its allocations
+ * are counted in the statistics of the given pump.
+ */
+lw_bool lwp_heapbuffer_add_ex (lwp_heapbuffer *, lw_pump,
+								 const char * buffer, size_t length);
+
 void lwp_heapbuffer_trim_left (lwp_heapbuffer *, size_t);
 void lwp_heapbuffer_trim_right (lwp_heapbuffer *, size_t);
 
@@ -36,6 +36,8 @@ struct _lw_pump
 
 	long use_count;
 
+	lw_pump_buffer_stats buffer_stats;
+
 	void * tag;
 };
 
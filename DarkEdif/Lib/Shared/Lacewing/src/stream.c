@@ -237,7 +237,8 @@ static void queue_back (lw_stream ctx, const char * buffer, size_t size)
 	  list_push (ctx->back_queue, queued);
 	}
 
-	lwp_heapbuffer_add (&list_elem_back (ctx->back_queue)->buffer, buffer, size);
+	lwp_heapbuffer_add_ex (&list_elem_back (ctx->back_queue)->buffer, ctx->pump,
+						   buffer, size);
 }
 
 static void queue_front (lw_stream ctx, const char * buffer, size_t size)
@@ -252,7 +253,8 @@ static void queue_front (lw_stream ctx, const char * buffer, size_t size)
 	  list_push (ctx->front_queue, queued);
 	}
 
-	lwp_heapbuffer_add (&list_elem_back (ctx->front_queue)->buffer, buffer, size);
+	lwp_heapbuffer_add_ex (&list_elem_back (ctx->front_queue)->buffer, ctx->pump,
+						   buffer, size);
 }
 
 size_t lwp_stream_write (lw_stream ctx, const char * buffer, size_t size, int flags)
@@ -389,8 +391,8 @@ size_t lwp_stream_write (lw_stream ctx, const char * buffer, size_t size, int fl
 	  {
 		 if (lwp_heapbuffer_length (&list_front (ctx->back_queue).buffer) == 0)
 		 {
-			lwp_heapbuffer_add (&list_elem_front (ctx->back_queue)->buffer,
-								buffer + written, size - written);
+			lwp_heapbuffer_add_ex (&list_elem_front (ctx->back_queue)->buffer,
+								  ctx->pump, buffer + written, size - written);
 		 }
 		 else
 		 {
@@ -400,7 +402,8 @@ size_t lwp_stream_write (lw_stream ctx, const char * buffer, size_t size, int fl
 
 			queued.type = lwp_stream_queued_data;
 
-			lwp_heapbuffer_add (&queued.buffer, buffer + written, size - written);
+			lwp_heapbuffer_add_ex (&queued.buffer, ctx->pump,
+								  buffer + written, size - written);
 
 			list_push_front (ctx->back_queue, queued);
 		 }
@@ -1139,11 +1142,17 @@ size_t lw_stream_queued (lw_stream stream)
 
 void lw_stream_end_queue_hb (lw_stream ctx, int num_head_buffers,
 							 const char ** buffers, size_t * lengths)
+{
+	lwp_stream_end_queue_hb (ctx, num_head_buffers, buffers, lengths, 0);
+}
+
+void lwp_stream_end_queue_hb (lw_stream ctx, int num_head_buffers,
+							  const char ** buffers, size_t * lengths, int flags)
 {
 	for (int i = 0; i < num_head_buffers; ++ i)
 	{
 	  lwp_stream_write (ctx, buffers [i], lengths [i],
-			lwp_stream_write_ignore_queue | lwp_stream_write_ignore_busy);
+			lwp_stream_write_ignore_queue | lwp_stream_write_ignore_busy | flags);
 	}
 
 	lw_stream_end_queue (ctx);
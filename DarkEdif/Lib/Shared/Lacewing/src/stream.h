@@ -198,6 +198,14 @@ void lwp_stream_init (lw_stream, const lw_streamdef *, lw_pump);
  size_t lwp_stream_write
 	(lw_stream, const char * buffer, size_t size, int flags);
 
+/* As lw_stream_end_queue_hb, with extra lwp_stream_write flags for the head
+ * buffers.  The webserver passes lwp_stream_write_ignore_filters when a
+ * compression filter is upstream, so the head isn't queued behind the body.
+ */
+
+ void lwp_stream_end_queue_hb (lw_stream, int num_head_buffers,
+								const char ** buffers, size_t * lengths, int flags);
+
 
 /* Attempts to write data from PrevDirect, returning false on failure. If
  * successful, DirectBytesLeft will be adjusted.
@@ -38,6 +38,8 @@ void lwp_init ()
 
 	init_called = lw_true;
 
+	lwp_heapbuffer_init ();
+
 	#ifdef ENABLE_SSL
 
 	  STACK_OF (SSL_COMP) * comp_methods;
@@ -93,6 +95,20 @@ lw_i64 lw_last_modified (const char * filename)
 	return 0;
 }
 
+lw_bool lwp_file_stat (const char * filename, lw_i64 * last_modified,
+						size_t * size)
+{
+	struct stat attr;
+
+	if (stat (filename, &attr) != 0 || S_ISDIR (attr.st_mode))
+	  return lw_false;
+
+	*last_modified = attr.st_mtime;
+	*size = attr.st_size;
+
+	return lw_true;
+}
+
 void lw_temp_path (char * buffer)
 {
 	char * path = getenv ("TMPDIR");
@@ -45,33 +45,124 @@ struct _lw_ws_upload_hdr
 	lw_ws_upload_hdr * next;
 };
 
+typedef struct _lwp_ws_autosave * lwp_ws_autosave;
+
+struct _lwp_ws_autosave_job
+{
+	lwp_ws_autosave autosave;
+	int type;
+
+	char * data;
+	size_t size;
+};
+
 struct _lw_ws_upload
 {
 	lw_ws_req request;
 
 	lwp_nvhash disposition;
 
-	lw_file autosave_file;
-	char * autosave_filename;
+	/* Filled up to ws->upload_buffer_size bytes, then queued for the
+	 * webserver's writer thread, so a slow disk doesn't hold up the pump.
+	 */
+	lwp_ws_autosave autosave;
+	char * autosave_buffer;
+	size_t autosave_buffered;
+	lw_bool autosave_closed;
+
+	lw_i64 size;
 
 	list (struct _lw_ws_upload_hdr, headers);
 };
 
 lw_ws_upload lwp_ws_upload_new (lw_ws_req request);
-void lwp_ws_upload_delete (lw_ws_upload);
+void lwp_ws_upload_delete (lw_ws_upload, lw_bool remove_file);
+
+/* These return 0, or the status to reject the request with */
+
+long lwp_ws_upload_write (lw_ws_upload, const char * buffer, size_t size);
+long lwp_ws_upload_close (lw_ws_upload);
+
+void lwp_ws_autosave_stop (lw_ws);
 
 #include "multipart.h"
 
 #define lwp_session_id_length 32
 
+/* How often expired sessions are swept, in milliseconds.  Sessions found to be
+ * expired when accessed between sweeps are closed there and then.
+ */
+#define lwp_session_sweep_interval (10 * 1000)
+
 struct _lw_ws_session
 {
 	char id [lwp_session_id_length * 2 + 1];
 
+	time_t created, last_access;
+
+	/* Least recently used first, so the idle sweep and the session cap only
+	 * ever need to look at the front of the list.
+	 */
+	lw_ws_session lru_prev, lru_next;
+
 	lwp_nvhash data;
 	UT_hash_handle hh;
 };
 
+void lwp_ws_mimetypes_init ();
+
+void lwp_ws_sessions_sweep (lw_ws);
+void lwp_ws_sessions_start_sweep (lw_ws);
+void lwp_ws_sessions_clear (lw_ws);
+
+#ifdef __linux__
+	#define lwp_ws_file_cache_inotify
+#endif
+
+typedef struct _lwp_ws_cachedfile
+{
+	char * filename;
+
+	lw_i64 last_modified;
+	size_t size;
+
+	char etag [48];
+
+	/* The file contents, or 0 if the file is too big to keep in memory */
+	char * data;
+
+	/* When the file was last stat'd */
+	time_t checked;
+
+	/* Whether "name.gz" was missing when last looked for, and when, so a file
+	 * without one isn't stat'd for it on every request
+	 */
+	lw_bool gz_missing;
+	time_t gz_checked;
+
+	#ifdef lwp_ws_file_cache_inotify
+	  int watch;
+	#endif
+
+	UT_hash_handle hh;
+
+} * lwp_ws_cachedfile;
+
+void lwp_ws_file_cache_init (lw_ws);
+void lwp_ws_file_cache_clear (lw_ws);
+
+typedef struct _lwp_ws_deflate * lwp_ws_deflate;
+
+#define lwp_ws_default_compression_min_size  256
+
+#define lwp_ws_default_max_field_size  (1024 * 1024)
+#define lwp_ws_default_upload_buffer_size  (64 * 1024)
+
+/* Autosave data waiting for the writer thread, across all uploads, past which
+ * uploads are refused with 503 rather than buffered
+ */
+#define lwp_ws_autosave_max_queued  (64 * 1024 * 1024)
+
 struct _lw_ws
 {
 	lw_pump pump;
@@ -80,11 +171,56 @@ struct _lw_ws
 
 	lw_timer timer;
 
+	/* Sessions in the hash are in order of creation, which the absolute
+	 * lifetime sweep relies on.
+	 */
 	lw_ws_session sessions;
+	lw_ws_session lru_first, lru_last;
+
+	size_t session_count, max_sessions;
+	long session_idle_lifetime, session_max_lifetime;
+
+	lw_timer session_timer;
+
+	/* Least recently used first */
+	lwp_ws_cachedfile file_cache;
+
+	size_t file_cache_count, file_cache_size;
+	size_t max_cached_file_size, max_file_cache_size;
+
+	#ifdef lwp_ws_file_cache_inotify
+	  int inotify_fd;
+	  lw_pump_watch inotify_watch;
+	#endif
+
+	/* 0 if responses aren't compressed on the fly */
+	int compression_level;
+	size_t compression_min_size;
+
+	lw_i64 compression_bytes_in, compression_bytes_out;
+
+	/* Limits on request bodies (0 for no limit).  Form fields without a
+	 * filename are kept in memory, so are limited separately.
+	 */
+	lw_i64 max_body_size, max_upload_size;
+	size_t max_field_size;
+
+	size_t upload_buffer_size;
+	lw_bool autosave_uploads;
+
+	/* Opens, writes and removes autosave files; started with the first */
+	lw_thread autosave_thread;
+	lw_sync autosave_sync;
+	lw_event autosave_signal;
+
+	list (struct _lwp_ws_autosave_job, autosave_jobs);
+	size_t autosave_queued;
+	lw_bool autosave_stop;
 
 	lw_bool auto_finish;
 
 	long timeout;
+	long max_keepalive_requests;
 
 	lw_ws_hook_error		  on_error;
 	lw_ws_hook_get			on_get;
@@ -147,7 +283,15 @@ struct _lw_ws_req
 
 	list (struct _lw_ws_req_hdr, headers_out);
 
+	/* Upstream filter compressing the body, created on first use */
+	lwp_ws_deflate deflate;
+
 	lw_bool responded;
+
+	/* Answered with an error before the body was read; the rest of the body
+	 * is discarded and the connection closed.
+	 */
+	lw_bool rejected;
 };
 
 lw_ws_req lwp_ws_req_new (lw_ws, lwp_ws_client, const lw_streamdef *);
@@ -179,6 +323,11 @@ void lwp_ws_req_after_handler (lw_ws_req);
 void lwp_ws_req_call_hook (lw_ws_req);
 
 void lwp_ws_req_respond (lw_ws_req);
+void lwp_ws_req_reject (lw_ws_req, long code, const char * message);
+
+void lwp_ws_req_compress_begin (lw_ws_req);
+void lwp_ws_req_compress_end (lw_ws_req);
+lw_bool lwp_ws_req_accepts_gzip (lw_ws_req);
 
 
 struct _lwp_ws_client
@@ -0,0 +1,490 @@
+/* vim: set et ts=3 sw=3 ft=c:
+ *
+ * Copyright (C) 2012, 2013 James McLaughlin et al.  All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright
+ *	notice, this list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *	notice, this list of conditions and the following disclaimer in the
+ *	documentation and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHOR AND CONTRIBUTORS ``AS IS'' AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED.  IN NO EVENT SHALL THE AUTHOR OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS
+ * OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY
+ * OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGE.
+ */
+
+#include "common.h"
+#include <zlib.h>
+
+/* Response bodies are compressed by a filter stream sitting upstream of the
+ * request.  The response is still queued until lwp_ws_req_respond, so the
+ * compressed length is known by the time content-length is written.
+ *
+ * Nothing is compressed until min_size bytes of body have been written, which
+ * keeps tiny responses (and those with no body at all) identity-encoded, and
+ * gives the handler a chance to set the content type first.  Streams written
+ * to the request (such as lw_stream_write_file) are never compressed; any
+ * handler doing so should call lw_ws_req_disable_compression beforehand.
+ */
+
+#define lwp_ws_encoding_identity  0
+#define lwp_ws_encoding_gzip	  1
+#define lwp_ws_encoding_deflate	2
+
+#define lwp_ws_deflate_chunk  16384
+
+struct _lwp_ws_deflate
+{
+	struct _lw_stream stream;
+
+	lw_ws_req request;
+
+	/* The encoding for the response in progress, or identity when the filter
+	 * is just passing data through.
+	 */
+	int encoding;
+
+	lw_bool started;
+
+	/* The zlib stream is kept between responses and reset, rather than being
+	 * reallocated for each one.  It must be reinitialised if the encoding
+	 * (and so the header format) changes.
+	 */
+	int initialised_encoding;
+	z_stream z;
+
+	/* Body held back until there's enough of it to be worth compressing */
+	lwp_heapbuffer pending;
+};
+
+static const char * find_header_out (lw_ws_req request, const char * name)
+{
+	list_each (request->headers_out, header)
+	{
+	  if (!strcasecmp (header.name, name))
+		 return header.value;
+	}
+
+	return 0;
+}
+
+/* Returns the best encoding the client accepts from an Accept-Encoding header,
+ * preferring gzip.  An encoding with q=0 is refused; anything else is taken.
+ */
+
+static int negotiate (const char * header)
+{
+	lw_bool gzip = lw_false, deflate = lw_false, wildcard = lw_false;
+
+	while (*header)
+	{
+	  const char * name, * params;
+	  size_t name_length;
+	  lw_bool refused = lw_false;
+
+	  while (*header == ' ' || *header == '\t' || *header == ',')
+		 ++ header;
+
+	  name = header;
+
+	  while (*header && *header != ',' && *header != ';'
+				&& *header != ' ' && *header != '\t')
+	  {
+		 ++ header;
+	  }
+
+	  name_length = header - name;
+
+	  /* Parameters - only q matters */
+
+	  params = header;
+
+	  while (*header && *header != ',')
+		 ++ header;
+
+	  for (; params < header; ++ params)
+	  {
+		 if ((*params == 'q' || *params == 'Q') && params [1] == '=')
+		 {
+			refused = atof (params + 2) <= 0;
+			break;
+		 }
+	  }
+
+	  if (refused)
+		 continue;
+
+	  if (name_length == 4 && !strncasecmp (name, "gzip", 4))
+		 gzip = lw_true;
+	  else if (name_length == 6 && !strncasecmp (name, "x-gzip", 6))
+		 gzip = lw_true;
+	  else if (name_length == 7 && !strncasecmp (name, "deflate", 7))
+		 deflate = lw_true;
+	  else if (name_length == 1 && *name == '*')
+		 wildcard = lw_true;
+	}
+
+	if (gzip || wildcard)
+	  return lwp_ws_encoding_gzip;
+
+	if (deflate)
+	  return lwp_ws_encoding_deflate;
+
+	return lwp_ws_encoding_identity;
+}
+
+lw_bool lwp_ws_req_accepts_gzip (lw_ws_req request)
+{
+	return negotiate (lw_ws_req_header (request, "accept-encoding"))
+				== lwp_ws_encoding_gzip;
+}
+
+/* Already-compressed formats gain nothing and cost CPU, so only text and the
+ * common structured text types are compressed.
+ */
+
+static lw_bool is_compressible (const char * content_type)
+{
+	const char * end;
+	size_t length;
+
+	if (!content_type)
+	  return lw_false;
+
+	if (!strncasecmp (content_type, "text/", 5))
+	  return lw_true;
+
+	end = strchr (content_type, ';');
+	length = end ? (size_t) (end - content_type) : strlen (content_type);
+
+	while (length > 0 && content_type [length - 1] == ' ')
+	  -- length;
+
+	#define lwp_type_is(type) \
+	  (length == sizeof (type) - 1 && !strncasecmp (content_type, type, length))
+
+	#define lwp_type_ends_with(suffix) \
+	  (length >= sizeof (suffix) - 1 && !strncasecmp \
+		 (content_type + length - (sizeof (suffix) - 1), suffix, sizeof (suffix) - 1))
+
+	return lwp_type_is ("application/json")
+		 || lwp_type_is ("application/javascript")
+		 || lwp_type_is ("application/x-javascript")
+		 || lwp_type_is ("application/xml")
+		 || lwp_type_is ("application/xhtml+xml")
+		 || lwp_type_is ("application/wasm")
+		 || lwp_type_is ("image/svg+xml")
+		 || lwp_type_is ("image/x-icon")
+		 || lwp_type_ends_with ("+json")
+		 || lwp_type_ends_with ("+xml");
+
+	#undef lwp_type_is
+	#undef lwp_type_ends_with
+}
+
+static void deflate_data (lwp_ws_deflate ctx, const char * buffer,
+						  size_t size, int flush)
+{
+	char output [lwp_ws_deflate_chunk];
+	lw_ws ws = ctx->request->ws;
+
+	ctx->z.next_in = (Bytef *) buffer;
+	ctx->z.avail_in = (uInt) size;
+
+	ws->compression_bytes_in += size;
+
+	for (;;)
+	{
+	  int result;
+	  size_t produced;
+
+	  ctx->z.next_out = (Bytef *) output;
+	  ctx->z.avail_out = sizeof (output);
+
+	  result = deflate (&ctx->z, flush);
+
+	  assert (result != Z_STREAM_ERROR);
+
+	  produced = sizeof (output) - ctx->z.avail_out;
+
+	  if (produced > 0)
+	  {
+		 ws->compression_bytes_out += produced;
+		 lw_stream_data ((lw_stream) ctx, output, produced);
+	  }
+
+	  if (flush == Z_FINISH ? result == Z_STREAM_END : ctx->z.avail_out != 0)
+		 break;
+
+	  if (result != Z_OK && result != Z_BUF_ERROR)
+		 break;
+	}
+}
+
+/* Decides whether the response is really going to be compressed, now that
+ * there's enough of it to tell.  Returns false to send it as it is.
+ */
+
+static lw_bool start (lwp_ws_deflate ctx)
+{
+	lw_ws_req request = ctx->request;
+	const char * etag;
+	int window_bits;
+
+	if (find_header_out (request, "content-encoding")
+		  || !is_compressible (find_header_out (request, "content-type")))
+	{
+	  return lw_false;
+	}
+
+	window_bits = ctx->encoding == lwp_ws_encoding_gzip ? 15 + 16 : 15;
+
+	if (ctx->initialised_encoding != ctx->encoding)
+	{
+	  if (ctx->initialised_encoding != lwp_ws_encoding_identity)
+		 deflateEnd (&ctx->z);
+
+	  ctx->initialised_encoding = lwp_ws_encoding_identity;
+
+	  memset (&ctx->z, 0, sizeof (ctx->z));
+
+	  if (deflateInit2 (&ctx->z, request->ws->compression_level, Z_DEFLATED,
+							window_bits, 8, Z_DEFAULT_STRATEGY) != Z_OK)
+	  {
+		 return lw_false;
+	  }
+
+	  ctx->initialised_encoding = ctx->encoding;
+	}
+	else
+	{
+	  deflateReset (&ctx->z);
+	  deflateParams (&ctx->z, request->ws->compression_level, Z_DEFAULT_STRATEGY);
+	}
+
+	lw_ws_req_set_header (request, "content-encoding",
+		ctx->encoding == lwp_ws_encoding_gzip ? "gzip" : "deflate");
+
+	lw_ws_req_set_header (request, "vary", "accept-encoding");
+
+	/* The compressed body isn't byte-for-byte what a strong validator
+	 * describes, so downgrade it to a weak one.
+	 */
+
+	if ((etag = find_header_out (request, "etag")) && *etag == '"')
+	{
+	  char * weak = (char *) malloc (strlen (etag) + 3);
+
+	  if (weak)
+	  {
+		 sprintf (weak, "W/%s", etag);
+		 lw_ws_req_set_header (request, "etag", weak);
+		 free (weak);
+	  }
+	}
+
+	ctx->started = lw_true;
+
+	return lw_true;
+}
+
+static void pass_through (lwp_ws_deflate ctx)
+{
+	size_t length = lwp_heapbuffer_length (&ctx->pending);
+
+	ctx->encoding = lwp_ws_encoding_identity;
+
+	if (length > 0)
+	{
+	  lw_stream_data ((lw_stream) ctx,
+					  lwp_heapbuffer_buffer (&ctx->pending), length);
+	}
+
+	lwp_heapbuffer_reset (&ctx->pending);
+}
+
+static size_t def_sink_data (lw_stream stream, const char * buffer, size_t size)
+{
+	lwp_ws_deflate ctx = (lwp_ws_deflate) stream;
+
+	if (ctx->encoding == lwp_ws_encoding_identity)
+	{
+	  lw_stream_data (stream, buffer, size);
+	  return size;
+	}
+
+	if (ctx->started)
+	{
+	  deflate_data (ctx, buffer, size, Z_NO_FLUSH);
+	  return size;
+	}
+
+	lwp_heapbuffer_add_ex (&ctx->pending, stream->pump, buffer, size);
+
+	if (lwp_heapbuffer_length (&ctx->pending) < ctx->request->ws->compression_min_size)
+	  return size;
+
+	if (!start (ctx))
+	{
+	  pass_through (ctx);
+	  return size;
+	}
+
+	deflate_data (ctx, lwp_heapbuffer_buffer (&ctx->pending),
+				  lwp_heapbuffer_length (&ctx->pending), Z_NO_FLUSH);
+
+	lwp_heapbuffer_reset (&ctx->pending);
+
+	return size;
+}
+
+static lw_bool def_is_transparent (lw_stream stream)
+{
+	return ((lwp_ws_deflate) stream)->encoding == lwp_ws_encoding_identity;
+}
+
+static void def_cleanup (lw_stream stream)
+{
+	lwp_ws_deflate ctx = (lwp_ws_deflate) stream;
+
+	if (ctx->initialised_encoding != lwp_ws_encoding_identity)
+	  deflateEnd (&ctx->z);
+
+	ctx->initialised_encoding = lwp_ws_encoding_identity;
+
+	lwp_heapbuffer_free (&ctx->pending);
+}
+
+const static lw_streamdef def_deflate =
+{
+	def_sink_data,
+	0, /* sink_stream */
+	0, /* retry */
+	def_is_transparent,
+	0, /* close */
+	0, /* bytes_left */
+	0, /* read */
+	def_cleanup,
+	0  /* tail_size */
+};
+
+void lwp_ws_req_compress_begin (lw_ws_req request)
+{
+	lwp_ws_deflate ctx = request->deflate;
+	int encoding;
+
+	if (ctx)
+	{
+	  ctx->encoding = lwp_ws_encoding_identity;
+	  ctx->started = lw_false;
+
+	  lwp_heapbuffer_reset (&ctx->pending);
+	}
+
+	if (request->ws->compression_level == 0 || !strcmp (request->method, "HEAD"))
+	  return;
+
+	/* A stream from the last response (such as a file) is still being written
+	 * through the filter, so leave this one alone rather than compress the
+	 * tail of that.
+	 */
+
+	if (list_length (request->stream.prev) > 0)
+	  return;
+
+	encoding = negotiate (lw_ws_req_header (request, "accept-encoding"));
+
+	if (encoding == lwp_ws_encoding_identity)
+	  return;
+
+	if (!ctx)
+	{
+	  if (! (ctx = (lwp_ws_deflate) calloc (sizeof (*ctx), 1)))
+		 return;
+
+	  lwp_stream_init ((lw_stream) ctx, &def_deflate, request->ws->pump);
+
+	  ctx->request = request;
+
+	  /* Deleted along with the request */
+
+	  lw_stream_add_filter_upstream ((lw_stream) request, (lw_stream) ctx,
+									 lw_true, lw_false);
+
+	  request->deflate = ctx;
+	}
+
+	ctx->encoding = encoding;
+}
+
+void lwp_ws_req_compress_end (lw_ws_req request)
+{
+	lwp_ws_deflate ctx = request->deflate;
+
+	if ((!ctx) || ctx->encoding == lwp_ws_encoding_identity)
+	  return;
+
+	if (!ctx->started)
+	{
+	  /* Never reached min_size, so isn't worth compressing */
+
+	  pass_through (ctx);
+	  return;
+	}
+
+	deflate_data (ctx, 0, 0, Z_FINISH);
+
+	ctx->encoding = lwp_ws_encoding_identity;
+	ctx->started = lw_false;
+}
+
+void lw_ws_req_disable_compression (lw_ws_req request)
+{
+	lwp_ws_deflate ctx = request->deflate;
+
+	if ((!ctx) || ctx->encoding == lwp_ws_encoding_identity)
+	  return;
+
+	/* Once compressed output has been produced, the rest of the body has to
+	 * be compressed too.
+	 */
+
+	if (!ctx->started)
+	  pass_through (ctx);
+}
+
+void lw_ws_set_compression (lw_ws ws, int level, size_t min_size)
+{
+	if (level < 0 || level > 9)
+	  level = Z_DEFAULT_COMPRESSION;
+
+	ws->compression_level = level;
+	ws->compression_min_size = min_size;
+}
+
+int lw_ws_compression_level (lw_ws ws)
+{
+	return ws->compression_level;
+}
+
+void lw_ws_compression_stats (lw_ws ws, lw_i64 * bytes_in, lw_i64 * bytes_out)
+{
+	if (bytes_in)
+	  *bytes_in = ws->compression_bytes_in;
+
+	if (bytes_out)
+	  *bytes_out = ws->compression_bytes_out;
+}
@@ -0,0 +1,461 @@
+/* vim: set et ts=3 sw=3 ft=c:
+ *
+ * Copyright (C) 2012, 2013 James McLaughlin et al.  All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright
+ *	notice, this list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *	notice, this list of conditions and the following disclaimer in the
+ *	documentation and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHOR AND CONTRIBUTORS ``AS IS'' AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED.  IN NO EVENT SHALL THE AUTHOR OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS
+ * OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY
+ * OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGE.
+ */
+
+#include "common.h"
+
+#ifdef lwp_ws_file_cache_inotify
+	#include <sys/inotify.h>
+#endif
+
+/* Static files are served through a per-webserver cache of their metadata,
+ * and the contents of small files.  On Linux, entries are invalidated by
+ * inotify as soon as the file changes; elsewhere, an entry is trusted for
+ * lwp_ws_file_cache_revalidate seconds before the file is stat'd again.
+ *
+ * Files too large to cache are still sent with lw_stream_write_file, so they
+ * keep going through sendfile/TransmitFile.
+ */
+
+#define lwp_ws_file_cache_revalidate  2
+#define lwp_ws_file_cache_max_entries  4096
+
+static void entry_delete (lw_ws ws, lwp_ws_cachedfile entry)
+{
+	HASH_DEL (ws->file_cache, entry);
+
+	-- ws->file_cache_count;
+	ws->file_cache_size -= entry->data ? entry->size : 0;
+
+	#ifdef lwp_ws_file_cache_inotify
+
+	  if (entry->watch != -1)
+	  {
+		 /* inotify hands out one watch per inode, so another entry (the same
+		  * file under a different name) may still be using it.
+		  */
+
+		 lwp_ws_cachedfile other, tmp;
+		 lw_bool shared = lw_false;
+
+		 HASH_ITER (hh, ws->file_cache, other, tmp)
+		 {
+			if (other->watch == entry->watch)
+			{
+				shared = lw_true;
+				break;
+			}
+		 }
+
+		 if (!shared)
+			inotify_rm_watch (ws->inotify_fd, entry->watch);
+	  }
+
+	#endif
+
+	free (entry->data);
+	free (entry->filename);
+	free (entry);
+}
+
+static void drop_contents (lw_ws ws, lwp_ws_cachedfile entry)
+{
+	ws->file_cache_size -= entry->size;
+
+	free (entry->data);
+	entry->data = 0;
+}
+
+#ifdef lwp_ws_file_cache_inotify
+
+static void on_inotify_ready (void * tag)
+{
+	lw_ws ws = (lw_ws) tag;
+	char buffer [4096];
+	ssize_t bytes;
+
+	while ((bytes = read (ws->inotify_fd, buffer, sizeof (buffer))) > 0)
+	{
+	  for (char * i = buffer; i < buffer + bytes; )
+	  {
+		 struct inotify_event * event = (struct inotify_event *) i;
+		 lwp_ws_cachedfile entry, tmp;
+
+		 HASH_ITER (hh, ws->file_cache, entry, tmp)
+		 {
+			if (entry->watch == event->wd)
+			{
+				entry->watch = -1;  /* the watch is removed by the kernel or below */
+				entry_delete (ws, entry);
+			}
+		 }
+
+		 if (! (event->mask & IN_IGNORED))
+			inotify_rm_watch (ws->inotify_fd, event->wd);
+
+		 i += sizeof (*event) + event->len;
+	  }
+	}
+}
+
+static int watch_file (lw_ws ws, const char * filename)
+{
+	if (ws->inotify_fd == -1)
+	  return -1;
+
+	if (!ws->inotify_watch)
+	{
+	  ws->inotify_watch = lw_pump_add (ws->pump, ws->inotify_fd, ws,
+									  on_inotify_ready, 0, lw_false);
+	}
+
+	return inotify_add_watch (ws->inotify_fd, filename,
+							  IN_MODIFY | IN_ATTRIB | IN_CLOSE_WRITE
+								 | IN_MOVE_SELF | IN_DELETE_SELF);
+}
+
+#endif
+
+void lwp_ws_file_cache_init (lw_ws ws)
+{
+	ws->max_cached_file_size = 1024 * 64;
+	ws->max_file_cache_size = 1024 * 1024 * 16;
+
+	#ifdef lwp_ws_file_cache_inotify
+	  ws->inotify_fd = inotify_init1 (IN_NONBLOCK | IN_CLOEXEC);
+	#endif
+}
+
+void lwp_ws_file_cache_clear (lw_ws ws)
+{
+	while (ws->file_cache)
+	  entry_delete (ws, ws->file_cache);
+
+	#ifdef lwp_ws_file_cache_inotify
+
+	  if (ws->inotify_watch)
+	  {
+		 lw_pump_remove (ws->pump, ws->inotify_watch);
+		 ws->inotify_watch = 0;
+	  }
+
+	  if (ws->inotify_fd != -1)
+	  {
+		 close (ws->inotify_fd);
+		 ws->inotify_fd = -1;
+	  }
+
+	#endif
+}
+
+static lw_bool load_contents (lw_ws ws, lwp_ws_cachedfile entry)
+{
+	lwp_ws_cachedfile other, tmp;
+	FILE * file;
+
+	if (entry->size > ws->max_cached_file_size)
+	  return lw_true;  /* too big - served from disk each time */
+
+	/* Make room by dropping the contents of the least recently used files.
+	 * Entries without contents would free nothing, so their metadata stays.
+	 */
+
+	HASH_ITER (hh, ws->file_cache, other, tmp)
+	{
+	  if (ws->file_cache_size + entry->size <= ws->max_file_cache_size)
+		 break;
+
+	  if (other != entry && other->data)
+		 drop_contents (ws, other);
+	}
+
+	if (ws->file_cache_size + entry->size > ws->max_file_cache_size)
+	  return lw_true;
+
+	if (! (file = fopen (entry->filename, "rb")))
+	  return lw_false;
+
+	if ((entry->data = (char *) malloc (entry->size + 1)))
+	{
+	  if (fread (entry->data, 1, entry->size, file) != entry->size)
+	  {
+		 /* Changed under us - don't cache a partial read */
+
+		 free (entry->data);
+		 entry->data = 0;
+	  }
+	  else
+	  {
+		 ws->file_cache_size += entry->size;
+	  }
+	}
+
+	fclose (file);
+
+	return lw_true;
+}
+
+/* Returns the up to date cache entry for a file, or 0 if it doesn't exist */
+
+static lwp_ws_cachedfile find_entry (lw_ws ws, const char * filename)
+{
+	lwp_ws_cachedfile entry;
+	lw_i64 last_modified;
+	size_t size;
+	time_t now = time (0);
+
+	HASH_FIND (hh, ws->file_cache, filename, strlen (filename), entry);
+
+	if (entry)
+	{
+	  #ifdef lwp_ws_file_cache_inotify
+		 lw_bool trusted = entry->watch != -1
+			|| now - entry->checked < lwp_ws_file_cache_revalidate;
+	  #else
+		 lw_bool trusted = now - entry->checked < lwp_ws_file_cache_revalidate;
+	  #endif
+
+	  /* Move to the back, so the least recently used entries are evicted */
+
+	  HASH_DEL (ws->file_cache, entry);
+	  HASH_ADD_KEYPTR (hh, ws->file_cache, entry->filename,
+					   strlen (entry->filename), entry);
+
+	  if (trusted)
+		 return entry;
+
+	  if (lwp_file_stat (filename, &last_modified, &size)
+			&& last_modified == entry->last_modified && size == entry->size)
+	  {
+		 entry->checked = now;
+		 return entry;
+	  }
+
+	  entry_delete (ws, entry);
+	}
+
+	if (!lwp_file_stat (filename, &last_modified, &size))
+	  return 0;
+
+	if (ws->file_cache_count >= lwp_ws_file_cache_max_entries)
+	  entry_delete (ws, ws->file_cache);
+
+	if (! (entry = (lwp_ws_cachedfile) calloc (sizeof (*entry), 1)))
+	  return 0;
+
+	if (! (entry->filename = strdup (filename)))
+	{
+	  free (entry);
+	  return 0;
+	}
+
+	entry->last_modified = last_modified;
+	entry->size = size;
+	entry->checked = now;
+
+	/* Strong validator: changes whenever the size or modification time does */
+
+	lwp_snprintf (entry->etag, sizeof (entry->etag), "\"%llx-%llx\"",
+				  (unsigned long long) last_modified, (unsigned long long) size);
+
+	#ifdef lwp_ws_file_cache_inotify
+	  entry->watch = watch_file (ws, filename);
+	#endif
+
+	HASH_ADD_KEYPTR (hh, ws->file_cache, entry->filename,
+					 strlen (entry->filename), entry);
+
+	++ ws->file_cache_count;
+
+	if (!load_contents (ws, entry))
+	{
+	  entry_delete (ws, entry);
+	  return 0;
+	}
+
+	return entry;
+}
+
+/* If-None-Match is a comma separated list of entity tags, or "*".  Weak
+ * comparison is used, as RFC 7232 requires for this header.
+ */
+
+static lw_bool etag_matches (const char * header, const char * etag)
+{
+	size_t etag_length = strlen (etag);
+
+	for (;;)
+	{
+	  while (*header == ' ' || *header == '\t' || *header == ',')
+		 ++ header;
+
+	  if (!*header)
+		 return lw_false;
+
+	  if (*header == '*')
+		 return lw_true;
+
+	  if (header [0] == 'W' && header [1] == '/')
+		 header += 2;
+
+	  if (!strncmp (header, etag, etag_length)
+			&& (header [etag_length] == 0 || header [etag_length] == ','
+				 || header [etag_length] == ' ' || header [etag_length] == '\t'))
+	  {
+		 return lw_true;
+	  }
+
+	  while (*header && *header != ',')
+		 ++ header;
+	}
+}
+
+/* When compression is enabled, a precompressed "name.gz" next to the file is
+ * sent in its place to clients that accept gzip.  A miss is remembered in the
+ * file's entry for lwp_ws_file_cache_revalidate seconds (a file that doesn't
+ * exist can't be watched).
+ */
+
+static lwp_ws_cachedfile find_precompressed (lw_ws ws, lwp_ws_cachedfile file)
+{
+	lwp_ws_cachedfile entry;
+	size_t length = strlen (file->filename);
+	char * gz_filename;
+	time_t now = time (0);
+
+	if (ws->compression_level == 0)
+	  return 0;
+
+	if (file->gz_missing && now - file->gz_checked < lwp_ws_file_cache_revalidate)
+	  return 0;
+
+	if (! (gz_filename = (char *) malloc (length + 4)))
+	  return 0;
+
+	memcpy (gz_filename, file->filename, length);
+	memcpy (gz_filename + length, ".gz", 4);
+
+	entry = find_entry (ws, gz_filename);
+
+	free (gz_filename);
+
+	file->gz_missing = !entry;
+	file->gz_checked = now;
+
+	return entry;
+}
+
+lw_bool lw_ws_req_send_file (lw_ws_req request, const char * filename)
+{
+	lwp_ws_cachedfile entry, gz_entry;
+	const char * if_none_match;
+	lw_i64 if_modified_since;
+
+	if (! (entry = find_entry (request->ws, filename)))
+	  return lw_false;
+
+	if ((gz_entry = find_precompressed (request->ws, entry)))
+	{
+	  /* Either way, caches must not give this response to a client that
+	   * sends a different Accept-Encoding
+	   */
+
+	  lw_ws_req_set_header (request, "vary", "accept-encoding");
+
+	  if (lwp_ws_req_accepts_gzip (request))
+	  {
+		 lw_ws_req_disable_compression (request);
+		 lw_ws_req_set_header (request, "content-encoding", "gzip");
+
+		 entry = gz_entry;
+	  }
+	}
+
+	if (entry != gz_entry && !entry->data)
+	{
+	  /* Streamed from disk, which the compression filter can't take */
+
+	  lw_ws_req_disable_compression (request);
+	}
+
+	lw_ws_req_set_header (request, "etag", entry->etag);
+	lw_ws_req_set_last_modified (request, entry->last_modified);
+
+	/* If-None-Match takes precedence over If-Modified-Since when present */
+
+	if_none_match = lw_ws_req_header (request, "if-none-match");
+
+	if (*if_none_match)
+	{
+	  if (etag_matches (if_none_match, entry->etag))
+	  {
+		 lw_ws_req_set_unmodified (request);
+		 return lw_true;
+	  }
+	}
+	else if ((if_modified_since = lw_ws_req_last_modified (request)) != 0
+				&& entry->last_modified <= if_modified_since)
+	{
+	  lw_ws_req_set_unmodified (request);
+	  return lw_true;
+	}
+
+	lw_ws_req_guess_mimetype (request, filename);
+
+	if (entry->data)
+	  lw_stream_write ((lw_stream) request, entry->data, entry->size);
+	else
+	  lw_stream_write_file ((lw_stream) request, entry->filename);
+
+	return lw_true;
+}
+
+void lw_ws_set_file_cache_limits (lw_ws ws, size_t max_file_size,
+								  size_t max_total_size)
+{
+	lwp_ws_cachedfile entry, tmp;
+
+	ws->max_cached_file_size = max_file_size;
+	ws->max_file_cache_size = max_total_size;
+
+	/* Drop contents that no longer qualify; metadata stays cached */
+
+	HASH_ITER (hh, ws->file_cache, entry, tmp)
+	{
+	  if (entry->data && (entry->size > max_file_size
+							 || ws->file_cache_size > max_total_size))
+	  {
+		 drop_contents (ws, entry);
+	  }
+	}
+}
+
+size_t lw_ws_file_cache_size (lw_ws ws)
+{
+	return ws->file_cache_size;
+}
+
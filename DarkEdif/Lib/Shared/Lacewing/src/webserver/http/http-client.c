@@ -86,6 +86,14 @@ void client_cleanup (lwp_ws_client client)
 		 ctx->client.ws->on_disconnect (ctx->client.ws, ctx->request);
 	}
 
+	/* Removes the files of any uploads that didn't complete */
+
+	if (ctx->client.multipart)
+	{
+	  lwp_ws_multipart_delete (ctx->client.multipart);
+	  ctx->client.multipart = 0;
+	}
+
 	lwp_ws_req_delete (ctx->request);
 }
 
@@ -111,10 +119,12 @@ static size_t def_sink_data (lw_stream stream, const char * buffer, size_t size)
 
 	for (;;)
 	{
-	  if (!ctx->request->responded)
+	  if (!ctx->request->responded
+			|| (ctx->client.multipart && ctx->client.multipart->waiting))
 	  {
 		 /* The application hasn't yet called Finish() for the last request,
-		  * so no more data can be processed.
+		  * or its autosaved uploads are still being written, so no more data
+		  * can be processed.
 		  */
 
 		 return processed;
@@ -137,6 +147,8 @@ static size_t def_sink_data (lw_stream stream, const char * buffer, size_t size)
 
 	  if (ctx->parsing_headers)
 	  {
+		 lw_bool message_complete = lw_false;
+
 		 for (size_t i = processed; i < size; ++ i)
 		 {
 			char b = buffer [i];
@@ -156,12 +168,16 @@ static size_t def_sink_data (lw_stream stream, const char * buffer, size_t size)
 
 				if (ctx->parser.http_errno == HPE_PAUSED)
 				{
-				  /* Paused by onMessageEnd - this has no significance, since
-					* we're already parsing headers.
+				  /* Paused by on_message_complete - a request without a body
+					* has finished.  Anything left in the buffer belongs to the
+					* next pipelined request, which mustn't be parsed into the
+					* request object until this one has been responded to.
 					*/
 
 				  http_parser_pause (&ctx->parser, 0);
-				  continue;
+
+				  message_complete = lw_true;
+				  break;
 				}
 				else if (parsed != to_parse || ctx->parser.upgrade)
 				{
@@ -176,6 +192,9 @@ static size_t def_sink_data (lw_stream stream, const char * buffer, size_t size)
 			}
 		 }
 
+		 if (message_complete)
+			continue;
+
 		 /* Reached the end of the buffer - are we still parsing headers? */
 
 		 if (ctx->parsing_headers)
@@ -281,10 +300,42 @@ void client_respond (lwp_ws_client client, lw_ws_req request)
 						(int) request->version_minor,
 						request->status);
 
+	lw_bool keep_alive = http_should_keep_alive (&ctx->parser);
+	lw_bool connection_set = lw_false;
+
+	long max_requests = ctx->client.ws->max_keepalive_requests;
+
+	if (max_requests > 0 && (++ ctx->requests) >= max_requests)
+	  keep_alive = lw_false;
+
 	list_each (request->headers_out, header)
 	{
 	  lwp_heapbuffer_addf (&request->buffer, "\r\n%s: %s",
 							header.name, header.value);
+
+	  if (!strcasecmp (header.name, "connection"))
+		 connection_set = lw_true;
+	}
+
+	/* Let the client know whether the connection will stay open, unless the
+	* application has already said so itself.  HTTP/1.1 defaults to keep-alive
+	* and HTTP/1.0 to close, so only the opposite needs stating.
+	*/
+
+	if (!connection_set)
+	{
+	  if (!keep_alive)
+	  {
+		 if (request->version_major > 1
+				|| (request->version_major == 1 && request->version_minor >= 1))
+		 {
+			lwp_heapbuffer_addf (&request->buffer, "\r\nconnection: close");
+		 }
+	  }
+	  else if (request->version_major == 1 && request->version_minor == 0)
+	  {
+		 lwp_heapbuffer_addf (&request->buffer, "\r\nconnection: keep-alive");
+	  }
 	}
 
 	for (lw_ws_req_cookie cookie = request->cookies; cookie;
@@ -308,8 +359,13 @@ void client_respond (lwp_ws_client client, lw_ws_req request)
 	char * head_buffer = lwp_heapbuffer_buffer (&request->buffer);
 	size_t head_length = lwp_heapbuffer_length (&request->buffer);
 
-	lw_stream_end_queue_hb ((lw_stream) ctx->request, 1,
-							(const char **) &head_buffer, &head_length);
+	/* The head goes in front of the queued body; a compression filter upstream
+	 * is only for the body.
+	 */
+
+	lwp_stream_end_queue_hb ((lw_stream) ctx->request, 1,
+							 (const char **) &head_buffer, &head_length,
+							 request->deflate ? lwp_stream_write_ignore_filters : 0);
 
 	lw_stream_begin_queue ((lw_stream) ctx->request);
 
@@ -317,7 +373,7 @@ void client_respond (lwp_ws_client client, lw_ws_req request)
 
 	lw_fdstream_uncork ((lw_fdstream) ctx->client.socket);
 
-	if (!http_should_keep_alive (&ctx->parser))
+	if (!keep_alive)
 	  lw_stream_close ((lw_stream) ctx->client.socket, lw_false);
 
 	request->responded = lw_true;
@@ -33,6 +33,16 @@ static int on_message_begin (http_parser * parser)
 {
 	lwp_ws_httpclient ctx = (lwp_ws_httpclient) parser->data;
 
+	/* The last request has been responded to, so its uploads are done with */
+
+	if (ctx->client.multipart)
+	{
+	  lwp_ws_multipart_delete (ctx->client.multipart);
+	  ctx->client.multipart = 0;
+	}
+
+	ctx->body_size = 0;
+
 	lwp_ws_req_clean (ctx->request);
 
 	return 0;
@@ -111,6 +121,21 @@ static int on_headers_complete (http_parser * parser)
 	  return -1;
 	}
 
+	/* Refuse a body that's going to be too big before any of it is read */
+
+	lw_i64 max_body_size = ctx->client.ws->max_body_size;
+
+	if (max_body_size > 0)
+	{
+	  const char * content_length = lw_ws_req_header (ctx->request, "content-length");
+
+	  if (*content_length && strtoll (content_length, 0, 10) > max_body_size)
+	  {
+		 lwp_ws_req_reject (ctx->request, 413, "Payload Too Large");
+		 return 0;
+	  }
+	}
+
 	const char * content_type = lw_ws_req_header (ctx->request, "content-type");
 
 	lwp_trace ("Content-Type is %s", content_type);
@@ -132,12 +157,27 @@ static int on_headers_complete (http_parser * parser)
 static int on_body (http_parser * parser, const char * buffer, size_t size)
 {
 	lwp_ws_httpclient ctx = (lwp_ws_httpclient) parser->data;
+	lw_i64 max_body_size = ctx->client.ws->max_body_size;
+
+	if (ctx->request->rejected)
+	  return 0;  /* already answered - discard the rest */
+
+	ctx->body_size += size;
+
+	/* Chunked bodies have no content-length to check up front */
+
+	if (max_body_size > 0 && ctx->body_size > max_body_size)
+	{
+	  lwp_ws_req_reject (ctx->request, 413, "Payload Too Large");
+	  return 0;
+	}
 
 	if (!ctx->client.multipart)
 	{
 	  /* Normal request body - just buffer it */
 
-	  lwp_heapbuffer_add (&ctx->request->buffer, buffer, size);
+	  lwp_heapbuffer_add_ex (&ctx->request->buffer,
+							 ctx->request->stream.pump, buffer, size);
 	  return 0;
 	}
 
@@ -145,12 +185,19 @@ static int on_body (http_parser * parser, const char * buffer, size_t size)
 
 	if (lwp_ws_multipart_process (ctx->client.multipart, buffer, size) != size)
 	{
+	  long reject_code = ctx->client.multipart->reject_code;
+	  const char * reject_message = ctx->client.multipart->reject_message;
+
 	  lwp_trace ("Error w/ multipart form data");
 
 	  lwp_ws_multipart_delete (ctx->client.multipart);
 	  ctx->client.multipart = 0;
 
-	  return -1;
+	  if (!reject_code)
+		 return -1;
+
+	  lwp_ws_req_reject (ctx->request, reject_code, reject_message);
+	  return 0;
 	}
 
 	if ( (!ctx->client.multipart) || ctx->client.multipart->done)
@@ -163,7 +210,7 @@ static int on_message_complete (http_parser * parser)
 {
 	lwp_ws_httpclient ctx = (lwp_ws_httpclient) parser->data;
 
-	if (!ctx->client.multipart)
+	if ((!ctx->client.multipart) && !ctx->request->rejected)
 	  lwp_ws_req_call_hook (ctx->request);
 
 	ctx->parsing_headers = lw_true;
@@ -41,6 +41,12 @@ typedef struct _lwp_ws_httpclient
 
 	lw_bool parsing_headers, signal_eof;
 
+	/* Body bytes received for the current request */
+	lw_i64 body_size;
+
+	/* Requests responded to on this connection, for the keep-alive limit */
+	long requests;
+
 	char * cur_header_name;
 	size_t cur_header_name_length;
 
@@ -29,6 +29,10 @@
 
 #include "../common.h"
 
+/* Must be kept sorted by (lowercase) extension, as lw_guess_mimetype does a
+ * binary search over it.
+ */
+
 const char * const mimetypes [] =
 {
 	"323",			"text/h323",
@@ -138,8 +142,8 @@ const char * const mimetypes [] =
 	"pml",			"application/x-perfmon",
 	"pmr",			"application/x-perfmon",
 	"pmw",			"application/x-perfmon",
-	"pnm",			"image/x-portable-anymap",
 	"png",			"image/png",
+	"pnm",			"image/x-portable-anymap",
 	"pot",			"application/vnd.ms-powerpoint",
 	"ppm",			"image/x-portable-pixmap",
 	"pps",			"application/vnd.ms-powerpoint",
@@ -170,9 +174,9 @@ const char * const mimetypes [] =
 	"sst",			"application/vnd.ms-pkicertstore",
 	"stl",			"application/vnd.ms-pkistl",
 	"stm",			"text/html",
-	"svg",			"image/svg+xml",
 	"sv4cpio",		"application/x-sv4cpio",
 	"sv4crc",		 "application/x-sv4crc",
+	"svg",			"image/svg+xml",
 	"swf",			"application/x-shockwave-flash",
 	"t",			  "application/x-troff",
 	"tar",			"application/x-tar",
@@ -215,27 +219,213 @@ const char * const mimetypes [] =
 	"zip",			"application/zip",
 0 };
 
+#define num_mimetypes ((sizeof (mimetypes) / sizeof (*mimetypes) - 1) / 2)
+
+/* Longer than any extension in the table, so anything that doesn't fit can
+ * only be a custom type.
+ */
+#define max_extension_length 32
+
+/* Types added at runtime, keyed by lowercase extension.  These take priority
+ * over the built-in table.  lw_guess_mimetype hands out the type strings
+ * without copying, so they're interned and never freed, even when an
+ * extension is registered again with a different type.  Requests on other
+ * threads can look types up while they're being registered, so the table is
+ * guarded by mimetype_sync.  That's created by lw_ws_new, before there are any
+ * requests, or by registering a type before any webserver exists.
+ */
+typedef struct _lwp_ws_mimetype
+{
+	char * extension;
+	const char * mimetype;
+
+	UT_hash_handle hh;
+
+} * lwp_ws_mimetype;
+
+typedef struct _lwp_ws_interned
+{
+	struct _lwp_ws_interned * next;
+	char value [1];
+
+} * lwp_ws_interned;
+
+static lwp_ws_mimetype custom_mimetypes = 0;
+static lwp_ws_interned interned = 0;
+static lw_sync mimetype_sync = 0;
+
+void lwp_ws_mimetypes_init ()
+{
+	if (!mimetype_sync)
+	  mimetype_sync = lw_sync_new ();
+}
+
+static char * lowercase_copy (const char * extension)
+{
+	char * copy;
+	size_t i, length = strlen (extension);
+
+	if (! (copy = (char *) malloc (length + 1)))
+	  return 0;
+
+	for (i = 0; i < length; ++ i)
+	  copy [i] = (char) tolower ((unsigned char) extension [i]);
+
+	copy [length] = 0;
+
+	return copy;
+}
+
+/* Must be called with mimetype_sync held */
+
+static const char * intern (const char * value)
+{
+	lwp_ws_interned item;
+	size_t length = strlen (value);
+
+	for (item = interned; item; item = item->next)
+	{
+	  if (!strcmp (item->value, value))
+		 return item->value;
+	}
+
+	if (! (item = (lwp_ws_interned) malloc (sizeof (*item) + length)))
+	  return 0;
+
+	memcpy (item->value, value, length + 1);
+
+	item->next = interned;
+	interned = item;
+
+	return item->value;
+}
+
+/* Must be called with mimetype_sync held */
+
+static const char * find_custom (const char * key)
+{
+	lwp_ws_mimetype item;
+
+	HASH_FIND (hh, custom_mimetypes, key, strlen (key), item);
+
+	return item ? item->mimetype : 0;
+}
+
+void lw_register_mimetype (const char * extension, const char * mimetype)
+{
+	lwp_ws_mimetype item;
+	const char * value;
+	char * key;
+
+	lwp_ws_mimetypes_init ();
+
+	if (*extension == '.')
+	  ++ extension;
+
+	if (! (key = lowercase_copy (extension)))
+	  return;
+
+	lw_sync_lock (mimetype_sync);
+
+	if (! (value = intern (mimetype)))
+	{
+	  lw_sync_release (mimetype_sync);
+	  free (key);
+
+	  return;
+	}
+
+	HASH_FIND (hh, custom_mimetypes, key, strlen (key), item);
+
+	if (item)
+	{
+	  item->mimetype = value;
+	  free (key);
+	}
+	else if ((item = (lwp_ws_mimetype) calloc (sizeof (*item), 1)))
+	{
+	  item->extension = key;
+	  item->mimetype = value;
+
+	  HASH_ADD_KEYPTR (hh, custom_mimetypes, item->extension,
+							 strlen (item->extension), item);
+	}
+	else
+	{
+	  free (key);
+	}
+
+	lw_sync_release (mimetype_sync);
+}
+
 const char * lw_guess_mimetype (const char * filename)
 {
 	const char * extension;
-	const char * const * i;
+	const char * custom = 0;
+	char lower [max_extension_length];
+	char * key;
+	size_t length, i;
+	size_t first = 0, last = num_mimetypes;
+	int cmp;
+
+	if (!*filename)
+	  return "application/octet-stream";
 
-	if (*filename)
+	extension = strrchr (filename, '.');
+
+	if (!extension)
+	  extension = filename;
+	else
+	  ++ extension;
+
+	if ((length = strlen (extension)) >= sizeof (lower))
 	{
-		extension = strrchr (filename, '.');
+	  /* Too long for the stack buffer, and for the built-in table, so only
+	   * a custom type can match
+	   */
+
+	  if (!mimetype_sync || ! (key = lowercase_copy (extension)))
+		 return "application/octet-stream";
 
-		if (!extension)
-			extension = filename;
-		else
-			++ extension;
+	  lw_sync_lock (mimetype_sync);
+	  custom = find_custom (key);
+	  lw_sync_release (mimetype_sync);
 
-		for(i = mimetypes; *i; i += 2)
-			if(!strcasecmp (*i, extension))
-				return *++ i;
+	  free (key);
+
+	  return custom ? custom : "application/octet-stream";
 	}
 
-	return "application/octet-stream";
-}
+	for (i = 0; i < length; ++ i)
+	  lower [i] = (char) tolower ((unsigned char) extension [i]);
 
+	lower [length] = 0;
 
+	/* Without the lock, nothing has been registered yet */
+
+	if (mimetype_sync)
+	{
+	  lw_sync_lock (mimetype_sync);
+	  custom = find_custom (lower);
+	  lw_sync_release (mimetype_sync);
+
+	  if (custom)
+		 return custom;
+	}
+
+	while (first < last)
+	{
+	  size_t middle = first + (last - first) / 2;
+
+	  if (! (cmp = strcmp (lower, mimetypes [middle * 2])))
+		 return mimetypes [middle * 2 + 1];
+
+	  if (cmp < 0)
+		 last = middle;
+	  else
+		 first = middle + 1;
+	}
+
+	return "application/octet-stream";
+}
 
@@ -29,6 +29,10 @@
 
 #include "common.h"
 
+/* Longest part header line that will be buffered while waiting for the rest */
+
+#define lwp_ws_multipart_max_line  (16 * 1024)
+
 static lw_bool parse_disposition (lwp_ws_multipart ctx,
 								  size_t length,
 								  const char * disposition)
@@ -143,6 +147,29 @@ static lw_bool parse_disposition (lwp_ws_multipart ctx,
 	return lw_true;
 }
 
+/* Stops the parser, leaving the request to be answered with code */
+
+static int reject (lwp_ws_multipart ctx, long code, const char * message)
+{
+	lwp_ws_multipart top = ctx;
+
+	while (top->parent)
+	  top = top->parent;
+
+	top->reject_code = code;
+	top->reject_message = message;
+
+	return -1;
+}
+
+static int reject_upload (lwp_ws_multipart ctx, long code)
+{
+	if (code == 503)
+	  return reject (ctx, 503, "Service Unavailable");
+
+	return reject (ctx, 500, "Internal Server Error");
+}
+
 static int on_header_field (multipart_parser * parser,
 							const char * at,
 							size_t length)
@@ -197,7 +224,13 @@ static int on_header_value (multipart_parser * parser,
 	{
 	  if (lwp_begins_with (header.value, "multipart"))
 	  {
-		 ctx->child = lwp_ws_multipart_new (ctx->ws, ctx->request, header.value);
+		 if (! (ctx->child = lwp_ws_multipart_new
+					(ctx->ws, ctx->request, header.value)))
+		 {
+			return -1;
+		 }
+
+		 ctx->child->parent = ctx;
 
 		 const char * name = lwp_nvhash_get (&ctx->disposition, "name", 0);
 
@@ -222,7 +255,8 @@ static int on_headers_complete (multipart_parser * parser)
 	{
 	  /* A filename was given - assign this part an upload structure. */
 
-	  ctx->cur_upload = lwp_ws_upload_new (ctx->request);
+	  if (! (ctx->cur_upload = lwp_ws_upload_new (ctx->request)))
+		 return -1;
 
 	  ctx->cur_upload->disposition = ctx->disposition;
 	  ctx->disposition = 0;
@@ -234,6 +268,14 @@ static int on_headers_complete (multipart_parser * parser)
 
 	  list_clear (ctx->headers);
 
+	  if (ctx->ws->autosave_uploads)
+	  {
+		 lw_ws_upload_set_autosave (ctx->cur_upload);
+
+		 if (!ctx->cur_upload->autosave)
+			return reject (ctx, 500, "Internal Server Error");
+	  }
+
 	  lwp_trace ("Multipart %p: Calling on_upload_start", ctx);
 
 	  if (ctx->ws->on_upload_start)
@@ -274,15 +316,34 @@ static int on_part_data (multipart_parser * parser,
 		* so the data must be buffered.
 		*/
 
+	  if (ctx->ws->max_field_size
+			&& lwp_heapbuffer_length (&ctx->request->buffer) + length
+					> ctx->ws->max_field_size)
+	  {
+		 return reject (ctx, 413, "Payload Too Large");
+	  }
+
 	  lwp_heapbuffer_add (&ctx->request->buffer, at, length);
 	  return 0;
 	}
 
-	if (ctx->cur_upload->autosave_file)
+	ctx->cur_upload->size += length;
+
+	if (ctx->ws->max_upload_size
+		  && ctx->cur_upload->size > ctx->ws->max_upload_size)
+	{
+	  return reject (ctx, 413, "Payload Too Large");
+	}
+
+	if (ctx->cur_upload->autosave)
 	{
 	  /* Auto save mode */
 
-	  lw_stream_write ((lw_stream) ctx->cur_upload->autosave_file, at, length);
+	  long error = lwp_ws_upload_write (ctx->cur_upload, at, length);
+
+	  if (error)
+		 return reject_upload (ctx, error);
+
 	  return 0;
 	}
 
@@ -324,28 +385,39 @@ static int on_part_data_end (multipart_parser * parser)
 
 	if (ctx->cur_upload)
 	{
-	  if (ctx->parent)
-		 add_upload (ctx->parent, ctx->cur_upload);
-	  else
-		 add_upload (ctx, ctx->cur_upload);
+	  lwp_ws_multipart top = ctx;
+
+	  while (top->parent)
+		 top = top->parent;
+
+	  add_upload (top, ctx->cur_upload);
+
+	  lw_ws_upload upload = ctx->cur_upload;
+
+	  /* Owned by the uploads list from here on */
+
+	  ctx->cur_upload = 0;
 
-	  if (ctx->cur_upload->autosave_file)
+	  if (upload->autosave)
 	  {
-		 /* Auto save */
+		 /* Auto save - the handler waits for the writer to close the file */
 
 		 lwp_trace("Closing auto save file");
 
-		 lw_stream_close ((lw_stream) ctx->cur_upload->autosave_file, lw_false);
+		 long error = lwp_ws_upload_close (upload);
+
+		 if (error)
+			return reject_upload (ctx, error);
+
+		 ++ top->pending_saves;
 	  }
 	  else
 	  {
 		 /* Manual save */
 
 		 if (ctx->ws->on_upload_done)
-			ctx->ws->on_upload_done (ctx->ws, ctx->request, ctx->cur_upload);
+			ctx->ws->on_upload_done (ctx->ws, ctx->request, upload);
 	  }
-
-	  ctx->cur_upload = 0;
 	}
 	else
 	{
@@ -382,19 +454,19 @@ static int on_body_end (multipart_parser * parser)
 
 void lwp_ws_multipart_call_hook (lwp_ws_multipart ctx)
 {
-	/* The handler might have already been called in autosave mode
-	*/
 	if (ctx->called_handler)
 	  return;
 
-	/* Only call the handler if all files are closed
-	*/
-	for (int i = 0; i < ctx->num_uploads; ++ i)
+	/* Autosaved files are only handed over once they're complete */
+
+	if (ctx->pending_saves > 0)
 	{
-	  if (ctx->uploads [i]->autosave_file)
-		 return;
+	  ctx->waiting = lw_true;
+	  return;
 	}
 
+	ctx->waiting = lw_false;
+
 	ctx->called_handler = lw_true;
 
 	lwp_ws_req_before_handler (ctx->request);
@@ -408,6 +480,30 @@ void lwp_ws_multipart_call_hook (lwp_ws_multipart ctx)
 	lwp_ws_req_after_handler (ctx->request);
 }
 
+/* Called on the pump thread once the writer has closed an autosaved file */
+
+void lwp_ws_multipart_saved (lwp_ws_multipart ctx, lw_bool success)
+{
+	-- ctx->pending_saves;
+
+	if (!success)
+	{
+	  ctx->waiting = lw_false;
+
+	  lwp_ws_req_reject (ctx->request, 500, "Internal Server Error");
+	  return;
+	}
+
+	if (!ctx->waiting || ctx->pending_saves > 0)
+	  return;
+
+	lwp_ws_multipart_call_hook (ctx);
+
+	/* Anything received meanwhile can be processed now */
+
+	lw_stream_retry ((lw_stream) ctx->request->client, lw_stream_retry_now);
+}
+
 const multipart_parser_settings settings =
 {
 	on_header_field,
@@ -430,7 +526,15 @@ lwp_ws_multipart lwp_ws_multipart_new (lw_ws ws, lw_ws_req request,
 	ctx->ws = ws;
 	ctx->request = request;
 
-	const char * _boundary = strstr (content_type, "boundary=") + 9;
+	const char * _boundary = strstr (content_type, "boundary=");
+
+	if (!_boundary)
+	{
+	  free (ctx);
+	  return 0;
+	}
+
+	_boundary += 9;
 
 	char * boundary = (char *) alloca (strlen (_boundary) + 3);
 
@@ -464,6 +568,18 @@ void lwp_ws_multipart_delete (lwp_ws_multipart ctx)
 	if (ctx->child)
 	  lwp_ws_multipart_delete (ctx->child);
 
+	/* A part still being received when the request was abandoned */
+
+	if (ctx->cur_upload)
+	  lwp_ws_upload_delete (ctx->cur_upload, lw_true);
+
+	/* Finished uploads all end up in the outermost multipart.  Their files
+	 * only belong to the application once the handler has been called.
+	 */
+
+	for (int i = 0; i < ctx->num_uploads; ++ i)
+	  lwp_ws_upload_delete (ctx->uploads [i], !ctx->called_handler);
+
 	free (ctx->uploads);
 
 	free (ctx);
@@ -539,7 +655,12 @@ size_t lwp_ws_multipart_process (lwp_ws_multipart ctx,
 
 	  if (ctx->parsing_headers)
 	  {
-		 /* TODO : max line length */
+		 if (lwp_heapbuffer_length (&ctx->request->buffer) + size
+				> lwp_ws_multipart_max_line)
+		 {
+			reject (ctx, 413, "Payload Too Large");
+			return 0;
+		 }
 
 		 lwp_heapbuffer_add (&ctx->request->buffer, buffer, size);
 		 return buffer_size;
@@ -53,6 +53,18 @@ typedef struct _lwp_ws_multipart
 	lw_ws_upload * uploads;
 	int num_uploads;
 
+	/* Autosaved uploads whose files the writer hasn't closed yet, and whether
+	 * the handler is waiting for them
+	 */
+	int pending_saves;
+	lw_bool waiting;
+
+	/* Set when a limit is exceeded or an upload can't be saved; the request
+	 * should be answered with this status rather than treated as malformed.
+	 */
+	long reject_code;
+	const char * reject_message;
+
 } * lwp_ws_multipart;
 
 lwp_ws_multipart lwp_ws_multipart_new
@@ -64,4 +76,5 @@ size_t lwp_ws_multipart_process
 	(lwp_ws_multipart, const char * buffer, size_t size);
 
 void lwp_ws_multipart_call_hook (lwp_ws_multipart);
+void lwp_ws_multipart_saved (lwp_ws_multipart, lw_bool success);
 
@@ -59,6 +59,7 @@ void lwp_ws_req_delete (lw_ws_req ctx)
 void lwp_ws_req_clean (lw_ws_req ctx)
 {
 	ctx->responded = lw_true;
+	ctx->rejected = lw_false;
 	ctx->parsed_post_data = lw_false;
 
 	ctx->version_major = 0;
@@ -140,6 +141,8 @@ void lwp_ws_req_before_handler (lw_ws_req ctx)
 	  lw_ws_req_add_header (ctx, "cache-control", "public");
 	}
 
+	lwp_ws_req_compress_begin (ctx);
+
 	assert (ctx->responded);
 
 	ctx->responded = lw_false;
@@ -484,11 +487,38 @@ void lwp_ws_req_respond (lw_ws_req ctx)
 {
 	assert (!ctx->responded);
 
+	/* The rest of the compressed body has to be queued before the protocol
+	* works out the content length.
+	*/
+
+	lwp_ws_req_compress_end (ctx);
+
 	/* Respond may delete us w/ SPDY blah blah */
 
 	ctx->client->respond (ctx->client, ctx);
 }
 
+/* Answers a request without calling the handler (e.g. for a body that's too
+ * large), then closes the connection once the response has been sent.
+ */
+
+void lwp_ws_req_reject (lw_ws_req ctx, long code, const char * message)
+{
+	if (ctx->rejected || !ctx->responded)
+	  return;
+
+	lwp_ws_req_before_handler (ctx);
+
+	lw_ws_req_status (ctx, code, message);
+	lw_ws_req_set_header (ctx, "connection", "close");
+
+	ctx->rejected = lw_true;
+
+	lwp_ws_req_respond (ctx);
+
+	lw_stream_close ((lw_stream) ctx->client->socket, lw_false);
+}
+
 lw_addr lw_ws_req_addr (lw_ws_req ctx)
 {
 	return lw_server_client_addr (ctx->client->socket);
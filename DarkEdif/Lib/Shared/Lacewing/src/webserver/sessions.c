@@ -33,22 +33,176 @@ const char * const session_cookie = "lw_session";
 
 const char hex [] = "0123456789abcdef";
 
-void lw_ws_req_session_write (lw_ws_req request, const char * key,
-							  const char * value)
+static void lru_unlink (lw_ws ws, lw_ws_session session)
 {
-	const char * cookie = lw_ws_req_get_cookie (request, session_cookie);
+	if (session->lru_prev)
+	  session->lru_prev->lru_next = session->lru_next;
+	else
+	  ws->lru_first = session->lru_next;
+
+	if (session->lru_next)
+	  session->lru_next->lru_prev = session->lru_prev;
+	else
+	  ws->lru_last = session->lru_prev;
+
+	session->lru_prev = session->lru_next = 0;
+}
+
+static void lru_append (lw_ws ws, lw_ws_session session)
+{
+	session->lru_prev = ws->lru_last;
+	session->lru_next = 0;
+
+	if (ws->lru_last)
+	  ws->lru_last->lru_next = session;
+	else
+	  ws->lru_first = session;
+
+	ws->lru_last = session;
+}
+
+static void session_delete (lw_ws ws, lw_ws_session session)
+{
+	lru_unlink (ws, session);
+	HASH_DEL (ws->sessions, session);
 
+	-- ws->session_count;
+
+	lwp_nvhash_clear (&session->data);
+	free (session);
+}
+
+static lw_bool session_expired (lw_ws ws, lw_ws_session session, time_t now)
+{
+	if (ws->session_idle_lifetime > 0
+		  && now - session->last_access >= ws->session_idle_lifetime)
+	{
+	  return lw_true;
+	}
+
+	if (ws->session_max_lifetime > 0
+		  && now - session->created >= ws->session_max_lifetime)
+	{
+	  return lw_true;
+	}
+
+	return lw_false;
+}
+
+/* Finds the session for the request's cookie, moving it to the back of the LRU
+ * list.  A session which has expired since the last sweep is closed here.
+ */
+
+static lw_ws_session find_session (lw_ws_req request)
+{
+	const char * cookie = lw_ws_req_get_cookie (request, session_cookie);
+	lw_ws ws = request->ws;
 	lw_ws_session session;
+	time_t now;
 
-	if (*cookie)
+	if (!*cookie)
+	  return 0;
+
+	HASH_FIND (hh, ws->sessions, cookie, strlen (cookie), session);
+
+	if (!session)
+	  return 0;
+
+	now = time (0);
+
+	if (session_expired (ws, session, now))
 	{
-	  HASH_FIND (hh, request->ws->sessions, cookie, strlen (cookie), session);
+	  session_delete (ws, session);
+	  return 0;
 	}
-	else
+
+	session->last_access = now;
+
+	if (session != ws->lru_last)
 	{
-	  session = 0;
+	  lru_unlink (ws, session);
+	  lru_append (ws, session);
 	}
 
+	return session;
+}
+
+static void on_sweep_tick (lw_timer timer)
+{
+	lwp_ws_sessions_sweep ((lw_ws) lw_timer_tag (timer));
+}
+
+void lwp_ws_sessions_sweep (lw_ws ws)
+{
+	time_t now = time (0);
+
+	/* The LRU list is ordered by last access, and the hash by creation, so
+	 * each sweep stops at the first session that hasn't expired.
+	 */
+
+	if (ws->session_idle_lifetime > 0)
+	{
+	  while (ws->lru_first
+				&& now - ws->lru_first->last_access >= ws->session_idle_lifetime)
+	  {
+		 session_delete (ws, ws->lru_first);
+	  }
+	}
+
+	if (ws->session_max_lifetime > 0)
+	{
+	  while (ws->sessions
+				&& now - ws->sessions->created >= ws->session_max_lifetime)
+	  {
+		 session_delete (ws, ws->sessions);
+	  }
+	}
+
+}
+
+/* The sweep runs from when the webserver is hosted, whether or not sessions
+ * are being created, for as long as either lifetime is set.
+ */
+
+void lwp_ws_sessions_start_sweep (lw_ws ws)
+{
+	if (ws->session_idle_lifetime <= 0 && ws->session_max_lifetime <= 0)
+	{
+	  if (ws->session_timer)
+		 lw_timer_stop (ws->session_timer);
+
+	  return;
+	}
+
+	if (!ws->session_timer)
+	{
+	  ws->session_timer = lw_timer_new (ws->pump);
+	  lw_timer_set_tag (ws->session_timer, ws);
+	  lw_timer_on_tick (ws->session_timer, on_sweep_tick);
+	}
+
+	if (!lw_timer_started (ws->session_timer))
+	  lw_timer_start (ws->session_timer, lwp_session_sweep_interval);
+}
+
+void lwp_ws_sessions_clear (lw_ws ws)
+{
+	while (ws->sessions)
+	  session_delete (ws, ws->sessions);
+
+	if (ws->session_timer)
+	{
+	  lw_timer_delete (ws->session_timer);
+	  ws->session_timer = 0;
+	}
+}
+
+void lw_ws_req_session_write (lw_ws_req request, const char * key,
+							  const char * value)
+{
+	lw_ws ws = request->ws;
+	lw_ws_session session = find_session (request);
+
 	if (!session)
 	{
 	  char session_id [lwp_session_id_length];
@@ -58,6 +212,14 @@ void lw_ws_req_session_write (lw_ws_req request, const char * key,
 		 assert (0);
 	  }
 
+	  /* Make room by evicting the least recently used sessions */
+
+	  while (ws->max_sessions > 0 && ws->session_count >= ws->max_sessions
+				&& ws->lru_first)
+	  {
+		 session_delete (ws, ws->lru_first);
+	  }
+
 	  session = (lw_ws_session) calloc (sizeof (*session), 1);
 
 	  for (int i = 0; i < lwp_session_id_length; ++ i)
@@ -66,9 +228,14 @@ void lw_ws_req_session_write (lw_ws_req request, const char * key,
 		 session->id [i * 2 + 1] = hex [(session_id [i] & 0xF0) >> 4];
 	  }
 
-	  HASH_ADD_KEYPTR (hh, request->ws->sessions, session->id,
+	  session->created = session->last_access = time (0);
+
+	  HASH_ADD_KEYPTR (hh, ws->sessions, session->id,
 							strlen (session->id), session);
 
+	  lru_append (ws, session);
+	  ++ ws->session_count;
+
 	  lw_ws_req_set_cookie (request, session_cookie, session->id);
 	}
 
@@ -77,13 +244,7 @@ void lw_ws_req_session_write (lw_ws_req request, const char * key,
 
 const char * lw_ws_req_session_read (lw_ws_req request, const char * key)
 {
-	const char * cookie = lw_ws_req_get_cookie (request, session_cookie);
-
-	if (!*cookie)
-	  return "";
-
-	lw_ws_session session;
-	HASH_FIND (hh, request->ws->sessions, cookie, strlen (cookie), session);
+	lw_ws_session session = find_session (request);
 
 	if (!session)
 	  return "";
@@ -99,8 +260,7 @@ void lw_ws_session_close (lw_ws ws, const char * id)
 	if (!session)
 	  return;
 
-	lwp_nvhash_clear (&session->data);
-	HASH_DEL (ws->sessions, session);
+	session_delete (ws, session);
 }
 
 void lw_ws_req_session_close (lw_ws_req request)
@@ -115,13 +275,7 @@ const char * lw_ws_req_session_id (lw_ws_req request)
 
 lw_ws_sessionitem lw_ws_req_session_first (lw_ws_req request)
 {
-	const char * cookie = lw_ws_req_get_cookie (request, session_cookie);
-
-	if (!*cookie)
-	  return 0;
-
-	lw_ws_session session;
-	HASH_FIND (hh, request->ws->sessions, cookie, strlen (cookie), session);
+	lw_ws_session session = find_session (request);
 
 	if (!session)
 	  return 0;
@@ -129,6 +283,50 @@ lw_ws_sessionitem lw_ws_req_session_first (lw_ws_req request)
 	return (lw_ws_sessionitem) session->data;
 }
 
+void lw_ws_set_session_idle_lifetime (lw_ws ws, long seconds)
+{
+	ws->session_idle_lifetime = seconds;
+
+	if (lw_ws_hosting (ws) || lw_ws_hosting_secure (ws))
+	  lwp_ws_sessions_start_sweep (ws);
+}
+
+long lw_ws_session_idle_lifetime (lw_ws ws)
+{
+	return ws->session_idle_lifetime;
+}
+
+void lw_ws_set_session_max_lifetime (lw_ws ws, long seconds)
+{
+	ws->session_max_lifetime = seconds;
+
+	if (lw_ws_hosting (ws) || lw_ws_hosting_secure (ws))
+	  lwp_ws_sessions_start_sweep (ws);
+}
+
+long lw_ws_session_max_lifetime (lw_ws ws)
+{
+	return ws->session_max_lifetime;
+}
+
+void lw_ws_set_max_sessions (lw_ws ws, size_t max_sessions)
+{
+	ws->max_sessions = max_sessions;
+
+	while (max_sessions > 0 && ws->session_count > max_sessions)
+	  session_delete (ws, ws->lru_first);
+}
+
+size_t lw_ws_max_sessions (lw_ws ws)
+{
+	return ws->max_sessions;
+}
+
+size_t lw_ws_session_count (lw_ws ws)
+{
+	return ws->session_count;
+}
+
 lw_ws_sessionitem lw_ws_sessionitem_next (lw_ws_sessionitem item)
 {
 	return (lw_ws_sessionitem) ((lwp_nvhash) item)->hh.next;
@@ -29,6 +29,263 @@
 
 #include "common.h"
 
+/* Autosaved uploads are written by a thread of the webserver's, so that a slow
+ * disk holds up only the uploads rather than everything else on the pump.  The
+ * file is opened, written, closed and removed on that thread, which posts
+ * back to the pump once it's done with a file.
+ */
+
+enum
+{
+	lwp_ws_autosave_write,
+	lwp_ws_autosave_close,
+	lwp_ws_autosave_release,
+	lwp_ws_autosave_release_remove
+};
+
+struct _lwp_ws_autosave
+{
+	lw_ws ws;
+
+	/* Pump thread only; 0 once the upload has been deleted */
+	lw_ws_upload upload;
+
+	char * filename;
+
+	/* Writer thread only */
+	FILE * file;
+
+	/* Set by the writer thread under ws->autosave_sync */
+	lw_bool failed;
+};
+
+static void on_closed (lwp_ws_autosave autosave)
+{
+	lw_ws_upload upload = autosave->upload;
+	lwp_ws_multipart multipart;
+	lw_bool failed;
+
+	/* The request was abandoned while the file was being closed */
+
+	if (!upload || ! (multipart = upload->request->client->multipart))
+	  return;
+
+	lw_sync_lock (autosave->ws->autosave_sync);
+	failed = autosave->failed;
+	lw_sync_release (autosave->ws->autosave_sync);
+
+	lwp_ws_multipart_saved (multipart, !failed);
+}
+
+static void on_released (lwp_ws_autosave autosave)
+{
+	/* Posts are handled in order, so nothing else refers to it by now */
+
+	free (autosave->filename);
+	free (autosave);
+}
+
+static void run_job (lw_ws ws, struct _lwp_ws_autosave_job * job)
+{
+	lwp_ws_autosave autosave = job->autosave;
+	lw_bool failed = autosave->failed, remove_file = lw_false;
+
+	switch (job->type)
+	{
+	  case lwp_ws_autosave_write:
+	  case lwp_ws_autosave_close:
+
+		 if (!autosave->file && !failed)
+		 {
+			/* Data is only queued in whole buffers, so stdio needn't add one */
+
+			if ((autosave->file = fopen (autosave->filename, "wb")))
+				setvbuf (autosave->file, 0, _IONBF, 0);
+			else
+				failed = lw_true;
+		 }
+
+		 if (job->size > 0 && !failed
+			   && fwrite (job->data, 1, job->size, autosave->file) != job->size)
+		 {
+			failed = lw_true;
+		 }
+
+		 if (job->type == lwp_ws_autosave_close && autosave->file)
+		 {
+			if (fclose (autosave->file) != 0)
+				failed = lw_true;
+
+			autosave->file = 0;
+		 }
+
+		 break;
+
+	  case lwp_ws_autosave_release:
+	  case lwp_ws_autosave_release_remove:
+
+		 /* Still open means the upload never finished, so the file is partial */
+
+		 if (autosave->file)
+		 {
+			fclose (autosave->file);
+			autosave->file = 0;
+
+			remove_file = lw_true;
+		 }
+
+		 if (remove_file || job->type == lwp_ws_autosave_release_remove)
+			remove (autosave->filename);
+
+		 break;
+	};
+
+	free (job->data);
+
+	lw_sync_lock (ws->autosave_sync);
+
+	ws->autosave_queued -= job->size;
+	autosave->failed = failed;
+
+	lw_sync_release (ws->autosave_sync);
+
+	if (job->type == lwp_ws_autosave_close)
+	  lw_pump_post (ws->pump, (void *) on_closed, autosave);
+	else if (job->type != lwp_ws_autosave_write)
+	  lw_pump_post (ws->pump, (void *) on_released, autosave);
+}
+
+static int autosave_thread (lw_ws ws)
+{
+	for (;;)
+	{
+	  lw_sync_lock (ws->autosave_sync);
+
+	  if (!list_length (ws->autosave_jobs))
+	  {
+		 lw_bool stop = ws->autosave_stop;
+
+		 lw_sync_release (ws->autosave_sync);
+
+		 if (stop)
+			break;
+
+		 /* Unsignalled before looking at the queue again, so a job pushed in
+		  * between still gets seen
+		  */
+
+		 lw_event_wait (ws->autosave_signal, -1);
+		 lw_event_unsignal (ws->autosave_signal);
+
+		 continue;
+	  }
+
+	  struct _lwp_ws_autosave_job job = list_front (ws->autosave_jobs);
+	  list_pop_front (ws->autosave_jobs);
+
+	  lw_sync_release (ws->autosave_sync);
+
+	  run_job (ws, &job);
+	}
+
+	return 0;
+}
+
+static lw_bool start_writer (lw_ws ws)
+{
+	if (ws->autosave_thread)
+	  return lw_true;
+
+	if (! (ws->autosave_thread = lw_thread_new
+			("upload autosave", (void *) autosave_thread)))
+	{
+	  return lw_false;
+	}
+
+	ws->autosave_sync = lw_sync_new ();
+	ws->autosave_signal = lw_event_new ();
+	ws->autosave_stop = lw_false;
+
+	lw_thread_start (ws->autosave_thread, ws);
+
+	return lw_true;
+}
+
+/* Called once the webserver's clients are gone, so all that's left to do is
+ * release their files
+ */
+
+void lwp_ws_autosave_stop (lw_ws ws)
+{
+	if (!ws->autosave_thread)
+	  return;
+
+	lw_sync_lock (ws->autosave_sync);
+	ws->autosave_stop = lw_true;
+	lw_sync_release (ws->autosave_sync);
+
+	lw_event_signal (ws->autosave_signal);
+
+	lw_thread_join (ws->autosave_thread);
+	lw_thread_delete (ws->autosave_thread);
+
+	lw_event_delete (ws->autosave_signal);
+	lw_sync_delete (ws->autosave_sync);
+
+	ws->autosave_thread = 0;
+}
+
+static long queue (lw_ws_upload ctx, int type, char * data, size_t size)
+{
+	lwp_ws_autosave autosave = ctx->autosave;
+	lw_ws ws = autosave->ws;
+	long error = 0;
+	lw_bool wake = lw_false;
+
+	struct _lwp_ws_autosave_job job = { autosave, type, data, size };
+
+	if (!ws->autosave_thread)
+	{
+	  free (data);
+	  return 500;
+	}
+
+	lw_sync_lock (ws->autosave_sync);
+
+	/* Releasing always goes ahead, so that the file is cleaned up */
+
+	if (type == lwp_ws_autosave_write || type == lwp_ws_autosave_close)
+	{
+	  if (autosave->failed)
+		 error = 500;
+	  else if (ws->autosave_queued + size > lwp_ws_autosave_max_queued)
+		 error = 503;
+	}
+
+	if (!error)
+	{
+	  /* The writer only waits once it's found the queue empty */
+
+	  wake = !list_length (ws->autosave_jobs);
+
+	  list_push (ws->autosave_jobs, job);
+	  ws->autosave_queued += size;
+	}
+
+	lw_sync_release (ws->autosave_sync);
+
+	if (error)
+	{
+	  free (data);
+	  return error;
+	}
+
+	if (wake)
+	  lw_event_signal (ws->autosave_signal);
+
+	return 0;
+}
+
 lw_ws_upload lwp_ws_upload_new (lw_ws_req request)
 {
 	lw_ws_upload ctx = (lw_ws_upload) calloc (sizeof (*ctx), 1);
@@ -41,7 +298,7 @@ lw_ws_upload lwp_ws_upload_new (lw_ws_req request)
 	return ctx;
 }
 
-void lwp_ws_upload_delete (lw_ws_upload ctx)
+void lwp_ws_upload_delete (lw_ws_upload ctx, lw_bool remove_file)
 {
 	lwp_trace("Free upload!");
 
@@ -55,8 +312,94 @@ void lwp_ws_upload_delete (lw_ws_upload ctx)
 
 	list_clear (ctx->headers);
 
-	lw_stream_delete ((lw_stream) ctx->autosave_file);
-	free (ctx->autosave_filename);
+	free (ctx->autosave_buffer);
+
+	if (ctx->autosave)
+	{
+	  lwp_ws_autosave autosave = ctx->autosave;
+
+	  autosave->upload = 0;
+
+	  if (autosave->ws->autosave_thread)
+	  {
+		 queue (ctx, (remove_file || !ctx->autosave_closed) ?
+						lwp_ws_autosave_release_remove : lwp_ws_autosave_release,
+				0, 0);
+	  }
+	  else
+		 on_released (autosave);
+	}
+
+	free (ctx);
+}
+
+long lwp_ws_upload_write (lw_ws_upload ctx, const char * buffer, size_t size)
+{
+	size_t buffer_size = ctx->request->ws->upload_buffer_size;
+	char * data;
+	long error;
+
+	if (size == 0)
+	  return 0;
+
+	if (ctx->autosave_buffered + size <= buffer_size)
+	{
+	  if (!ctx->autosave_buffer
+			&& ! (ctx->autosave_buffer = (char *) malloc (buffer_size)))
+	  {
+		 return 500;
+	  }
+
+	  memcpy (ctx->autosave_buffer + ctx->autosave_buffered, buffer, size);
+	  ctx->autosave_buffered += size;
+
+	  if (ctx->autosave_buffered < buffer_size)
+		 return 0;
+
+	  size = 0;
+	}
+
+	/* Full, or this data wouldn't fit: queue what's buffered, then anything
+	 * as big as the buffer on its own
+	 */
+
+	if (ctx->autosave_buffered > 0)
+	{
+	  error = queue (ctx, lwp_ws_autosave_write,
+					 ctx->autosave_buffer, ctx->autosave_buffered);
+
+	  ctx->autosave_buffer = 0;
+	  ctx->autosave_buffered = 0;
+
+	  if (error)
+		 return error;
+	}
+
+	if (size == 0)
+	  return 0;
+
+	if (size < buffer_size)
+	  return lwp_ws_upload_write (ctx, buffer, size);
+
+	if (! (data = (char *) malloc (size)))
+	  return 500;
+
+	memcpy (data, buffer, size);
+
+	return queue (ctx, lwp_ws_autosave_write, data, size);
+}
+
+long lwp_ws_upload_close (lw_ws_upload ctx)
+{
+	long error = queue (ctx, lwp_ws_autosave_close,
+						ctx->autosave_buffer, ctx->autosave_buffered);
+
+	ctx->autosave_buffer = 0;
+	ctx->autosave_buffered = 0;
+
+	ctx->autosave_closed = lw_true;
+
+	return error;
 }
 
 const char * lw_ws_upload_filename (lw_ws_upload ctx)
@@ -111,37 +454,56 @@ lw_ws_upload_hdr lw_ws_upload_hdr_next (lw_ws_upload_hdr header)
 	return list_elem_next (header);
 }
 
-static void on_autosave_close (lw_stream stream, void * tag)
+void lw_ws_upload_set_autosave (lw_ws_upload ctx)
 {
-	lw_ws_upload upload = (lw_ws_upload) tag;
+	char name [lwp_max_path];
+	unsigned char random [8];
+	lw_ws ws = ctx->request->ws;
+	lwp_ws_autosave autosave;
 
-	lw_stream_delete ((lw_stream) upload->autosave_file);
-	upload->autosave_file = 0;
+	if (ctx->autosave)
+	  return;
 
-	lwp_ws_multipart_call_hook (upload->request->client->multipart);
-}
+	lw_temp_path (name);
+	lw_random ((char *) random, sizeof (random));
 
-void lw_ws_upload_set_autosave (lw_ws_upload ctx)
-{
-	if (ctx->autosave_file)
+	for (size_t i = 0; i < sizeof (random); ++ i)
+	  sprintf (name + strlen (name), "%02x", random [i]);
+
+	lwp_trace ("Autosaving upload to: %s", name);
+
+	if (! (autosave = (lwp_ws_autosave) calloc (sizeof (*autosave), 1)))
 	  return;
 
-	ctx->autosave_file = lw_file_new (ctx->request->ws->pump);
+	if (! (autosave->filename = strdup (name)))
+	{
+	  free (autosave);
+	  return;
+	}
 
-	lw_stream_add_hook_close ((lw_stream) ctx->autosave_file,
-							 on_autosave_close, ctx);
+	autosave->ws = ws;
+	autosave->upload = ctx;
 
-	lw_file_open_temp (ctx->autosave_file);
+	/* The file is opened by the writer, so a failure shows up as a 500 when
+	 * the next data is queued, or when the upload is closed
+	 */
 
-	free (ctx->autosave_filename);
-	ctx->autosave_filename = strdup (lw_file_name (ctx->autosave_file));
+	if (!start_writer (ws))
+	  autosave->failed = lw_true;
+
+	ctx->autosave = autosave;
 }
 
 const char * lw_ws_upload_autosave_fname (lw_ws_upload ctx)
 {
-	if (!ctx->autosave_filename)
+	if (!ctx->autosave)
 	  return "";
 
-	return ctx->autosave_filename;
+	return ctx->autosave->filename;
 }
 
+
+lw_i64 lw_ws_upload_size (lw_ws_upload ctx)
+{
+	return ctx->size;
+}
@@ -94,39 +94,38 @@ static void on_error (lw_server server, lw_error error)
 
 static void start_timer (lw_ws ctx)
 {
-	#ifdef LacewingTimeoutExperiment
-
-	  if (lw_timer_started (ctx->timer))
-		 return;
-
-	  lw_timer_start (ctx->timer, ctx->timeout * 1000);
+	if (lw_timer_started (ctx->timer) || ctx->timeout <= 0)
+	  return;
 
-	#endif
+	lw_timer_start (ctx->timer, ctx->timeout * 1000);
 }
 
-static void on_timer_tick (lw_timer timer)
+static void tick_clients (lw_server server)
 {
-	lw_server_client client_socket;
+	lw_server_client client_socket, next;
 	lwp_ws_client client;
-	lw_ws ws = (lw_ws) lw_timer_tag (timer);
 
-	for (client_socket = lw_server_client_first (ws->socket);
+	/* A tick may close the client, so get the next one first */
+
+	for (client_socket = lw_server_client_first (server);
 		 client_socket;
-		 client_socket = lw_server_client_next (client_socket))
+		 client_socket = next)
 	{
-	  client = (lwp_ws_client) lw_stream_tag ((lw_stream) client_socket);
+	  next = lw_server_client_next (client_socket);
 
-	  client->tick (client);
+	  if ((client = (lwp_ws_client) lw_stream_tag ((lw_stream) client_socket)))
+		 client->tick (client);
 	}
+}
 
-	for (client_socket = lw_server_client_first (ws->socket_secure);
-		 client_socket;
-		 client_socket = lw_server_client_next (client_socket))
-	{
-	  client = (lwp_ws_client) lw_stream_tag ((lw_stream) client_socket);
+static void on_timer_tick (lw_timer timer)
+{
+	lw_ws ws = (lw_ws) lw_timer_tag (timer);
 
-	  client->tick (client);
-	}
+	/* Closes keep-alive connections that have been idle for too long */
+
+	tick_clients (ws->socket);
+	tick_clients (ws->socket_secure);
 }
 
 lw_ws lw_ws_new (lw_pump pump)
@@ -137,10 +136,18 @@ lw_ws lw_ws_new (lw_pump pump)
 	  return 0;
 
 	lwp_init ();
+	lwp_ws_mimetypes_init ();
 
 	ctx->pump = pump;
 	ctx->auto_finish = lw_true;
-	ctx->timeout = 5;
+	ctx->timeout = 0; /* idle connections are kept until set */
+	ctx->max_keepalive_requests = 100;
+	ctx->compression_min_size = lwp_ws_default_compression_min_size;
+	ctx->max_field_size = lwp_ws_default_max_field_size;
+	ctx->upload_buffer_size = lwp_ws_default_upload_buffer_size;
+	ctx->session_idle_lifetime = 20 * 60;
+
+	lwp_ws_file_cache_init (ctx);
 
 	ctx->timer = lw_timer_new (ctx->pump);
 	lw_timer_set_tag (ctx->timer, ctx);
@@ -184,8 +191,15 @@ void lw_ws_delete (lw_ws ctx)
 	lw_server_delete (ctx->socket);
 	lw_server_delete (ctx->socket_secure);
 
+	/* After the clients, whose uploads still have files to release */
+
+	lwp_ws_autosave_stop (ctx);
+
 	lw_timer_delete (ctx->timer);
 
+	lwp_ws_sessions_clear (ctx);
+	lwp_ws_file_cache_clear (ctx);
+
 	free (ctx);
 }
 
@@ -205,6 +219,8 @@ void lw_ws_host_filter (lw_ws ctx, lw_filter filter)
 	  lw_filter_set_local_port (filter, 80);
 
 	lw_server_host_filter (ctx->socket, filter);
+
+	lwp_ws_sessions_start_sweep (ctx);
 }
 
 void lw_ws_host_secure (lw_ws ctx, long port)
@@ -226,6 +242,8 @@ void lw_ws_host_secure_filter (lw_ws ctx, lw_filter filter)
 	  lw_filter_set_local_port (filter, 443);
 
 	lw_server_host_filter (ctx->socket_secure, filter);
+
+	lwp_ws_sessions_start_sweep (ctx);
 }
 
 void lw_ws_unhost (lw_ws ctx)
@@ -287,10 +305,9 @@ void lw_ws_set_idle_timeout (lw_ws ctx, long seconds)
 	ctx->timeout = seconds;
 
 	if (lw_timer_started (ctx->timer))
-	{
 	  lw_timer_stop (ctx->timer);
-	  start_timer (ctx);
-	}
+
+	start_timer (ctx);
 }
 
 long lw_ws_idle_timeout (lw_ws ctx)
@@ -298,6 +315,34 @@ long lw_ws_idle_timeout (lw_ws ctx)
 	return ctx->timeout;
 }
 
+void lw_ws_set_max_keepalive_requests (lw_ws ctx, long max_requests)
+{
+	ctx->max_keepalive_requests = max_requests;
+}
+
+long lw_ws_max_keepalive_requests (lw_ws ctx)
+{
+	return ctx->max_keepalive_requests;
+}
+
+void lw_ws_set_upload_limits (lw_ws ctx, lw_i64 max_body_size,
+							  lw_i64 max_upload_size, size_t max_field_size)
+{
+	ctx->max_body_size = max_body_size;
+	ctx->max_upload_size = max_upload_size;
+	ctx->max_field_size = max_field_size;
+}
+
+void lw_ws_set_upload_buffer_size (lw_ws ctx, size_t size)
+{
+	ctx->upload_buffer_size = size;
+}
+
+void lw_ws_enable_upload_autosave (lw_ws ctx)
+{
+	ctx->autosave_uploads = lw_true;
+}
+
 void * lw_ws_tag (lw_ws ctx)
 {
 	return ctx->tag;
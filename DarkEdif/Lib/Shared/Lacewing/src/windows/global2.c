@@ -35,6 +35,8 @@ void lwp_init ()
 {
 	WSADATA winsock_data;
 
+	lwp_heapbuffer_init ();
+
 	if (++init_called == 1)
 		return;
 
@@ -85,6 +87,31 @@ lw_i64 lw_last_modified (const char * filename)
 	return (time_t) ((time.QuadPart - 116444736000000000ULL) / 10000000);
 }
 
+lw_bool lwp_file_stat (const char * filename, lw_i64 * last_modified,
+						size_t * size)
+{
+	WIN32_FILE_ATTRIBUTE_DATA info;
+	LARGE_INTEGER value;
+
+	if (!GetFileAttributesExA (filename, GetFileExInfoStandard, &info)
+		  || (info.dwFileAttributes & FILE_ATTRIBUTE_DIRECTORY))
+	{
+	  return lw_false;
+	}
+
+	value.LowPart = info.ftLastWriteTime.dwLowDateTime;
+	value.HighPart = info.ftLastWriteTime.dwHighDateTime;
+
+	*last_modified = (lw_i64) ((value.QuadPart - 116444736000000000ULL) / 10000000);
+
+	value.LowPart = info.nFileSizeLow;
+	value.HighPart = info.nFileSizeHigh;
+
+	*size = (size_t) value.QuadPart;
+
+	return lw_true;
+}
+
 void lw_temp_path (char * buffer)
 {
 	GetTempPathA (lwp_max_path, buffer);
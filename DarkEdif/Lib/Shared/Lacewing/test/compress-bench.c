@@ -0,0 +1,268 @@
+/* Benchmark for on-the-fly response compression (src/webserver/compress.c).
+ *
+ * Runs JSON and HTML bodies of several sizes through the compression deflate_filter
+ * at a few levels, writing each body in 4 KB pieces as a handler would, and
+ * reports the bytes saved and the CPU time per response.  Every configuration
+ * is checked to inflate back to the original body.
+ *
+ * Usage: compress-bench [total MB per configuration, default 64]
+ */
+
+#include "fake.h"
+#include "../src/webserver/common.h"
+#include <zlib.h>
+
+#undef time
+
+void lwp_init ()
+{
+	lwp_heapbuffer_init ();
+}
+
+/* The stream graph is reduced to what the filter needs: it's created with
+ * lwp_stream_init, added upstream of the request, and its output collected.
+ */
+
+static lw_stream deflate_filter = 0;
+static char * output = 0;
+static size_t output_length = 0, output_allocated = 0;
+
+void lwp_stream_init (lw_stream ctx, const lw_streamdef * def, lw_pump pump)
+{
+	ctx->def = def;
+	ctx->pump = pump;
+}
+
+void lw_stream_add_filter_upstream (lw_stream stream, lw_stream upstream,
+												lw_bool delete_with_stream,
+												lw_bool close_together)
+{
+	(void) stream, (void) delete_with_stream, (void) close_together;
+	deflate_filter = upstream;
+}
+
+void lw_stream_data (lw_stream stream, const char * buffer, size_t size)
+{
+	(void) stream;
+
+	if (output_length + size > output_allocated)
+	{
+	  output_allocated = (output_length + size) * 2;
+	  output = (char *) realloc (output, output_allocated);
+	}
+
+	memcpy (output + output_length, buffer, size);
+	output_length += size;
+}
+
+const char * lw_ws_req_header (lw_ws_req request, const char * name)
+{
+	(void) request;
+	return strcasecmp (name, "accept-encoding") ? "" : "gzip, deflate";
+}
+
+void lw_ws_req_set_header (lw_ws_req request, const char * name,
+									const char * value)
+{
+	struct _lw_ws_req_hdr header;
+
+	list_each_elem (request->headers_out, existing)
+	{
+	  if (!strcasecmp (existing->name, name))
+	  {
+		 free (existing->value);
+		 existing->value = strdup (value);
+		 return;
+	  }
+	}
+
+	header.name = strdup (name);
+	header.value = strdup (value);
+	list_push (request->headers_out, header);
+}
+
+static void clear_headers (lw_ws_req request)
+{
+	list_each (request->headers_out, header)
+	{
+	  free (header.name);
+	  free (header.value);
+	}
+
+	list_clear (request->headers_out);
+}
+
+/* Bodies are made of records that vary, so they don't compress unrealistically
+ * well.
+ */
+
+static char * make_body (const char * type, size_t size)
+{
+	char * body = (char *) malloc (size + 256), * at = body;
+	unsigned int seed = 12345, i = 0;
+
+	while ((size_t) (at - body) < size)
+	{
+	  seed = seed * 1103515245 + 12345;
+
+	  if (!strcmp (type, "json"))
+	  {
+		 at += sprintf (at, "{\"id\":%u,\"name\":\"player%u\",\"score\":%u,"
+							 "\"online\":%s,\"room\":\"lobby-%u\"},", i, seed % 9973,
+							 (seed >> 8) % 100000, seed & 1 ? "true" : "false",
+							 (seed >> 16) % 64);
+	  }
+	  else
+	  {
+		 at += sprintf (at, "<tr><td class=\"id\">%u</td><td>player%u</td>"
+							 "<td class=\"score\">%u</td></tr>\n", i, seed % 9973,
+							 (seed >> 8) % 100000);
+	  }
+
+	  ++ i;
+	}
+
+	return body;
+}
+
+static double now_us ()
+{
+	struct timespec ts;
+	clock_gettime (CLOCK_MONOTONIC, &ts);
+	return ts.tv_sec * 1e6 + ts.tv_nsec / 1e3;
+}
+
+/* Sends one response through the deflate_filter, returning the bytes that came out */
+
+static size_t respond (lw_ws_req request, const char * content_type,
+							  const char * body, size_t size)
+{
+	size_t written, piece;
+
+	output_length = 0;
+
+	lwp_ws_req_compress_begin (request);
+	lw_ws_req_set_header (request, "content-type", content_type);
+
+	for (written = 0; written < size; written += piece)
+	{
+	  piece = size - written < 4096 ? size - written : 4096;
+
+	  if (deflate_filter)
+		 deflate_filter->def->sink_data (deflate_filter, body + written, piece);
+	  else
+		 lw_stream_data ((lw_stream) request, body + written, piece);
+	}
+
+	lwp_ws_req_compress_end (request);
+	clear_headers (request);
+
+	return output_length;
+}
+
+static lw_bool inflates_to (const char * body, size_t size)
+{
+	z_stream z;
+	char * inflated = (char *) malloc (size + 1);
+	lw_bool matches;
+	int result;
+
+	memset (&z, 0, sizeof (z));
+	inflateInit2 (&z, 15 + 32);  /* gzip or zlib header */
+
+	z.next_in = (Bytef *) output;
+	z.avail_in = (uInt) output_length;
+	z.next_out = (Bytef *) inflated;
+	z.avail_out = (uInt) size + 1;
+
+	result = inflate (&z, Z_FINISH);
+
+	matches = result == Z_STREAM_END && z.total_out == size
+					&& !memcmp (inflated, body, size);
+
+	inflateEnd (&z);
+	free (inflated);
+
+	return matches;
+}
+
+int main (int argc, char * argv [])
+{
+	static const size_t sizes [] =
+		{ 512, 2048, 8192, 32768, 131072, 524288, 2097152 };
+	static const int levels [] = { 1, 6, 9 };
+	static const char * const types [] = { "json", "html" };
+
+	double total_mb = argc > 1 ? atof (argv [1]) : 64;
+	struct _lw_ws ws_data;
+	lw_ws_req request = (lw_ws_req) calloc (sizeof (*request), 1);
+	int failures = 0;
+	size_t s, l, t;
+
+	lwp_init ();
+
+	memset (&ws_data, 0, sizeof (ws_data));
+	request->ws = &ws_data;
+	strcpy (request->method, "GET");
+
+	ws_data.compression_min_size = lwp_ws_default_compression_min_size;
+
+	printf ("%-5s %9s %5s %10s %7s %10s %8s\n", "type", "size", "level",
+			  "out bytes", "saved", "us/resp", "MB/s");
+
+	for (t = 0; t < sizeof (types) / sizeof (*types); ++ t)
+	{
+	  const char * content_type = t == 0 ? "application/json" : "text/html";
+
+	  for (s = 0; s < sizeof (sizes) / sizeof (*sizes); ++ s)
+	  {
+		 char * body = make_body (types [t], sizes [s]);
+		 long responses = (long) (total_mb * 1024 * 1024 / sizes [s]), i;
+
+		 if (responses < 1)
+			responses = 1;
+
+		 for (l = 0; l < sizeof (levels) / sizeof (*levels); ++ l)
+		 {
+			size_t out = 0;
+			double started, elapsed;
+
+			ws_data.compression_level = levels [l];
+
+			/* Once for the zlib stream to be set up, and to check the output */
+
+			respond (request, content_type, body, sizes [s]);
+
+			if (!inflates_to (body, sizes [s]))
+			{
+				printf ("FAIL: %s %zu bytes at level %d doesn't inflate back\n",
+						  types [t], sizes [s], levels [l]);
+				++ failures;
+			}
+
+			started = now_us ();
+
+			for (i = 0; i < responses; ++ i)
+				out = respond (request, content_type, body, sizes [s]);
+
+			elapsed = now_us () - started;
+
+			printf ("%-5s %9zu %5d %10zu %6.1f%% %10.1f %8.1f\n", types [t],
+					  sizes [s], levels [l], out,
+					  100.0 - 100.0 * out / sizes [s], elapsed / responses,
+					  sizes [s] * (double) responses / elapsed);
+		 }
+
+		 free (body);
+	  }
+	}
+
+	if (deflate_filter)
+	  deflate_filter->def->cleanup (deflate_filter);
+
+	free (deflate_filter);
+	free (request);
+	free (output);
+
+	return failures ? 1 : 0;
+}
@@ -0,0 +1,57 @@
+/* Declarations from http-parser, enough to compile the webserver sources the
+ * harnesses use.  None of the harnesses parse HTTP, so nothing is defined.
+ */
+
+#ifndef http_parser_h
+#define http_parser_h
+
+#include <stddef.h>
+
+typedef struct http_parser http_parser;
+typedef int (*http_data_cb) (http_parser *, const char *, size_t);
+typedef int (*http_cb) (http_parser *);
+
+enum http_parser_type { HTTP_REQUEST, HTTP_RESPONSE, HTTP_BOTH };
+enum http_method { HTTP_GET };
+enum http_errno { HPE_OK, HPE_PAUSED };
+
+struct http_parser
+{
+	unsigned type : 2, flags : 6, state : 8, header_state : 8, index : 8;
+	unsigned nread;
+	long content_length;
+	unsigned short http_major, http_minor;
+	unsigned status_code : 16, method : 8, http_errno : 7, upgrade : 1;
+	void * data;
+};
+
+typedef struct
+{
+	http_cb on_message_begin;
+	http_data_cb on_url;
+	http_data_cb on_header_field;
+	http_data_cb on_header_value;
+	http_cb on_headers_complete;
+	http_data_cb on_body;
+	http_cb on_message_complete;
+
+} http_parser_settings;
+
+enum http_parser_url_fields
+	{ UF_SCHEMA, UF_HOST, UF_PORT, UF_PATH, UF_QUERY, UF_FRAGMENT, UF_MAX };
+
+struct http_parser_url
+{
+	unsigned short field_set, port;
+	struct { unsigned short off, len; } field_data [UF_MAX];
+};
+
+void http_parser_init (http_parser *, enum http_parser_type);
+size_t http_parser_execute (http_parser *, const http_parser_settings *,
+									 const char *, size_t);
+int http_should_keep_alive (const http_parser *);
+const char * http_method_str (enum http_method);
+int http_parser_parse_url (const char *, size_t, int, struct http_parser_url *);
+void http_parser_pause (http_parser *, int);
+
+#endif
@@ -0,0 +1,29 @@
+/* Declarations from multipart-parser-c, enough to compile the webserver
+ * sources the harnesses use.  None of the harnesses parse multipart bodies.
+ */
+
+#ifndef multipart_parser_h
+#define multipart_parser_h
+
+#include <stddef.h>
+
+typedef struct multipart_parser multipart_parser;
+typedef int (*multipart_data_cb) (multipart_parser *, const char *, size_t);
+typedef int (*multipart_notify_cb) (multipart_parser *);
+
+typedef struct
+{
+	multipart_data_cb on_header_field, on_header_value, on_part_data;
+	multipart_notify_cb on_part_data_begin, on_headers_complete,
+							  on_part_data_end, on_body_end;
+
+} multipart_parser_settings;
+
+multipart_parser * multipart_parser_init (const char *,
+														const multipart_parser_settings *);
+void multipart_parser_free (multipart_parser *);
+size_t multipart_parser_execute (multipart_parser *, const char *, size_t);
+void multipart_parser_set_data (multipart_parser *, void *);
+void * multipart_parser_get_data (multipart_parser *);
+
+#endif
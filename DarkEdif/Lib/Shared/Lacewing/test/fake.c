@@ -0,0 +1,272 @@
+/* Stand-ins for the parts of liblacewing the harnesses don't test */
+
+#include "fake.h"
+#include <pthread.h>
+#include <malloc.h>
+
+#undef time
+
+static time_t now = 1000000000;
+
+time_t lwtest_time (time_t * t)
+{
+	if (t)
+	  *t = now;
+
+	return now;
+}
+
+size_t lwtest_heap_in_use ()
+{
+	return mallinfo2 ().uordblks;
+}
+
+struct _lw_sync
+{
+	pthread_mutex_t mutex;
+};
+
+lw_sync lw_sync_new ()
+{
+	lw_sync ctx = (lw_sync) malloc (sizeof (*ctx));
+	pthread_mutex_init (&ctx->mutex, 0);
+	return ctx;
+}
+
+void lw_sync_delete (lw_sync ctx)
+{
+	pthread_mutex_destroy (&ctx->mutex);
+	free (ctx);
+}
+
+void lw_sync_lock (lw_sync ctx)
+{
+	pthread_mutex_lock (&ctx->mutex);
+}
+
+void lw_sync_release (lw_sync ctx)
+{
+	pthread_mutex_unlock (&ctx->mutex);
+}
+
+/* Started until joined, as on Windows.  The Unix lw_thread stops counting as
+ * started once its proc returns, so a join after that doesn't wait for it.
+ */
+
+struct _lw_thread
+{
+	void * proc, * param;
+	pthread_t thread;
+	lw_bool started;
+};
+
+lw_thread lw_thread_new (const char * name, void * proc)
+{
+	lw_thread ctx = (lw_thread) calloc (sizeof (*ctx), 1);
+	(void) name;
+	ctx->proc = proc;
+	return ctx;
+}
+
+void lw_thread_delete (lw_thread ctx)
+{
+	lw_thread_join (ctx);
+	free (ctx);
+}
+
+static void * thread_proc (void * ctx)
+{
+	lw_thread thread = (lw_thread) ctx;
+	return (void *) (size_t) ((int (*) (void *)) thread->proc) (thread->param);
+}
+
+void lw_thread_start (lw_thread ctx, void * param)
+{
+	ctx->param = param;
+	ctx->started = pthread_create (&ctx->thread, 0, thread_proc, ctx) == 0;
+}
+
+lw_bool lw_thread_started (lw_thread ctx)
+{
+	return ctx->started;
+}
+
+void * lw_thread_join (lw_thread ctx)
+{
+	void * exit_code = (void *) -1;
+
+	if (ctx->started)
+	  pthread_join (ctx->thread, &exit_code);
+
+	ctx->started = lw_false;
+
+	return exit_code;
+}
+
+/* The Unix lw_event is a pipe, which clashes with lacewing::pipe in C++ */
+
+struct _lw_event
+{
+	pthread_mutex_t mutex;
+	pthread_cond_t cond;
+	lw_bool signalled;
+};
+
+lw_event lw_event_new ()
+{
+	lw_event ctx = (lw_event) calloc (sizeof (*ctx), 1);
+	pthread_mutex_init (&ctx->mutex, 0);
+	pthread_cond_init (&ctx->cond, 0);
+	return ctx;
+}
+
+void lw_event_delete (lw_event ctx)
+{
+	pthread_cond_destroy (&ctx->cond);
+	pthread_mutex_destroy (&ctx->mutex);
+	free (ctx);
+}
+
+void lw_event_signal (lw_event ctx)
+{
+	pthread_mutex_lock (&ctx->mutex);
+	ctx->signalled = lw_true;
+	pthread_cond_broadcast (&ctx->cond);
+	pthread_mutex_unlock (&ctx->mutex);
+}
+
+void lw_event_unsignal (lw_event ctx)
+{
+	pthread_mutex_lock (&ctx->mutex);
+	ctx->signalled = lw_false;
+	pthread_mutex_unlock (&ctx->mutex);
+}
+
+lw_bool lw_event_wait (lw_event ctx, long milliseconds)
+{
+	lw_bool signalled;
+	(void) milliseconds;
+
+	/* Only waiting forever is needed so far */
+
+	pthread_mutex_lock (&ctx->mutex);
+
+	while (!ctx->signalled)
+	  pthread_cond_wait (&ctx->cond, &ctx->mutex);
+
+	signalled = ctx->signalled;
+	pthread_mutex_unlock (&ctx->mutex);
+
+	return signalled;
+}
+
+/* Timers are kept in a list and ticked by lwtest_advance */
+
+struct _lw_timer
+{
+	void * tag;
+	lw_timer_hook_tick on_tick;
+
+	lw_bool started;
+	long interval;		/* milliseconds */
+	long long due;		/* milliseconds on the simulated clock */
+
+	lw_timer next;
+};
+
+static lw_timer timers = 0;
+
+lw_timer lw_timer_new (lw_pump pump)
+{
+	lw_timer ctx = (lw_timer) calloc (sizeof (*ctx), 1);
+	(void) pump;
+
+	ctx->next = timers;
+	timers = ctx;
+
+	return ctx;
+}
+
+void lw_timer_delete (lw_timer ctx)
+{
+	lw_timer * link = &timers;
+
+	while (*link != ctx)
+	  link = &(*link)->next;
+
+	*link = ctx->next;
+	free (ctx);
+}
+
+void lw_timer_start (lw_timer ctx, long milliseconds)
+{
+	ctx->started = lw_true;
+	ctx->interval = milliseconds;
+	ctx->due = now * 1000LL + milliseconds;
+}
+
+lw_bool lw_timer_started (lw_timer ctx)
+{
+	return ctx->started;
+}
+
+void lw_timer_stop (lw_timer ctx)
+{
+	ctx->started = lw_false;
+}
+
+void lw_timer_force_tick (lw_timer ctx)
+{
+	if (ctx->on_tick)
+	  ctx->on_tick (ctx);
+}
+
+void * lw_timer_tag (lw_timer ctx)
+{
+	return ctx->tag;
+}
+
+void lw_timer_set_tag (lw_timer ctx, void * tag)
+{
+	ctx->tag = tag;
+}
+
+void lw_timer_on_tick (lw_timer ctx, lw_timer_hook_tick on_tick)
+{
+	ctx->on_tick = on_tick;
+}
+
+void lwtest_advance (long seconds)
+{
+	lw_timer timer, next;
+
+	now += seconds;
+
+	for (timer = timers; timer; timer = next)
+	{
+	  next = timer->next;
+
+	  while (timer->started && timer->due <= now * 1000LL)
+	  {
+		 timer->due += timer->interval;
+		 lw_timer_force_tick (timer);
+	  }
+	}
+}
+
+lw_bool lw_random (char * buffer, size_t size)
+{
+	static unsigned long long state = 88172645463325252ULL;
+	size_t i;
+
+	for (i = 0; i < size; ++ i)
+	{
+	  state ^= state << 13;
+	  state ^= state >> 7;
+	  state ^= state << 17;
+
+	  buffer [i] = (char) state;
+	}
+
+	return lw_true;
+}
@@ -0,0 +1,23 @@
+/* Stand-ins for the parts of liblacewing the harnesses don't test: a timer
+ * that ticks off a simulated clock rather than the pump, and lw_sync,
+ * lw_thread and lw_event on pthreads.  Include before the sources being tested, so that their calls to
+ * time () read the simulated clock.
+ */
+
+#ifndef lwtest_fake_h
+#define lwtest_fake_h
+
+#include "../src/common.h"
+
+/* Seconds since the epoch, as far as the code under test can tell */
+time_t lwtest_time (time_t *);
+
+/* Moves the simulated clock on, ticking any started timers that come due */
+void lwtest_advance (long seconds);
+
+/* Bytes the process has allocated from the heap and not freed */
+size_t lwtest_heap_in_use ();
+
+#define time lwtest_time
+
+#endif
@@ -0,0 +1,132 @@
+/* Test for the heap buffer pool and pump buffer statistics (src/heapbuffer.c).
+ *
+ * lwp_init is never called here, as in a program using only an event pump
+ * with an fdstream, so the pool's lock has to be created on first use.  Four
+ * threads start filling and freeing buffers at once with pooling off, then
+ * with it on, checking each pump's statistics add up; then pooled buffers are
+ * checked to be reused, kept under the limit, and dropped when the limit is
+ * lowered.  "make check-tsan" runs it with ThreadSanitizer.
+ *
+ * Usage: heapbuffer-pool
+ */
+
+#include "fake.h"
+#include "../src/pump.h"
+
+#include <pthread.h>
+
+void lwp_init ()
+{
+}
+
+static int failures = 0;
+
+static void check (lw_bool passed, const char * what)
+{
+	printf ("%s: %s\n", passed ? "pass" : "FAIL", what);
+
+	if (!passed)
+	  ++ failures;
+}
+
+#define threads 4
+#define rounds 20000
+
+static struct _lw_pump pumps [threads];
+static pthread_barrier_t start;
+
+/* Fills and frees a buffer of a few sizes, as a stream queueing writes does */
+
+static void * fill_and_free (void * param)
+{
+	lw_pump pump = (lw_pump) param;
+	char data [3000] = { 0 };
+	lwp_heapbuffer buffer = 0;
+	int i;
+
+	pthread_barrier_wait (&start);
+
+	for (i = 0; i < rounds; ++ i)
+	{
+	  lwp_heapbuffer_add_ex (&buffer, pump, data, 100 + i % 7 * 400);
+	  lwp_heapbuffer_add_ex (&buffer, pump, data, sizeof (data));
+	  lwp_heapbuffer_free (&buffer);
+	}
+
+	return 0;
+}
+
+/* Runs fill_and_free on every pump at once, and checks their statistics */
+
+static lw_bool run_threads ()
+{
+	pthread_t thread [threads];
+	lw_pump_buffer_stats stats;
+	lw_bool balanced = lw_true;
+	int i;
+
+	pthread_barrier_init (&start, 0, threads);
+
+	for (i = 0; i < threads; ++ i)
+	{
+	  lw_pump_reset_buffer_stats (&pumps [i]);
+	  pthread_create (&thread [i], 0, fill_and_free, &pumps [i]);
+	}
+
+	for (i = 0; i < threads; ++ i)
+	{
+	  pthread_join (thread [i], 0);
+	  lw_pump_get_buffer_stats (&pumps [i], &stats);
+
+	  balanced = balanced && stats.bytes_held == 0 && stats.peak_bytes_held > 0
+						&& stats.allocations + stats.pool_hits == rounds
+						&& stats.releases == rounds;
+	}
+
+	pthread_barrier_destroy (&start);
+
+	return balanced;
+}
+
+int main ()
+{
+	lw_pump_buffer_stats stats;
+	lwp_heapbuffer buffer = 0;
+	char data [1000] = { 0 };
+
+	check (run_threads (), "pooling off, without lwp_init: every thread's statistics add up");
+
+	lw_pump_get_buffer_stats (&pumps [0], &stats);
+	check (stats.pool_hits == 0 && lw_heapbuffer_pool_size () == 0, "pooling off: nothing is pooled");
+
+	lw_heapbuffer_set_pool_limit (256 * 1024);
+	check (run_threads (), "pooling on: every thread's statistics add up");
+
+	lw_pump_get_buffer_stats (&pumps [0], &stats);
+	printf ("  %lu of %d buffers came from the pool on the first thread\n",
+				(unsigned long) stats.pool_hits, rounds);
+	check (stats.pool_hits > 0, "pooling on: freed buffers are reused");
+	check (lw_heapbuffer_pool_size () > 0 && lw_heapbuffer_pool_size () <= 256 * 1024,
+				"pooling on: the pool stays under its limit");
+
+	lwp_heapbuffer_add_ex (&buffer, &pumps [0], data, sizeof (data));
+	lwp_heapbuffer_free (&buffer);
+	lw_pump_reset_buffer_stats (&pumps [0]);
+	lwp_heapbuffer_add_ex (&buffer, &pumps [0], data, sizeof (data));
+	lwp_heapbuffer_free (&buffer);
+	lw_pump_get_buffer_stats (&pumps [0], &stats);
+	check (stats.pool_hits == 1 && stats.allocations == 0, "a buffer freed to the pool is taken again");
+
+	lw_heapbuffer_set_pool_limit (0);
+	check (lw_heapbuffer_pool_size () == 0, "turning pooling off empties the pool");
+
+	lw_pump_reset_buffer_stats (&pumps [0]);
+	lwp_heapbuffer_add_ex (&buffer, &pumps [0], data, sizeof (data));
+	lwp_heapbuffer_free (&buffer);
+	lw_pump_get_buffer_stats (&pumps [0], &stats);
+	check (stats.pool_hits == 0 && stats.allocations == 1 && lw_heapbuffer_pool_size () == 0,
+				"with pooling off again, buffers are allocated and freed");
+
+	printf (failures ? "%d failed\n" : "all passed\n", failures);
+	return failures ? 1 : 0;
+}
@@ -0,0 +1,393 @@
+/* Load test for the webserver's HTTP/1.1 keep-alive and pipelining.
+ *
+ * Makes GET requests to a running server from several connections at once,
+ * in three modes: a new connection for every request, keep-alive with one
+ * request at a time, and keep-alive with requests pipelined in batches.  For
+ * each mode it reports requests per second and the latency distribution,
+ * and fails if any response is missing or isn't 200.
+ *
+ * Usage: http-load [-c connections] [-n requests per connection]
+ *						[-p pipeline depth] host port [path]
+ *
+ * Latency in pipelined mode is from sending a batch to each response of it
+ * arriving, so includes the time spent queued behind earlier requests.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <strings.h>
+#include <unistd.h>
+#include <pthread.h>
+#include <time.h>
+#include <netdb.h>
+#include <sys/socket.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+
+typedef enum { mode_close, mode_keepalive, mode_pipeline } load_mode;
+
+static const char * host, * port, * path = "/";
+static int connections = 8, requests = 2000, depth = 8;
+static load_mode mode;
+static struct addrinfo * address;
+
+typedef struct
+{
+	double * latencies;	/* microseconds, one per request */
+	int completed;
+	const char * error;
+
+	pthread_t thread;
+
+} worker;
+
+static double now_us ()
+{
+	struct timespec ts;
+	clock_gettime (CLOCK_MONOTONIC, &ts);
+	return ts.tv_sec * 1e6 + ts.tv_nsec / 1e3;
+}
+
+static int connect_to_server ()
+{
+	int fd = socket (address->ai_family, SOCK_STREAM, 0), on = 1;
+
+	if (fd == -1)
+	  return -1;
+
+	setsockopt (fd, IPPROTO_TCP, TCP_NODELAY, &on, sizeof (on));
+
+	if (connect (fd, address->ai_addr, address->ai_addrlen) == -1)
+	{
+	  close (fd);
+	  return -1;
+	}
+
+	return fd;
+}
+
+static int send_all (int fd, const char * buffer, size_t size)
+{
+	while (size > 0)
+	{
+	  ssize_t sent = send (fd, buffer, size, MSG_NOSIGNAL);
+
+	  if (sent <= 0)
+		 return 0;
+
+	  buffer += sent;
+	  size -= sent;
+	}
+
+	return 1;
+}
+
+/* Responses are read through a per-connection buffer, as a pipelined batch
+ * can arrive in one read.
+ */
+
+typedef struct
+{
+	int fd;
+	char data [65536];
+	size_t start, end;
+
+} reader;
+
+static int fill (reader * r)
+{
+	ssize_t got;
+
+	if (r->start > 0)
+	{
+	  memmove (r->data, r->data + r->start, r->end - r->start);
+	  r->end -= r->start;
+	  r->start = 0;
+	}
+
+	if (r->end == sizeof (r->data))
+	  return 0;
+
+	if ((got = recv (r->fd, r->data + r->end, sizeof (r->data) - r->end, 0)) <= 0)
+	  return 0;
+
+	r->end += got;
+	return 1;
+}
+
+/* Reads one response, returning its status, or 0 on error.  The body is
+ * skipped; it must have a Content-Length, or end with the connection.
+ */
+
+static int read_response (reader * r, int * closes)
+{
+	char * headers, * end, * line;
+	long long remaining = -1;
+	int status;
+
+	for (;;)
+	{
+	  headers = r->data + r->start;
+
+	  if ((end = (char *) memmem (headers, r->end - r->start, "\r\n\r\n", 4)))
+		 break;
+
+	  if (!fill (r))
+		 return 0;
+	}
+
+	*end = 0;
+
+	if (sscanf (headers, "HTTP/1.%*d %d", &status) != 1)
+	  return 0;
+
+	*closes = 0;
+
+	for (line = strstr (headers, "\r\n"); line; line = strstr (line + 2, "\r\n"))
+	{
+	  if (!strncasecmp (line + 2, "Content-Length:", 15))
+		 remaining = atoll (line + 17);
+	  else if (!strncasecmp (line + 2, "Connection: close", 17))
+		 *closes = 1;
+	}
+
+	r->start = end + 4 - r->data;
+
+	if (remaining == -1)
+	{
+	  /* Delimited by the connection closing */
+
+	  while (fill (r))
+		 r->start = r->end;
+
+	  r->start = r->end;
+	  *closes = 1;
+
+	  return status;
+	}
+
+	while (remaining > 0)
+	{
+	  size_t available = r->end - r->start;
+
+	  if (available == 0)
+	  {
+		 if (!fill (r))
+			return 0;
+
+		 continue;
+	  }
+
+	  if ((long long) available > remaining)
+		 available = (size_t) remaining;
+
+	  r->start += available;
+	  remaining -= available;
+	}
+
+	return status;
+}
+
+static void * run_worker (void * param)
+{
+	worker * w = (worker *) param;
+	char request [1024];
+	int request_length, batch, i, status, closes = 0;
+	double sent;
+	reader * r = (reader *) calloc (sizeof (*r), 1);
+
+	request_length = snprintf (request, sizeof (request),
+		"GET %s HTTP/1.1\r\nHost: %s\r\n%s\r\n", path, host,
+		mode == mode_close ? "Connection: close\r\n" : "");
+
+	r->fd = -1;
+
+	while (w->completed < requests)
+	{
+	  if (r->fd == -1 || closes)
+	  {
+		 if (r->fd != -1)
+			close (r->fd);
+
+		 r->start = r->end = 0;
+
+		 if ((r->fd = connect_to_server ()) == -1)
+		 {
+			w->error = "couldn't connect";
+			break;
+		 }
+	  }
+
+	  batch = mode == mode_pipeline ? depth : 1;
+
+	  if (batch > requests - w->completed)
+		 batch = requests - w->completed;
+
+	  sent = now_us ();
+
+	  for (i = 0; i < batch; ++ i)
+	  {
+		 if (!send_all (r->fd, request, request_length))
+			break;
+	  }
+
+	  if (i < batch)
+	  {
+		 w->error = "connection closed while sending";
+		 break;
+	  }
+
+	  for (i = 0; i < batch; ++ i)
+	  {
+		 if (! (status = read_response (r, &closes)))
+		 {
+			w->error = "connection closed before a response";
+			break;
+		 }
+
+		 if (status != 200)
+		 {
+			w->error = "response status wasn't 200";
+			break;
+		 }
+
+		 w->latencies [w->completed ++] = now_us () - sent;
+
+		 /* The server may end a pipelined batch early, when a connection
+		  * reaches its request limit; the rest is sent again.
+		  */
+
+		 if (closes)
+			break;
+	  }
+
+	  if (w->error)
+		 break;
+
+	  if (mode == mode_close)
+		 closes = 1;
+	}
+
+	if (r->fd != -1)
+	  close (r->fd);
+
+	free (r);
+	return 0;
+}
+
+static int compare (const void * a, const void * b)
+{
+	double x = *(const double *) a, y = *(const double *) b;
+	return x < y ? -1 : x > y;
+}
+
+static int run (load_mode run_mode, const char * name)
+{
+	worker * workers = (worker *) calloc (sizeof (*workers), connections);
+	double * all, started, elapsed;
+	int i, total = 0, failed = 0;
+
+	mode = run_mode;
+
+	for (i = 0; i < connections; ++ i)
+	  workers [i].latencies = (double *) malloc (sizeof (double) * requests);
+
+	started = now_us ();
+
+	for (i = 0; i < connections; ++ i)
+	  pthread_create (&workers [i].thread, 0, run_worker, &workers [i]);
+
+	for (i = 0; i < connections; ++ i)
+	  pthread_join (workers [i].thread, 0);
+
+	elapsed = (now_us () - started) / 1e6;
+
+	all = (double *) malloc (sizeof (double) * requests * connections);
+
+	for (i = 0; i < connections; ++ i)
+	{
+	  memcpy (all + total, workers [i].latencies,
+				sizeof (double) * workers [i].completed);
+
+	  total += workers [i].completed;
+
+	  if (workers [i].error)
+	  {
+		 fprintf (stderr, "%s: connection %d: %s after %d requests\n",
+					 name, i, workers [i].error, workers [i].completed);
+		 failed = 1;
+	  }
+
+	  free (workers [i].latencies);
+	}
+
+	qsort (all, total, sizeof (double), compare);
+
+	if (total > 0)
+	{
+	  printf ("%-22s %8d %10.0f %9.0f %9.0f %9.0f %9.0f\n", name, total,
+				 total / elapsed, all [total / 2], all [total * 9 / 10],
+				 all [total * 99 / 100], all [total - 1]);
+	}
+
+	free (all);
+	free (workers);
+
+	return !failed;
+}
+
+int main (int argc, char * argv [])
+{
+	struct addrinfo hints = { 0 };
+	char name [64];
+	int option, passed = 1;
+
+	while ((option = getopt (argc, argv, "c:n:p:")) != -1)
+	{
+	  switch (option)
+	  {
+		 case 'c': connections = atoi (optarg); break;
+		 case 'n': requests = atoi (optarg); break;
+		 case 'p': depth = atoi (optarg); break;
+		 default: return 2;
+	  }
+	}
+
+	if (argc - optind < 2 || connections < 1 || requests < 1 || depth < 1)
+	{
+	  fprintf (stderr, "usage: http-load [-c connections] [-n requests per "
+						"connection] [-p pipeline depth] host port [path]\n");
+	  return 2;
+	}
+
+	host = argv [optind];
+	port = argv [optind + 1];
+
+	if (argc - optind > 2)
+	  path = argv [optind + 2];
+
+	hints.ai_socktype = SOCK_STREAM;
+
+	if (getaddrinfo (host, port, &hints, &address))
+	{
+	  fprintf (stderr, "couldn't resolve %s\n", host);
+	  return 2;
+	}
+
+	printf ("%d connections x %d requests, GET %s\n\n", connections,
+			  requests, path);
+
+	printf ("%-22s %8s %10s %9s %9s %9s %9s\n", "mode", "requests", "req/s",
+			  "p50 us", "p90 us", "p99 us", "max us");
+
+	passed &= run (mode_close, "no keep-alive");
+	passed &= run (mode_keepalive, "keep-alive");
+
+	snprintf (name, sizeof (name), "pipelined x%d", depth);
+	passed &= run (mode_pipeline, name);
+
+	freeaddrinfo (address);
+
+	return passed ? 0 : 1;
+}
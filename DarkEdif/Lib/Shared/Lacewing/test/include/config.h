@@ -0,0 +1,14 @@
+/* Configuration for building parts of liblacewing on Linux for the harnesses
+ * in this directory.  The real build gets this from configure.
+ */
+
+#define HAVE_MALLOC_H 1
+#define HAVE_NETDB_H 1
+#define HAVE_SYS_PRCTL_H 1
+#define HAVE_DECL_PR_SET_NAME 1
+#define HAVE_SYS_SENDFILE_H 1
+#define HAVE_SYS_TIMERFD_H 1
+#define HAVE_TIMEGM 1
+#define HAVE_DECL_SO_NOSIGPIPE 0
+#define ENABLE_THREADS 1
+#define _lacewing_static 1
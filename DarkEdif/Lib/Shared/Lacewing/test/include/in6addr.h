@@ -0,0 +1 @@
+/* Windows-only header lacewing.h includes; the Linux headers declare in6_addr */
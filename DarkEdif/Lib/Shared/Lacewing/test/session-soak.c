@@ -0,0 +1,180 @@
+/* Soak test for the webserver session store (src/webserver/sessions.c).
+ *
+ * Simulates a crawler making millions of requests that never send the session
+ * cookie back, so every hit creates a session, and checks that the session
+ * count and heap stay flat under the idle lifetime and under the session cap.
+ * Then checks that sessions only ever resumed, never created, still expire.
+ *
+ * Usage: session-soak [hits, default 2000000]
+ */
+
+#include "fake.h"
+#include "../src/webserver/common.h"
+
+#undef time
+
+static char client_cookie [lwp_session_id_length * 2 + 1];
+static char resumed_ids [100][lwp_session_id_length * 2 + 1];
+static lw_bool hosting = lw_false;
+
+const char * lw_ws_req_get_cookie (lw_ws_req request, const char * name)
+{
+	(void) request, (void) name;
+	return client_cookie;
+}
+
+void lw_ws_req_set_cookie (lw_ws_req request, const char * name,
+									const char * value)
+{
+	(void) request, (void) name;
+	strcpy (client_cookie, value);
+}
+
+lw_bool lw_ws_hosting (lw_ws ws)
+{
+	(void) ws;
+	return hosting;
+}
+
+lw_bool lw_ws_hosting_secure (lw_ws ws)
+{
+	(void) ws;
+	return lw_false;
+}
+
+static int failures = 0;
+
+static void check (lw_bool passed, const char * what)
+{
+	printf ("%s: %s\n", passed ? "pass" : "FAIL", what);
+
+	if (!passed)
+	  ++ failures;
+}
+
+/* One request from a client that doesn't keep cookies */
+
+static void sessionless_hit (lw_ws_req request)
+{
+	*client_cookie = 0;
+	lw_ws_req_session_write (request, "visited", "1");
+}
+
+/* Runs the hits at 1000 a second, returning the highest session count seen.
+ * The heap in use is sampled a quarter of the way in, once the store should
+ * have reached its steady state, and at the end.
+ */
+
+static size_t run_hits (lw_ws_req request, long hits,
+								size_t * heap_early, size_t * heap_late)
+{
+	size_t peak = 0;
+	long i;
+
+	for (i = 0; i < hits; ++ i)
+	{
+	  sessionless_hit (request);
+
+	  if (lw_ws_session_count (request->ws) > peak)
+		 peak = lw_ws_session_count (request->ws);
+
+	  if ((i + 1) % 1000 == 0)
+		 lwtest_advance (1);
+
+	  if (i == hits / 4)
+		 *heap_early = lwtest_heap_in_use ();
+	}
+
+	*heap_late = lwtest_heap_in_use ();
+
+	return peak;
+}
+
+int main (int argc, char * argv [])
+{
+	long hits = argc > 1 ? atol (argv [1]) : 2000000;
+	lw_ws ws = (lw_ws) calloc (sizeof (*ws), 1);
+	lw_ws_req request = (lw_ws_req) calloc (sizeof (*request), 1);
+	size_t peak, heap_early, heap_late;
+	char message [256];
+	int i, resumed;
+
+	request->ws = ws;
+
+	/* Sessions idle for a minute expire; at 1000 hits a second, the store
+	 * should level off at 60000 sessions plus up to a sweep interval's worth.
+	 */
+
+	hosting = lw_true;
+	lw_ws_set_session_idle_lifetime (ws, 60);
+
+	peak = run_hits (request, hits, &heap_early, &heap_late);
+
+	sprintf (message, "idle lifetime: %ld hits, peak %zu sessions, "
+				"heap %zu KB at 1/4, %zu KB at end", hits, peak,
+				heap_early / 1024, heap_late / 1024);
+
+	check (peak <= (60 + lwp_session_sweep_interval / 1000) * 1000, message);
+	check (heap_late <= heap_early + heap_early / 10,
+			 "idle lifetime: heap stays flat");
+
+	lwp_ws_sessions_clear (ws);
+
+	/* With no lifetimes, the cap alone bounds the store */
+
+	lw_ws_set_session_idle_lifetime (ws, 0);
+	lw_ws_set_max_sessions (ws, 10000);
+
+	peak = run_hits (request, hits, &heap_early, &heap_late);
+
+	sprintf (message, "session cap: %ld hits, peak %zu sessions, "
+				"heap %zu KB at 1/4, %zu KB at end", hits, peak,
+				heap_early / 1024, heap_late / 1024);
+
+	check (peak == 10000, message);
+	check (heap_late <= heap_early + heap_early / 10,
+			 "session cap: heap stays flat");
+
+	lwp_ws_sessions_clear (ws);
+	lw_ws_set_max_sessions (ws, 0);
+
+	/* Sessions created while no lifetime was set, and then only ever resumed,
+	 * must still expire once one is set.
+	 */
+
+	for (i = 0; i < 100; ++ i)
+	{
+	  sessionless_hit (request);
+	  strcpy (resumed_ids [i], client_cookie);
+	}
+
+	lw_ws_set_session_idle_lifetime (ws, 60);
+
+	/* Half the clients come back every 10 seconds for 5 minutes */
+
+	for (i = 0; i < 30; ++ i)
+	{
+	  for (resumed = 0; resumed < 50; ++ resumed)
+	  {
+		 strcpy (client_cookie, resumed_ids [resumed]);
+		 lw_ws_req_session_read (request, "visited");
+	  }
+
+	  lwtest_advance (10);
+	}
+
+	check (lw_ws_session_count (ws) == 50,
+			 "resumed sessions are kept, the rest expire");
+
+	lwtest_advance (60 + lwp_session_sweep_interval / 1000);
+
+	check (lw_ws_session_count (ws) == 0,
+			 "sessions expire once no longer resumed");
+
+	lwp_ws_sessions_clear (ws);
+
+	free (request);
+	free (ws);
+
+	return failures ? 1 : 0;
+}
@@ -0,0 +1,348 @@
+/* Test for autosaved uploads (src/webserver/upload.c).
+ *
+ * Feeds uploads through the autosave path the way the multipart parser does,
+ * with the writer thread running for real, and checks that the files come out
+ * whole, that the pump side doesn't wait for a slow disk, and that a file that
+ * can't be written, or a disk that falls too far behind, is reported rather
+ * than the upload quietly going unsaved.
+ *
+ * Usage: upload-autosave [MB per upload, default 16]
+ */
+
+#include "fake.h"
+#include "../src/webserver/common.h"
+
+#include <sys/stat.h>
+#include <sys/time.h>
+#include <unistd.h>
+
+#undef time
+
+static char temp_path [lwp_max_path];
+
+void lw_temp_path (char * buffer)
+{
+	strcpy (buffer, temp_path);
+}
+
+/* The build wraps fwrite with this, so the test can slow the disk down */
+
+static long write_delay_us = 0;
+
+static void set_write_delay (long us)
+{
+	__atomic_store_n (&write_delay_us, us, __ATOMIC_RELAXED);
+}
+
+extern "C" size_t __real_fwrite (const void *, size_t, size_t, FILE *);
+
+extern "C" size_t __wrap_fwrite (const void * buffer, size_t size,
+										size_t count, FILE * file)
+{
+	long delay = __atomic_load_n (&write_delay_us, __ATOMIC_RELAXED);
+
+	if (delay)
+	  usleep (delay);
+
+	return __real_fwrite (buffer, size, count, file);
+}
+
+/* Posts from the writer thread are run by run_posts () on the main thread */
+
+struct post
+{
+	void (* proc) (void *);
+	void * param;
+};
+
+static pthread_mutex_t posts_lock = PTHREAD_MUTEX_INITIALIZER;
+static list (struct post, posts);
+
+void lw_pump_post (lw_pump pump, void * proc, void * param)
+{
+	struct post post = { (void (*) (void *)) proc, param };
+	(void) pump;
+
+	pthread_mutex_lock (&posts_lock);
+	list_push (posts, post);
+	pthread_mutex_unlock (&posts_lock);
+}
+
+static void run_posts ()
+{
+	for (;;)
+	{
+	  pthread_mutex_lock (&posts_lock);
+
+	  if (!list_length (posts))
+	  {
+		 pthread_mutex_unlock (&posts_lock);
+		 return;
+	  }
+
+	  struct post post = list_front (posts);
+	  list_pop_front (posts);
+
+	  pthread_mutex_unlock (&posts_lock);
+
+	  post.proc (post.param);
+	}
+}
+
+/* What the multipart parser would be told */
+
+static int saves, failed_saves;
+
+void lwp_ws_multipart_saved (lwp_ws_multipart ctx, lw_bool success)
+{
+	(void) ctx;
+
+	if (success)
+	  ++ saves;
+	else
+	  ++ failed_saves;
+}
+
+static int failures = 0;
+
+static void check (lw_bool passed, const char * what)
+{
+	printf ("%s: %s\n", passed ? "pass" : "FAIL", what);
+
+	if (!passed)
+	  ++ failures;
+}
+
+static double now_ms ()
+{
+	struct timeval tv;
+	gettimeofday (&tv, 0);
+
+	return tv.tv_sec * 1000.0 + tv.tv_usec / 1000.0;
+}
+
+static void wait_for (int * counter, int target)
+{
+	double give_up = now_ms () + 60000;
+
+	while (*counter < target && now_ms () < give_up)
+	{
+	  run_posts ();
+	  usleep (1000);
+	}
+}
+
+static char pattern (size_t offset)
+{
+	return (char) ((offset * 31) ^ (offset >> 11));
+}
+
+/* Writes size bytes in chunks of the sizes a socket hands over, returning the
+ * first error and the longest a write kept the pump waiting
+ */
+
+static long upload (lw_ws_upload upload, size_t size, double * slowest_ms)
+{
+	static const size_t chunk_sizes [] = { 1460, 4096, 65536, 300, 200000 };
+	char chunk [200000];
+	size_t offset = 0;
+	int n = 0;
+
+	*slowest_ms = 0;
+
+	while (offset < size)
+	{
+	  size_t length = chunk_sizes [n ++ % 5];
+
+	  if (length > size - offset)
+		 length = size - offset;
+
+	  for (size_t i = 0; i < length; ++ i)
+		 chunk [i] = pattern (offset + i);
+
+	  double start = now_ms ();
+	  long error = lwp_ws_upload_write (upload, chunk, length);
+	  double taken = now_ms () - start;
+
+	  if (taken > *slowest_ms)
+		 *slowest_ms = taken;
+
+	  if (error)
+		 return error;
+
+	  offset += length;
+	}
+
+	return 0;
+}
+
+static lw_bool file_matches (const char * filename, size_t size)
+{
+	FILE * file = fopen (filename, "rb");
+	size_t offset = 0;
+	char buffer [65536];
+	size_t got;
+
+	if (!file)
+	  return lw_false;
+
+	while ((got = fread (buffer, 1, sizeof (buffer), file)) > 0)
+	{
+	  for (size_t i = 0; i < got; ++ i)
+	  {
+		 if (buffer [i] != pattern (offset + i))
+		 {
+			fclose (file);
+			return lw_false;
+		 }
+	  }
+
+	  offset += got;
+	}
+
+	fclose (file);
+
+	return offset == size;
+}
+
+static lw_bool exists (const char * filename)
+{
+	struct stat st;
+	return stat (filename, &st) == 0;
+}
+
+int main (int argc, char * argv [])
+{
+	size_t size = (argc > 1 ? atol (argv [1]) : 16) * 1024 * 1024;
+	double slowest;
+	char filename [lwp_max_path];
+
+	strcpy (temp_path, "/tmp/lw-autosave-XXXXXX");
+
+	if (!mkdtemp (temp_path))
+	{
+	  printf ("Couldn't make a temporary directory\n");
+	  return 1;
+	}
+
+	strcat (temp_path, "/");
+
+	lw_ws ws = (lw_ws) calloc (sizeof (*ws), 1);
+	ws->upload_buffer_size = lwp_ws_default_upload_buffer_size;
+
+	struct _lwp_ws_client client = {};
+	client.ws = ws;
+	client.multipart = (lwp_ws_multipart) calloc (sizeof (struct _lwp_ws_multipart), 1);
+
+	struct _lw_ws_req request = {};
+	request.ws = ws;
+	request.client = &client;
+
+	/* A whole upload, at the speed of the disk */
+
+	lw_ws_upload a = lwp_ws_upload_new (&request);
+	lw_ws_upload_set_autosave (a);
+	strcpy (filename, lw_ws_upload_autosave_fname (a));
+
+	double start = now_ms ();
+	long error = upload (a, size, &slowest);
+	double queued = now_ms () - start;
+
+	check (!error && !lwp_ws_upload_close (a), "upload queued and closed");
+
+	wait_for (&saves, 1);
+	double taken = now_ms () - start;
+
+	check (saves == 1 && !failed_saves, "writer reported the file saved");
+	check (file_matches (filename, size), "file has the uploaded data");
+
+	printf ("  %lu MB: queued in %.1f ms, saved in %.1f ms (%.0f MB/s), "
+			"slowest write %.3f ms\n", (unsigned long) (size >> 20), queued,
+			taken, (size / 1048576.0) / (taken / 1000.0), slowest);
+
+	lwp_ws_upload_delete (a, lw_false);
+	run_posts ();
+	check (exists (filename), "file kept once handed over");
+	remove (filename);
+
+	/* The same upload to a disk taking 10 ms a write: the pump side only
+	 * copies into buffers, so mustn't wait on it
+	 */
+
+	set_write_delay (10000);
+
+	lw_ws_upload b = lwp_ws_upload_new (&request);
+	lw_ws_upload_set_autosave (b);
+	strcpy (filename, lw_ws_upload_autosave_fname (b));
+
+	error = upload (b, size, &slowest);
+
+	check (!error && !lwp_ws_upload_close (b), "slow disk: upload queued");
+	check (slowest < 5.0, "slow disk: no write held the pump for 5 ms");
+
+	printf ("  slowest write %.3f ms against 10 ms a write on the disk\n", slowest);
+
+	wait_for (&saves, 2);
+	check (saves == 2 && file_matches (filename, size), "slow disk: file saved");
+
+	lwp_ws_upload_delete (b, lw_true);
+	run_posts ();
+
+	set_write_delay (0);
+
+	/* A disk that falls too far behind gets a 503 rather than unbounded
+	 * memory.  Halfway through, the upload is abandoned, so its partial
+	 * file is removed.
+	 */
+
+	set_write_delay (100000);
+
+	lw_ws_upload c = lwp_ws_upload_new (&request);
+	lw_ws_upload_set_autosave (c);
+	strcpy (filename, lw_ws_upload_autosave_fname (c));
+
+	error = upload (c, lwp_ws_autosave_max_queued * 2, &slowest);
+
+	check (error == 503, "stuck disk: refused with 503 once too far behind");
+
+	set_write_delay (0);
+
+	lwp_ws_upload_delete (c, lw_false);
+	lwp_ws_autosave_stop (ws);
+	run_posts ();
+
+	check (!exists (filename), "abandoned upload's partial file removed");
+	check (ws->autosave_queued == 0, "nothing left queued after stopping");
+
+	/* A file that can't be opened is reported, where the upload used to
+	 * quietly become a manual one
+	 */
+
+	strcat (temp_path, "missing/");
+
+	lw_ws_upload d = lwp_ws_upload_new (&request);
+	lw_ws_upload_set_autosave (d);
+
+	error = upload (d, 4 * ws->upload_buffer_size, &slowest);
+
+	if (!error)
+	  error = lwp_ws_upload_close (d);
+
+	wait_for (&failed_saves, error ? 0 : 1);
+
+	check (error == 500 || failed_saves == 1, "unwritable file: reported as 500");
+
+	lwp_ws_upload_delete (d, lw_true);
+	lwp_ws_autosave_stop (ws);
+	run_posts ();
+
+	temp_path [strlen (temp_path) - strlen ("missing/")] = 0;
+	rmdir (temp_path);
+
+	free (client.multipart);
+	free (ws);
+
+	printf (failures ? "%d failed\n" : "all passed\n", failures);
+
+	return failures ? 1 : 0;
+}
@@ -85,6 +85,105 @@ static void * json_alloc (json_state * state, unsigned long size, int zero)
 	return state->settings.mem_alloc (size, zero, state->settings.user_data);
 }
 
+unsigned int json_hash (const json_char * name)
+{
+	unsigned int hash = json_hash_offset;
+
+	for (; *name; ++ name)
+	  hash = (hash ^ (unsigned char) *name) * json_hash_prime;
+
+	return hash;
+}
+
+/* The index is an open-addressed table of (hash, member + 1) pairs, at least
+ * twice the member count so probes stay short. It is built as soon as the
+ * object is complete, when parsing or loading a compiled image, so lookups
+ * only ever read it and a parsed value can be shared between threads. It is
+ * allocated with calloc rather than the parse settings' allocator, as compiled
+ * images have no settings.
+ */
+static unsigned int index_size (unsigned int length)
+{
+	unsigned int size = 16;
+
+	while (size < length * 2)
+	  size <<= 1;
+
+	return size;
+}
+
+/* Leaves objects too small to be worth it, or that there's no memory to index,
+ * to be searched linearly
+ */
+static void build_index (json_value * object)
+{
+	unsigned int i, slot, mask;
+	unsigned int * index;
+
+	if (object->u.object.length < json_index_min_length)
+	  return;
+
+	mask = index_size (object->u.object.length) - 1;
+
+	if (! (index = (unsigned int *) calloc (mask + 1, sizeof (unsigned int) * 2)) )
+	  return;
+
+	/* Insert in reverse, so that on duplicate names the first member wins, as
+	 * with a linear search
+	 */
+	for (i = object->u.object.length; i > 0; -- i)
+	{
+	  unsigned int hash = json_hash (object->u.object.values [i - 1].name);
+
+	  for (slot = hash & mask; index [slot * 2 + 1]; slot = (slot + 1) & mask)
+	  {
+		 if (index [slot * 2] == hash
+			  && !strcmp (object->u.object.values [index [slot * 2 + 1] - 1].name,
+							  object->u.object.values [i - 1].name))
+		 {
+			break;
+		 }
+	  }
+
+	  index [slot * 2] = hash;
+	  index [slot * 2 + 1] = i;
+	}
+
+	object->_index = index;
+}
+
+const json_value * json_object_find (const json_value * object,
+									 const json_char * name,
+									 unsigned int hash)
+{
+	unsigned int i, slot, mask;
+
+	if (object->type != json_object)
+	  return 0;
+
+	if (!object->_index)
+	{
+	  for (i = 0; i < object->u.object.length; ++ i)
+		 if (!strcmp (object->u.object.values [i].name, name))
+			return object->u.object.values [i].value;
+
+	  return 0;
+	}
+
+	mask = index_size (object->u.object.length) - 1;
+
+	for (slot = hash & mask; (i = object->_index [slot * 2 + 1]) != 0; slot = (slot + 1) & mask)
+	{
+	  if (object->_index [slot * 2] == hash
+			&& !strcmp (object->u.object.values [i - 1].name, name))
+	  {
+		 return object->u.object.values [i - 1].value;
+	  }
+	}
+
+	return 0;
+}
+
 static int new_value
 	(json_state * state, json_value ** top, json_value ** root, json_value ** alloc, json_type type)
 {
@@ -702,6 +801,9 @@ json_value * json_parse_ex (json_settings * settings,
 			{
 				flags = (flags & ~ flag_next) | flag_need_comma;
 
+				if (!state.first_pass && top->type == json_object)
+					build_index (top);
+
 				if (!top->parent)
 				{
 					/* root value done */
@@ -791,6 +893,230 @@ json_value * json_parse (const json_char * json, size_t length)
 	return json_parse_ex (&settings, json, length, 0, 0);
 }
 
+/* A loaded compiled image is one allocation: the value count, then the values
+ * (the root first), the object members, the array elements and the strings.
+ * Its root is marked by pointing _reserved.next_alloc at itself, which the
+ * parser never does.
+ */
+#define compiled_values_offset ((sizeof (unsigned int) + 15) & ~15)
+
+static int is_compiled_root (const json_value * value)
+{
+	return value->_reserved.next_alloc == value;
+}
+
+static void free_compiled (json_value * root)
+{
+	char * base = ((char *) root) - compiled_values_offset;
+	unsigned int i, count = *(unsigned int *) base;
+
+	/* Indexes are allocated outside the image */
+	for (i = 0; i < count; ++ i)
+	  free (root [i]._index);
+
+	free (base);
+}
+
+/* Makes values [child] a child of values [parent]. Children come after their
+ * parents and belong to one parent, so the records can only describe a tree.
+ */
+static int adopt (json_value * values, unsigned int count,
+						unsigned int parent, unsigned int child)
+{
+	if (child <= parent || child >= count || values [child].parent)
+	  return 0;
+
+	values [child].parent = &values [parent];
+	return 1;
+}
+
+json_value * json_load_compiled (const void * image, size_t size,
+											char * error_buf, size_t error_buf_len)
+{
+	json_compiled_header header;
+	const json_compiled_value * records, * record;
+	const json_compiled_member * members;
+	const unsigned int * elements;
+	size_t members_at, elements_at, strings_at;
+	json_value * values, * value, ** element_values;
+	decltype (values->u.object.values) member_values;
+	unsigned int i, j, first, adopted = 0;
+	json_int_t bits;
+	char * base, * strings;
+
+	if (size < sizeof (header)
+		 || (memcpy (&header, image, sizeof (header)), header.magic != json_compiled_magic)
+		 || header.version != json_compiled_version)
+	{
+	  if (error_buf)
+		 strcpy_s (error_buf, error_buf_len, "Not a compiled JSON image, or an unsupported version");
+
+	  return 0;
+	}
+
+	/* Each part must fit in what's left of the image, with the string table
+	 * taking the rest, ending in a terminator. Loaded, the image takes at most
+	 * a few times its size, so refuse anything that could overflow that.
+	 */
+	records = (const json_compiled_value *) (((const char *) image) + sizeof (header));
+
+	if (header.size != size || size > ((size_t) -1) / 4 || header.value_count == 0
+		 || header.value_count > (size - sizeof (header)) / sizeof (*records))
+	{
+	  goto e_corrupt;
+	}
+
+	members_at = sizeof (header) + header.value_count * sizeof (*records);
+
+	if (header.member_count > (size - members_at) / sizeof (*members))
+	  goto e_corrupt;
+
+	elements_at = members_at + header.member_count * sizeof (*members);
+
+	if (header.element_count > (size - elements_at) / sizeof (*elements))
+	  goto e_corrupt;
+
+	strings_at = elements_at + header.element_count * sizeof (*elements);
+
+	if (header.strings_size != size - strings_at || header.strings_size == 0
+		 || ((const char *) image) [size - 1] != 0)
+	{
+	  goto e_corrupt;
+	}
+
+	members = (const json_compiled_member *) (((const char *) image) + members_at);
+	elements = (const unsigned int *) (((const char *) image) + elements_at);
+
+	if (! (base = (char *) calloc (1, compiled_values_offset
+				+ header.value_count * sizeof (json_value)
+				+ header.member_count * sizeof (*member_values)
+				+ header.element_count * sizeof (*element_values)
+				+ header.strings_size)) )
+	{
+	  if (error_buf)
+		 strcpy_s (error_buf, error_buf_len, "Memory allocation failure");
+
+	  return 0;
+	}
+
+	*(unsigned int *) base = header.value_count;
+	values = (json_value *) (base + compiled_values_offset);
+	member_values = (decltype (member_values)) (values + header.value_count);
+	element_values = (json_value **) (member_values + header.member_count);
+	strings = (char *) (element_values + header.element_count);
+
+	memcpy (strings, ((const char *) image) + strings_at, header.strings_size);
+
+	for (i = 0; i < header.value_count; ++ i)
+	{
+	  record = &records [i];
+	  value = &values [i];
+	  first = record->data [0];
+
+	  value->type = (json_type) record->type;
+
+	  switch (record->type)
+	  {
+		 case json_object:
+
+			if (first > header.member_count || record->length > header.member_count - first)
+				goto e_free;
+
+			value->u.object.length = record->length;
+			value->u.object.values = member_values + first;
+
+			for (j = 0; j < record->length; ++ j)
+			{
+				if (members [first + j].name >= header.strings_size
+					 || !adopt (values, header.value_count, i, members [first + j].value))
+				{
+					goto e_free;
+				}
+
+				value->u.object.values [j].name = strings + members [first + j].name;
+				value->u.object.values [j].value = &values [members [first + j].value];
+			}
+
+			adopted += record->length;
+			build_index (value);
+			break;
+
+		 case json_array:
+
+			if (first > header.element_count || record->length > header.element_count - first)
+				goto e_free;
+
+			value->u.array.length = record->length;
+			value->u.array.values = element_values + first;
+
+			for (j = 0; j < record->length; ++ j)
+			{
+				if (!adopt (values, header.value_count, i, elements [first + j]))
+					goto e_free;
+
+				value->u.array.values [j] = &values [elements [first + j]];
+			}
+
+			adopted += record->length;
+			break;
+
+		 case json_string:
+
+			if (first >= header.strings_size || record->length >= header.strings_size - first
+				 || strings [first + record->length] != 0)
+			{
+				goto e_free;
+			}
+
+			value->u.string.length = record->length;
+			value->u.string.ptr = strings + first;
+			break;
+
+		 case json_integer:
+		 case json_double:
+
+			bits = (json_int_t) ((((unsigned long long) record->data [1]) << 32) | record->data [0]);
+
+			if (record->type == json_integer)
+				value->u.integer = bits;
+			else
+				memcpy (&value->u.dbl, &bits, sizeof (value->u.dbl));
+
+			break;
+
+		 case json_boolean:
+
+			value->u.boolean = record->data [0] != 0;
+			break;
+
+		 case json_null:
+			break;
+
+		 default:
+			goto e_free;
+	  };
+	}
+
+	/* Every value but the root belongs to something */
+	if (adopted != header.value_count - 1)
+	  goto e_free;
+
+	values->_reserved.next_alloc = values;
+
+	return values;
+
+e_free:
+
+	free_compiled (values);
+
+e_corrupt:
+
+	if (error_buf)
+	  strcpy_s (error_buf, error_buf_len, "Compiled JSON image is corrupt");
+
+	return 0;
+}
+
 void json_value_free_ex (json_settings * settings, json_value * value)
 {
 	json_value * cur_value;
@@ -798,6 +1124,12 @@ void json_value_free_ex (json_settings * settings, json_value * value)
 	if (!value)
 	  return;
 
+	if (is_compiled_root (value))
+	{
+	  free_compiled (value);
+	  return;
+	}
+
 	value->parent = 0;
 
 	while (value)
@@ -820,6 +1152,7 @@ void json_value_free_ex (json_settings * settings, json_value * value)
 			if (!value->u.object.length)
 			{
 				settings->mem_free (value->u.object.values, settings->user_data);
+				free (value->_index);
 				break;
 			}
 
@@ -0,0 +1,270 @@
+// Benchmark for the per-call overhead of A/C/E dispatch in Edif.cpp.
+//
+// The SDK's dispatch needs the Fusion runtime, so this mirrors the two versions of the
+// parameter-gathering step of ActionOrCondition() against the real JSON parser:
+//
+//  before: fetch the ACEInfo, then look up CurLang["Actions"/"Conditions"][ID]["NumAutoProps"]
+//          in the JSON to find how many parameters to read, on every call
+//  after:  index the ACEDescriptor built once in the Edif::SDK constructor
+//
+// Both then read the parameters through the same stand-ins for the CNC_XX runtime calls, which
+// are cheap here, so the difference is what dispatch costs on top of the real runtime calls.
+//
+// Usage: ace-bench [calls, default 20000000]
+
+#include "json.h"
+
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <string>
+#include <vector>
+
+// Mirrors of the SDK types, without the Windows headers they live with
+enum class Params : short { Expression = 1, String_Expression = 2, Object = 3, Filename = 4 };
+
+struct ACEInfo
+{
+	short FloatFlags, ID;
+	short Flags;
+	short NumOfParams;
+	Params Parameter[16];
+};
+
+struct ACEDescriptor
+{
+	short NumParams;
+	short FloatFlags;
+	short Returns;
+	Params Parameter[16];
+};
+
+// Stand-ins for CNC_GetIntParameter() etc.; out of line, as the runtime's are
+static std::intptr_t paramCounter;
+__attribute__((noinline)) static std::intptr_t GetIntParameter() { return ++paramCounter; }
+__attribute__((noinline)) static std::intptr_t GetFloatParameter() { return paramCounter += 2; }
+__attribute__((noinline)) static std::intptr_t GetStringParameter() { return (std::intptr_t)"text"; }
+__attribute__((noinline)) static std::intptr_t GetParameter() { return ++paramCounter; }
+
+static std::intptr_t sink;
+
+// The function called with the parameters; the thunk is the same in both versions
+__attribute__((noinline)) static void CallFunction(const std::intptr_t * Params, int Count)
+{
+	for (int i = 0; i < Count; ++i)
+		sink += Params[i];
+}
+
+static const char * TypeNames[] = { "Number", "Text", "Object", "Filename" };
+
+// An extension's JSON, shaped as DarkEdif expects: the About object, then the languages. Runtime
+// builds only take JSON as the pre-build tool minifies it, headed by a timestamp comment.
+static std::string MakeJSON(int NumActions, int NumConditions)
+{
+	std::string Out = "//1700000000\n{ \"About\": { \"Name\": \"Bench\" }, \"English\": {\n"
+		"\"About\": { \"Name\": \"Bench\", \"Author\": \"Someone\" },\n";
+
+	const auto Section = [&](const char * Name, int Count, const char * Prefix)
+	{
+		Out += std::string("\"") + Name + "\": [\n";
+		for (int i = 0; i < Count; ++i)
+		{
+			char Buffer[256];
+			snprintf(Buffer, sizeof(Buffer), "{ \"Title\": \"%s number %d\", \"Triggered\": false, "
+				"\"Parameters\": [", Prefix, i);
+			Out += Buffer;
+
+			for (int j = 0; j < i % 5; ++j)
+			{
+				snprintf(Buffer, sizeof(Buffer), "%s[ \"%s\", \"Parameter %d\" ]", j ? ", " : "",
+					TypeNames[(i + j) % 4], j);
+				Out += Buffer;
+			}
+			Out += " ]";
+
+			// A few ACEs read their last parameters themselves
+			if (i % 7 == 6)
+				Out += ", \"NumAutoProps\": 1";
+
+			Out += i + 1 < Count ? " },\n" : " }\n";
+		}
+		Out += "],\n";
+	};
+
+	Section("Actions", NumActions, "Do thing");
+	Section("Conditions", NumConditions, "Is thing");
+
+	Out += "\"Expressions\": [], \"Properties\": [] } }";
+	return Out;
+}
+
+static ACEInfo * MakeInfo(const json_value &ACE)
+{
+	ACEInfo * Info = new ACEInfo();
+	const json_value &Parameters = ACE["Parameters"];
+
+	Info->NumOfParams = (short)Parameters.u.array.length;
+	for (int i = 0; i < Info->NumOfParams; ++i)
+	{
+		const char * Type = Parameters[i][0];
+		Info->Parameter[i] = !strcmp(Type, "Text") ? Params::String_Expression :
+			!strcmp(Type, "Object") ? Params::Object :
+			!strcmp(Type, "Filename") ? Params::Filename : Params::Expression;
+		if (!strcmp(Type, "Number") && i % 2)
+			Info->FloatFlags |= 1 << i;
+	}
+	return Info;
+}
+
+// As MakeDescriptor() in Edif.cpp
+static ACEDescriptor MakeDescriptor(const ACEInfo * Info, const json_value &JSON)
+{
+	ACEDescriptor Desc = {};
+
+	Desc.NumParams = Info->NumOfParams;
+	Desc.FloatFlags = Info->FloatFlags;
+
+	const json_value &numAutoProps = JSON["NumAutoProps"];
+	if (numAutoProps.type == json_integer && numAutoProps.u.integer >= 0 && numAutoProps.u.integer < Desc.NumParams)
+		Desc.NumParams = (short)numAutoProps.u.integer;
+
+	for (int i = 0; i < Info->NumOfParams; ++i)
+		Desc.Parameter[i] = Info->Parameter[i];
+
+	return Desc;
+}
+
+static void ReadParameters(std::intptr_t * Parameters, int Count, const Params * Types, short FloatFlags)
+{
+	for (int i = 0; i < Count; ++i)
+	{
+		switch (Types[i])
+		{
+			case Params::Expression:
+				Parameters[i] = (FloatFlags & (1 << i)) ? GetFloatParameter() : GetIntParameter();
+				break;
+			case Params::String_Expression:
+			case Params::Filename:
+				Parameters[i] = GetStringParameter();
+				break;
+			default:
+				Parameters[i] = GetParameter();
+				break;
+		}
+	}
+}
+
+struct SDK
+{
+	json_value * json;
+	std::vector<ACEInfo *> ActionInfos, ConditionInfos;
+	std::vector<void *> ActionFunctions, ConditionFunctions;
+	std::vector<ACEDescriptor> ActionDescriptors, ConditionDescriptors;
+};
+
+static SDK * TheSDK;
+
+#define CurLang (*TheSDK->json->u.object.values[TheSDK->json->u.object.length - 1].value)
+
+// The call path before: ActionOrCondition(Function, ID, ...)
+__attribute__((noinline)) static void CallBefore(void * Function, int ID)
+{
+	bool Condition = (TheSDK->ConditionFunctions.size() >= (unsigned int)ID + 1) && (TheSDK->ConditionFunctions[ID] == Function);
+
+	const ACEInfo * Info = Condition ? TheSDK->ConditionInfos[ID] : TheSDK->ActionInfos[ID];
+	int ParameterCount = Info->NumOfParams;
+
+	const json_value &numAutoProps = CurLang[Condition ? "Conditions" : "Actions"][ID]["NumAutoProps"];
+	if (numAutoProps.type == json_integer)
+		ParameterCount = (int)numAutoProps.u.integer;
+
+	std::intptr_t * Parameters = (std::intptr_t *)alloca(sizeof(std::intptr_t) * ParameterCount);
+	ReadParameters(Parameters, ParameterCount, Info->Parameter, Info->FloatFlags);
+	CallFunction(Parameters, ParameterCount);
+}
+
+// The call path after: ActionOrCondition(Function, Descriptors[ID], ...)
+__attribute__((noinline)) static void CallAfter(const ACEDescriptor &Desc)
+{
+	std::intptr_t Parameters[sizeof(Desc.Parameter) / sizeof(*Desc.Parameter)] = {};
+	ReadParameters(Parameters, Desc.NumParams, Desc.Parameter, Desc.FloatFlags);
+	CallFunction(Parameters, Desc.NumParams);
+}
+
+template<class Func>
+static double NanosecondsPerCall(long Calls, Func &&Call)
+{
+	const auto Start = std::chrono::steady_clock::now();
+	for (long i = 0; i < Calls; ++i)
+		Call(i);
+	const std::chrono::duration<double, std::nano> Taken = std::chrono::steady_clock::now() - Start;
+	return Taken.count() / Calls;
+}
+
+int main(int argc, char ** argv)
+{
+	const long Calls = argc > 1 ? atol(argv[1]) : 20000000;
+	const int NumActions = 60, NumConditions = 30;
+
+	const std::string Text = MakeJSON(NumActions, NumConditions);
+	char Error[256];
+	json_settings Settings = {};
+
+	SDK TheSDKData;
+	TheSDK = &TheSDKData;
+	if (!(TheSDK->json = json_parse_ex(&Settings, Text.c_str(), Text.size(), Error, sizeof(Error))))
+	{
+		printf("JSON error: %s\n", Error);
+		return 1;
+	}
+
+	const json_value &Actions = CurLang["Actions"], &Conditions = CurLang["Conditions"];
+	for (int i = 0; i < NumActions; ++i)
+	{
+		TheSDK->ActionInfos.push_back(MakeInfo(Actions[i]));
+		TheSDK->ActionFunctions.push_back((void *)(std::intptr_t)(0x1000 + i));
+		TheSDK->ActionDescriptors.push_back(MakeDescriptor(TheSDK->ActionInfos[i], Actions[i]));
+	}
+	for (int i = 0; i < NumConditions; ++i)
+	{
+		TheSDK->ConditionInfos.push_back(MakeInfo(Conditions[i]));
+		TheSDK->ConditionFunctions.push_back((void *)(std::intptr_t)(0x2000 + i));
+		TheSDK->ConditionDescriptors.push_back(MakeDescriptor(TheSDK->ConditionInfos[i], Conditions[i]));
+	}
+
+	// Events call ACEs all over the table, so step through it rather than repeating one
+	const auto ID = [&](long i, int Count) { return (int)((i * 7) % Count); };
+
+	printf("%ld calls over %d actions and %d conditions\n", Calls, NumActions, NumConditions);
+
+	const double ActBefore = NanosecondsPerCall(Calls, [&](long i) {
+		const int n = ID(i, NumActions); CallBefore(TheSDK->ActionFunctions[n], n); });
+	const double ActAfter = NanosecondsPerCall(Calls, [&](long i) {
+		CallAfter(TheSDK->ActionDescriptors[ID(i, NumActions)]); });
+	const double CndBefore = NanosecondsPerCall(Calls, [&](long i) {
+		const int n = ID(i, NumConditions); CallBefore(TheSDK->ConditionFunctions[n], n); });
+	const double CndAfter = NanosecondsPerCall(Calls, [&](long i) {
+		CallAfter(TheSDK->ConditionDescriptors[ID(i, NumConditions)]); });
+
+	// Only what's spent besides reading the parameters and calling the function
+	const double Floor = NanosecondsPerCall(Calls, [&](long i) {
+		const ACEDescriptor &Desc = TheSDK->ActionDescriptors[ID(i, NumActions)];
+		std::intptr_t Parameters[16];
+		ReadParameters(Parameters, Desc.NumParams, Desc.Parameter, Desc.FloatFlags);
+		CallFunction(Parameters, Desc.NumParams); });
+
+	printf("%-12s %10s %10s\n", "", "before", "after");
+	printf("%-12s %8.1f ns %7.1f ns\n", "action", ActBefore, ActAfter);
+	printf("%-12s %8.1f ns %7.1f ns\n", "condition", CndBefore, CndAfter);
+	printf("reading parameters and calling alone: %.1f ns\n", Floor);
+	printf("dispatch overhead per action: %.1f ns before, %.1f ns after\n",
+		ActBefore - Floor, ActAfter - Floor);
+
+	json_value_free(TheSDK->json);
+	for (ACEInfo * Info : TheSDK->ActionInfos)
+		delete Info;
+	for (ACEInfo * Info : TheSDK->ConditionInfos)
+		delete Info;
+	return (int)(sink & 0);
+}
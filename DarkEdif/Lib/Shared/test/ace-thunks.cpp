@@ -0,0 +1,167 @@
+// Test for the A/C/E trampolines in Inc/Shared/ACEThunk.h, against a fake runtime.
+//
+// An extension's functions are linked the way the Link macros do it, then called the way
+// ActionOrCondition() and Expression() in Edif.cpp do: parameters are read from the runtime as
+// int-sized values (floats as their bits), gathered into an array, and handed to the thunk. The checks are that each C++ parameter type gets what the runtime gave,
+// and that results come back as Fusion expects them.
+//
+// Then times calling through the thunks against calling the member function pointers with every
+// parameter as an int, chosen by parameter count, which is what the x86 __asm used to do. The
+// __asm itself can't run on x64, so that's the nearest portable equivalent.
+//
+// Usage: ace-thunks [calls to time, default 20000000]
+
+#include "ACEThunk.h"
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <vector>
+
+class Extension
+{
+public:
+	std::string Log;
+	int Total = 0;
+
+	void NoParams() { Log += "NoParams;"; }
+	void IntParams(int a, int b, int c) { Log += "Int " + std::to_string(a) + " " + std::to_string(b) + " " + std::to_string(c) + ";"; }
+	void FloatParam(float f, int i) { char buf[64]; snprintf(buf, sizeof(buf), "Float %g %d;", f, i); Log += buf; }
+	void TextParam(const char * Text, int Length) { Log += std::string("Text ") + Text + " " + std::to_string(Length) + ";"; }
+	void ConstAction(int a) const { const_cast<Extension *>(this)->Log += "Const " + std::to_string(a) + ";"; }
+
+	bool IsPositive(int a) { return a > 0; }
+	bool IsEqual(float a, float b) const { return a == b; }
+
+	int Add(int a, int b) { return a + b; }
+	unsigned int Unsigned(unsigned int a) { return a * 2; }
+	float Half(float a) { return a / 2; }
+	const char * Echo(const char * Text) { return Text; }
+
+	int Many(int a, int b, int c, int d, int e, int f, int g, int h, int i, int j)
+		{ return a + b * 2 + c * 3 + d * 4 + e * 5 + f * 6 + g * 7 + h * 8 + i * 9 + j * 10; }
+
+	// Simple enough to time the call rather than the work
+	int Sum2(int a, int b) { return Total += a + b; }
+	int Sum4(int a, int b, int c, int d) { return Total += a + b + c + d; }
+};
+
+static std::intptr_t FloatBits(float f)
+{
+	std::int32_t Bits;
+	memcpy(&Bits, &f, sizeof(Bits));
+	return Bits;
+}
+
+static float BitsFloat(std::intptr_t Bits)
+{
+	const std::int32_t Bits32 = (std::int32_t)Bits;
+	float f;
+	memcpy(&f, &Bits32, sizeof(f));
+	return f;
+}
+
+// As ActionOrCondition(): the event's parameters, as the runtime's CNC_GetIntParameter() etc.
+// return them, go into an array sized for the most an A/C/E can have, then to the thunk
+static std::intptr_t Call(Edif::ACEFunction Function, Extension * Ext, const std::vector<std::intptr_t> &RuntimeParams)
+{
+	std::intptr_t Parameters[16] = {};
+
+	for (size_t i = 0; i < RuntimeParams.size(); ++i)
+		Parameters[i] = RuntimeParams[i];
+
+	return Function(Ext, Parameters);
+}
+
+static int failures = 0;
+
+static void check(bool passed, const char * what)
+{
+	printf("%s: %s\n", passed ? "pass" : "FAIL", what);
+
+	if (!passed)
+		++failures;
+}
+
+// As the Link macros
+#define Link(Function) &Edif::ACEThunk<&Extension::Function>::Call
+
+template<class Func>
+static double NanosecondsPerCall(long Calls, Func &&Call)
+{
+	const auto Start = std::chrono::steady_clock::now();
+	for (long i = 0; i < Calls; ++i)
+		Call(i);
+	const std::chrono::duration<double, std::nano> Taken = std::chrono::steady_clock::now() - Start;
+	return Taken.count() / Calls;
+}
+
+// The old dispatch's equivalent: every parameter passed as an int, the count picking the call
+typedef void (Extension::*AnyFunction)();
+
+__attribute__((noinline)) static std::intptr_t CallByCount(AnyFunction Function, Extension * Ext, const std::intptr_t * P, int Count)
+{
+	switch (Count)
+	{
+		case 2: return (Ext->*(int (Extension::*)(int, int))Function)((int)P[0], (int)P[1]);
+		case 4: return (Ext->*(int (Extension::*)(int, int, int, int))Function)((int)P[0], (int)P[1], (int)P[2], (int)P[3]);
+		default: return 0;
+	}
+}
+
+__attribute__((noinline)) static std::intptr_t CallThunk(Edif::ACEFunction Function, Extension * Ext, const std::intptr_t * P)
+{
+	return Function(Ext, P);
+}
+
+int main(int argc, char ** argv)
+{
+	const long Calls = argc > 1 ? atol(argv[1]) : 20000000;
+	Extension Ext;
+
+	// Actions
+	Call(Link(NoParams), &Ext, {});
+	Call(Link(IntParams), &Ext, { 1, -2, 2147483647 });
+	Call(Link(FloatParam), &Ext, { FloatBits(2.5f), 7 });
+	Call(Link(TextParam), &Ext, { (std::intptr_t)"hello", 5 });
+	Call(Link(ConstAction), &Ext, { 42 });
+
+	check(Ext.Log == "NoParams;Int 1 -2 2147483647;Float 2.5 7;Text hello 5;Const 42;",
+		"actions get each parameter as its C++ type");
+
+	// Conditions
+	check(Call(Link(IsPositive), &Ext, { 5 }) == 1 && Call(Link(IsPositive), &Ext, { -5 }) == 0,
+		"bool results are 1 or 0");
+	check(Call(Link(IsEqual), &Ext, { FloatBits(0.1f), FloatBits(0.1f) }) == 1,
+		"float parameters of a const condition");
+
+	// Expressions
+	check(Call(Link(Add), &Ext, { 40, 2 }) == 42, "int result");
+	check(Call(Link(Add), &Ext, { -40, 2 }) == -38, "negative int result");
+	check((unsigned int)Call(Link(Unsigned), &Ext, { 0x40000000 }) == 0x80000000u, "unsigned result");
+	check(BitsFloat(Call(Link(Half), &Ext, { FloatBits(5.0f) })) == 2.5f, "float result comes back as its bits");
+
+	const char * Text = "text";
+	check((const char *)Call(Link(Echo), &Ext, { (std::intptr_t)Text }) == Text, "string result is the same pointer");
+
+	check(Call(Link(Many), &Ext, { 1, 1, 1, 1, 1, 1, 1, 1, 1, 1 }) == 55 &&
+		Call(Link(Many), &Ext, { 0, 0, 0, 0, 0, 0, 0, 0, 0, 1 }) == 10,
+		"ten parameters land in order");
+
+	// Timing; not checked, as it depends on the machine
+	const std::intptr_t Params[4] = { 1, 2, 3, 4 };
+	const AnyFunction Sum2 = (AnyFunction)&Extension::Sum2, Sum4 = (AnyFunction)&Extension::Sum4;
+
+	const double ByCount2 = NanosecondsPerCall(Calls, [&](long) { CallByCount(Sum2, &Ext, Params, 2); });
+	const double Thunk2 = NanosecondsPerCall(Calls, [&](long) { CallThunk(Link(Sum2), &Ext, Params); });
+	const double ByCount4 = NanosecondsPerCall(Calls, [&](long) { CallByCount(Sum4, &Ext, Params, 4); });
+	const double Thunk4 = NanosecondsPerCall(Calls, [&](long) { CallThunk(Link(Sum4), &Ext, Params); });
+
+	printf("  %ld calls: 2 parameters %.2f ns by count, %.2f ns thunk; 4 parameters %.2f ns by count, %.2f ns thunk\n",
+		Calls, ByCount2, Thunk2, ByCount4, Thunk4);
+
+	printf(failures ? "%d failed\n" : "all passed\n", failures);
+	return failures ? 1 : 0;
+}
@@ -0,0 +1,28 @@
+// Stand-ins for the MSVC CRT functions the portable SDK sources use, so they
+// build with GCC on Linux. Force-included by the Makefile.
+
+#ifndef DARKEDIF_TEST_COMPAT_H
+#define DARKEDIF_TEST_COMPAT_H
+
+#include <stdio.h>
+#include <string.h>
+#include <strings.h>
+
+#define _stricmp strcasecmp
+#define _strnicmp strncasecmp
+
+inline int strcpy_s(char * Dest, size_t Size, const char * Source)
+{
+	snprintf(Dest, Size, "%s", Source);
+	return 0;
+}
+
+#ifdef __cplusplus
+template<size_t Size, class... Args>
+inline int sprintf_s(char (&Buffer)[Size], const char * Format, Args... args)
+{
+	return snprintf(Buffer, Size, Format, args...);
+}
+#endif
+
+#endif
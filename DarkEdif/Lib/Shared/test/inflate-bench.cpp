@@ -0,0 +1,260 @@
+// Benchmark for Bluewing Client's Decompress received binary (RecvMsg_DecompressBinary in Actions.cpp).
+//
+// The extension needs the Fusion runtime and Lacewing, so this mirrors the two versions of its
+// inflate step against the system zlib:
+//
+//  before: allocate the size the sender claims in the message's 4-byte precursor, inflate into it
+//          in one call, then copy it into the message
+//  after:  inflate straight into the message's new content in chunks, starting at 1MB at most and
+//          doubling as it fills, never past the claimed size, then move it into the message
+//
+// Each is timed on messages of several sizes, in MB/s of decompressed data, with the peak memory
+// held by one call through operator new, not counting zlib's own 40KB or so. Then both are given a
+// message claiming 200MB that holds only 64KB, as a careless or hostile sender could send.
+//
+// Usage: inflate-bench [MB to decompress for each size, default 256]
+
+#include <zlib.h>
+
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <memory>
+#include <new>
+#include <random>
+#include <string>
+
+// Bytes held through operator new, and the most held since Peak was last reset
+static size_t Held, Peak;
+
+void * operator new(size_t Size)
+{
+	// Each block starts with its size, so delete knows how much it gives back
+	size_t * Block = (size_t *)malloc(Size + 16);
+	if (!Block)
+		throw std::bad_alloc();
+	*Block = Size;
+	Held += Size;
+	Peak = std::max(Peak, Held);
+	return (char *)Block + 16;
+}
+
+void operator delete(void * Memory) noexcept
+{
+	if (!Memory)
+		return;
+	size_t * Block = (size_t *)((char *)Memory - 16);
+	Held -= *Block;
+	free(Block);
+}
+
+void operator delete(void * Memory, size_t) noexcept
+{
+	operator delete(Memory);
+}
+
+static uint32_t ClaimedSize(const std::string &Message)
+{
+	uint32_t Size;
+	memcpy(&Size, Message.data(), sizeof(Size));
+	return Size;
+}
+
+// Before: the claimed size up front, then copied into the message
+static bool InflateBefore(const std::string &Message, std::string &Content)
+{
+	const uint32_t Expected = ClaimedSize(Message);
+	z_stream strm = {};
+	if (inflateInit(&strm) != Z_OK)
+		return false;
+
+	std::unique_ptr<unsigned char[]> Output;
+	try {
+		Output = std::make_unique<unsigned char[]>(Expected);
+	}
+	catch (std::bad_alloc)
+	{
+		inflateEnd(&strm);
+		return false;
+	}
+
+	strm.next_in = (unsigned char *)Message.data() + sizeof(uint32_t);
+	strm.avail_in = (uInt)(Message.size() - sizeof(uint32_t));
+	strm.avail_out = Expected;
+	strm.next_out = Output.get();
+	const int ret = inflate(&strm, Z_FINISH);
+	inflateEnd(&strm);
+	if (ret < Z_OK)
+		return false;
+
+	Content.assign((char *)Output.get(), Expected);
+	return true;
+}
+
+// After: in chunks, growing up to one byte past the claimed size, then moved into the message
+static bool InflateAfter(const std::string &Message, std::string &Content)
+{
+	const uint32_t Expected = ClaimedSize(Message);
+	z_stream strm = {};
+	if (inflateInit(&strm) != Z_OK)
+		return false;
+
+	std::string Output;
+	size_t Requested = std::max((size_t)4096, std::min((size_t)Expected, (size_t)1024 * 1024));
+	try {
+		Output.resize(Requested);
+
+		strm.next_in = (unsigned char *)Message.data() + sizeof(uint32_t);
+		strm.avail_in = (uInt)(Message.size() - sizeof(uint32_t));
+		while (true)
+		{
+			if (strm.total_out == Output.size())
+			{
+				// One byte over, so inflate can finish a message of exactly the expected size
+				if (Output.size() > Expected)
+				{
+					inflateEnd(&strm);
+					return false;
+				}
+				Requested = std::min(Output.size() * 2, (size_t)Expected + 1);
+				Output.resize(Requested);
+			}
+
+			strm.next_out = (unsigned char *)&Output[0] + strm.total_out;
+			strm.avail_out = (uInt)(Output.size() - strm.total_out);
+			const int ret = inflate(&strm, Z_NO_FLUSH);
+			if (ret == Z_STREAM_END)
+				break;
+			if ((strm.avail_in == 0 && strm.avail_out != 0 && (ret == Z_OK || ret == Z_BUF_ERROR)) ||
+				(ret != Z_OK && ret != Z_BUF_ERROR))
+			{
+				inflateEnd(&strm);
+				return false;
+			}
+		}
+	}
+	catch (std::bad_alloc)
+	{
+		inflateEnd(&strm);
+		return false;
+	}
+	inflateEnd(&strm);
+
+	if (strm.total_out != Expected)
+		return false;
+	Output.resize(strm.total_out);
+	Content = std::move(Output);
+	return true;
+}
+
+// Text-like data, compressing about as well as a typical game message
+static std::string MakeData(size_t Size)
+{
+	static const char * const Words[] = { "player", "score", "level", "x", "y", "health", "channel",
+		"item", "name", "enemy", "position", "speed", "\n", "=", ",", "{", "}" };
+	std::mt19937 Random(20261019);
+	std::string Data;
+	Data.reserve(Size + 32);
+	while (Data.size() < Size)
+	{
+		const unsigned int Pick = Random() % 40;
+		if (Pick < sizeof(Words) / sizeof(*Words))
+			Data += Words[Pick];
+		else
+			Data += std::to_string(Random() % 10000);
+		Data += ' ';
+	}
+	Data.resize(Size);
+	return Data;
+}
+
+// A message as Lacewing sends it: the claimed size, then the zlib stream
+static std::string MakeMessage(const std::string &Data, uint32_t Claimed)
+{
+	uLongf Size = compressBound((uLong)Data.size());
+	std::string Message(sizeof(uint32_t) + Size, '\0');
+	compress2((Bytef *)&Message[sizeof(uint32_t)], &Size, (const Bytef *)Data.data(), (uLong)Data.size(), Z_DEFAULT_COMPRESSION);
+	memcpy(&Message[0], &Claimed, sizeof(Claimed));
+	Message.resize(sizeof(uint32_t) + Size);
+	return Message;
+}
+
+typedef bool (*Inflate)(const std::string &Message, std::string &Content);
+
+// Decompresses the message Calls times; returns MB/s, and the peak held by one call in PeakMB
+static double Time(Inflate Function, const std::string &Message, const std::string &Data, int Calls, double &PeakMB, bool &Same)
+{
+	size_t MostHeld = 0;
+	Same = true;
+	const auto Start = std::chrono::steady_clock::now();
+	for (int i = 0; i < Calls; ++i)
+	{
+		const size_t Before = Held;
+		Peak = Held;
+		{
+			std::string Content;
+			Same = Function(Message, Content) && Content == Data && Same;
+		}
+		MostHeld = std::max(MostHeld, Peak - Before);
+	}
+	const double Seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - Start).count();
+	PeakMB = MostHeld / 1048576.0;
+	return Data.size() * (double)Calls / 1048576 / Seconds;
+}
+
+int main(int argc, char ** argv)
+{
+	const double MB = argc > 1 ? atof(argv[1]) : 256;
+	if (MB <= 0)
+	{
+		fprintf(stderr, "Usage: inflate-bench [MB to decompress for each size, default 256]\n");
+		return 2;
+	}
+
+	// Honest senders
+	const size_t Sizes[] = { 4 * 1024, 64 * 1024, 1024 * 1024, 16 * 1024 * 1024, 64 * 1024 * 1024 };
+	for (size_t Size : Sizes)
+	{
+		const std::string Data = MakeData(Size);
+		const std::string Message = MakeMessage(Data, (uint32_t)Size);
+		const int Calls = std::max(1, (int)(MB * 1048576 / Size));
+
+		double BeforePeak, AfterPeak;
+		bool BeforeSame, AfterSame;
+		const double BeforeSpeed = Time(InflateBefore, Message, Data, Calls, BeforePeak, BeforeSame);
+		const double AfterSpeed = Time(InflateAfter, Message, Data, Calls, AfterPeak, AfterSame);
+		printf("%8zu KB: before %6.0f MB/s, peak %7.2f MB; after %6.0f MB/s, peak %7.2f MB%s\n",
+			Size / 1024, BeforeSpeed, BeforePeak, AfterSpeed, AfterPeak,
+			BeforeSame && AfterSame ? "" : "; OUTPUT DIFFERS");
+	}
+
+	// A message claiming far more than it holds
+	{
+		const std::string Data = MakeData(64 * 1024);
+		const std::string Message = MakeMessage(Data, 200 * 1024 * 1024);
+		std::string Content;
+		const size_t Before = Held;
+
+		Peak = Held;
+		auto Start = std::chrono::steady_clock::now();
+		const bool BeforeAccepted = InflateBefore(Message, Content);
+		const double BeforeTime = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - Start).count();
+		const double BeforePeak = (Peak - Before) / 1048576.0;
+		Content.clear();
+		Content.shrink_to_fit();
+
+		Peak = Held;
+		Start = std::chrono::steady_clock::now();
+		const bool AfterAccepted = InflateAfter(Message, Content);
+		const double AfterTime = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - Start).count();
+		const double AfterPeak = (Peak - Before) / 1048576.0;
+
+		printf("64KB claiming 200MB: before %s in %.1f ms, peak %.2f MB; after %s in %.1f ms, peak %.2f MB\n",
+			BeforeAccepted ? "padded with zeros" : "rejected", BeforeTime, BeforePeak,
+			AfterAccepted ? "accepted" : "rejected", AfterTime, AfterPeak);
+	}
+	return 0;
+}
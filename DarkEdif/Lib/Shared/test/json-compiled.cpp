@@ -0,0 +1,230 @@
+// Test and benchmark for compiled JSON images (DarkEdifJSONCompiler/JSONCompiler.h, and
+// json_load_compiled in json.cpp).
+//
+// Checks that an image is the bytes json.h describes, whatever json_value looks like in the build
+// making it, by comparing one against an image written out by hand; that images load back as the
+// tree they were made from; and that truncated or damaged images are refused rather than read
+// out of bounds. "make check-asan" runs it with AddressSanitizer, for the last.
+//
+// Then times parsing an extension-sized JSON file against loading its image.
+//
+// Usage: json-compiled [times to load, default 200]
+
+#include "JSONCompiler.h"
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <string>
+#include <vector>
+
+static int failures = 0;
+
+static void check(bool passed, const char * what)
+{
+	printf("%s: %s\n", passed ? "pass" : "FAIL", what);
+
+	if (!passed)
+		++failures;
+}
+
+static json_value * Parse(const std::string &Text)
+{
+	char Error[256];
+	json_settings Settings = {};
+
+	// Runtime builds only take JSON as the pre-build tool minifies it, headed by a timestamp comment
+	const std::string Runtime = "//1700000000\n" + Text;
+
+	json_value * Value = json_parse_ex(&Settings, Runtime.c_str(), Runtime.size(), Error, sizeof(Error));
+	if (!Value)
+		printf("JSON error: %s\n", Error);
+	return Value;
+}
+
+static json_value * Load(const std::vector<char> &Image)
+{
+	char Error[256];
+	return json_load_compiled(Image.data(), Image.size(), Error, sizeof(Error));
+}
+
+template<class T>
+static void Put(std::vector<char> &Image, std::initializer_list<T> Items)
+{
+	for (T Item : Items)
+		for (size_t i = 0; i < sizeof(T); ++i)
+			Image.push_back((char)(Item >> (i * 8)));
+}
+
+// {"a":[1,"b"],"c":true}, as json.h lays it out
+static std::vector<char> HandMadeImage()
+{
+	std::vector<char> Image;
+
+	// Header: magic, version, size, values, members, elements, string table size, reserved
+	Put<unsigned int>(Image, { json_compiled_magic, json_compiled_version, 142, 5, 2, 2, 6, 0 });
+
+	// Records: type, length, data; depth first
+	Put<unsigned int>(Image, { json_object, 2, 0, 0 });
+	Put<unsigned int>(Image, { json_array, 2, 0, 0 });
+	Put<unsigned int>(Image, { json_integer, 0, 1, 0 });
+	Put<unsigned int>(Image, { json_string, 1, 4, 0 });
+	Put<unsigned int>(Image, { json_boolean, 0, 1, 0 });
+
+	// Members: name, record; elements: record
+	Put<unsigned int>(Image, { 0, 1, 2, 4 });
+	Put<unsigned int>(Image, { 2, 3 });
+
+	for (char c : std::string("a\0c\0b\0", 6))
+		Image.push_back(c);
+
+	return Image;
+}
+
+// Reads every value, so AddressSanitizer sees anything out of bounds
+static size_t Walk(const json_value &Value)
+{
+	size_t Total = 1;
+
+	switch (Value.type)
+	{
+		case json_object:
+			for (unsigned int i = 0; i < Value.u.object.length; ++i)
+				Total += strlen(Value.u.object.values[i].name) + Walk(*Value.u.object.values[i].value);
+			break;
+		case json_array:
+			for (unsigned int i = 0; i < Value.u.array.length; ++i)
+				Total += Walk(*Value.u.array.values[i]);
+			break;
+		case json_string:
+			Total += strlen(Value.u.string.ptr);
+			break;
+		default:
+			break;
+	}
+
+	return Total;
+}
+
+// An extension's JSON, shaped as DarkEdif expects
+static std::string MakeExtensionJSON(int NumACEs)
+{
+	std::string Out = "{ \"About\": { \"Name\": \"Bench\" }, \"English\": {\n"
+		"\"About\": { \"Name\": \"Bench\", \"Author\": \"Someone\" },\n";
+
+	for (const char * Section : { "Actions", "Conditions", "Expressions" })
+	{
+		Out += std::string("\"") + Section + "\": [\n";
+		for (int i = 0; i < NumACEs; ++i)
+		{
+			Out += "{ \"Title\": \"" + std::string(Section) + " number " + std::to_string(i) +
+				"\", \"Triggered\": false, \"Parameters\": [";
+			for (int j = 0; j < i % 5; ++j)
+				Out += std::string(j ? ", " : "") + "[ \"Number\", \"Parameter " + std::to_string(j) + "\" ]";
+			Out += i + 1 < NumACEs ? " ] },\n" : " ] }\n";
+		}
+		Out += "],\n";
+	}
+
+	Out += "\"Properties\": [] } }";
+	return Out;
+}
+
+int main(int argc, char ** argv)
+{
+	const int Loads = argc > 1 ? atoi(argv[1]) : 200;
+
+	// The format
+	json_value * Small = Parse("{\"a\":[1,\"b\"],\"c\":true}");
+	const std::vector<char> HandMade = HandMadeImage();
+	check(Small && JSONCompiler().Compile(Small) == HandMade, "image is the bytes json.h describes");
+
+	json_value * SmallLoaded = Load(HandMade);
+	check(SmallLoaded && JSONSame(*Small, *SmallLoaded), "hand made image loads");
+	json_value_free(SmallLoaded);
+
+	// Every kind of value
+	std::string Members;
+	for (int i = 0; i < 40; ++i)
+		Members += ", \"member " + std::to_string(i) + "\": " + std::to_string(i);
+
+	json_value * All = Parse("{ \"int\": 42, \"negative\": -9223372036854775807, \"big\": 9223372036854775807, "
+		"\"double\": -1.5e300, \"zero\": -0.0, \"true\": true, \"false\": false, \"null\": null, "
+		"\"text\": \"caf\\u00e9 \\u0000 nul\", \"empty text\": \"\", \"empty\": {}, \"none\": [], "
+		"\"nested\": [ [ [ { \"deep\": [ 1, 2, { \"deeper\": \"yes\" } ] } ] ] ], "
+		"\"int\": \"duplicate\"" + Members + " }");
+	json_value * AllLoaded = All ? Load(JSONCompiler().Compile(All)) : nullptr;
+
+	check(AllLoaded && JSONSame(*All, *AllLoaded), "every kind of value loads back the same");
+	check(AllLoaded && (json_int_t)(*AllLoaded)["int"] == 42 && (*AllLoaded)["member 39"].type == json_integer,
+		"lookups by name on a loaded image");
+	check(AllLoaded && (*AllLoaded)["text"].u.string.length == 11, "strings with a nul in keep their length");
+	json_value_free(AllLoaded);
+
+	// Damaged images
+	const std::vector<char> Image = JSONCompiler().Compile(All);
+	bool Refused = true;
+	for (size_t Length = 0; Length < Image.size(); ++Length)
+		Refused = Refused && !Load(std::vector<char>(Image.begin(), Image.begin() + Length));
+	check(Refused, "every truncated image is refused");
+
+	size_t Loaded = 0;
+	for (size_t i = 0; i < Image.size(); ++i)
+	{
+		for (int Bit = 0; Bit < 8; ++Bit)
+		{
+			std::vector<char> Damaged = Image;
+			Damaged[i] ^= (char)(1 << Bit);
+
+			if (json_value * Value = Load(Damaged))
+			{
+				Walk(*Value);
+				json_value_free(Value);
+				++Loaded;
+			}
+		}
+	}
+	printf("  %zu of %zu images with a bit flipped still made a tree\n", Loaded, Image.size() * 8);
+	check(true, "images with any one bit flipped load safely or are refused");
+
+	// Records that would make something other than a tree
+	std::vector<char> Cycle = HandMade;
+	Cycle[32 + 5 * 16 + 4] = 0;		// member "a" is the root itself
+	std::vector<char> Shared = HandMade;
+	Shared[32 + 5 * 16 + 8 + 4] = 1;	// member "c" is the array "a" is too
+	std::vector<char> Orphan = HandMade;
+	Orphan[32 + 16 + 4] = 1;			// the array only has 1, leaving "b" unowned
+	check(!Load(Cycle) && !Load(Shared), "records that loop or share a value are refused");
+	check(!Load(Orphan), "records left out of the tree are refused");
+
+	std::vector<char> OldVersion = HandMade;
+	OldVersion[4] = 1;
+	check(!Load(OldVersion), "images from the old version are refused");
+
+	json_value_free(All);
+	json_value_free(Small);
+
+	// Timing; not checked, as it depends on the machine
+	const std::string Text = MakeExtensionJSON(150);
+	json_value * Extension = Parse(Text);
+	if (!Extension)
+		return 1;
+
+	const std::vector<char> ExtensionImage = JSONCompiler().Compile(Extension);
+
+	const auto Start = std::chrono::steady_clock::now();
+	for (int i = 0; i < Loads; ++i)
+		json_value_free(Parse(Text));
+	const auto Middle = std::chrono::steady_clock::now();
+	for (int i = 0; i < Loads; ++i)
+		json_value_free(Load(ExtensionImage));
+	const auto End = std::chrono::steady_clock::now();
+
+	const std::chrono::duration<double, std::micro> ParseTime = Middle - Start, LoadTime = End - Middle;
+	printf("  %zu bytes of JSON, %zu byte image: %.1f us to parse, %.1f us to load\n",
+		Text.size(), ExtensionImage.size(), ParseTime.count() / Loads, LoadTime.count() / Loads);
+	json_value_free(Extension);
+
+	printf(failures ? "%d failed\n" : "all passed\n", failures);
+	return failures ? 1 : 0;
+}
@@ -0,0 +1,189 @@
+// Test and benchmark for looking up JSON object members by name (json_object_find in json.cpp).
+//
+// Checks that lookups through the hash index find what a linear search of the members does,
+// including the first of duplicate names and names that aren't there, for objects either side of
+// json_index_min_length. Then looks up members of one parsed value from several threads at once,
+// as extensions do from their own threads; lookups only read the value, so under
+// "make check-tsan" this should report nothing.
+//
+// Then times the linear search the lookups used to do against the index, by plain name and by
+// json_key, on an object shaped like an extension's language object.
+//
+// Usage: json-lookup [lookups to time, default 20000000]
+
+#include "json.h"
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <string>
+#include <thread>
+#include <vector>
+
+static int failures = 0;
+
+static void check(bool passed, const char * what)
+{
+	printf("%s: %s\n", passed ? "pass" : "FAIL", what);
+
+	if (!passed)
+		++failures;
+}
+
+// As operator[] did before the index
+__attribute__((noinline)) static const json_value &LinearFind(const json_value &Object, const char * Name)
+{
+	for (unsigned int i = 0; i < Object.u.object.length; ++i)
+		if (!strcmp(Object.u.object.values[i].name, Name))
+			return *Object.u.object.values[i].value;
+
+	return json_value_none;
+}
+
+__attribute__((noinline)) static const json_value &IndexFind(const json_value &Object, const char * Name)
+{
+	return Object[Name];
+}
+
+__attribute__((noinline)) static const json_value &KeyFind(const json_value &Object, const json_key &Key)
+{
+	return Object[Key];
+}
+
+// An object of Count members "member 0" and so on, with values their numbers. If Duplicate, every
+// member is listed twice, the second time with the value negated.
+static std::string MakeObject(int Count, bool Duplicate)
+{
+	std::string Out = "{";
+
+	for (int Pass = 0; Pass < (Duplicate ? 2 : 1); ++Pass)
+	{
+		for (int i = 0; i < Count; ++i)
+		{
+			Out += (Pass || i) ? ", " : " ";
+			Out += "\"member " + std::to_string(i) + "\": " + std::to_string(Pass ? -i : i);
+		}
+	}
+
+	return Out + " }";
+}
+
+static json_value * Parse(const std::string &Text)
+{
+	char Error[256];
+	json_settings Settings = {};
+
+	// Runtime builds only take JSON as the pre-build tool minifies it, headed by a timestamp comment
+	const std::string Runtime = "//1700000000\n" + Text;
+
+	json_value * Value = json_parse_ex(&Settings, Runtime.c_str(), Runtime.size(), Error, sizeof(Error));
+	if (!Value)
+		printf("JSON error: %s\n", Error);
+	return Value;
+}
+
+// Whether every member, and some names that aren't members, are found as by a linear search
+static bool MatchesLinear(const json_value &Object, int Count)
+{
+	for (int i = 0; i < Count + 4; ++i)
+	{
+		const std::string Name = "member " + std::to_string(i);
+
+		if (&IndexFind(Object, Name.c_str()) != &LinearFind(Object, Name.c_str())
+			|| &KeyFind(Object, json_key(Name.c_str())) != &LinearFind(Object, Name.c_str()))
+		{
+			return false;
+		}
+	}
+
+	return &Object["member"] == &json_value_none && &Object[""] == &json_value_none;
+}
+
+// An extension's language object, to time lookups of its sections
+static std::string MakeLanguage()
+{
+	static const char * Sections[] = { "About", "ActionMenu", "ConditionMenu", "ExpressionMenu",
+		"Actions", "Conditions", "Expressions", "Properties", "Comments", "Help", "Dependencies" };
+	std::string Out = "{";
+
+	for (const char * Section : Sections)
+		Out += std::string(Out.size() > 1 ? ", \"" : " \"") + Section + "\": [ 1, 2, 3 ]";
+
+	return Out + " }";
+}
+
+static const json_value * volatile Found;
+
+template<class Func>
+static double NanosecondsPerCall(long Calls, Func &&Call)
+{
+	const auto Start = std::chrono::steady_clock::now();
+	for (long i = 0; i < Calls; ++i)
+		Call(i);
+	const std::chrono::duration<double, std::nano> Taken = std::chrono::steady_clock::now() - Start;
+	return Taken.count() / Calls;
+}
+
+int main(int argc, char ** argv)
+{
+	const long Calls = argc > 1 ? atol(argv[1]) : 20000000;
+
+	// Either side of where indexing starts, and large
+	for (int Count : { 1, json_index_min_length - 1, json_index_min_length, 100, 5000 })
+	{
+		json_value * Value = Parse(MakeObject(Count, false));
+		std::string What = std::to_string(Count) + " members: lookups match a linear search";
+		check(Value && MatchesLinear(*Value, Count), What.c_str());
+		json_value_free(Value);
+
+		Value = Parse(MakeObject(Count, true));
+		What = std::to_string(Count) + " members listed twice: the first of each is found";
+		check(Value && MatchesLinear(*Value, Count) && (json_int_t)(*Value)["member 0"] == 0
+			&& (Count < 2 || (json_int_t)(*Value)["member 1"] == 1), What.c_str());
+		json_value_free(Value);
+	}
+
+	// Nested objects are indexed as well as the root
+	json_value * Nested = Parse("{ \"outer\": " + MakeObject(50, false) + ", \"other\": 1 }");
+	check(Nested && MatchesLinear((*Nested)["outer"], 50), "nested object: lookups match a linear search");
+	json_value_free(Nested);
+
+	// Lookups from several threads at once on one parsed value
+	json_value * Shared = Parse(MakeObject(200, false));
+	std::vector<std::thread> Threads;
+	int Mismatches[4] = {};
+
+	for (int t = 0; t < 4; ++t)
+	{
+		Threads.emplace_back([&, t] {
+			for (int i = 0; i < 2000; ++i)
+			{
+				const std::string Name = "member " + std::to_string((i * 7 + t) % 210);
+				if (&IndexFind(*Shared, Name.c_str()) != &LinearFind(*Shared, Name.c_str()))
+					++Mismatches[t];
+			}
+		});
+	}
+	for (std::thread &Thread : Threads)
+		Thread.join();
+
+	check(!(Mismatches[0] + Mismatches[1] + Mismatches[2] + Mismatches[3]), "lookups from four threads at once");
+	json_value_free(Shared);
+
+	// Timing; not checked, as it depends on the machine
+	json_value * Language = Parse(MakeLanguage());
+	if (!Language)
+		return 1;
+
+	static const json_key Properties("Properties");
+	const double Linear = NanosecondsPerCall(Calls, [&](long) { Found = &LinearFind(*Language, "Properties"); });
+	const double Indexed = NanosecondsPerCall(Calls, [&](long) { Found = &IndexFind(*Language, "Properties"); });
+	const double Keyed = NanosecondsPerCall(Calls, [&](long) { Found = &KeyFind(*Language, Properties); });
+
+	printf("  %ld lookups of \"Properties\" on a language object: %.2f ns linear, %.2f ns indexed, "
+		"%.2f ns by json_key\n", Calls, Linear, Indexed, Keyed);
+	json_value_free(Language);
+
+	printf(failures ? "%d failed\n" : "all passed\n", failures);
+	return failures ? 1 : 0;
+}
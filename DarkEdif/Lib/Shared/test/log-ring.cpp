@@ -0,0 +1,288 @@
+// Test and benchmark for the ring behind DebugObject's asynchronous logging (DebugObject/LogRing.h).
+//
+// Runs a writer thread as AsyncLog does, woken by an auto-reset event or every 50 ms, writing out
+// in batches. Checks every line pushed by several threads is written once, in each thread's order,
+// or counted as dropped; that lines too long for a record come through whole; and that Flushed()
+// returns once the writer catches up, and times out when it can't. "make check-tsan" runs it with
+// ThreadSanitizer.
+//
+// Then times logging lines to a file through the ring, from one and from four threads, against
+// writing and flushing each line as synchronous logging does; and how long Flushed() waits after
+// a line is pushed.
+//
+// Usage: log-ring [lines to time per thread, default 200000]
+
+#include "LogRing.h"
+
+#include <chrono>
+#include <condition_variable>
+#include <cstdio>
+#include <cstdlib>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+static int failures = 0;
+
+static void check(bool passed, const char * what)
+{
+	printf("%s: %s\n", passed ? "pass" : "FAIL", what);
+
+	if (!passed)
+		++failures;
+}
+
+// AsyncLog's writer thread, with an auto-reset event and file in place of the Win32 ones
+class Writer
+{
+	LogRing &ring;
+	FILE * file;
+	std::string batch;
+	std::mutex wakeLock;
+	std::condition_variable wakeCond;
+	bool woken = false, stop = false;
+	std::thread thread;
+
+	void WriteOut()
+	{
+		const size_t popped = ring.Pop([&](const LogRing::Line &line) {
+			if (line.toFile)
+			{
+				batch.append(line.text, line.length);
+				if (!line.raw)
+					batch.append("\r\n", 2);
+			}
+			if (batch.size() >= 60 * 1024)
+			{
+				fwrite(batch.data(), 1, batch.size(), file);
+				batch.clear();
+			}
+		});
+
+		if (!batch.empty())
+		{
+			fwrite(batch.data(), 1, batch.size(), file);
+			batch.clear();
+		}
+		if (popped)
+		{
+			fflush(file);
+			ring.Written();
+		}
+	}
+
+	void Run()
+	{
+		while (true)
+		{
+			bool stopping;
+			{
+				std::unique_lock<std::mutex> lock(wakeLock);
+				wakeCond.wait_for(lock, std::chrono::milliseconds(50), [&] { return woken; });
+				woken = false;
+				stopping = stop;
+			}
+			WriteOut();
+			if (stopping)
+				break;
+		}
+	}
+
+public:
+	Writer(LogRing &ring, FILE * file) : ring(ring), file(file), thread(&Writer::Run, this)
+	{
+		batch.reserve(64 * 1024);
+	}
+	~Writer()
+	{
+		{
+			std::lock_guard<std::mutex> lock(wakeLock);
+			stop = woken = true;
+		}
+		wakeCond.notify_one();
+		thread.join();
+	}
+
+	void Wake()
+	{
+		{
+			std::lock_guard<std::mutex> lock(wakeLock);
+			woken = true;
+		}
+		wakeCond.notify_one();
+	}
+
+	// AsyncLog::Push and Flush
+	bool Push(const std::string &Text)
+	{
+		bool wake;
+		const bool pushed = ring.Push("[log] ", 6, Text.data(), Text.size(), true, false, false, wake);
+		if (wake)
+			Wake();
+		return pushed;
+	}
+	bool Flush(int timeoutMS = 2000)
+	{
+		Wake();
+		return ring.Flushed(std::chrono::milliseconds(timeoutMS));
+	}
+};
+
+// Pushes Lines lines from each of Threads threads through a writer, returning the time taken
+// until the last is flushed. To time what the writer keeps up with, a thread that finds the ring
+// full waits for room rather than dropping the line; Full counts the times it did.
+static double LogThroughRing(FILE * File, int Threads, long Lines, std::uint64_t &Full)
+{
+	LogRing Ring;
+	Writer Out(Ring, File);
+	std::vector<std::thread> Producers;
+
+	const auto Start = std::chrono::steady_clock::now();
+	for (int t = 0; t < Threads; ++t)
+	{
+		Producers.emplace_back([&, t] {
+			std::string Text = "thread " + std::to_string(t) + ", message number ";
+			const size_t Length = Text.size();
+			for (long i = 0; i < Lines; ++i)
+			{
+				Text.resize(Length);
+				Text += std::to_string(i);
+				while (!Out.Push(Text))
+					std::this_thread::yield();
+			}
+		});
+	}
+	for (std::thread &Producer : Producers)
+		Producer.join();
+	Out.Flush();
+	const std::chrono::duration<double, std::milli> Time = std::chrono::steady_clock::now() - Start;
+
+	Full = Ring.Dropped();
+	return Time.count();
+}
+
+int main(int argc, char ** argv)
+{
+	const long Lines = argc > 1 ? atol(argv[1]) : 200000;
+
+	// Several threads pushing, some lines too long for a record
+	{
+		const int Threads = 4;
+		const long PerThread = 100000;
+		LogRing Ring;
+		FILE * File = tmpfile();
+		std::vector<long> Pushed(Threads);
+		{
+			Writer Out(Ring, File);
+			std::vector<std::thread> Producers;
+			for (int t = 0; t < Threads; ++t)
+			{
+				Producers.emplace_back([&, t] {
+					for (long i = 0; i < PerThread; ++i)
+					{
+						std::string Text = std::to_string(t) + " " + std::to_string(i);
+						if (i % 1000 == 0)
+							Text += " " + std::string(300 + i % 700, 'L') + ".";
+						Pushed[t] += Out.Push(Text);
+					}
+				});
+			}
+			for (std::thread &Producer : Producers)
+				Producer.join();
+			check(Out.Flush(), "Flushed() returns once everything pushed is written");
+		}
+
+		// Read it back; each thread's lines must be in order, with none repeated
+		rewind(File);
+		std::vector<long> Last(Threads, -1), Written(Threads);
+		bool Ordered = true, Whole = true;
+		char Line[2048];
+		while (fgets(Line, sizeof(Line), File))
+		{
+			int t;
+			long i;
+			if (sscanf(Line, "[log] %d %ld", &t, &i) != 2 || t < 0 || t >= Threads)
+			{
+				Whole = false;
+				continue;
+			}
+			Ordered = Ordered && i > Last[t];
+			Last[t] = i;
+			++Written[t];
+			if (i % 1000 == 0)
+			{
+				const char * Long = strchr(strchr(Line + 6, ' ') + 1, ' ');
+				Whole = Whole && Long && strlen(Long) == 1 + 300 + i % 700 + 1 + 2 && !strcmp(Long + 1 + 300 + i % 700, ".\r\n");
+			}
+		}
+		fclose(File);
+
+		long TotalPushed = 0, TotalWritten = 0;
+		for (int t = 0; t < Threads; ++t)
+		{
+			TotalPushed += Pushed[t];
+			TotalWritten += Written[t];
+		}
+		printf("  %ld lines pushed, %ld written, %llu dropped\n", Threads * PerThread, TotalWritten, (unsigned long long)Ring.Dropped());
+		check(Ordered, "each thread's lines are written in order, once");
+		check(TotalWritten == TotalPushed && TotalPushed + (long)Ring.Dropped() == Threads * PerThread,
+			"every line is written or counted as dropped");
+		check(Whole, "long lines are written whole");
+	}
+
+	// Nothing to write out
+	{
+		LogRing Ring;
+		bool Wake;
+		check(Ring.Flushed(std::chrono::milliseconds(0)), "Flushed() returns at once with nothing pushed");
+		Ring.Push("", 0, "stuck", 5, true, false, false, Wake);
+		const auto Start = std::chrono::steady_clock::now();
+		const bool Flushed = Ring.Flushed(std::chrono::milliseconds(20));
+		const std::chrono::duration<double, std::milli> Waited = std::chrono::steady_clock::now() - Start;
+		check(!Flushed && Waited.count() >= 19, "Flushed() times out with no writer");
+	}
+
+	// Timing; not checked, as it depends on the machine
+	FILE * File = tmpfile();
+	std::uint64_t Full;
+
+	const auto Start = std::chrono::steady_clock::now();
+	std::string Text = "[log] thread 0, message number ";
+	const size_t Length = Text.size();
+	for (long i = 0; i < Lines; ++i)
+	{
+		Text.resize(Length);
+		Text += std::to_string(i);
+		Text += "\r\n";
+		fwrite(Text.data(), 1, Text.size(), File);
+		fflush(File);
+	}
+	const std::chrono::duration<double, std::milli> Sync = std::chrono::steady_clock::now() - Start;
+	printf("  %ld lines written and flushed one by one: %.1f ms, %.0f lines/s\n", Lines, Sync.count(), Lines / Sync.count() * 1000);
+
+	for (int Threads : { 1, 4 })
+	{
+		const double Time = LogThroughRing(File, Threads, Lines, Full);
+		printf("  %ld lines from %d thread%s through the ring: %.1f ms, %.0f lines/s, ring full %llu times\n",
+			Threads * Lines, Threads, Threads > 1 ? "s" : "", Time, Threads * Lines / Time * 1000, (unsigned long long)Full);
+	}
+
+	{
+		LogRing Ring;
+		Writer Out(Ring, File);
+		const int Flushes = 2000;
+		const auto FlushStart = std::chrono::steady_clock::now();
+		for (int i = 0; i < Flushes; ++i)
+		{
+			Out.Push("flushed line");
+			Out.Flush();
+		}
+		const std::chrono::duration<double, std::micro> FlushTime = std::chrono::steady_clock::now() - FlushStart;
+		printf("  a line pushed then flushed: %.1f us\n", FlushTime.count() / Flushes);
+	}
+	fclose(File);
+
+	printf(failures ? "%d failed\n" : "all passed\n", failures);
+	return failures ? 1 : 0;
+}
@@ -0,0 +1,360 @@
+// Test for property layouts (Inc/Shared/PropertyLayout.h), which PropIndex() and
+// GetPropertyStr(name) use to find properties in EDITDATA.
+//
+// Builds property lists of every type in random orders, with the flat data InitialisePropertiesFromJSON()
+// writes for them, and checks every property is found where the walk PropIndex() used to do finds
+// it, with the same size. Then checks titles are looked up as _stricmp() compares them: ASCII
+// letters in any case, and UTF-8 titles byte for byte.
+//
+// Then checks the chunked layout: flat data reads the same once chunked; data chunked for an older
+// property list keeps each property with the same ID and type, and gives the rest their defaults;
+// data with the chunk header is never read as flat, even if its version is unknown; the header is
+// found from the trailer, so flat data holding the header's bytes isn't taken for chunks; and data
+// cut short is never read past its end. "make check-asan" runs it with AddressSanitizer, for the last.
+
+#include "PropertyLayout.h"
+
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <memory>
+#include <random>
+#include <string>
+#include <vector>
+
+static int failures = 0;
+
+static void check(bool passed, const char * what)
+{
+	printf("%s: %s\n", passed ? "pass" : "FAIL", what);
+
+	if (!passed)
+		++failures;
+}
+
+// PropIndex() before property layouts, less its JSON checks
+static char * WalkPropIndex(const json_value &j, char * Props, unsigned int ID, unsigned int * size)
+{
+	char * Current = &Props[(size_t)ceil(j.u.array.length / 8.0f)], * StartPos, * EndPos;
+
+	const char * curStr = (const char *)j[ID]["Type"];
+	// Read unchangable properties
+	if (!_stricmp(curStr, "Text") || !_stricmp(curStr, "Checkbox") || !_strnicmp(curStr, "Folder", sizeof("Folder") - 1))
+		return nullptr;
+
+	// Read changable properties
+	StartPos = Current; // For ID 0
+	unsigned int i = 0;
+	while (i <= ID)
+	{
+		curStr = (const char *)j[i]["Type"];
+
+		if (!_stricmp(curStr, "Editbox String"))
+			Current += strlen(Current) + 1;
+		else if (!_stricmp(curStr, "Editbox Number") || !_stricmp(curStr, "Combo Box"))
+			Current += sizeof(unsigned int);
+
+		if (i == ID - 1)
+			StartPos = Current;
+
+		++i;
+	}
+
+	EndPos = Current;
+
+	if (size)
+		*size = EndPos - StartPos;
+	return StartPos;
+}
+
+static json_value * Parse(const std::string &Text)
+{
+	char Error[256];
+	json_settings Settings = {};
+	const std::string Runtime = "//1700000000\n" + Text;
+
+	json_value * Value = json_parse_ex(&Settings, Runtime.c_str(), Runtime.size(), Error, sizeof(Error));
+	if (!Value)
+		printf("JSON error: %s\n", Error);
+	return Value;
+}
+
+// Type names as extensions write them, including other cases, and types with no data
+static const char * TypeNames[] = { "Text", "Checkbox", "Folder", "Folder End", "Edit button",
+	"Editbox String", "Editbox Number", "Combo Box", "editbox string", "COMBO BOX", "Color", "Editbox Float" };
+
+// Whether Layouts read Chunked as they read Flat, checkboxes included
+static bool ChunksMatchFlat(const Edif::PropertyLayouts &Layouts, std::string Flat, std::string Chunked)
+{
+	if (!Layouts.Chunks(&Chunked[0], Chunked.size()))
+		return false;
+
+	for (unsigned int i = 0; i < Layouts.size(); ++i)
+	{
+		unsigned int FlatSize = 0, ChunkedSize = 0;
+		const char * FlatData = Layouts.Find(&Flat[0], Flat.size(), i, &FlatSize);
+		const char * ChunkedData = Layouts.Find(&Chunked[0], Chunked.size(), i, &ChunkedSize);
+
+		if (!FlatData != !ChunkedData || (FlatData && (FlatSize != ChunkedSize || memcmp(FlatData, ChunkedData, FlatSize))) ||
+			Layouts.IsChecked(Flat.data(), Flat.size(), i) != Layouts.IsChecked(Chunked.data(), Chunked.size(), i))
+		{
+			return false;
+		}
+	}
+	return true;
+}
+
+static bool MatchesWalk(std::mt19937 &Random, int Count, bool &Chunked)
+{
+	std::string JSON = "[";
+	std::vector<std::string> Types;
+
+	for (int i = 0; i < Count; ++i)
+	{
+		Types.push_back(TypeNames[Random() % (sizeof(TypeNames) / sizeof(*TypeNames))]);
+		JSON += std::string(i ? ", " : "") + "{ \"Type\": \"" + Types.back() + "\", \"Title\": \"Property " + std::to_string(i) + "\" }";
+	}
+
+	json_value * Properties = Parse(JSON + " ]");
+	if (!Properties)
+		return false;
+
+	// As InitialisePropertiesFromJSON() used to lay them out
+	std::string Data((Count + 7) / 8, '\0');
+	for (char &Bits : Data)
+		Bits = (char)Random();
+	for (const std::string &Type : Types)
+	{
+		if (!_stricmp(Type.c_str(), "Editbox String"))
+			Data += std::string(Random() % 40, (char)('a' + Random() % 26)) + '\0';
+		else if (!_stricmp(Type.c_str(), "Editbox Number") || !_stricmp(Type.c_str(), "Combo Box"))
+		{
+			const unsigned int Number = Random();
+			Data.append((const char *)&Number, sizeof(Number));
+		}
+	}
+
+	Edif::PropertyLayouts Layouts;
+	Layouts.Make(*Properties);
+
+	bool Same = Layouts.size() == (size_t)Count;
+	for (int i = 0; i < Count && Same; ++i)
+	{
+		unsigned int WalkSize = 0, LayoutSize = 0;
+		const char * Walked = WalkPropIndex(*Properties, &Data[0], i, &WalkSize);
+		const char * Found = Layouts.FlatIndex(&Data[0], Data.size(), i, &LayoutSize);
+
+		Same = Walked == Found && (!Walked || WalkSize == LayoutSize);
+		if (!Same)
+		{
+			printf("  property %d, %s: offset %td size %u, was offset %td size %u\n", i, Types[i].c_str(),
+				Found ? Found - Data.data() : -1, LayoutSize, Walked ? Walked - Data.data() : -1, WalkSize);
+		}
+	}
+
+	Chunked = Chunked && ChunksMatchFlat(Layouts, Data, Layouts.Chunk(&Data[0], Data.size()));
+
+	json_value_free(Properties);
+	return Same;
+}
+
+// Sets a property in data chunked for Layouts, as PropChange() does when it fits
+static void SetChunked(const Edif::PropertyLayouts &Layouts, std::string &Data, unsigned int ID, const std::string &Value)
+{
+	Edif::PropChunk * Chunks = Layouts.Chunks(&Data[0], Data.size());
+	memcpy(&Data[Chunks[ID].Offset], Value.data(), Value.size());
+}
+
+static std::string Number(unsigned int Value)
+{
+	return std::string((const char *)&Value, sizeof(Value));
+}
+
+static std::string Found(const Edif::PropertyLayouts &Layouts, std::string &Data, unsigned int ID)
+{
+	unsigned int Size = 0;
+	const char * Found = Layouts.Find(&Data[0], Data.size(), ID, &Size);
+	return Found ? std::string(Found, Size) : "(none)";
+}
+
+static void CheckChunks()
+{
+	// The properties an extension saved with, and its next version's, which replaces "Port" with a
+	// checkbox and "Old" with a number, and adds a string after
+	json_value * OldJSON = Parse("[ { \"Type\": \"Editbox String\", \"Title\": \"Name\", \"DefaultState\": \"none\" }, "
+		"{ \"Type\": \"Checkbox\", \"Title\": \"Enabled\", \"DefaultState\": false }, "
+		"{ \"Type\": \"Editbox Number\", \"Title\": \"Port\", \"DefaultState\": 80 }, "
+		"{ \"Type\": \"Combo Box\", \"Title\": \"Mode\", \"DefaultState\": \"B\", \"Items\": [ \"A\", \"B\", \"C\" ] }, "
+		"{ \"Type\": \"Editbox String\", \"Title\": \"Old\", \"DefaultState\": \"gone\", \"ChkDefault\": true } ]");
+	json_value * NewJSON = Parse("[ { \"Type\": \"Editbox String\", \"Title\": \"Name\", \"DefaultState\": \"none\" }, "
+		"{ \"Type\": \"Checkbox\", \"Title\": \"Enabled\", \"DefaultState\": false }, "
+		"{ \"Type\": \"Checkbox\", \"Title\": \"Secure\", \"DefaultState\": true }, "
+		"{ \"Type\": \"Combo Box\", \"Title\": \"Mode\", \"DefaultState\": \"c\", \"Items\": [ \"A\", \"B\", \"C\" ] }, "
+		"{ \"Type\": \"Editbox Number\", \"Title\": \"Timeout\", \"DefaultState\": 30, \"ChkDefault\": true }, "
+		"{ \"Type\": \"Editbox String\", \"Title\": \"Host\", \"DefaultState\": \"Localhost\", \"Case\": \"Lower\" } ]");
+	if (!OldJSON || !NewJSON)
+	{
+		check(false, "chunk test JSON parses");
+		return;
+	}
+
+	Edif::PropertyLayouts Old, New;
+	Old.Make(*OldJSON);
+	New.Make(*NewJSON);
+
+	// Defaults
+	std::string Data = Old.Chunk(nullptr, 0);
+	const size_t HeaderAt = 4;
+	Edif::PropChunkTrailer Trailer;
+	memcpy(&Trailer, &Data[Data.size() - sizeof(Trailer)], sizeof(Trailer));
+	check(Data.compare(HeaderAt, 4, "DEPc") == 0 && Data.compare(Data.size() - 4, 4, "DEPt") == 0 && Trailer.HeaderOffset == HeaderAt,
+		"chunk header starts with the bytes \"DEPc\", and the trailer ends with \"DEPt\" and says where it is");
+	check(Found(Old, Data, 0) == std::string("none", 5) && Found(Old, Data, 2) == Number(80) && Found(Old, Data, 3) == Number(1) &&
+		Found(Old, Data, 1) == "(none)" && !Old.IsChecked(Data.data(), Data.size(), 1) && Old.IsChecked(Data.data(), Data.size(), 4),
+		"new data has the JSON's defaults");
+
+	// Saved by the old version
+	SetChunked(Old, Data, 0, std::string("mine", 5));
+	SetChunked(Old, Data, 2, Number(8080));
+	SetChunked(Old, Data, 3, Number(2));
+	Data[0] |= 1 << 1 | 1 << 2;
+
+	check(!New.Chunks(&Data[0], Data.size()), "data for another property list isn't current");
+	check(Found(New, Data, 0) == std::string("mine", 5) && Found(New, Data, 3) == Number(2) &&
+		New.IsChecked(Data.data(), Data.size(), 1), "properties with the same ID and type keep their values");
+	check(New.IsChecked(Data.data(), Data.size(), 2) && Found(New, Data, 2) == "(none)",
+		"a property that changed type gets its default, not the old one's data");
+	check(Found(New, Data, 4) == Number(30) && New.IsChecked(Data.data(), Data.size(), 4),
+		"a replaced property gets its default, not the old one's data or checkbox");
+	check(Found(New, Data, 5) == std::string("localhost", 10) && !New.IsChecked(Data.data(), Data.size(), 5),
+		"added properties get their defaults, not the old header's bytes");
+
+	std::string Migrated = New.Chunk(&Data[0], Data.size());
+	check(New.Chunks(&Migrated[0], Migrated.size()) && ChunksMatchFlat(New, Data, Migrated),
+		"migrated data is current and reads as before");
+
+	// Migrating back drops the properties that aren't in the old list
+	std::string Back = Old.Chunk(&Migrated[0], Migrated.size());
+	check(Found(Old, Back, 0) == std::string("mine", 5) && Found(Old, Back, 2) == Number(80) &&
+		Found(Old, Back, 4) == std::string("gone", 5) && Found(Old, Back, 3) == Number(2),
+		"migrating back drops added properties and defaults removed ones");
+
+	// Strings grown past their first capacity, as PropChange() does
+	std::string Long(100, 'x');
+	Edif::PropChunk * Chunks = New.Chunks(&Migrated[0], Migrated.size());
+	const size_t Grow = Edif::PropertyLayouts::ChunkCapacity(New[5].Type, Long.size() + 1) - Chunks[5].Capacity;
+	const size_t ChunkEnd = Chunks[5].Offset + Chunks[5].Capacity;
+	Migrated.insert(ChunkEnd, Grow, '\0');
+	Chunks = New.Chunks(&Migrated[0], Migrated.size());
+	for (unsigned int i = 0; i < New.size(); ++i)
+		if (i != 5 && Chunks[i].Offset >= ChunkEnd)
+			Chunks[i].Offset += (std::uint32_t)Grow;
+	Chunks[5].Capacity += (std::uint32_t)Grow;
+	memcpy(&Migrated[Chunks[5].Offset], Long.c_str(), Long.size() + 1);
+	check(Found(New, Migrated, 5) == Long + '\0' && Found(New, Migrated, 3) == Number(2), "grown strings read back");
+
+	// Never read as flat once the header's found
+	std::string Version = Data;
+	Version[HeaderAt + 4] = 9;
+	check(!New.Chunks(&Version[0], Version.size()) && !Old.Chunks(&Version[0], Version.size()) &&
+		Found(Old, Version, 0) == std::string("none", 5) && Found(Old, Version, 2) == Number(80),
+		"data of an unknown version is read as defaults");
+
+	// Flat data holding a header's bytes where a header would be; before the trailer, this was
+	// taken for chunks, and every property read as its default
+	{
+		json_value * JSON = Parse("[ { \"Type\": \"Editbox String\", \"Title\": \"A\", \"DefaultState\": \"\" }, "
+			"{ \"Type\": \"Editbox String\", \"Title\": \"B\", \"DefaultState\": \"\" } ]");
+		Edif::PropertyLayouts Two;
+		Two.Make(*JSON);
+		const Edif::PropChunkHeader Header = { Edif::PropChunkHeader::Magic, Edif::PropChunkHeader::LatestVersion, 2, 0 };
+		std::string Flat = std::string(1, '\0') + "abc";
+		Flat.append((const char *)&Header, sizeof(Header));
+		Flat.append(2 * sizeof(Edif::PropChunk), '\0');
+
+		unsigned int Size = 0;
+		const char * A = Two.Find(&Flat[0], Flat.size(), 0, &Size);
+		check(A == &Flat[1] && Size == 9 && !memcmp(A, "abcDEPc\x03", 9) && Two.Find(&Flat[0], Flat.size(), 1, &Size) == &Flat[10],
+			"flat data holding a chunk header's bytes is still read as flat");
+		json_value_free(JSON);
+	}
+
+	// Data cut short loses its trailer, so is read as flat, but never past its end
+	bool Safe = true;
+	for (size_t Length = 0; Length < Data.size() && Safe; ++Length)
+	{
+		// Its own allocation, so AddressSanitizer sees reads past it
+		std::unique_ptr<char[]> Cut(new char[Length + 1]);
+		memcpy(Cut.get(), Data.data(), Length);
+		for (unsigned int i = 0; i < Old.size(); ++i)
+		{
+			unsigned int Size = 0;
+			const char * Read = Old.Find(Cut.get(), Length, i, &Size);
+			Safe = Safe && (!Read || (Read >= Cut.get() && Size <= (size_t)(Cut.get() + Length - Read)) ||
+				Read == Old.Find(nullptr, 0, i, nullptr));
+			Old.IsChecked(Cut.get(), Length, i);
+		}
+		Safe = Safe && !Old.Chunks(Cut.get(), Length);
+	}
+	check(Safe, "data cut short is read within bounds");
+
+	json_value_free(OldJSON);
+	json_value_free(NewJSON);
+}
+
+int main()
+{
+	std::mt19937 Random(1234);
+
+	bool Same = true, Chunked = true;
+	for (int Round = 0; Round < 2000 && Same; ++Round)
+		Same = MatchesWalk(Random, 1 + Round % 40, Chunked);
+	check(Same, "2000 property lists: every offset and size matches the old walk");
+	check(Chunked, "2000 property lists: flat data reads the same once chunked");
+
+	CheckChunks();
+
+	// Titles
+	json_value * Properties = Parse("[ { \"Type\": \"Text\", \"Title\": \"Speed\" }, "
+		"{ \"Type\": \"Text\", \"Title\": \"\\u00dcber \\u00c9t\\u00e9\" }, "
+		"{ \"Type\": \"Text\", \"Title\": \"\\u00fcber \\u00e9t\\u00e9\" }, "
+		"{ \"Type\": \"Text\", \"Title\": \"SPEED\" }, "
+		"{ \"Type\": \"Text\", \"Title\": \"\\u0130d\" } ]");
+	if (!Properties)
+		return 1;
+
+	Edif::PropertyLayouts Layouts;
+	Layouts.Make(*Properties);
+
+	const auto Find = [&](const char * Title) {
+		const auto Found = Layouts.IDs.find(Edif::PropertyLayouts::TitleKey(Title));
+		return Found == Layouts.IDs.end() ? -1 : (int)Found->second;
+	};
+
+	check(Find("speed") == 0 && Find("sPeEd") == 0, "ASCII titles are found in any case, first match wins");
+	check(Find("\xc3\x9c" "ber \xc3\x89t\xc3\xa9") == 1 && Find("\xc3\xbc" "ber \xc3\xa9t\xc3\xa9") == 2,
+		"UTF-8 titles are found byte for byte");
+	check(Find("\xc3\x9c" "BER \xc3\x89T\xc3\xa9") == 1, "ASCII letters in UTF-8 titles ignore case");
+	check(Find("\xc4\xb0" "D") == 4 && Find("id") == -1, "non-ASCII letters aren't folded to ASCII ones");
+
+	// Keys agree with _stricmp() on any bytes
+	bool Agrees = true;
+	for (int i = 0; i < 100000 && Agrees; ++i)
+	{
+		char A[4] = {}, B[4] = {};
+		for (int j = 0; j < 3; ++j)
+		{
+			A[j] = (char)(1 + Random() % 255);
+			B[j] = Random() % 2 ? A[j] : (char)(1 + Random() % 255);
+			if (Random() % 2 && A[j] >= 'a' && A[j] <= 'z')
+				B[j] = A[j] - 'a' + 'A';
+		}
+		Agrees = (Edif::PropertyLayouts::TitleKey(A) == Edif::PropertyLayouts::TitleKey(B)) == !_stricmp(A, B);
+	}
+	check(Agrees, "title keys match when _stricmp() says titles are equal");
+
+	json_value_free(Properties);
+
+	printf(failures ? "%d failed\n" : "all passed\n", failures);
+	return failures ? 1 : 0;
+}
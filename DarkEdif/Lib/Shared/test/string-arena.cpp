@@ -0,0 +1,202 @@
+// Test and benchmark for the string arena behind Runtime::CopyString (Inc/Shared/StringArena.h).
+//
+// Copies strings as a fastloop running expressions does, with no new frame loop to reset at, and
+// checks the arena's memory stays bounded while every string among the last StringsPerGeneration
+// copied still reads back. Then checks strings from before Hold() survive however many are copied
+// until Release(), including when held again inside; that long strings don't cut that short, and
+// those over MaxStringBytes are left to the caller; that a peak's memory is given back; and that
+// dedupe and conversion lookups only return what's still there. "make check-asan" runs it with
+// AddressSanitizer.
+//
+// Then times copying a short string through the arena against a heap allocation per copy, as
+// GET_STRING_SPACE_EX did.
+//
+// Usage: string-arena [copies to time, default 10000000]
+
+#include "StringArena.h"
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <deque>
+#include <string>
+#include <utility>
+
+static int failures = 0;
+
+static void check(bool passed, const char * what)
+{
+	printf("%s: %s\n", passed ? "pass" : "FAIL", what);
+
+	if (!passed)
+		++failures;
+}
+
+static const char * Copy(Edif::StringArena &Arena, const std::string &Text)
+{
+	return Arena.Copy(Text.c_str(), Text.size() + 1);
+}
+
+// Copies Count distinct strings, checking the last Keep of them all read back as copied
+static bool CopiesKept(Edif::StringArena &Arena, size_t Count, size_t Keep, size_t &MaxCapacity)
+{
+	std::deque<std::pair<const char *, std::string>> Recent;
+
+	for (size_t i = 0; i < Count; ++i)
+	{
+		std::string Text = "value " + std::to_string(i) + std::string(i % 50, 'x');
+		Recent.emplace_back(Copy(Arena, Text), std::move(Text));
+		if (Recent.size() > Keep)
+			Recent.pop_front();
+
+		// Checking every copy is slow; every so often, and at the end, is enough to catch reuse
+		if (i % 997 == 0 || i + 1 == Count)
+		{
+			for (const auto &Kept : Recent)
+				if (Kept.second != Kept.first)
+					return false;
+		}
+		MaxCapacity = std::max(MaxCapacity, Arena.Capacity());
+	}
+	return true;
+}
+
+int main(int argc, char ** argv)
+{
+	const long Copies = argc > 1 ? atol(argv[1]) : 10000000;
+	typedef Edif::StringArena Arena;
+
+	// A fastloop of expressions, with nothing to reset the arena
+	{
+		Arena Strings;
+		size_t MaxCapacity = 0;
+		check(CopiesKept(Strings, 1000000, Arena::StringsPerGeneration, MaxCapacity),
+			"1000000 copies: the last StringsPerGeneration all read back");
+		printf("  at most %zu bytes held, %zu generation moves\n", MaxCapacity, Strings.GetStats().Flips);
+		check(MaxCapacity < 2 * 1024 * 1024, "1000000 copies: memory stays bounded");
+	}
+
+	// Actions and conditions
+	{
+		Arena Strings;
+		const char * Param = Copy(Strings, "parameter");
+		size_t MaxCapacity = 0;
+
+		Strings.Hold();
+		const char * Inner = Copy(Strings, "inner parameter");
+		Strings.Hold();
+		bool Kept = CopiesKept(Strings, 50000, Arena::StringsPerGeneration, MaxCapacity);
+		Strings.Release();
+		Kept = Kept && !strcmp(Inner, "inner parameter") && !strcmp(Param, "parameter");
+		Kept = Kept && CopiesKept(Strings, 50000, Arena::StringsPerGeneration, MaxCapacity);
+		Strings.Release();
+
+		check(Kept && !strcmp(Param, "parameter"), "strings from before Hold() survive until Release(), nested");
+
+		for (int i = 0; i < 100000; ++i)
+		{
+			Strings.Hold();
+			Copy(Strings, "action " + std::to_string(i));
+			Strings.Release();
+		}
+		check(Strings.Capacity() <= MaxCapacity, "copies in many held actions are freed after each");
+		Strings.Release();
+		check(!strcmp(Param, "parameter"), "an unmatched Release() is ignored");
+	}
+
+	// Long strings, in an action
+	{
+		Arena Strings;
+		Strings.Hold();
+		const std::string Longest(Arena::MaxStringBytes - 1, 'a');
+		std::deque<std::pair<const char *, std::string>> Recent;
+		bool Kept = true;
+		for (size_t i = 0; i < Arena::StringsPerGeneration && Kept; ++i)
+		{
+			std::string Text = Longest;
+			Text[0] = (char)('A' + i % 26);
+			Text[1] = (char)('A' + i / 26 % 26);
+			Text[2] = (char)('A' + i / 676 % 26);
+			Recent.emplace_back(Copy(Strings, Text), std::move(Text));
+			if (i == 2)
+				Kept = Recent[0].first != Recent[2].first && Recent[0].second == Recent[0].first;
+		}
+		for (const auto &String : Recent)
+			Kept = Kept && String.second == String.first;
+		check(Kept, "strings of MaxStringBytes: the last StringsPerGeneration all read back");
+
+		Kept = true;
+		for (int i = 0; i < 3; ++i)
+			Kept = Kept && !Copy(Strings, std::string(4 * 1024 * 1024, (char)('x' + i)));
+		check(Kept && Strings.Capacity() < 3 * Arena::StringsPerGeneration * Arena::MaxStringBytes,
+			"strings over MaxStringBytes aren't copied, and take no arena memory");
+		check(!Strings.AddConversion("long", 4, std::string(Arena::MaxStringBytes, 'c').c_str(), Arena::MaxStringBytes + 1),
+			"conversions over MaxStringBytes aren't copied");
+		Strings.Release();
+	}
+
+	// Peaks
+	{
+		Arena Strings;
+		for (size_t i = 0; i < Arena::StringsPerGeneration; ++i)
+			Copy(Strings, std::to_string(i) + std::string(Arena::MaxStringBytes - 8, 'p'));
+		const size_t Peak = Strings.Capacity();
+		size_t MaxCapacity = 0;
+		// The peak's generation is kept as the previous one once, then shrunk when it's next reused
+		CopiesKept(Strings, 4 * Arena::StringsPerGeneration, 1, MaxCapacity);
+		printf("  %zu bytes held at the peak, %zu after\n", Peak, Strings.Capacity());
+		check(Strings.Capacity() < Peak / 8, "memory from a peak is given back");
+	}
+
+	// Dedupe and conversions
+	{
+		Arena Strings;
+		const char * First = Copy(Strings, "same");
+		check(Copy(Strings, "same") == First && Copy(Strings, "other") != First, "identical strings share a copy");
+
+		char Source[] = "caf\xc3\xa9";
+		const char * Converted = Strings.AddConversion(Source, 5, "CAFE", 5);
+		check(Strings.FindConversion(Source, 5) == Converted, "a conversion is found again");
+		Source[0] = 'C';
+		check(!Strings.FindConversion(Source, 5), "a conversion isn't found once its source text changes");
+
+		Source[0] = 'c';
+		size_t MaxCapacity = 0;
+		CopiesKept(Strings, 2 * Arena::StringsPerGeneration, 1, MaxCapacity);
+		check(!Strings.FindConversion(Source, 5) && Copy(Strings, "same") != First,
+			"lookups don't return strings from a reused generation");
+	}
+
+	// Timing; not checked, as it depends on the machine
+	const std::string Text = "Received message text";
+	Arena Strings;
+	const char * volatile Sink;
+
+	const auto Start = std::chrono::steady_clock::now();
+	for (long i = 0; i < Copies; ++i)
+	{
+		char * Heap = (char *)malloc(Text.size() + 1);
+		memcpy(Heap, Text.c_str(), Text.size() + 1);
+		Sink = Heap;
+		free(Heap);
+	}
+	const auto Middle = std::chrono::steady_clock::now();
+	for (long i = 0; i < Copies; ++i)
+		Sink = Copy(Strings, Text);
+	const auto Middle2 = std::chrono::steady_clock::now();
+	std::string Varied = Text;
+	for (long i = 0; i < Copies; ++i)
+	{
+		Varied[0] = (char)('A' + i % 26);
+		Sink = Copy(Strings, Varied);
+	}
+	const auto End = std::chrono::steady_clock::now();
+	(void)Sink;
+
+	const std::chrono::duration<double, std::nano> Heap = Middle - Start, Same = Middle2 - Middle, Distinct = End - Middle2;
+	printf("  %ld copies of a %zu byte string: %.1f ns by heap, %.1f ns by arena, %.1f ns by arena with 26 strings\n",
+		Copies, Text.size(), Heap.count() / Copies, Same.count() / Copies, Distinct.count() / Copies);
+
+	printf(failures ? "%d failed\n" : "all passed\n", failures);
+	return failures ? 1 : 0;
+}
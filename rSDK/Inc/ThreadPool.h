@@ -0,0 +1,78 @@
+// Include guard
+#ifndef THREADPOOL_H
+#define THREADPOOL_H
+
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+// Fixed set of worker threads running tasks from a queue, shared by the extensions that run jobs
+// off the main thread (ZlibStream's compression, UnzipMe's extraction).
+// Workers sleep on a condition variable while the queue is empty.
+class ThreadPool
+{
+public:
+	ThreadPool(unsigned int threadCount) : stop(false)
+	{
+		if (threadCount < 1)
+			threadCount = 1;
+		threads.reserve(threadCount);
+		for (unsigned int i = 0; i < threadCount; ++i)
+			threads.emplace_back(&ThreadPool::WorkerLoop, this);
+	}
+
+	// Drops tasks that haven't started, and waits for running ones to finish
+	~ThreadPool()
+	{
+		{
+			std::lock_guard<std::mutex> guard(lock);
+			stop = true;
+			tasks.clear();
+		}
+		wake.notify_all();
+
+		for (std::thread &thread : threads)
+			thread.join();
+	}
+
+	void Submit(std::function<void()> task)
+	{
+		{
+			std::lock_guard<std::mutex> guard(lock);
+			tasks.push_back(std::move(task));
+		}
+		wake.notify_one();
+	}
+
+	unsigned int ThreadCount() const { return (unsigned int)threads.size(); }
+
+private:
+	std::mutex lock;
+	std::condition_variable wake;
+	std::deque<std::function<void()>> tasks;
+	std::vector<std::thread> threads;
+	bool stop;
+
+	void WorkerLoop()
+	{
+		while (true)
+		{
+			std::function<void()> task;
+			{
+				std::unique_lock<std::mutex> guard(lock);
+				wake.wait(guard, [this] { return stop || !tasks.empty(); });
+				if (stop)
+					return;
+				task = std::move(tasks.front());
+				tasks.pop_front();
+			}
+			task();
+		}
+	}
+};
+
+// End include guard
+#endif
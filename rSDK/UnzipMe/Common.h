@@ -7,17 +7,31 @@
 // General includes
 #include "TemplateInc.h"
 
+//String
+#include	<string>
+#include	<sstream>
+using namespace std;
+
+//Extraction
+#include	<atomic>
+#include	<condition_variable>
+#include	<deque>
+#include	<memory>
+#include	<mutex>
+#include	<thread>
+#include	<vector>
+#include	"ThreadPool.h"
+
+//Index
+#include	<unordered_map>
+#include	"ZipIndex.h"
+
 // Specific to this extension
 #include "Resource.h"
 #include "FlagsPrefs.h"
 #include "Information.h"
 #include "Data.h"
 
-//String
-#include	<string>
-#include	<sstream>
-using namespace std;
-
 // rTemplate include
 #include "rTemplate.h"
 
@@ -7,12 +7,71 @@ typedef rRundata * LPRRDATA;
 // If you want to store anything between actions/conditions/expressions
 // you should store it here
 
+// An archive being extracted. Shared by the coordinator thread, the workers unzipping its entries,
+// and the expressions reading its progress.
+struct Extraction
+{
+	string infilename;						// Input archive
+	string outfolder;						// Folder to extract to
+	string password;						// Empty if none
+	string include;							// Filters, as set when the extraction began
+	string exclude;
+	std::atomic<unsigned __int64> done;		// Uncompressed bytes extracted so far
+	std::atomic<unsigned __int64> total;	// Uncompressed size of the selected entries, 0 until the directory is read
+	std::atomic<int> filesDone;				// Entries extracted so far
+	std::atomic<int> filesTotal;			// Entries selected by the filters
+	std::atomic<bool> passwordUsed;			// Set if any entry needed the password
+	std::atomic<bool> cancel;				// Set to stop the extraction early
+
+	// Guards the rest; the workers update them as each entry finishes
+	std::mutex lock;
+	string lastFile;						// Name of the last entry extracted
+	string error;							// First error, empty on success
+
+	Extraction() : done(0), total(0), filesDone(0), filesTotal(0), passwordUsed(false), cancel(false) {}
+};
+
+// Result of a finished extraction, passed back to the Fusion thread to run its event
+struct ExtractionResult
+{
+	bool success;
+	string message;				// Error, empty on success
+	string lastFile;
+	bool passwordUsed;
+	int files;
+	int filesSelected;
+};
+
 typedef struct tagRDATA
 {
 	#include "MagicRDATA.h"
 
+	string returnstring;		// Last error
+	string LastFileExtracted;	// Last entry extracted
+	bool PasswordBeingUsed;		// Whether the last extraction needed the password
+	int NumberOfFilesExtracted;	// Entries extracted by the last extraction
+	int NumberOfFilesSelected;	// Entries the filters selected in the last extraction
+	string include;				// ';'-separated wildcards for new extractions; empty selects everything
+	string exclude;				// ';'-separated wildcards for new extractions; empty excludes nothing
+
+	// Only results is shared with the coordinator thread; lock resultLock to access it.
+	// The rest is only touched by the Fusion thread.
+	std::mutex resultLock;
+	std::deque<ExtractionResult> results;		// Finished extractions, waiting for their event
+	std::shared_ptr<Extraction> extraction;		// Current extraction, null if none
+	std::thread coordinator;					// Reads the directory and waits for the entries of the current extraction
+	ThreadPool * pool;							// Created with the first extraction
 
+	ZipIndex index;				// Archive opened for reading entries to memory
+	const char * entryData;		// Last entry read; points into index, so is only valid until the next read or close
+	size_t entrySize;
 
+	tagRDATA() : returnstring(""), LastFileExtracted(""), PasswordBeingUsed(false), NumberOfFilesExtracted(0), NumberOfFilesSelected(0), pool(NULL), entryData(NULL), entrySize(0) // Constructor
+	{
+		//vars initialized above in the initializer list
+	}
+	//functions
+	~tagRDATA(){} // Destructor
 } RUNDATA;
 typedef	RUNDATA	* LPRDATA;
 
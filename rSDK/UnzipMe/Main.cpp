@@ -8,116 +8,244 @@
 #include "unzip.h"
 // ============================================================================
 //
-// GLOBAL VARIABLES
+// EXTRACTION
 //
 // ============================================================================
-string returnstring = "";
-TCHAR * LastFileExtracted = "";
-bool NoCurrentCompression = true, PasswordBeingUsed = false;
-int NumberOfFilesExtracted = 0;
-HANDLE MainThread;
-//Define struct used to export data from actions to threads
-typedef struct Parameters {
-	char *para_infilename;		//Input file name
-	char *para_outfilename;		//Output file name
-	char *para_password;		//Password
-	LPRDATA para_rdPtr;			//rdPtr (must be given or threads cannot access rdPtr)
-} MYDATA, *PMYDATA;
 
-// ============================================================================
-//
-// THREADS
-//
-// ============================================================================
-
-DWORD WINAPI decompress(LPVOID lpParam)
+// Matches name against a wildcard pattern, ignoring case; * matches any run of characters,
+// ? matches one. / and \ match each other, so either can be used as the folder separator.
+static bool WildcardMatch(const char * pattern, const char * patternEnd, const char * name)
 {
-	//Open struct and set variables
-	PMYDATA pDataArray = (PMYDATA)lpParam;				//Open the struct
-	char *infilename = pDataArray -> para_infilename;	//Get input file name
-	char *outfilename = pDataArray -> para_outfilename;	//Get output file name
-	char *password = pDataArray -> para_password;		//Get password
-	LPRDATA rdPtr = pDataArray -> para_rdPtr;			//Get rdPtr
-
-	//Set non-struct variables & begin extraction
-	HZIP hz = OpenZip(infilename,0); // 0 = no password
-	SetUnzipBaseDir(hz,outfilename); // Set the extract-to folder
-	ZIPENTRY baseze;
-	ZRESULT zr = GetZipItem(hz,-1,&baseze); // ZRESULT zr contains error number.
-
-	//This part may get complicated.
-	//No error with no password, so just extract
-	for (int zi=0; zi<baseze.index; zi++)
+	const char * starPattern = NULL, * starName = NULL;
+	while (*name)
 	{
-		ZIPENTRY ze;
-		GetZipItem(hz,zi,&ze);			// fetch individual details
-		zr=UnzipItem(hz, zi, ze.name);	// e.g. the item's name.
+		if (pattern != patternEnd && *pattern == '*')
+		{
+			// Remember where the star was; on a mismatch, let it eat one more character
+			starPattern = ++pattern;
+			starName = name;
+			continue;
+		}
+		if (pattern != patternEnd &&
+			(*pattern == '?' || tolower((unsigned char)*pattern) == tolower((unsigned char)*name) ||
+			((*pattern == '/' || *pattern == '\\') && (*name == '/' || *name == '\\'))))
+		{
+			++pattern;
+			++name;
+			continue;
+		}
+		if (!starPattern)
+			return false;
+		pattern = starPattern;
+		name = ++starName;
 	}
-	CloseZip(hz);
-	if (zr==ZR_OK)
+	while (pattern != patternEnd && *pattern == '*')
+		++pattern;
+	return pattern == patternEnd;
+}
+
+// Matches name against a ';'-separated list of wildcard patterns
+static bool FilterMatch(const string &filter, const char * name)
+{
+	const char * pattern = filter.c_str();
+	while (*pattern)
 	{
-		rdPtr->rRd->PushEvent(0);
-		NoCurrentCompression=true;
-		PasswordBeingUsed=false;
+		const char * patternEnd = strchr(pattern, ';');
+		if (!patternEnd)
+			patternEnd = pattern + strlen(pattern);
+		if (patternEnd != pattern && WildcardMatch(pattern, patternEnd, name))
+			return true;
+		pattern = *patternEnd ? patternEnd + 1 : patternEnd;
 	}
-	else
-	{ // Error occured when extracting with no password
-		if (zr==ZR_PASSWORD&&password!="0")
-		{ // ZR_PASSWORD -> invalid password. So try with password, if one is provided.
-			zr = ZR_OK;
-			CloseZip(hz);
-			hz = OpenZip(infilename,password);
-			GetZipItem(hz,-1,&baseze);
-			NumberOfFilesExtracted=baseze.index;
-			MessageBox(NULL,"zr==ZR_PASSWORD&&password!=\"0\"", "Debug", NULL);
-			PasswordBeingUsed=true;
-
-			//No error when extracting with given password, so just extract.
-			for (int zi=0; zi<baseze.index; zi++)
-			{	//I Can Haz Stallage
-				ZIPENTRY ze;
-				GetZipItem(hz,zi,&ze);			// fetch individual details
-				zr=UnzipItem(hz, zi, ze.name);	// e.g. the item's name.
-			}
-			CloseZip(hz);
-			NoCurrentCompression=true;
-			if (zr==ZR_OK)
-			{
-				rdPtr->rRd->PushEvent(0);
-				MessageBox(NULL,"zr==ZR_PASSWORD&&password!=\"0\" > zr==ZR_OK", "Debug", NULL);
-			}
-			else
+	return false;
+}
+
+static string ZipMessage(ZRESULT zr)
+{
+	TCHAR message[256];
+	FormatZipMessage(zr, message, sizeof(message) / sizeof(*message));
+	return message;
+}
+
+// An entry selected for extraction, as read from the central directory
+struct EntryRef
+{
+	int index;
+	unsigned long pos;		// Position of its central directory record, for GoToZipItem()
+	string name;
+	unsigned __int64 size;	// Uncompressed size
+};
+
+// Each worker unzips with its own handles, as an HZIP can only read one entry at a time.
+// The password handle is only opened if an entry turns out to need it.
+struct HandleSlot
+{
+	HZIP plain;
+	HZIP withPassword;
+};
+
+// State shared by the coordinator and the entry tasks of one extraction
+struct ExtractionContext
+{
+	std::shared_ptr<Extraction> ext;
+	std::vector<EntryRef> entries;
+	std::atomic<bool> failed;
+
+	// Guards the rest
+	std::mutex lock;
+	std::condition_variable finished;
+	size_t remaining;
+	std::vector<HandleSlot> freeSlots;	// Handles not in use; all slots are in here once remaining is 0
+
+	ExtractionContext() : failed(false), remaining(0) {}
+};
+
+static void Fail(ExtractionContext &ctx, const string &message)
+{
+	std::lock_guard<std::mutex> lock(ctx.ext->lock);
+	if (ctx.ext->error.empty())
+		ctx.ext->error = message;
+	ctx.failed = true;
+}
+
+static HZIP OpenForExtraction(const Extraction &ext, const char * password)
+{
+	HZIP hz = OpenZip(ext.infilename.c_str(), password);
+	if (hz)
+		SetUnzipBaseDir(hz, ext.outfolder.c_str());
+	return hz;
+}
+
+// Runs on a worker thread; unzips one entry
+static void ExtractEntry(ExtractionContext &ctx, const EntryRef &entry)
+{
+	Extraction &ext = *ctx.ext;
+	if (!ext.cancel && !ctx.failed)
+	{
+		HandleSlot slot = { 0, 0 };
+		{
+			std::lock_guard<std::mutex> lock(ctx.lock);
+			if (!ctx.freeSlots.empty())
 			{
-				if (zr==ZR_PASSWORD)
-				{ // The password provided was wrong, so report it.
-					returnstring="Password incorrect or required.";
-					MessageBox(NULL,"zr==ZR_PASSWORD&&password!=\"0\" > zr==ZR_PASSWORD", "Debug", NULL);
-					rdPtr->rRd->PushEvent(1);
-				}
-				else
-				{ // Password was correct but error occured anyway
-					MessageBox(NULL,"zr==ZR_PASSWORD&&password!=\"0\" > zr!=ZR_PASSWORD", "Debug", NULL);
-					stringstream temp;
-					temp<<"An error occured, but the provided password was correct. Error number "<<zr<<".";
-					returnstring=temp.str();
-					NoCurrentCompression=true;
-					rdPtr->rRd->PushEvent(1);
-				}
+				slot = ctx.freeSlots.back();
+				ctx.freeSlots.pop_back();
 			}
 		}
-		else
-		{ // Not a password error when we tried to open without a password...
-			stringstream temp;
-			temp<<"An error occured - not a password error. Error number "<<zr<<".";
-			returnstring=temp.str();
-			NoCurrentCompression=true;
-			rdPtr->rRd->PushEvent(1);
+		if (!slot.plain)
+			slot.plain = OpenForExtraction(ext, 0);
+
+		ZRESULT zr = ZR_NOFILE;
+		if (slot.plain)
+		{
+			zr = GoToZipItem(slot.plain, entry.index, entry.pos);
+			if (zr == ZR_OK)
+				zr = UnzipItem(slot.plain, entry.index, entry.name.c_str());
+		}
+
+		// Encrypted entry; try again with the password, if one is provided
+		if (zr == ZR_PASSWORD && !ext.password.empty())
+		{
+			if (!slot.withPassword)
+				slot.withPassword = OpenForExtraction(ext, ext.password.c_str());
+			zr = slot.withPassword ? GoToZipItem(slot.withPassword, entry.index, entry.pos) : ZR_NOFILE;
+			if (zr == ZR_OK)
+				zr = UnzipItem(slot.withPassword, entry.index, entry.name.c_str());
+			if (zr == ZR_OK)
+				ext.passwordUsed = true;
+		}
+
+		if (zr == ZR_OK)
+		{
+			ext.done += entry.size;
+			++ext.filesDone;
+			std::lock_guard<std::mutex> lock(ext.lock);
+			ext.lastFile = entry.name;
 		}
+		else if (zr == ZR_PASSWORD)
+			Fail(ctx, "Password incorrect or required.");
+		else
+			Fail(ctx, "Couldn't extract \"" + entry.name + "\": " + ZipMessage(zr) + ".");
+
+		std::lock_guard<std::mutex> lock(ctx.lock);
+		ctx.freeSlots.push_back(slot);
 	}
-	//FormatZipMessage(zr,LastFileExtracted,sizeof(LastFileExtracted));
-	return 0;
+
+	std::lock_guard<std::mutex> lock(ctx.lock);
+	if (--ctx.remaining == 0)
+		ctx.finished.notify_one();
 }
 
+// Runs on the coordinator thread: reads the central directory once, then unzips the selected
+// entries on the worker pool, and waits for them. It isn't a pool task itself, so it can't
+// take a worker its entries need.
+static void Extract(LPRDATA rdPtr, ThreadPool * pool, std::shared_ptr<Extraction> ext)
+{
+	ExtractionContext ctx;
+	ctx.ext = ext;
+
+	HZIP hz = OpenForExtraction(*ext, 0);
+	if (!hz)
+		Fail(ctx, "Couldn't open archive: " + ZipMessage(ZR_RECENT) + ".");
+	else
+	{
+		ZIPENTRY ze;
+		ZRESULT zr = GetZipItem(hz, -1, &ze);
+		const int count = zr == ZR_OK ? ze.index : 0;
+
+		// Entries are read in order, so each GetZipItem() only steps one record along
+		unsigned __int64 total = 0;
+		for (int i = 0; i < count && zr == ZR_OK && !ext->cancel; ++i)
+		{
+			zr = GetZipItem(hz, i, &ze);
+			if (zr != ZR_OK)
+				break;
+			if (!ext->include.empty() && !FilterMatch(ext->include, ze.name))
+				continue;
+			if (FilterMatch(ext->exclude, ze.name))
+				continue;
+
+			EntryRef entry = { i, 0, ze.name, (unsigned long)ze.unc_size };
+			zr = GetZipItemPos(hz, i, &entry.pos);
+			total += entry.size;
+			ctx.entries.push_back(std::move(entry));
+		}
+		if (zr != ZR_OK)
+			Fail(ctx, "Couldn't read archive: " + ZipMessage(zr) + ".");
+
+		ext->total = total;
+		ext->filesTotal = (int)ctx.entries.size();
+		ctx.freeSlots.push_back({ hz, 0 });
+	}
+
+	if (!ctx.failed && !ext->cancel && !ctx.entries.empty())
+	{
+		ctx.remaining = ctx.entries.size();
+		for (const EntryRef &entry : ctx.entries)
+			pool->Submit([&ctx, &entry] { ExtractEntry(ctx, entry); });
+
+		std::unique_lock<std::mutex> lock(ctx.lock);
+		ctx.finished.wait(lock, [&ctx] { return ctx.remaining == 0; });
+	}
+
+	for (HandleSlot &slot : ctx.freeSlots)
+	{
+		if (slot.plain)
+			CloseZip(slot.plain);
+		if (slot.withPassword)
+			CloseZip(slot.withPassword);
+	}
+
+	ExtractionResult result;
+	result.success = !ctx.failed && !ext->cancel;
+	result.message = ext->cancel && !ctx.failed ? "Extraction cancelled." : ext->error;
+	result.lastFile = ext->lastFile;
+	result.passwordUsed = ext->passwordUsed;
+	result.files = ext->filesDone;
+	result.filesSelected = ext->filesTotal;
+
+	std::lock_guard<std::mutex> lock(rdPtr->resultLock);
+	rdPtr->results.push_back(std::move(result));
+}
 
 // ============================================================================
 //
@@ -143,6 +271,17 @@ CONDITION(
 	return true;
 }
 
+CONDITION(
+	/* ID */			2,
+	/* Name */			"%o: Entry %0 is in the index",
+	/* Flags */			EVFLAGS_ALWAYS|EVFLAGS_NOTABLE,
+	/* Params */		(1,PARAM_STRING,"Path in archive:")
+) {
+	char * p1=(char *)Param(TYPE_STRING);
+
+	return rdPtr->index.Find(p1) != NULL;
+}
+
 // ============================================================================
 //
 // ACTIONS
@@ -157,33 +296,126 @@ ACTION(
 						PARAM_STRING, "Output file:",
 						PARAM_STRING, "Password: (use \"0\" for none)")
 ) {
-	if (NoCurrentCompression)
+	char * p1=(char *)Param(TYPE_STRING);
+	char * p2=(char *)Param(TYPE_STRING);
+	char * p3=(char *)Param(TYPE_STRING);
+
+	//Only one extraction each time; its entries are already extracted in parallel.
+	if (rdPtr->extraction)
 	{
-		//Retrieve variables from parameters
-		char * p1=(char *)Param(TYPE_STRING);
-		char * p2=(char *)Param(TYPE_STRING);
-		char * p3=(char *)Param(TYPE_STRING);
-
-		//Reset old variables
-		returnstring="";
-		PasswordBeingUsed=false;
-		LastFileExtracted="";
-
-		//Declare struct and set variables in struct
-		PMYDATA Parameters = new MYDATA;	//Declaration
-		Parameters->para_infilename=p1;		//Pass the input archive name
-		Parameters->para_outfilename=p2;	//Pass the output folder name
-		Parameters->para_password=p3;		//Pass the password
-		Parameters->para_rdPtr=rdPtr;		//Pass rdPtr
-
-		//Create thread
-		MainThread=CreateThread(NULL, 0, decompress, Parameters, 0, NULL);
-	}
-	else
-	{	//Only one decompression each time.
-		returnstring = "Extraction already in progress.";
+		rdPtr->returnstring = "Extraction already in progress.";
 		rdPtr->rRd->PushEvent(1);
+		return;
 	}
+
+	//Reset old variables
+	rdPtr->returnstring="";
+	rdPtr->PasswordBeingUsed=false;
+	rdPtr->LastFileExtracted="";
+	rdPtr->NumberOfFilesExtracted=0;
+	rdPtr->NumberOfFilesSelected=0;
+
+	std::shared_ptr<Extraction> ext = std::make_shared<Extraction>();
+	ext->infilename = p1;
+	ext->outfolder = p2;
+	if (strcmp(p3, "0"))
+		ext->password = p3;
+	ext->include = rdPtr->include;
+	ext->exclude = rdPtr->exclude;
+
+	// Small entries spend most of their time creating files rather than inflating,
+	// so use two workers per core
+	if (!rdPtr->pool)
+		rdPtr->pool = new ThreadPool(std::thread::hardware_concurrency() * 2);
+
+	rdPtr->extraction = ext;
+	rdPtr->coordinator = std::thread(Extract, rdPtr, rdPtr->pool, ext);
+	rdPtr->rRd->Rehandle(); // Wait for the result in HandleRunObject
+}
+
+ACTION(
+	/* ID */		1,
+	/* Name */		"Set include filter to (%0)",
+	/* Flags */		0,
+	/* Params */	(1, PARAM_STRING, "Entries to extract, as wildcards separated by ';', e.g. \"*.png;sounds/*\" (empty for all):")
+) {
+	rdPtr->include = (char *)Param(TYPE_STRING);
+}
+
+ACTION(
+	/* ID */		2,
+	/* Name */		"Set exclude filter to (%0)",
+	/* Flags */		0,
+	/* Params */	(1, PARAM_STRING, "Entries to skip, as wildcards separated by ';', e.g. \"*.txt\" (empty for none):")
+) {
+	rdPtr->exclude = (char *)Param(TYPE_STRING);
+}
+
+ACTION(
+	/* ID */		3,
+	/* Name */		"Cancel extraction",
+	/* Flags */		0,
+	/* Params */	(0)
+) {
+	// Entries being unzipped are finished; the rest are skipped, and On error runs
+	if (rdPtr->extraction)
+		rdPtr->extraction->cancel = true;
+}
+
+ACTION(
+	/* ID */		4,
+	/* Name */		"Open archive index (%0)",
+	/* Flags */		0,
+	/* Params */	(1, PARAM_FILENAME, "Input file:")
+) {
+	char * p1=(char *)Param(TYPE_STRING);
+
+	// The last entry read points into the old archive
+	rdPtr->entryData = NULL;
+	rdPtr->entrySize = 0;
+
+	// The archive stays mapped, and its directory in memory, until closed or reopened
+	string error;
+	if (!rdPtr->index.Open(p1, error))
+	{
+		rdPtr->returnstring = error;
+		rdPtr->rRd->GenerateEvent(1);
+	}
+}
+
+ACTION(
+	/* ID */		5,
+	/* Name */		"Close archive index",
+	/* Flags */		0,
+	/* Params */	(0)
+) {
+	rdPtr->index.Close();
+	rdPtr->entryData = NULL;
+	rdPtr->entrySize = 0;
+}
+
+ACTION(
+	/* ID */		6,
+	/* Name */		"Read entry (%0) to memory",
+	/* Flags */		0,
+	/* Params */	(1, PARAM_STRING, "Path in archive (case is ignored, / and \\ are alike):")
+) {
+	char * p1=(char *)Param(TYPE_STRING);
+
+	rdPtr->entryData = NULL;
+	rdPtr->entrySize = 0;
+
+	string error;
+	const ZipIndex::Entry * entry = rdPtr->index.Find(p1);
+	if (!rdPtr->index.IsOpen())
+		error = "No archive index is open.";
+	else if (!entry)
+		error = string("Entry \"") + p1 + "\" is not in the archive.";
+	else if (rdPtr->index.Read(*entry, rdPtr->entryData, rdPtr->entrySize, error))
+		return;
+
+	rdPtr->returnstring = error;
+	rdPtr->rRd->GenerateEvent(1);
 }
 
 // ============================================================================
@@ -198,7 +430,12 @@ EXPRESSION(
 	/* Flags */			EXPFLAG_STRING,
 	/* Params */		(0)
 ) {
-	ReturnString(LastFileExtracted);
+	if (rdPtr->extraction)
+	{
+		std::lock_guard<std::mutex> lock(rdPtr->extraction->lock);
+		rdPtr->LastFileExtracted = rdPtr->extraction->lastFile;
+	}
+	ReturnStringSafe(rdPtr->LastFileExtracted.c_str());
 }
 
 EXPRESSION(
@@ -207,7 +444,7 @@ EXPRESSION(
 	/* Flags */			0,
 	/* Params */		(0)
 ) {
-	return PasswordBeingUsed;
+	return rdPtr->extraction ? rdPtr->extraction->passwordUsed.load() : rdPtr->PasswordBeingUsed;
 }
 
 EXPRESSION(
@@ -216,7 +453,7 @@ EXPRESSION(
 	/* Flags */			EXPFLAG_STRING,
 	/* Params */		(0)
 ) {
-	ReturnString(returnstring.c_str());
+	ReturnStringSafe(rdPtr->returnstring.c_str());
 }
 
 EXPRESSION(
@@ -225,5 +462,79 @@ EXPRESSION(
 	/* Flags */			0,
 	/* Params */		(0)
 ) {
-	return NumberOfFilesExtracted;
+	return rdPtr->extraction ? rdPtr->extraction->filesDone.load() : rdPtr->NumberOfFilesExtracted;
+}
+
+EXPRESSION(
+	/* ID */			4,
+	/* Name */			"Progress(",
+	/* Flags */			EXPFLAG_DOUBLE,
+	/* Params */		(0)
+) {
+	// Percentage of the selected entries' uncompressed bytes; -1 if not extracting
+	float progress = -1.0f;
+	if (rdPtr->extraction)
+	{
+		const Extraction &ext = *rdPtr->extraction;
+		const unsigned __int64 total = ext.total;
+		const int filesTotal = ext.filesTotal;
+		if (total)
+			progress = (float)((ext.done * 100.0) / total);
+		else if (filesTotal) // Only empty files and folders
+			progress = (float)((ext.filesDone * 100.0) / filesTotal);
+		else
+			progress = 0.0f;
+	}
+	ReturnFloat(progress);
+}
+
+EXPRESSION(
+	/* ID */			5,
+	/* Name */			"SelectedFileCount(",
+	/* Flags */			0,
+	/* Params */		(0)
+) {
+	return rdPtr->extraction ? rdPtr->extraction->filesTotal.load() : rdPtr->NumberOfFilesSelected;
+}
+
+EXPRESSION(
+	/* ID */			6,
+	/* Name */			"EntryAddress(",
+	/* Flags */			0,
+	/* Params */		(0)
+) {
+	// Stored entries are read without a copy, so this points into the mapped archive; don't write to it
+	return (long)rdPtr->entryData;
+}
+
+EXPRESSION(
+	/* ID */			7,
+	/* Name */			"EntrySize(",
+	/* Flags */			0,
+	/* Params */		(0)
+) {
+	return (long)rdPtr->entrySize;
+}
+
+EXPRESSION(
+	/* ID */			8,
+	/* Name */			"EntryText$(",
+	/* Flags */			EXPFLAG_STRING,
+	/* Params */		(0)
+) {
+	// Entries aren't null-terminated, so copy to string space with one added
+	TCHAR * text = rdPtr->rRd->GetStringSpace(rdPtr->entrySize + 1);
+	if (rdPtr->entrySize)
+		memcpy(text, rdPtr->entryData, rdPtr->entrySize);
+	text[rdPtr->entrySize] = 0;
+	ReturnString(text);
+}
+
+EXPRESSION(
+	/* ID */			9,
+	/* Name */			"IndexFileCount(",
+	/* Flags */			0,
+	/* Params */		(0)
+) {
+	return (long)rdPtr->index.Count();
 }
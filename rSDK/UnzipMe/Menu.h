@@ -6,6 +6,8 @@
 
 	ITEM(0, "On completion")
 	ITEM(1, "On error")
+	SEPARATOR
+	ITEM(2, "Entry is in the index")
 
 #endif
 
@@ -16,7 +18,14 @@
 #ifdef ACTION_MENU
 
 	ITEM(0, "Unzip archive")
+	ITEM(3, "Cancel extraction")
+	SEPARATOR
+	ITEM(1, "Set include filter")
+	ITEM(2, "Set exclude filter")
 	SEPARATOR
+	ITEM(4, "Open archive index")
+	ITEM(6, "Read entry to memory")
+	ITEM(5, "Close archive index")
 
 #endif
 
@@ -32,5 +41,12 @@
 	ITEM(1,"Was password used?")
 	ITEM(2,"Last error string")
 	ITEM(3,"Number of files extracted")
+	ITEM(5,"Number of files selected by filters")
+	ITEM(4,"Progress (%)")
+	SEPARATOR
+	ITEM(6,"Entry address")
+	ITEM(7,"Entry size")
+	ITEM(8,"Entry as text")
+	ITEM(9,"Number of entries in index")
 
 #endif
\ No newline at end of file
@@ -26,6 +26,7 @@ short WINAPI DLLExport GetRunObjectDataSize(fprh rhPtr, LPEDATA edPtr)
 short WINAPI DLLExport CreateRunObject(LPRDATA rdPtr, LPEDATA edPtr, fpcob cobPtr)
 {
 	// Do some rSDK stuff
+	new (rdPtr) RUNDATA; // Call rdPtr's Constructor
 	#include "rCreateRunObject.h"
 
 	/*
@@ -47,19 +48,23 @@ short WINAPI DLLExport CreateRunObject(LPRDATA rdPtr, LPEDATA edPtr, fpcob cobPt
 // ----------------
 // Destroys the run-time object
 //
-extern HANDLE MainThread;
-extern bool NoCurrentCompression;
 short WINAPI DLLExport DestroyRunObject(LPRDATA rdPtr, long fast)
 {
-	if (NoCurrentCompression==true)
-		TerminateThread(MainThread,0);
 /*
 	When your object is destroyed (either with a Destroy action or at the end of
 	the frame) this routine is called. You must free any resources you have allocated!
 	See Graphic_Object_Ex.txt for an example of what you may put here.
 */
+	// Stop the extraction: entries being unzipped are finished, the rest are skipped
+	if (rdPtr->extraction)
+		rdPtr->extraction->cancel = true;
+	if (rdPtr->coordinator.joinable())
+		rdPtr->coordinator.join();
+	delete rdPtr->pool; // After the coordinator, as it waits on entries in the pool
+
 	// No errors
 	delete rdPtr->rRd;
+	rdPtr->~RUNDATA();
 	return 0;
 }
 
@@ -71,6 +76,31 @@ short WINAPI DLLExport DestroyRunObject(LPRDATA rdPtr, long fast)
 //
 short WINAPI DLLExport HandleRunObject(LPRDATA rdPtr)
 {
+	// Run the event of a finished extraction
+	ExtractionResult result;
+	bool finished = false;
+	{
+		std::lock_guard<std::mutex> lock(rdPtr->resultLock);
+		if (!rdPtr->results.empty())
+		{
+			result = std::move(rdPtr->results.front());
+			rdPtr->results.pop_front();
+			finished = true;
+		}
+	}
+	if (finished)
+	{
+		rdPtr->coordinator.join(); // Already pushed its result, so it's returning
+		rdPtr->extraction = nullptr;
+
+		rdPtr->returnstring = result.message;
+		rdPtr->LastFileExtracted = result.lastFile;
+		rdPtr->PasswordBeingUsed = result.passwordUsed;
+		rdPtr->NumberOfFilesExtracted = result.files;
+		rdPtr->NumberOfFilesSelected = result.filesSelected;
+		rdPtr->rRd->GenerateEvent(result.success ? 0 : 1);
+	}
+
 /*
 	If your extension will draw to the MMF window you should first
 	check if anything about its display has changed :
@@ -96,8 +126,8 @@ short WINAPI DLLExport HandleRunObject(LPRDATA rdPtr)
 
 	At the end of the loop this code will run
 */
-	// Will not be called next loop
-	return REFLAG_ONESHOT;
+	// Keep checking for the result while extracting
+	return rdPtr->extraction ? 0 : REFLAG_ONESHOT;
 }
 
 // ----------------
@@ -0,0 +1,257 @@
+// ============================================================================
+//
+// This file contains the zip index that reads entries to memory
+//
+// ============================================================================
+#include "common.h"
+#include "..\Inc\zlib.h"
+#pragma comment (lib, "..\\Lib\\zlib.lib")
+
+// Zip fields are little-endian, and not necessarily aligned
+static unsigned int Get16(const unsigned char * p)
+{
+	return p[0] | (p[1] << 8);
+}
+static unsigned int Get32(const unsigned char * p)
+{
+	return p[0] | (p[1] << 8) | (p[2] << 16) | ((unsigned int)p[3] << 24);
+}
+
+ZipIndex::ZipIndex() : view(NULL), viewSize(0), bufferSize(0)
+{
+}
+
+ZipIndex::~ZipIndex()
+{
+	Close();
+}
+
+std::string ZipIndex::Key(const char * name, size_t length)
+{
+	std::string key(name, length);
+	for (char &c : key)
+		c = c == '\\' ? '/' : (char)tolower((unsigned char)c);
+	return key;
+}
+
+bool ZipIndex::Open(const char * filename, std::string &error)
+{
+	Close();
+
+	HANDLE file = CreateFileA(filename, GENERIC_READ, FILE_SHARE_READ, NULL, OPEN_EXISTING, FILE_FLAG_RANDOM_ACCESS, NULL);
+	if (file == INVALID_HANDLE_VALUE)
+	{
+		error = "Couldn't open archive.";
+		return false;
+	}
+	LARGE_INTEGER fileSize;
+	if (!GetFileSizeEx(file, &fileSize) || fileSize.QuadPart < 22 || (unsigned __int64)fileSize.QuadPart > (size_t)-1)
+	{
+		CloseHandle(file);
+		error = "Archive is empty, or too large to map.";
+		return false;
+	}
+
+	// The view keeps the mapping, and the mapping the file, open until unmapped
+	HANDLE mapping = CreateFileMapping(file, NULL, PAGE_READONLY, 0, 0, NULL);
+	CloseHandle(file);
+	if (mapping)
+	{
+		view = (const unsigned char *)MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0);
+		CloseHandle(mapping);
+	}
+	if (!view)
+	{
+		error = "Couldn't map archive into memory.";
+		return false;
+	}
+	viewSize = (size_t)fileSize.QuadPart;
+
+	// End of central directory record; the last one in the file, before the archive comment
+	const unsigned char * eocd = NULL;
+	const size_t searchEnd = viewSize > 22 + 0xFFFF ? viewSize - 22 - 0xFFFF : 0;
+	for (size_t pos = viewSize - 22; ; --pos)
+	{
+		if (Get32(view + pos) == 0x06054b50)
+		{
+			eocd = view + pos;
+			break;
+		}
+		if (pos == searchEnd)
+			break;
+	}
+	if (!eocd)
+	{
+		Close();
+		error = "Not a zip archive.";
+		return false;
+	}
+
+	const unsigned int count = Get16(eocd + 10);
+	const unsigned int directorySize = Get32(eocd + 12);
+	const unsigned int directoryOffset = Get32(eocd + 16);
+	if (count == 0xFFFF || directoryOffset == 0xFFFFFFFF)
+	{
+		Close();
+		error = "Zip64 archives aren't supported.";
+		return false;
+	}
+	// Offsets in the archive don't count a self-extractor stub before it
+	const size_t directoryEnd = eocd - view;
+	if ((unsigned __int64)directoryOffset + directorySize > directoryEnd)
+	{
+		Close();
+		error = "Archive is corrupt.";
+		return false;
+	}
+	const size_t stub = directoryEnd - directorySize - directoryOffset;
+
+	entries.reserve(count);
+	const unsigned char * record = view + stub + directoryOffset;
+	const unsigned char * const recordsEnd = view + directoryEnd;
+	for (unsigned int i = 0; i < count; ++i)
+	{
+		if (recordsEnd - record < 46 || Get32(record) != 0x02014b50)
+		{
+			Close();
+			error = "Archive is corrupt.";
+			return false;
+		}
+		const unsigned int nameLength = Get16(record + 28);
+		const size_t recordSize = 46 + nameLength + Get16(record + 30) + Get16(record + 32);
+		if ((size_t)(recordsEnd - record) < recordSize)
+		{
+			Close();
+			error = "Archive is corrupt.";
+			return false;
+		}
+
+		Entry entry;
+		entry.name.assign((const char *)record + 46, nameLength);
+		entry.flags = Get16(record + 8);
+		entry.method = Get16(record + 10);
+		entry.crc = Get32(record + 16);
+		entry.compressedSize = Get32(record + 20);
+		entry.uncompressedSize = Get32(record + 24);
+		entry.localHeaderOffset = stub + Get32(record + 42);
+		entries[Key(entry.name.c_str(), entry.name.size())] = std::move(entry);
+
+		record += recordSize;
+	}
+	return true;
+}
+
+void ZipIndex::Close()
+{
+	if (view)
+		UnmapViewOfFile(view);
+	view = NULL;
+	viewSize = 0;
+	entries.clear();
+	buffer.reset();
+	bufferSize = 0;
+}
+
+const ZipIndex::Entry * ZipIndex::Find(const char * name) const
+{
+	std::unordered_map<std::string, Entry>::const_iterator entry = entries.find(Key(name, strlen(name)));
+	return entry == entries.end() ? NULL : &entry->second;
+}
+
+bool ZipIndex::Read(const Entry &entry, const char * &data, size_t &size, std::string &error)
+{
+	data = NULL;
+	size = 0;
+	if (!view)
+	{
+		error = "No archive is open.";
+		return false;
+	}
+	if (entry.flags & 1)
+	{
+		error = "Entry \"" + entry.name + "\" is encrypted; unzip it with a password instead.";
+		return false;
+	}
+
+	// The data starts after the local header, whose name and extra field lengths can differ
+	// from the central directory's
+	if (viewSize < 30 || entry.localHeaderOffset > viewSize - 30)
+	{
+		error = "Archive is corrupt.";
+		return false;
+	}
+	const unsigned char * local = view + entry.localHeaderOffset;
+	if (Get32(local) != 0x04034b50)
+	{
+		error = "Archive is corrupt.";
+		return false;
+	}
+	const size_t dataOffset = entry.localHeaderOffset + 30 + Get16(local + 26) + Get16(local + 28);
+	if (dataOffset > viewSize || entry.compressedSize > viewSize - dataOffset)
+	{
+		error = "Archive is corrupt.";
+		return false;
+	}
+	const unsigned char * compressed = view + dataOffset;
+
+	if (entry.method == 0)
+	{
+		if (entry.compressedSize != entry.uncompressedSize)
+		{
+			error = "Archive is corrupt.";
+			return false;
+		}
+		data = (const char *)compressed;
+		size = entry.uncompressedSize;
+		return true;
+	}
+	if (entry.method != Z_DEFLATED)
+	{
+		std::stringstream temp;
+		temp << "Entry \"" << entry.name << "\" uses unsupported compression method " << entry.method << ".";
+		error = temp.str();
+		return false;
+	}
+	if (entry.uncompressedSize == 0)
+	{
+		data = "";
+		return true;
+	}
+
+	// Grow-only, so reading many entries of similar size doesn't reallocate
+	if (bufferSize < entry.uncompressedSize)
+	{
+		buffer.reset(new (std::nothrow) char[entry.uncompressedSize]);
+		bufferSize = buffer ? entry.uncompressedSize : 0;
+		if (!buffer)
+		{
+			error = "Out of memory reading entry \"" + entry.name + "\".";
+			return false;
+		}
+	}
+
+	// The whole entry is in memory, so inflate it in one call
+	z_stream stream = {};
+	if (inflateInit2(&stream, -MAX_WBITS) != Z_OK)
+	{
+		error = "Couldn't start inflating.";
+		return false;
+	}
+	stream.next_in = (Bytef *)compressed;
+	stream.avail_in = entry.compressedSize;
+	stream.next_out = (Bytef *)buffer.get();
+	stream.avail_out = entry.uncompressedSize;
+	const int result = inflate(&stream, Z_FINISH);
+	const uLong inflated = stream.total_out;
+	inflateEnd(&stream);
+
+	if (result != Z_STREAM_END || inflated != entry.uncompressedSize ||
+		crc32(0, (const Bytef *)buffer.get(), entry.uncompressedSize) != entry.crc)
+	{
+		error = "Entry \"" + entry.name + "\" is corrupt.";
+		return false;
+	}
+	data = buffer.get();
+	size = entry.uncompressedSize;
+	return true;
+}
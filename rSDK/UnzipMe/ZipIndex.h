@@ -0,0 +1,53 @@
+// Include guard
+#ifndef ZIPINDEX_H
+#define ZIPINDEX_H
+
+#include <memory>
+#include <string>
+#include <unordered_map>
+
+// Central directory of a zip, read once from a read-only mapping of the whole archive, and kept
+// until closed. Entries are looked up by path in a hash map, ignoring case, with / and \ alike.
+// Stored entries are read straight out of the mapping; deflated ones are inflated in one call.
+class ZipIndex
+{
+public:
+	struct Entry
+	{
+		std::string name;				// As in the archive
+		unsigned int method;			// 0 for stored, 8 for deflated
+		unsigned int flags;				// Bit 0 is set if encrypted
+		unsigned int crc;
+		unsigned int compressedSize;
+		unsigned int uncompressedSize;
+		size_t localHeaderOffset;		// From the start of the mapping, so includes any self-extractor stub
+	};
+
+	ZipIndex();
+	~ZipIndex(); // Unmaps the archive
+
+	// Maps the archive and reads its central directory, closing any archive open before
+	bool Open(const char * filename, std::string &error);
+	void Close();
+	bool IsOpen() const { return view != NULL; }
+
+	const Entry * Find(const char * name) const; // NULL if not in the archive
+	size_t Count() const { return entries.size(); }
+
+	// Gets an entry's uncompressed data. Stored entries point into the mapping, without a copy,
+	// and aren't CRC-checked; deflated ones are inflated into a buffer owned by the index.
+	// Either way, data stays valid until the next Read() or Close().
+	bool Read(const Entry &entry, const char * &data, size_t &size, std::string &error);
+
+private:
+	const unsigned char * view;
+	size_t viewSize;
+	std::unordered_map<std::string, Entry> entries;	// By Key(name)
+	std::unique_ptr<char[]> buffer;					// Last inflated entry
+	size_t bufferSize;
+
+	static std::string Key(const char * name, size_t length);
+};
+
+// End include guard
+#endif
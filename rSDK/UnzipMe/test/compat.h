@@ -0,0 +1,8 @@
+// Stand-ins for the few Windows CRT calls unzip.cpp still makes when built with ZIP_STD
+#include <stdio.h>
+#include <string.h>
+
+#define _strdup strdup
+#define MessageBox(a, b, c, d) ((void)0)
+#define sprintf_s(buf, ...) snprintf(buf, MAX_PATH, __VA_ARGS__)
+#define _tcsncpy_s(d, n, s, c) strncpy(d, s, c)
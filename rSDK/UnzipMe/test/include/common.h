@@ -0,0 +1,87 @@
+// Stands in for UnzipMe's Common.h when building ZipIndex.cpp on Linux: the Win32 file and
+// mapping calls it makes, done with open() and mmap(), and the headers Common.h brings in.
+#pragma once
+#include <ctype.h>
+#include <fcntl.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <map>
+#include <mutex>
+#include <new>
+#include <sstream>
+#include <string>
+
+typedef long long __int64;
+typedef void * HANDLE;
+typedef union { long long QuadPart; } LARGE_INTEGER;
+
+#define INVALID_HANDLE_VALUE ((HANDLE)-1)
+#define GENERIC_READ 0
+#define FILE_SHARE_READ 0
+#define OPEN_EXISTING 0
+#define FILE_FLAG_RANDOM_ACCESS 0
+#define PAGE_READONLY 0
+#define FILE_MAP_READ 0
+
+// Files and mappings are both handles, so each is a heap object saying which it is
+struct StandInHandle
+{
+	int fd;
+	bool mapping;
+};
+
+static std::mutex standInViewsLock;
+static std::map<const void *, size_t> standInViews; // Size of each view, for munmap()
+
+static HANDLE CreateFileA(const char * name, int, int, void *, int, int, void *)
+{
+	const int fd = open(name, O_RDONLY);
+	return fd < 0 ? INVALID_HANDLE_VALUE : new StandInHandle { fd, false };
+}
+
+static bool GetFileSizeEx(HANDLE handle, LARGE_INTEGER * size)
+{
+	struct stat st;
+	if (fstat(((StandInHandle *)handle)->fd, &st))
+		return false;
+	size->QuadPart = st.st_size;
+	return true;
+}
+
+static HANDLE CreateFileMapping(HANDLE file, void *, int, int, int, void *)
+{
+	const int fd = dup(((StandInHandle *)file)->fd);
+	return fd < 0 ? NULL : new StandInHandle { fd, true };
+}
+
+static void * MapViewOfFile(HANDLE mapping, int, int, int, int)
+{
+	LARGE_INTEGER size;
+	if (!GetFileSizeEx(mapping, &size))
+		return NULL;
+	void * view = mmap(NULL, (size_t)size.QuadPart, PROT_READ, MAP_PRIVATE, ((StandInHandle *)mapping)->fd, 0);
+	if (view == MAP_FAILED)
+		return NULL;
+	std::lock_guard<std::mutex> lock(standInViewsLock);
+	standInViews[view] = (size_t)size.QuadPart;
+	return view;
+}
+
+static void UnmapViewOfFile(const void * view)
+{
+	std::lock_guard<std::mutex> lock(standInViewsLock);
+	munmap((void *)view, standInViews[view]);
+	standInViews.erase(view);
+}
+
+static void CloseHandle(HANDLE handle)
+{
+	close(((StandInHandle *)handle)->fd);
+	delete (StandInHandle *)handle;
+}
+
+#include <unordered_map>
+#include "ZipIndex.h"
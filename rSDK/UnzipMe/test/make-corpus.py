@@ -0,0 +1,87 @@
+#!/usr/bin/env python3
+# Writes the corpus unzip-speed times: a folder of files shaped like what Fusion games ship
+# (source-like text, structured binaries, already-compressed data, a few large files, empty
+# files and nested folders), and a zip of it. The content comes from a fixed seed, so every run
+# writes the same files and timings can be compared between machines and changes.
+#
+# If the zip command is installed, also writes an archive of part of the corpus encrypted with
+# the password "corpus", to time and check decryption; Python can read those but not write them.
+#
+# Usage: make-corpus.py output-folder [megabytes, default 64]
+
+import os
+import random
+import shutil
+import subprocess
+import sys
+import zipfile
+
+out = sys.argv[1]
+target = int(sys.argv[2]) * 1024 * 1024 if len(sys.argv) > 2 else 64 * 1024 * 1024
+rng = random.Random(20261019)
+
+words = ["int", "const", "char", "return", "if", "else", "for", "while", "struct", "static",
+	"void", "unsigned", "size_t", "std::string", "nullptr", "true", "false", "rdPtr", "Extension",
+	"Runtime", "object", "frame", "value", "index", "count", "buffer", "length", "=", "==", "+=",
+	"(", ")", "{", "}", ";", "->", "0", "1", "255", "// TODO", "#include", "#define"]
+lines = [" ".join(rng.choice(words) for _ in range(rng.randint(2, 14))) for _ in range(4000)]
+
+def text(size):
+	parts, length = [], 0
+	while length < size:
+		line = "\t" * rng.randint(0, 3) + rng.choice(lines) + "\n"
+		parts.append(line)
+		length += len(line)
+	return "".join(parts).encode()[:size]
+
+def records(size):
+	# Fixed-size records with slowly changing fields, like level or sprite tables
+	out, i = bytearray(), 0
+	while len(out) < size:
+		out += i.to_bytes(4, "little") + (i * 7 % 640).to_bytes(2, "little") + \
+			(i * 3 % 480).to_bytes(2, "little") + bytes([i % 17, 0, 0, 255]) + rng.randbytes(4)
+		i += 1
+	return bytes(out[:size])
+
+def noise(size):
+	return rng.randbytes(size)
+
+kinds = [("src/%s/%d.cpp", text, 1024, 200 * 1024, 5),
+	("data/%s/%d.bin", records, 4 * 1024, 1024 * 1024, 3),
+	("media/%s/%d.ogg", noise, 16 * 1024, 2 * 1024 * 1024, 1)]
+folders = ["core", "ui", "net", "levels/world1", "levels/world2", "sound"]
+
+shutil.rmtree(out, ignore_errors=True)
+corpus = os.path.join(out, "corpus")
+files, total = [], 0
+
+def write(name, data):
+	global total
+	path = os.path.join(corpus, name)
+	os.makedirs(os.path.dirname(path), exist_ok=True)
+	with open(path, "wb") as f:
+		f.write(data)
+	files.append(name)
+	total += len(data)
+
+for i in range(3):
+	write("large/%d.bin" % i, (text, records, noise)[i](target // 12))
+for i in range(5):
+	write("empty/%d.txt" % i, b"")
+while total < target:
+	pattern, make, low, high, weight = rng.choices(kinds, [k[4] for k in kinds])[0]
+	write(pattern % (rng.choice(folders), len(files)), make(int(rng.triangular(low, high, low))))
+os.makedirs(os.path.join(corpus, "empty/folder"))
+
+# Already-compressed data is stored, as zip tools do
+with zipfile.ZipFile(os.path.join(out, "corpus.zip"), "w") as z:
+	z.write(os.path.join(corpus, "empty/folder"), "empty/folder/")
+	for name in files:
+		method = zipfile.ZIP_STORED if name.endswith(".ogg") else zipfile.ZIP_DEFLATED
+		z.write(os.path.join(corpus, name), name, method, 6)
+
+if shutil.which("zip"):
+	subprocess.run(["zip", "-q", "-r", "-P", "corpus", "../encrypted.zip", "src", "empty"],
+		cwd=corpus, check=True)
+
+print("%d files, %.1f MB, in %s" % (len(files), total / 1048576, out))
@@ -0,0 +1,32 @@
+// The lookup and read ZipIndex replaces, done with unzip.cpp, for zip-index to time against. It's
+// a file of its own because unzip.h's ZIP_STD types clash with the Win32 stand-ins ZipIndex uses.
+
+#include "unzip.h"
+
+#include <string>
+#include <vector>
+
+bool UnzipLookup(const char * archive, const std::vector<std::string> &names, double &bytes)
+{
+	HZIP zip = OpenZip(archive, NULL);
+	if (!zip)
+		return false;
+
+	std::vector<char> buffer;
+	bool read = true;
+	for (const std::string &name : names)
+	{
+		int index;
+		ZIPENTRY entry;
+		if (FindZipItem(zip, name.c_str(), true, &index, &entry) != ZR_OK)
+		{
+			read = false;
+			continue;
+		}
+		buffer.resize(entry.unc_size + 1);
+		read = UnzipItem(zip, index, buffer.data(), (unsigned int)buffer.size()) == ZR_OK && read;
+		bytes += entry.unc_size;
+	}
+	CloseZip(zip);
+	return read;
+}
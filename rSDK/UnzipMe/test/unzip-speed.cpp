@@ -0,0 +1,258 @@
+// Test and benchmark for UnzipMe's unzip.cpp, built with ZIP_STD.
+//
+// Unzips every entry of an archive made by make-corpus.py and checks each comes out the same as
+// the file it was zipped from: first to memory, then to files, then to files from several threads
+// with a handle each and GoToZipItem(), as the extension's extraction does. Checks a wrong
+// password is refused, so unzip.cpp's last error is kept per thread. "make check-tsan" runs it
+// with ThreadSanitizer.
+//
+// Each way is timed in MB/s of uncompressed data. Memory is the decoder alone; files adds the
+// writes, so put the output folder on tmpfs to leave out the disk.
+//
+// Usage: unzip-speed [-p password] [-t threads] [-o output folder] archive corpus-folder
+
+#include "unzip.h"
+#include "ThreadPool.h"
+
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdio>
+#include <cstdlib>
+#include <mutex>
+#include <string>
+#include <vector>
+
+static int failures = 0;
+
+static void check(bool passed, const char * what)
+{
+	printf("%s: %s\n", passed ? "pass" : "FAIL", what);
+
+	if (!passed)
+		++failures;
+}
+
+static bool ReadFile(const std::string &Path, std::string &Data)
+{
+	FILE * File = fopen(Path.c_str(), "rb");
+	if (!File)
+		return false;
+	Data.clear();
+	char Buffer[64 * 1024];
+	size_t Read;
+	while ((Read = fread(Buffer, 1, sizeof(Buffer), File)) > 0)
+		Data.append(Buffer, Read);
+	fclose(File);
+	return true;
+}
+
+struct Item
+{
+	int Index;
+	unsigned long Pos;
+	std::string Name;
+	long Size;
+};
+
+// Compares every file unzipped under Output with its source under Corpus
+static bool SameFiles(const std::vector<Item> &Items, const std::string &Output, const std::string &Corpus)
+{
+	std::string Unzipped, Source;
+	for (const Item &Entry : Items)
+	{
+		if (!ReadFile(Output + "/" + Entry.Name, Unzipped) || !ReadFile(Corpus + "/" + Entry.Name, Source) || Unzipped != Source)
+		{
+			printf("  %s differs\n", Entry.Name.c_str());
+			return false;
+		}
+	}
+	return true;
+}
+
+static double MBps(double Bytes, std::chrono::steady_clock::duration Time)
+{
+	return Bytes / 1048576 / std::chrono::duration<double>(Time).count();
+}
+
+int main(int argc, char ** argv)
+{
+	const char * Password = NULL;
+	unsigned int Threads = std::max(1U, std::thread::hardware_concurrency());
+	std::string Output = "build/out";
+	int Option;
+
+	while ((Option = getopt(argc, argv, "p:t:o:")) != -1)
+	{
+		switch (Option)
+		{
+			case 'p': Password = optarg; break;
+			case 't': Threads = std::max(1, atoi(optarg)); break;
+			case 'o': Output = optarg; break;
+			default: optind = argc + 1; break;
+		}
+	}
+	if (optind + 2 != argc)
+	{
+		fprintf(stderr, "Usage: unzip-speed [-p password] [-t threads] [-o output folder] archive corpus-folder\n");
+		return 2;
+	}
+	const char * Archive = argv[optind];
+	const std::string Corpus = argv[optind + 1];
+
+	HZIP Zip = OpenZip(Archive, Password);
+	ZIPENTRY Entry;
+	if (!Zip || GetZipItem(Zip, -1, &Entry) != ZR_OK)
+	{
+		fprintf(stderr, "unzip-speed: couldn't open %s\n", Archive);
+		return 1;
+	}
+
+	// The files; folders are made as files in them are unzipped
+	std::vector<Item> Items;
+	double Total = 0;
+	const int Count = Entry.index;
+	for (int i = 0; i < Count; ++i)
+	{
+		GetZipItem(Zip, i, &Entry);
+		if (S_ISDIR(Entry.attr))
+			continue;
+		Item Next = { i, 0, Entry.name, Entry.unc_size };
+		GetZipItemPos(Zip, i, &Next.Pos);
+		Items.push_back(Next);
+		Total += Entry.unc_size;
+	}
+	printf("  %zu files, %.1f MB\n", Items.size(), Total / 1048576);
+
+	// To memory
+	{
+		long Largest = 1;
+		for (const Item &File : Items)
+			Largest = std::max(Largest, File.Size);
+		std::vector<char> Buffer(Largest);
+		std::vector<std::string> Unzipped(Items.size());
+		bool Unzips = true;
+
+		const auto Start = std::chrono::steady_clock::now();
+		for (size_t i = 0; i < Items.size(); ++i)
+		{
+			Unzips = UnzipItem(Zip, Items[i].Index, Buffer.data(), (unsigned int)Buffer.size()) == ZR_OK && Unzips;
+			Unzipped[i].assign(Buffer.data(), Items[i].Size);
+		}
+		const auto Time = std::chrono::steady_clock::now() - Start;
+		check(Unzips, "to memory: every entry unzips");
+
+		bool Same = true;
+		std::string Source;
+		for (size_t i = 0; i < Items.size() && Same; ++i)
+			Same = ReadFile(Corpus + "/" + Items[i].Name, Source) && Unzipped[i] == Source;
+		check(Same, "to memory: every entry is the same as its source");
+		printf("  to memory: %.0f MB/s\n", MBps(Total, Time));
+	}
+
+	// To files, one thread
+	{
+		system(("rm -rf '" + Output + "'").c_str());
+		SetUnzipBaseDir(Zip, Output.c_str());
+		bool Unzips = true;
+
+		const auto Start = std::chrono::steady_clock::now();
+		for (const Item &File : Items)
+			Unzips = UnzipItem(Zip, File.Index, File.Name.c_str()) == ZR_OK && Unzips;
+		const auto Time = std::chrono::steady_clock::now() - Start;
+
+		check(Unzips && SameFiles(Items, Output, Corpus), "to files: every entry is the same as its source");
+		printf("  to files: %.0f MB/s\n", MBps(Total, Time));
+	}
+	CloseZip(Zip);
+
+	// To files, from a pool, with a handle per thread; largest first, so one isn't left till last
+	{
+		system(("rm -rf '" + Output + "'").c_str());
+		std::vector<const Item *> Order;
+		for (const Item &File : Items)
+			Order.push_back(&File);
+		std::sort(Order.begin(), Order.end(), [](const Item * a, const Item * b) { return a->Size > b->Size; });
+
+		std::mutex Lock;
+		std::condition_variable Finished;
+		std::vector<HZIP> Free;
+		size_t Remaining = Order.size();
+		std::atomic<bool> Unzips(true);
+
+		const auto Start = std::chrono::steady_clock::now();
+		{
+			ThreadPool Pool(Threads);
+			for (const Item * File : Order)
+			{
+				Pool.Submit([&, File] {
+					HZIP Handle = NULL;
+					{
+						std::lock_guard<std::mutex> Guard(Lock);
+						if (!Free.empty())
+						{
+							Handle = Free.back();
+							Free.pop_back();
+						}
+					}
+					if (!Handle && (Handle = OpenZip(Archive, Password)) != NULL)
+						SetUnzipBaseDir(Handle, Output.c_str());
+
+					if (!Handle || GoToZipItem(Handle, File->Index, File->Pos) != ZR_OK ||
+						UnzipItem(Handle, File->Index, File->Name.c_str()) != ZR_OK)
+						Unzips = false;
+
+					std::lock_guard<std::mutex> Guard(Lock);
+					if (Handle)
+						Free.push_back(Handle);
+					if (--Remaining == 0)
+						Finished.notify_one();
+				});
+			}
+			std::unique_lock<std::mutex> Guard(Lock);
+			Finished.wait(Guard, [&] { return Remaining == 0; });
+		}
+		const auto Time = std::chrono::steady_clock::now() - Start;
+		for (HZIP Handle : Free)
+			CloseZip(Handle);
+
+		check(Unzips && SameFiles(Items, Output, Corpus), "to files on threads: every entry is the same as its source");
+		printf("  to files on %u threads: %.0f MB/s\n", Threads, MBps(Total, Time));
+	}
+
+	// A wrong password, with the error read back on the thread that got it
+	const auto Encrypted = std::find_if(Items.begin(), Items.end(), [](const Item &File) { return File.Size > 0; });
+	if (Password && Encrypted != Items.end())
+	{
+		std::atomic<bool> Refused(true);
+		std::vector<std::thread> Checkers;
+		for (int t = 0; t < 4; ++t)
+		{
+			Checkers.emplace_back([&, t] {
+				HZIP Wrong = OpenZip(Archive, t % 2 ? "wrong" : Password);
+				std::vector<char> Buffer(Encrypted->Size);
+				for (int i = 0; i < 50 && Wrong; ++i)
+				{
+					const ZRESULT Result = UnzipItem(Wrong, Encrypted->Index, Buffer.data(), (unsigned int)Buffer.size());
+					TCHAR Message[256], Recent[256];
+					FormatZipMessage(Result, Message, sizeof(Message));
+					FormatZipMessage(ZR_RECENT, Recent, sizeof(Recent));
+					if ((Result == ZR_PASSWORD) != (t % 2 == 1) || strcmp(Message, Recent))
+						Refused = false;
+				}
+				if (Wrong)
+					CloseZip(Wrong);
+			});
+		}
+		for (std::thread &Checker : Checkers)
+			Checker.join();
+		check(Refused, "a wrong password is refused, and ZR_RECENT reports each thread's own result");
+	}
+
+	printf(failures ? "%d failed\n" : "all passed\n", failures);
+	return failures ? 1 : 0;
+}
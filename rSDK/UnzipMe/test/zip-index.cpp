@@ -0,0 +1,223 @@
+// Test and benchmark for UnzipMe's zip index (ZipIndex.cpp), built with Win32 stand-ins.
+//
+// Indexes an archive made by make-corpus.py and checks every file in the corpus is found, ignoring
+// case and with \ for /, and reads back the same as its source; and again with a self-extractor
+// stub before the archive. Then checks archives whose central directory points a local header or
+// entry data past the end of the file are reported corrupt rather than read, and that encrypted
+// entries are refused. "make check-asan" runs it with AddressSanitizer.
+//
+// Then times indexing the archive, and finding and reading every file in a shuffled order, against
+// FindZipItem() and UnzipItem() doing the same.
+//
+// Usage: zip-index archive corpus-folder [encrypted archive]
+
+#include "common.h"
+
+#include <ftw.h>
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <random>
+#include <string>
+#include <vector>
+
+bool UnzipLookup(const char * archive, const std::vector<std::string> &names, double &bytes);
+
+static int failures = 0;
+
+static void check(bool passed, const char * what)
+{
+	printf("%s: %s\n", passed ? "pass" : "FAIL", what);
+
+	if (!passed)
+		++failures;
+}
+
+static bool ReadFile(const std::string &Path, std::string &Data)
+{
+	FILE * File = fopen(Path.c_str(), "rb");
+	if (!File)
+		return false;
+	Data.clear();
+	char Buffer[64 * 1024];
+	size_t Read;
+	while ((Read = fread(Buffer, 1, sizeof(Buffer), File)) > 0)
+		Data.append(Buffer, Read);
+	fclose(File);
+	return true;
+}
+
+static bool WriteFile(const std::string &Path, const std::string &Data)
+{
+	FILE * File = fopen(Path.c_str(), "wb");
+	const bool Written = File && fwrite(Data.data(), 1, Data.size(), File) == Data.size();
+	if (File)
+		fclose(File);
+	return Written;
+}
+
+// Every file in the corpus, by its path in the archive
+static std::vector<std::string> Names;
+static size_t CorpusLength;
+
+static int AddName(const char * Path, const struct stat *, int Type, FTW *)
+{
+	if (Type == FTW_F)
+		Names.push_back(Path + CorpusLength + 1);
+	return 0;
+}
+
+// Checks every name is found and reads back the same as its source
+static bool ReadsSame(ZipIndex &Index, const std::string &Corpus)
+{
+	std::string Source, Error;
+	for (const std::string &Name : Names)
+	{
+		const ZipIndex::Entry * Entry = Index.Find(Name.c_str());
+		const char * Data;
+		size_t Size;
+		if (!Entry || !Index.Read(*Entry, Data, Size, Error) || !ReadFile(Corpus + "/" + Name, Source) ||
+			Source.size() != Size || memcmp(Source.data(), Data, Size))
+		{
+			printf("  %s: %s\n", Name.c_str(), Entry ? Error.c_str() : "not found");
+			return false;
+		}
+	}
+	return true;
+}
+
+static unsigned int Get16(const std::string &Data, size_t At)
+{
+	return (unsigned char)Data[At] | ((unsigned char)Data[At + 1] << 8);
+}
+static unsigned int Get32(const std::string &Data, size_t At)
+{
+	return Get16(Data, At) | (Get16(Data, At + 2) << 16);
+}
+static void Put32(std::string &Data, size_t At, unsigned int Value)
+{
+	for (int i = 0; i < 4; ++i)
+		Data[At + i] = (char)(Value >> (8 * i));
+}
+
+// Copies the archive with a field of its first central directory record changed, and tries to
+// read that entry from the copy; returns whether it was read
+static bool ReadsCorrupt(const std::string &Archive, size_t Field, unsigned int Value, std::string &Error)
+{
+	std::string Data;
+	ReadFile(Archive, Data);
+	const size_t Eocd = Data.rfind("PK\x05\x06");
+	const size_t Record = Get32(Data, Eocd + 16);
+	const std::string Name = Data.substr(Record + 46, Get16(Data, Record + 28));
+	Put32(Data, Record + Field, Value);
+
+	const std::string Corrupt = Archive + ".corrupt";
+	WriteFile(Corrupt, Data);
+	ZipIndex Index;
+	const ZipIndex::Entry * Entry;
+	const char * Read;
+	size_t Size;
+	Error.clear();
+	return Index.Open(Corrupt.c_str(), Error) && (Entry = Index.Find(Name.c_str())) != NULL &&
+		Index.Read(*Entry, Read, Size, Error);
+}
+
+int main(int argc, char ** argv)
+{
+	if (argc != 3 && argc != 4)
+	{
+		fprintf(stderr, "Usage: zip-index archive corpus-folder [encrypted archive]\n");
+		return 2;
+	}
+	const std::string Archive = argv[1], Corpus = argv[2];
+	CorpusLength = Corpus.size();
+	nftw(Corpus.c_str(), AddName, 16, FTW_PHYS);
+	std::string Error;
+
+	ZipIndex Index;
+	check(Index.Open(Archive.c_str(), Error), "the archive is indexed");
+	printf("  %zu entries, %zu files in the corpus\n", Index.Count(), Names.size());
+	check(ReadsSame(Index, Corpus), "every file is found and reads back the same as its source");
+
+	std::string Other = Names[0];
+	for (char &c : Other)
+		c = c == '/' ? '\\' : (char)toupper((unsigned char)c);
+	check(Index.Find(Other.c_str()) == Index.Find(Names[0].c_str()) && !Index.Find("not/in/the/archive"),
+		"names are found ignoring case, with \\ for /");
+
+	// A self-extractor: offsets in the archive don't count the stub
+	{
+		std::string Data;
+		ReadFile(Archive, Data);
+		const std::string Extractor = Archive + ".exe";
+		WriteFile(Extractor, "MZ" + std::string(70000, '\x90') + Data);
+		ZipIndex Stubbed;
+		check(Stubbed.Open(Extractor.c_str(), Error) && ReadsSame(Stubbed, Corpus),
+			"an archive after a self-extractor stub reads back the same");
+	}
+
+	// Corrupt archives
+	check(!ReadsCorrupt(Archive, 42, 0xFFFFFFF0, Error) && Error == "Archive is corrupt.",
+		"a local header offset past the end of the file is reported corrupt");
+	check(!ReadsCorrupt(Archive, 20, 0xFFFFFFF0, Error) && Error == "Archive is corrupt.",
+		"a compressed size past the end of the file is reported corrupt");
+	{
+		ZipIndex NotZip;
+		check(!NotZip.Open((Corpus + "/" + Names[0]).c_str(), Error), "a file that isn't a zip isn't indexed");
+	}
+
+	if (argc > 3)
+	{
+		ZipIndex Encrypted;
+		bool Refused = Encrypted.Open(argv[3], Error);
+		for (const std::string &Name : Names)
+		{
+			const ZipIndex::Entry * Entry = Encrypted.Find(Name.c_str());
+			const char * Data;
+			size_t Size;
+			if (Entry && Entry->uncompressedSize)
+				Refused = Refused && !Encrypted.Read(*Entry, Data, Size, Error) && Error.find("encrypted") != std::string::npos;
+		}
+		check(Refused, "encrypted entries are refused");
+	}
+
+	// Timing; not checked, as it depends on the machine
+	std::vector<std::string> Shuffled = Names;
+	std::shuffle(Shuffled.begin(), Shuffled.end(), std::mt19937(20261019));
+
+	const auto Start = std::chrono::steady_clock::now();
+	ZipIndex Timed;
+	Timed.Open(Archive.c_str(), Error);
+	const auto Indexed = std::chrono::steady_clock::now();
+	double Bytes = 0;
+	for (const std::string &Name : Shuffled)
+	{
+		const char * Data;
+		size_t Size;
+		if (Timed.Read(*Timed.Find(Name.c_str()), Data, Size, Error))
+			Bytes += Size;
+	}
+	const auto Read = std::chrono::steady_clock::now();
+	const int Lookups = 1000000;
+	size_t Found = 0;
+	for (int i = 0; i < Lookups; ++i)
+		Found += Timed.Find(Shuffled[i % Shuffled.size()].c_str()) != NULL;
+	const auto Looked = std::chrono::steady_clock::now();
+
+	double UnzipBytes = 0;
+	check(UnzipLookup(Archive.c_str(), Shuffled, UnzipBytes) && UnzipBytes == Bytes, "unzip.cpp reads the same files");
+	const auto Unzipped = std::chrono::steady_clock::now();
+
+	typedef std::chrono::duration<double, std::milli> Milliseconds;
+	const Milliseconds IndexTime = Indexed - Start, ReadTime = Read - Indexed, UnzipTime = Unzipped - Looked;
+	printf("  indexed in %.2f ms; %zu files found and read in %.1f ms, %.0f MB/s; a lookup takes %.0f ns\n",
+		IndexTime.count(), Shuffled.size(), ReadTime.count(), Bytes / 1048576 / ReadTime.count() * 1000,
+		std::chrono::duration<double, std::nano>(Looked - Read).count() / Lookups);
+	printf("  by FindZipItem() and UnzipItem(), opening included: %.1f ms, %.0f MB/s\n",
+		UnzipTime.count(), UnzipBytes / 1048576 / UnzipTime.count() * 1000);
+	(void)Found;
+
+	printf(failures ? "%d failed\n" : "all passed\n", failures);
+	return failures ? 1 : 0;
+}
@@ -74,6 +74,14 @@ ZRESULT GetZipItem(HZIP hz, int index, ZIPENTRY *ze);
 // then then comp_size and sometimes unc_size as well may not be known until
 // after the item has been unzipped.
 
+ZRESULT GetZipItemPos(HZIP hz, int index, unsigned long *pos);
+ZRESULT GoToZipItem(HZIP hz, int index, unsigned long pos);
+// GetZipItemPos - returns where an item's entry is in the central directory.
+// GoToZipItem - given that position, makes the item current without walking
+// the central directory from the start, so a following GetZipItem/UnzipItem
+// of that index is quick. Handy when several handles to one zip each unzip
+// a different set of items: read the positions once, then jump to them.
+
 ZRESULT FindZipItem(HZIP hz, const TCHAR *name, bool ic, int *index, ZIPENTRY *ze);
 // FindZipItem - finds an item by name. ic means 'insensitive to case'.
 // It returns the index of the item, and returns information about it.
@@ -12,6 +12,19 @@
 #include	<string>
 using namespace std;
 
+//Jobs
+#include	<atomic>
+#include	<condition_variable>
+#include	<deque>
+#include	<map>
+#include	<memory>
+#include	<mutex>
+#include	<vector>
+#include	<io.h>
+#include	<fcntl.h>
+#include	<sys/stat.h>
+#include	"ThreadPool.h"
+
 // Specific to this extension
 #include "Resource.h"
 #include "FlagsPrefs.h"
@@ -7,18 +7,52 @@ typedef rRundata * LPRRDATA;
 // If you want to store anything between actions/conditions/expressions
 // you should store it here
 
+// A compress or decompress job. Shared by the worker running it and the expressions reading its progress.
+struct Job
+{
+	int id;
+	bool compress;						  // If true, compress; otherwise decompress
+	bool append;						  // If true, append; otherwise (over)write output
+	string infilename;					  // Input file name
+	string outfilename;					  // Output file name
+	unsigned int buffersize;			  // Size of memory buffer
+	bool parallel;						  // If true, compress in blocks on all cores
+	std::atomic<unsigned __int64> done;	  // Bytes of input file processed so far
+	std::atomic<unsigned __int64> total;  // Size of input file, 0 until the job starts
+	std::atomic<bool> cancel;			  // Set to stop the job early
+
+	Job() : id(0), compress(false), append(false), buffersize(0), parallel(false), done(0), total(0), cancel(false) {}
+};
+
+// Result of a finished job, passed back to the Fusion thread to run its event
+struct JobResult
+{
+	bool success;
+	string message;				  // Statistics or error
+	double PercentageDifference;  // Only set on success
+	string outfilename;
+};
+
 typedef struct tagRDATA
 {
 	#include "MagicRDATA.h"
 
-	//bool is volatile so it can be changed instantly by threads
-	unsigned short inbuffersize;  // Default size of memory buffer
+	unsigned int inbuffersize;	  // Size of memory buffer for new jobs
 	double PercentageDifference;  // Percentage difference input->output
 	string LastOutput;			  // Last finished file name
 	string returnstring;		  // String to return with statistics or errors
-	volatile bool threadsafe;	  // Ensure only one thread accesses rdPtr's variables
+	int lastJobID;				  // ID of the last job queued
+	bool parallel;				  // Compress new jobs in blocks on all cores
+
+	// Only the job map and results are shared with the worker threads; lock jobLock to access them.
+	// The rest is only touched by the Fusion thread, as workers pass their results back via HandleRunObject.
+	std::mutex jobLock;
+	std::map<int, std::shared_ptr<Job>> jobs;  // Queued and running jobs, by ID
+	std::deque<JobResult> results;			  // Finished jobs, waiting for their event
+	ThreadPool * pool;						  // Created with the first job
+	ThreadPool * blockPool;					  // Created with the first parallel job
 
-	tagRDATA() : inbuffersize(8192), PercentageDifference(0.0), LastOutput(""), returnstring(""), threadsafe(false) // Constructor
+	tagRDATA() : inbuffersize(256 * 1024), PercentageDifference(0.0), LastOutput(""), returnstring(""), lastJobID(0), parallel(false), pool(NULL), blockPool(NULL) // Constructor
 	{
 		//vars initialized above in the initializer list
 	}
@@ -5,245 +5,410 @@
 // ============================================================================
 #include "Common.h"
 
-//Macros for Thread Safety
-//If accessing rdPtr, wrap the accessing code in these
-#define ThreadSafe_Start() \
-	while (rdPtr -> threadsafe) \
-	{ \
-		Sleep(0); \
-	} \
-	rdPtr -> threadsafe=true
-#define ThreadSafe_End() rdPtr -> threadsafe=false
-//Macro for simplicity
-#define Terminate() \
-	ThreadSafe_Start(); \
-	delete[] infilename, outfilename; \
-	rdPtr -> LastOutput = outfilename; \
-	rdPtr -> rRd -> CallEvent(1); \
-	ThreadSafe_End(); \
-	return 1
-
-// Please note: Using GenerateEvent in place of PushEvent is not a good idea, being that
-// access to rdPtr is blocked by ThreadSafe_Start. Example code:
-//	ThreadSafe_Start();
-//	rdPtr -> GenerateEvent(0);
-//	ThreadSafe_End();
-// If the user retrieves expressions with GenerateEvent, the ThreadSafe_End is not run
-// until after they retrieve the variables. So of course the while loop in ThreadSafe_Start
-// runs without stopping.
-// PushEvent is slower, being called on next MMF loop, which means the expressions are accessed
-// after: No "infinite-while-loop" problem.
-// So here we have the caller type:
-#define CallEvent PushEvent
-
-//Define struct used to export data from actions to threads
-struct Params
+// Jobs run on a pool of worker threads, and only touch rdPtr through jobLock.
+// When a job finishes, its result is queued, and HandleRunObject runs its event on the Fusion thread,
+// so each event sees its own job's results, even if several jobs finish in the same frame.
+
+// Fills in the statistics returned by ReturnedString$() after a job succeeds
+static void SetStatistics(const Job &job, JobResult &result, unsigned int buffersize, unsigned __int64 total_read, unsigned __int64 total_written)
 {
-	char para_infilename [MAX_PATH];  // Input file name
-	char para_outfilename [MAX_PATH]; // Output file name
-	bool para_UseAppend;			  // If true, append; otherwise (over)write output
-	LPRDATA para_rdPtr;				//rdPtr (must be given or threads cannot access rdPtr)
-};
+	result.success = true;
+	result.PercentageDifference = (total_written * (1.0 / total_read)) * 100.0;
 
-//Calculate file size
-unsigned long file_size(char *filename) {
-	FILE *pFile = NULL;
-	if (fopen_s(&pFile, filename, "rb"))  // Open file
-		return 0;						// If handle has a problem, return 0, eg no file
-	fseek(pFile, 0, SEEK_END);		  // If not, goto end of file
-	unsigned long size = ftell(pFile);	//Get position (Must be stored so fclose can be run)
-	fclose(pFile);					  // Close file
-	return size;						 // Return
+	stringstream temp;
+	temp <<"Buffer used: "
+		 << buffersize
+		 <<", total bytes read: "
+		 << total_read
+		 <<", total bytes written: "
+		 << total_written
+		 <<(job.compress ? ", compression rate: " : ", decompression rate: ")
+		 << result.PercentageDifference
+		 <<"%.";
+	result.message = temp.str();
 }
 
-bool FileSizeCheck(char *infilename, LPRDATA rdPtr)
+// Opens the input file, and reads its size from the handle
+static int OpenInput(Job &job, JobResult &result, __int64 &insize)
 {
-	if (file_size(infilename) < 1)
+	int infile = -1;
+	if (_sopen_s(&infile, job.infilename.c_str(), _O_RDONLY | _O_BINARY | _O_SEQUENTIAL, _SH_DENYWR, 0))
 	{
-		ThreadSafe_Start();
-		rdPtr -> returnstring = "Input file size 0 or nonexistent.";
-		ThreadSafe_End();
-		return true;
+		result.message = "Input file size 0 or nonexistent.";
+		return -1;
 	}
-	else
-		return false;
+	insize = _filelengthi64(infile);
+	if (insize < 1)
+	{
+		_close(infile);
+		result.message = "Input file size 0 or nonexistent.";
+		return -1;
+	}
+	job.total = insize;
+	return infile;
 }
 
-bool HandleCheck(FILE *file, gzFile gzfile, LPRDATA rdPtr)
+// Opens the output file, and reads its size from the handle; if using Write, it'll be 0
+static int OpenOutput(Job &job, JobResult &result, __int64 &PreviousOutputSize)
 {
-	if (!file)
-	{
-		ThreadSafe_Start();
-		rdPtr -> returnstring = "Input file malfunctioned.";
-		gzclose(gzfile);
-		ThreadSafe_End();
-		return true;
-	}
-	else if (!gzfile)
+	int outfile = -1;
+	if (_sopen_s(&outfile, job.outfilename.c_str(), _O_WRONLY | _O_CREAT | _O_BINARY | (job.append ? _O_APPEND : _O_TRUNC),
+		_SH_DENYWR, _S_IREAD | _S_IWRITE))
 	{
-		ThreadSafe_Start();
-		rdPtr -> returnstring = "Output file malfunctioned.";
-		fclose(file);
-		ThreadSafe_End();
-		return true;
+		result.message = "Output file malfunctioned.";
+		return -1;
 	}
-	else
+	PreviousOutputSize = _filelengthi64(outfile);
+	return outfile;
+}
+
+// Closes the output file; if the job didn't finish, takes back what it wrote
+static void CloseOutput(const Job &job, const JobResult &result, int outfile, __int64 PreviousOutputSize)
+{
+	if (!result.success)
+		_chsize_s(outfile, PreviousOutputSize);
+	_close(outfile);
+	if (!result.success && !job.append)
+		remove(job.outfilename.c_str());
+}
+
+// Allocates a job's read buffer, of up to 64MB. Jobs run on a worker thread, where a throw would end
+// the program, so running out of memory fails the job and runs its On error event instead.
+static std::unique_ptr<char[]> AllocateBuffer(JobResult &result, unsigned int buffersize)
+{
+	std::unique_ptr<char[]> buffer(new (std::nothrow) char[buffersize]);
+	if (!buffer)
 	{
-		return false;
+		stringstream temp;
+		temp << "Not enough memory for a buffer of " << buffersize << " bytes.";
+		result.message = temp.str();
 	}
+	return buffer;
 }
 
+static void parallel_compress_one_file(Job &job, JobResult &result, ThreadPool &blockPool, __int64 insize, int infile);
+static const unsigned int ParallelBlockSize = 128 * 1024;
+
 //Compress a file
-DWORD WINAPI compress_one_file(Params *pDataArray)
+static void compress_one_file(Job &job, JobResult &result, ThreadPool * blockPool)
 {
-	//Open struct and set variables
-	char *infilename = new char [MAX_PATH];			 // Get input file name
-	strcpy_s(infilename, MAX_PATH, pDataArray -> para_infilename);
-	char *outfilename = new char [MAX_PATH];			 // Get output file name
-	strcpy_s(outfilename, MAX_PATH, pDataArray -> para_outfilename);
-	bool UseAppend = pDataArray -> para_UseAppend;	  // G et whether to append or write
-	LPRDATA rdPtr = pDataArray -> para_rdPtr;			//Get rdPtr
-	delete pDataArray;								  // Container is expendable
-
-	char * WriteType = "wb9";		//User is using write (overwriting)
-	if (UseAppend) WriteType = "ab9"; // User is using append
-
-	//Check input file size - no handles to close
-	if (FileSizeCheck(infilename, rdPtr)) {Terminate();}
-
-	//Open handles to both files
-	FILE *infile = fopen(infilename, "rb");	  // r = read, b = binary
-	gzFile outfile = gzopen(outfilename, WriteType); // a = append (or w=write), b = binary, 9 = max compression
-
-	//Check handles - HandleCheck() automatically closes handles if invalid
-	if (HandleCheck(infile, outfile, rdPtr)) {Terminate();}
-
-	//Declare variables
-	unsigned long PreviousOutputSize = 0; // For calculation purposes
-	signed int num_read = 0;
-	unsigned long total_read = 0;
-	ThreadSafe_Start();
-	unsigned short tempinbuffersize = rdPtr -> inbuffersize;
-	ThreadSafe_End();
-
-	//If using Write, output size should not be included in the calculation later. Otherwise:
-	if (UseAppend) PreviousOutputSize = file_size(outfilename);
+	__int64 insize, PreviousOutputSize;
+	const int infile = OpenInput(job, result, insize);
+	if (infile == -1)
+		return;
+	if (blockPool && insize > ParallelBlockSize)
+		return parallel_compress_one_file(job, result, *blockPool, insize, infile);
 
 	//This makes sure that the buffer is the right size - if too large, set buffer smaller
-	if ( file_size(infilename) < tempinbuffersize)
-		tempinbuffersize = (unsigned short)file_size(infilename);
+	const unsigned int buffersize = (unsigned int)(std::min)((__int64)job.buffersize, insize);
+	std::unique_ptr<char[]> inbuffer = AllocateBuffer(result, buffersize);
+	if (!inbuffer)
+		return (void)_close(infile);
+
+	const int outfile = OpenOutput(job, result, PreviousOutputSize);
+	if (outfile == -1)
+		return (void)_close(infile);
+
+	// gzclose() closes the handle it's given, so keep a duplicate to measure and close the output with
+	int outfilekeep = _dup(outfile);
+	gzFile gzoutfile = outfilekeep == -1 ? NULL : gzdopen(outfile, job.append ? "ab9" : "wb9"); // 9 = max compression
+	if (!gzoutfile)
+	{
+		_close(infile);
+		if (outfilekeep == -1)
+			outfilekeep = outfile;
+		else
+			_close(outfile);
+		result.message = "Output file malfunctioned.";
+		return CloseOutput(job, result, outfilekeep, PreviousOutputSize);
+	}
 
-	//Then declare final variable, the buffer
-	char *inbuffer = new char[tempinbuffersize];
+	gzbuffer(gzoutfile, buffersize);
 
 	//Iteration through the files
-	while ((num_read = fread(inbuffer, 1, tempinbuffersize, infile)) > 0)
+	int num_read = 0;
+	unsigned __int64 total_read = 0;
+	bool failed = false;
+	while (!(failed = job.cancel) && (num_read = _read(infile, inbuffer.get(), buffersize)) > 0)
 	{
+		if (gzwrite(gzoutfile, inbuffer.get(), num_read) != num_read)
+		{
+			failed = true;
+			break;
+		}
 		total_read += num_read;
-		gzwrite(outfile, inbuffer, num_read);
+		job.done = total_read;
 	}
+	failed = failed || num_read < 0;
 
-	//Close thread
-	fclose(infile);
-	gzclose(outfile);
-	delete[] inbuffer, infilename, outfilename;
+	//Close handles
+	_close(infile);
+	failed = gzclose(gzoutfile) != Z_OK || failed;
 
-	//Set variables afnter completion
-	ThreadSafe_Start();
-	unsigned long saveoutfilesize = file_size(outfilename);
-	unsigned long saveinfilesize = file_size(infilename);
-	rdPtr -> PercentageDifference = ((file_size(outfilename)-PreviousOutputSize)*(1.0/file_size(infilename)))*100.0;
+	if (job.cancel)
+		result.message = "Job cancelled.";
+	else if (failed)
+		result.message = num_read < 0 ? "Reading input file failed." : "Writing output file failed.";
+	else
+		SetStatistics(job, result, buffersize, total_read, _filelengthi64(outfilekeep) - PreviousOutputSize);
+	CloseOutput(job, result, outfilekeep, PreviousOutputSize);
+}
 
-	stringstream temp;
-	temp <<"Buffer used: "
-		 << tempinbuffersize
-		 <<", total bytes read: "
-		 << file_size(infilename)
-		 <<", total bytes written: "
-		 << file_size(outfilename)-PreviousOutputSize
-		 <<", compression rate: "
-		 << rdPtr -> PercentageDifference
-		 <<"%.";
-	rdPtr -> returnstring = temp.str();
-	temp.flush();
-	rdPtr -> LastOutput = outfilename;
-	rdPtr -> rRd -> PushEvent(0);
-	ThreadSafe_End();
-	return 0;
+// Parallel compression, in the style of pigz: the input is split into blocks, which are deflated
+// on the block pool at the same time. Each block is primed with the 32KB of input before it as its
+// dictionary, so little compression is lost. The blocks end on a sync flush, which pads them out to
+// a whole byte without ending the deflate stream, so they can be written one after another as one
+// normal gzip stream.
+struct Block
+{
+	std::vector<unsigned char> dictionary;	// Last 32KB of the previous block's input
+	std::vector<unsigned char> in;
+	std::vector<unsigned char> out;
+	uLong crc;								// CRC-32 of in
+	bool last;								// Finishes the deflate stream
+	bool done;
+	bool failed;
+};
+
+// Deflated blocks waiting to be written, in order
+struct BlockQueue
+{
+	std::mutex lock;
+	std::condition_variable finished;
+	std::deque<std::shared_ptr<Block>> blocks;
+};
+
+static const unsigned int DictionarySize = 32 * 1024;
+
+// Runs on the block pool
+static void deflate_block(Block &block)
+{
+	block.crc = crc32(crc32(0L, Z_NULL, 0), block.in.data(), (uInt)block.in.size());
+
+	// Raw deflate; the gzip header and trailer are written by parallel_compress_one_file
+	z_stream strm = {};
+	block.failed = deflateInit2(&strm, 9, Z_DEFLATED, -MAX_WBITS, 8, Z_DEFAULT_STRATEGY) != Z_OK;
+	if (block.failed)
+		return;
+	if (!block.dictionary.empty())
+		deflateSetDictionary(&strm, block.dictionary.data(), (uInt)block.dictionary.size());
+
+	// deflateBound() doesn't count the sync flush's empty stored block
+	block.out.resize(deflateBound(&strm, (uLong)block.in.size()) + 64);
+	strm.next_in = block.in.data();
+	strm.avail_in = (uInt)block.in.size();
+	strm.next_out = block.out.data();
+	strm.avail_out = (uInt)block.out.size();
+
+	const int ret = deflate(&strm, block.last ? Z_FINISH : Z_SYNC_FLUSH);
+	block.failed = block.last ? ret != Z_STREAM_END : (ret != Z_OK || strm.avail_in != 0 || strm.avail_out == 0);
+	block.out.resize(strm.total_out);
+	deflateEnd(&strm);
 }
 
-//Decompress a file
-DWORD WINAPI decompress_one_file(Params *pDataArray)
+static bool write_all(int outfile, const void * data, unsigned int size)
 {
-	//Open struct and set variables
-	char *infilename = new char [MAX_PATH];			 // Get input file name
-	strcpy_s(infilename, MAX_PATH, pDataArray -> para_infilename);
-	char *outfilename = new char [MAX_PATH];			 // Get output file name
-	strcpy_s(outfilename, MAX_PATH, pDataArray -> para_outfilename);
-	bool UseAppend = pDataArray -> para_UseAppend;	  // Get whether to append or write
-	LPRDATA rdPtr = pDataArray -> para_rdPtr;			//Get rdPtr
-	delete pDataArray;								  // Container is expendable
-
-	char * WriteType = "wb";		//User is using write (overwriting)
-	if (UseAppend) WriteType = "ab"; // User is using append
-
-	if (FileSizeCheck(infilename, rdPtr)) {Terminate();}
-	//Open handles to both files
-	gzFile infile = gzopen(infilename, "rb"); // r = read, b = binary
-	FILE *outfile = fopen(outfilename, WriteType); // a = append or w = write, b = binary
-
-	if (HandleCheck(outfile, infile, rdPtr)) {Terminate();}
-	//Declare variables
-	unsigned long PreviousOutputSize = 0; // For calculation purposes
-	int num_read = 0;
-	unsigned long total_read = 0;
-	ThreadSafe_Start();
-	unsigned short tempinbuffersize = rdPtr -> inbuffersize;
-	ThreadSafe_End();
+	return _write(outfile, data, size) == (int)size;
+}
+
+//Compress a file, using all cores
+static void parallel_compress_one_file(Job &job, JobResult &result, ThreadPool &blockPool, __int64 insize, int infile)
+{
+	__int64 PreviousOutputSize;
+	const int outfile = OpenOutput(job, result, PreviousOutputSize);
+	if (outfile == -1)
+		return (void)_close(infile);
+
+	// Gzip header: magic, deflate, no flags, no time, max compression, NTFS
+	static const unsigned char header[10] = { 0x1f, 0x8b, 8, 0, 0, 0, 0, 0, 2, 11 };
+	bool failed = !write_all(outfile, header, sizeof(header));
+	unsigned __int64 total_written = sizeof(header);
+
+	// Read ahead enough to keep every core busy, but no further, to keep memory use bounded
+	const size_t maxBlocksInFlight = blockPool.ThreadCount() * 2 + 2;
+	std::shared_ptr<BlockQueue> queue = std::make_shared<BlockQueue>();
+	std::shared_ptr<Block> previous;
+	uLong crc = crc32(0L, Z_NULL, 0);
+	unsigned __int64 total_read = 0;
+	bool readfailed = false, allread = false;
+
+	while (true)
+	{
+		// Queue blocks until there's enough in flight, or the input runs out
+		while (!failed && !allread && !job.cancel && queue->blocks.size() < maxBlocksInFlight)
+		{
+			std::shared_ptr<Block> block = std::make_shared<Block>();
+			block->in.resize(ParallelBlockSize);
+			const int num_read = _read(infile, block->in.data(), ParallelBlockSize);
+			if (num_read < 0)
+			{
+				readfailed = failed = true;
+				break;
+			}
+			block->in.resize(num_read);
+			total_read += num_read;
+			allread = total_read >= (unsigned __int64)insize || num_read == 0;
+			block->last = allread;
+			block->done = block->failed = false;
+
+			if (previous)
+			{
+				const size_t dictionarySize = (std::min)(previous->in.size(), (size_t)DictionarySize);
+				block->dictionary.assign(previous->in.end() - dictionarySize, previous->in.end());
+			}
+			previous = block;
+
+			{
+				std::lock_guard<std::mutex> lock(queue->lock);
+				queue->blocks.push_back(block);
+			}
+			blockPool.Submit([queue, block] {
+				deflate_block(*block);
+				std::lock_guard<std::mutex> lock(queue->lock);
+				block->done = true;
+				queue->finished.notify_one();
+			});
+		}
+
+		// Write out the oldest block when it's ready; on failure or cancel, just let the rest finish
+		std::shared_ptr<Block> block;
+		{
+			std::unique_lock<std::mutex> lock(queue->lock);
+			if (queue->blocks.empty())
+				break;
+			block = queue->blocks.front();
+			queue->finished.wait(lock, [&block] { return block->done; });
+			queue->blocks.pop_front();
+		}
+		if (failed || job.cancel)
+			continue;
+
+		failed = block->failed || !write_all(outfile, block->out.data(), (unsigned int)block->out.size());
+		total_written += block->out.size();
+		crc = crc32_combine(crc, block->crc, (z_off_t)block->in.size());
+		job.done += block->in.size();
+	}
+	_close(infile);
+
+	// Gzip trailer: CRC-32 and input size, little-endian
+	if (!failed && !job.cancel)
+	{
+		const unsigned char trailer[8] = {
+			(unsigned char)crc, (unsigned char)(crc >> 8), (unsigned char)(crc >> 16), (unsigned char)(crc >> 24),
+			(unsigned char)total_read, (unsigned char)(total_read >> 8), (unsigned char)(total_read >> 16), (unsigned char)(total_read >> 24)
+		};
+		failed = !write_all(outfile, trailer, sizeof(trailer));
+		total_written += sizeof(trailer);
+	}
+
+	if (job.cancel)
+		result.message = "Job cancelled.";
+	else if (failed)
+		result.message = readfailed ? "Reading input file failed." : "Writing output file failed.";
+	else
+		SetStatistics(job, result, ParallelBlockSize, total_read, total_written);
+	CloseOutput(job, result, outfile, PreviousOutputSize);
+}
 
-	//If using Write, output size should not be included in the calculation later. Otherwise:
-	if (UseAppend) PreviousOutputSize = file_size(outfilename);
+//Decompress a file
+static void decompress_one_file(Job &job, JobResult &result)
+{
+	__int64 insize, PreviousOutputSize;
+	const int infile = OpenInput(job, result, insize);
+	if (infile == -1)
+		return;
 
 	//This makes sure that the buffer is the right size - if too large, set buffer smaller
-	if ( file_size(infilename) < tempinbuffersize)
-		tempinbuffersize = (unsigned short)file_size(infilename);
+	const unsigned int buffersize = (unsigned int)(std::min)((__int64)job.buffersize, insize);
+	std::unique_ptr<char[]> inbuffer = AllocateBuffer(result, buffersize);
+	if (!inbuffer)
+		return (void)_close(infile);
+
+	// gzclose() closes infile
+	gzFile gzinfile = gzdopen(infile, "rb");
+	if (!gzinfile)
+	{
+		_close(infile);
+		result.message = "Input file malfunctioned.";
+		return;
+	}
+	const int outfile = OpenOutput(job, result, PreviousOutputSize);
+	if (outfile == -1)
+		return (void)gzclose(gzinfile);
 
-	//Then declare final variable, the buffer
-	char *inbuffer = new char[tempinbuffersize];
+	gzbuffer(gzinfile, buffersize);
 
 	//Iteration through the files
-	while ((num_read = gzread(infile, inbuffer, tempinbuffersize)) > 0)
+	int num_read = 0;
+	unsigned __int64 total_written = 0;
+	bool failed = false;
+	while (!(failed = job.cancel) && (num_read = gzread(gzinfile, inbuffer.get(), buffersize)) > 0)
 	{
-		total_read += num_read;
-		fwrite(inbuffer, 1, num_read, outfile);
+		if (_write(outfile, inbuffer.get(), num_read) != num_read)
+		{
+			failed = true;
+			break;
+		}
+		total_written += num_read;
+		job.done = gzoffset(gzinfile);
 	}
 
-	//Close thread
-	gzclose(infile);
-	fclose(outfile);
-	delete[] inbuffer, infilename, outfilename;
+	if (job.cancel)
+		result.message = "Job cancelled.";
+	else if (num_read < 0)
+	{
+		int errnum;
+		result.message = string("Reading input file failed: ") + gzerror(gzinfile, &errnum);
+	}
+	else if (failed)
+		result.message = "Writing output file failed.";
+	else
+		SetStatistics(job, result, buffersize, insize, total_written);
 
-	//Set variables after completion
-	ThreadSafe_Start();
-	rdPtr -> PercentageDifference = ((file_size(outfilename)-PreviousOutputSize)*(1.0/file_size(infilename)))*100.0;
-	stringstream temp;
-	temp <<"Buffer used: "
-		 << tempinbuffersize
-		 <<", total bytes read: "
-		 << file_size(infilename)
-		 <<", total bytes written: "
-		 << file_size(outfilename)-PreviousOutputSize
-		 <<", decompression rate: "
-		 << rdPtr -> PercentageDifference
-		 <<"%.";
-	rdPtr -> returnstring = temp.str();
-	temp.flush();
-	rdPtr -> LastOutput = outfilename;
-	rdPtr -> rRd -> CallEvent(0);
-	ThreadSafe_End();
-	return 0;
+	//Close handles
+	gzclose(gzinfile);
+	CloseOutput(job, result, outfile, PreviousOutputSize);
 }
 
+// Runs on a worker thread
+static void RunJob(LPRDATA rdPtr, std::shared_ptr<Job> job)
+{
+	JobResult result = { false, "", 0.0, job->outfilename };
+	if (job->cancel)
+		result.message = "Job cancelled.";
+	else if (job->compress)
+		compress_one_file(*job, result, job->parallel ? rdPtr->blockPool : NULL);
+	else
+		decompress_one_file(*job, result);
+
+	std::lock_guard<std::mutex> lock(rdPtr->jobLock);
+	rdPtr->jobs.erase(job->id);
+	rdPtr->results.push_back(std::move(result));
+}
+
+static void QueueJob(LPRDATA rdPtr, bool compress, const char * infilename, const char * outfilename, bool append)
+{
+	std::shared_ptr<Job> job = std::make_shared<Job>();
+	job->id = ++rdPtr->lastJobID;
+	job->compress = compress;
+	job->append = append;
+	job->infilename = infilename;
+	job->outfilename = outfilename;
+	job->buffersize = rdPtr->inbuffersize;
+	job->parallel = rdPtr->parallel;
+	{
+		std::lock_guard<std::mutex> lock(rdPtr->jobLock);
+		rdPtr->jobs[job->id] = job;
+	}
+
+	// One worker per core; compression level 9 is mostly CPU-bound
+	if (!rdPtr->pool)
+		rdPtr->pool = new ThreadPool(std::thread::hardware_concurrency());
+	// Blocks have their own pool, so jobs waiting on their blocks can't hold up the blocks
+	if (job->parallel && !rdPtr->blockPool)
+		rdPtr->blockPool = new ThreadPool(std::thread::hardware_concurrency());
+	rdPtr->pool->Submit([rdPtr, job] { RunJob(rdPtr, job); });
+}
 
 // ============================================================================
 //
@@ -299,18 +464,17 @@ ACTION(
 	/* ID */		2,
 	/* Name */	  "Set buffer size to %0 bytes",
 	/* Flags */	 0,
-	/* Params */	(1, PARAM_NUMBER, "Buffer size (1 to 16384 bytes):")
+	/* Params */	(1, PARAM_NUMBER, "Buffer size (1 to 67108864 bytes):")
 ) {
 	int p1 = Param(TYPE_INT);
-	ThreadSafe_Start();
-	if (p1 > 0 && p1 < 16385)
+	// Applies to jobs queued from now on
+	if (p1 > 0 && p1 <= 64 * 1024 * 1024)
 		rdPtr -> inbuffersize = p1;
 	else
 	{
-		rdPtr -> returnstring = "Buffer is an invalid size. Must be between 0 and 16385 (exclusive).";
-		rdPtr -> rRd -> CallEvent(1);
+		rdPtr -> returnstring = "Buffer is an invalid size. Must be between 1 and 67108864 (inclusive).";
+		rdPtr -> rRd -> GenerateEvent(1);
 	}
-	ThreadSafe_End();
 }
 
 ACTION(
@@ -324,20 +488,7 @@ ACTION(
 	char *p2 = (char *) Param(TYPE_STRING);
 	int p3 = Param(TYPE_INT);
 
-	//Set bool for simplicity
-	bool temp = false;
-	if (p3 != 0)
-		temp = true;
-
-	//Declare struct and set variables in struct
-	Params* Parameters = new Params;						  // Declaration
-	strcpy_s(Parameters -> para_infilename, MAX_PATH, p1);  // Pass the input file name
-	strcpy_s(Parameters -> para_outfilename, MAX_PATH, p2); // Pass the output file name
-	Parameters -> para_UseAppend = temp;					  // Pass the append command
-	Parameters -> para_rdPtr = rdPtr;						 // Pass rdPtr
-
-	//Create thread
-	CreateThread(NULL, 0, (LPTHREAD_START_ROUTINE)&compress_one_file, Parameters, 0, NULL);
+	QueueJob(rdPtr, true, p1, p2, p3 != 0);
 }
 
 ACTION(
@@ -351,20 +502,44 @@ ACTION(
 	char *p2 = (char *) Param(TYPE_STRING);
 	int p3 = Param(TYPE_INT);
 
-	//Set bool for simplicity
-	bool temp = false;
-	if (p3 != 0)
-		temp = true;
+	QueueJob(rdPtr, false, p1, p2, p3 != 0);
+}
 
-	//Declare struct and set variables in struct
-	Params* Parameters = new Params;	 // Declaration
-	strcpy_s(Parameters -> para_infilename, MAX_PATH, p1);  // Pass the input file name
-	strcpy_s(Parameters -> para_outfilename, MAX_PATH, p2); // Pass the output file name
-	Parameters -> para_UseAppend = temp;					  // Pass the append command
-	Parameters -> para_rdPtr = rdPtr;						 // Pass rdPtr
+ACTION(
+	/* ID */		5,
+	/* Name */	  "Cancel job %0",
+	/* Flags */	 0,
+	/* Params */	(1, PARAM_NUMBER, "Job ID (from LastJobID()):")
+) {
+	int p1 = Param(TYPE_INT);
 
-	//Create thread
-	CreateThread(NULL, 0, (LPTHREAD_START_ROUTINE)&decompress_one_file, Parameters, 0, NULL);
+	// The job runs its On error event when it stops
+	std::lock_guard<std::mutex> lock(rdPtr -> jobLock);
+	std::map<int, std::shared_ptr<Job>>::iterator job = rdPtr -> jobs.find(p1);
+	if (job != rdPtr -> jobs.end())
+		job -> second -> cancel = true;
+}
+
+ACTION(
+	/* ID */		6,
+	/* Name */	  "Cancel all jobs",
+	/* Flags */	 0,
+	/* Params */	(0)
+) {
+	std::lock_guard<std::mutex> lock(rdPtr -> jobLock);
+	for (auto &job : rdPtr -> jobs)
+		job.second -> cancel = true;
+}
+
+ACTION(
+	/* ID */		7,
+	/* Name */	  "Set parallel compression to %0",
+	/* Flags */	 0,
+	/* Params */	(1, PARAM_NUMBER, "Compress files over 128KB on all cores? (0 for no, 1 for yes)")
+) {
+	int p1 = Param(TYPE_INT);
+	// Applies to jobs queued from now on
+	rdPtr -> parallel = p1 != 0;
 }
 
 // ============================================================================
@@ -390,10 +565,7 @@ EXPRESSION(
 	/* Flags */	 EXPFLAG_STRING,
 	/* Params */	(0)
 ) {
-	ThreadSafe_Start();
-	string temp = rdPtr -> returnstring;
-	ThreadSafe_End();
-	ReturnStringSafe(temp.c_str());
+	ReturnStringSafe(rdPtr -> returnstring.c_str());
 }
 
 EXPRESSION(
@@ -402,10 +574,7 @@ EXPRESSION(
 	/* Flags */	 0,
 	/* Params */	(0)
 ) {
-	ThreadSafe_Start();
-	unsigned short temp = rdPtr -> inbuffersize;
-	ThreadSafe_End();
-	return temp;
+	return rdPtr -> inbuffersize;
 }
 
 EXPRESSION(
@@ -414,9 +583,7 @@ EXPRESSION(
 	/* Flags */	 EXPFLAG_DOUBLE,
 	/* Params */	(0)
 ) {
-	ThreadSafe_Start();
 	double temp = rdPtr -> PercentageDifference;
-	ThreadSafe_End();
 	//This casts to 2 decimal places
 	char sprintfdest[20];
 	sprintf(sprintfdest,"%.2f", temp);
@@ -432,8 +599,46 @@ EXPRESSION(
 	/* Flags */	 EXPFLAG_STRING,
 	/* Params */	(0)
 ) {
-	ThreadSafe_Start();
-	string temp = rdPtr -> LastOutput;
-	ThreadSafe_End();
-	ReturnStringSafe(temp.c_str());
+	ReturnStringSafe(rdPtr -> LastOutput.c_str());
+}
+
+EXPRESSION(
+	/* ID */		5,
+	/* Name */	  "LastJobID(",
+	/* Flags */	 0,
+	/* Params */	(0)
+) {
+	return rdPtr -> lastJobID;
+}
+
+EXPRESSION(
+	/* ID */		6,
+	/* Name */	  "JobProgress(",
+	/* Flags */	 EXPFLAG_DOUBLE,
+	/* Params */	(1, EXPPARAM_NUMBER, "Job ID")
+) {
+	int p1 = ExParam(TYPE_INT);
+
+	// -1 if the job isn't queued or running
+	float progress = -1.0f;
+	{
+		std::lock_guard<std::mutex> lock(rdPtr -> jobLock);
+		std::map<int, std::shared_ptr<Job>>::iterator job = rdPtr -> jobs.find(p1);
+		if (job != rdPtr -> jobs.end())
+		{
+			const unsigned __int64 total = job -> second -> total;
+			progress = total ? (float)((job -> second -> done * 100.0) / total) : 0.0f;
+		}
+	}
+	ReturnFloat(progress);
+}
+
+EXPRESSION(
+	/* ID */		7,
+	/* Name */	  "JobCount(",
+	/* Flags */	 0,
+	/* Params */	(0)
+) {
+	std::lock_guard<std::mutex> lock(rdPtr -> jobLock);
+	return (long)rdPtr -> jobs.size();
 }
\ No newline at end of file
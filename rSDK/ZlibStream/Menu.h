@@ -46,7 +46,11 @@
 	ITEM(3,"Compress a file")
 	ITEM(4,"Decompress a file")
 	SEPARATOR
+	ITEM(5,"Cancel a job")
+	ITEM(6,"Cancel all jobs")
+	SEPARATOR
 	ITEM(2,"Set buffer size (bytes)")
+	ITEM(7,"Set parallel compression")
 	SEPARATOR
 #endif
 
@@ -61,6 +65,10 @@
 	ITEM(3,"Last percentage difference")
 	ITEM(4,"Last output filename")
 	SEPARATOR
+	ITEM(5,"Last queued job ID")
+	ITEM(6,"Job progress (percentage)")
+	ITEM(7,"Number of queued and running jobs")
+	SEPARATOR
 	ITEM(2,"Current buffer size (bytes)")
 	SEPARATOR
 #endif
\ No newline at end of file
@@ -54,6 +54,15 @@ short WINAPI DLLExport DestroyRunObject(LPRDATA rdPtr, long fast)
 		the frame) this routine is called. You must free any resources you have allocated!
 		See Graphic_Object_Ex.txt for an example of what you may put here.
 	*/
+	// Stop the jobs: queued ones are dropped, running ones stop at their next read
+	{
+		std::lock_guard<std::mutex> lock(rdPtr->jobLock);
+		for (auto &job : rdPtr->jobs)
+			job.second->cancel = true;
+	}
+	delete rdPtr->pool; // Waits for the workers
+	delete rdPtr->blockPool; // After pool, as jobs in it wait on their blocks
+
 	// No errors
 	delete rdPtr->rRd;
 	rdPtr->~RUNDATA();
@@ -66,7 +75,25 @@ short WINAPI DLLExport DestroyRunObject(LPRDATA rdPtr, long fast)
 //
 short WINAPI DLLExport HandleRunObject(LPRDATA rdPtr)
 {
-		//Needs to add fixed value to vector array
+	// Run the events of finished jobs, one at a time, so each sees its own results
+	while (true)
+	{
+		JobResult result;
+		{
+			std::lock_guard<std::mutex> lock(rdPtr->jobLock);
+			if (rdPtr->results.empty())
+				break;
+			result = std::move(rdPtr->results.front());
+			rdPtr->results.pop_front();
+		}
+
+		rdPtr->returnstring = result.message;
+		rdPtr->LastOutput = result.outfilename;
+		if (result.success)
+			rdPtr->PercentageDifference = result.PercentageDifference;
+		rdPtr->rRd->GenerateEvent(result.success ? 0 : 1);
+	}
+
 	/*
 		If your extension will draw to the MMF window you should first
 		check if anything about its display has changed :
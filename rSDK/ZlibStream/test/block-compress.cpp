@@ -0,0 +1,238 @@
+// Test and benchmark for ZlibStream's parallel block compression (Main.cpp), built with Linux stand-ins
+// in include/Common.h.
+//
+// Compresses inputs around each of several block sizes, from 1 byte to 1MB, on block pools of 1 to
+// 8 threads, and checks each output is one gzip stream that "gzip -t" accepts, if gzip is installed,
+// and that zlib's inflate reads back the same as the input, CRC and length included. The sizes cover
+// a single byte, exactly one block, one byte over, exact multiples, and a short last block. An empty
+// input is refused without making an output file. "make check-tsan" runs it with ThreadSanitizer.
+//
+// Then times compressing a larger input on one thread without blocks, and on block pools of each
+// thread count, in MB/s of input.
+//
+// Usage: block-compress [-t max threads] [-m MB] folder
+
+#include "Main.cpp"
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <random>
+
+static int failures = 0;
+
+static void check(bool passed, const char * what)
+{
+	printf("%s: %s\n", passed ? "pass" : "FAIL", what);
+
+	if (!passed)
+		++failures;
+}
+
+static bool ReadFile(const std::string &Path, std::string &Data)
+{
+	FILE * File = fopen(Path.c_str(), "rb");
+	if (!File)
+		return false;
+	Data.clear();
+	char Buffer[64 * 1024];
+	size_t Read;
+	while ((Read = fread(Buffer, 1, sizeof(Buffer), File)) > 0)
+		Data.append(Buffer, Read);
+	fclose(File);
+	return true;
+}
+
+static bool WriteFile(const std::string &Path, const std::string &Data)
+{
+	FILE * File = fopen(Path.c_str(), "wb");
+	const bool Written = File && fwrite(Data.data(), 1, Data.size(), File) == Data.size();
+	if (File)
+		fclose(File);
+	return Written;
+}
+
+// Text-like data with the odd run of random bytes, so blocks are neither all alike nor incompressible
+static std::string MakeData(size_t Size, unsigned int Seed)
+{
+	static const char * const Words[] = { "player", "score", "level", "x", "y", "health", "inventory",
+		"item", "name", "enemy", "position", "speed", "\n", "=", ",", "{", "}" };
+	std::mt19937 Random(Seed);
+	std::string Data;
+	Data.reserve(Size + 32);
+	while (Data.size() < Size)
+	{
+		const unsigned int Pick = Random() % 40;
+		if (Pick < sizeof(Words) / sizeof(*Words))
+			Data += Words[Pick];
+		else if (Pick < 38)
+			Data += std::to_string(Random() % 10000);
+		else
+			for (int i = 0; i < 16; ++i)
+				Data += (char)Random();
+		Data += ' ';
+	}
+	Data.resize(Size);
+	return Data;
+}
+
+// Reads the gzip stream with zlib, checking it holds exactly the input, and nothing follows it
+static bool Inflates(const std::string &Compressed, const std::string &Input)
+{
+	z_stream strm = {};
+	if (inflateInit2(&strm, 16 + MAX_WBITS) != Z_OK)
+		return false;
+	std::string Output(Input.size() + 1, '\0');
+	strm.next_in = (Bytef *)Compressed.data();
+	strm.avail_in = (uInt)Compressed.size();
+	strm.next_out = (Bytef *)&Output[0];
+	strm.avail_out = (uInt)Output.size();
+	const bool Same = inflate(&strm, Z_FINISH) == Z_STREAM_END && strm.avail_in == 0 &&
+		strm.total_out == Input.size() && !memcmp(Output.data(), Input.data(), Input.size());
+	inflateEnd(&strm);
+	return Same;
+}
+
+static bool HaveGzip;
+
+// Compresses Input on the block pool, and checks the output; prints what went wrong
+static bool CompressesSame(const std::string &Folder, const std::string &Input, ThreadPool * BlockPool)
+{
+	const std::string In = Folder + "/in", Out = Folder + "/in.gz";
+	WriteFile(In, Input);
+	Job job;
+	job.compress = true;
+	job.infilename = In;
+	job.outfilename = Out;
+	job.buffersize = 256 * 1024;
+	JobResult result = { false, "", 0.0, Out };
+	compress_one_file(job, result, BlockPool);
+
+	// Inputs over a block are split into blocks; their gzip header is written by
+	// parallel_compress_one_file, which gives NTFS (11) as the OS, where zlib gives the system's
+	const bool Blocks = BlockPool && Input.size() > ParallelBlockSize;
+	std::string Compressed;
+	const char * Problem = NULL;
+	if (!result.success)
+		Problem = result.message.c_str();
+	else if (!ReadFile(Out, Compressed) || Compressed.size() < 10)
+		Problem = "no output";
+	else if (Blocks != (Compressed[9] == 11))
+		Problem = Blocks ? "not compressed in blocks" : "compressed in blocks";
+	else if (!Inflates(Compressed, Input))
+		Problem = "zlib doesn't inflate it to the input";
+	else if (HaveGzip && system(("gzip -t '" + Out + "'").c_str()) != 0)
+		Problem = "gzip -t rejects it";
+
+	if (Problem)
+		printf("  %zu bytes, blocks of %u, %u threads: %s\n", Input.size(), ParallelBlockSize,
+			BlockPool ? BlockPool->ThreadCount() : 0, Problem);
+	return !Problem;
+}
+
+int main(int argc, char ** argv)
+{
+	unsigned int MaxThreads = 8;
+	double MB = 32;
+	int Option;
+
+	while ((Option = getopt(argc, argv, "t:m:")) != -1)
+	{
+		switch (Option)
+		{
+			case 't': MaxThreads = std::max(1, atoi(optarg)); break;
+			case 'm': MB = atof(optarg); break;
+			default: optind = argc + 1; break;
+		}
+	}
+	if (optind + 1 != argc || MB <= 0)
+	{
+		fprintf(stderr, "Usage: block-compress [-t max threads] [-m MB] folder\n");
+		return 2;
+	}
+	const std::string Folder = argv[optind];
+	system(("mkdir -p '" + Folder + "'").c_str());
+	HaveGzip = system("gzip --version > /dev/null 2>&1") == 0;
+	if (!HaveGzip)
+		printf("  gzip isn't installed, so output is only checked with zlib\n");
+
+	std::vector<unsigned int> ThreadCounts;
+	for (unsigned int Threads = 1; Threads <= MaxThreads; Threads *= 2)
+		ThreadCounts.push_back(Threads);
+
+	// Sizes around each block size, on each thread count
+	const unsigned int DefaultBlockSize = ParallelBlockSize;
+	const unsigned int BlockSizes[] = { 1, 4096, DictionarySize, 100000, DefaultBlockSize, 1024 * 1024 };
+	for (unsigned int Threads : ThreadCounts)
+	{
+		ThreadPool BlockPool(Threads);
+		bool Same = true;
+		for (unsigned int BlockSize : BlockSizes)
+		{
+			ParallelBlockSize = BlockSize;
+			const size_t Sizes[] = { 1, 2, BlockSize, BlockSize + 1, 3 * (size_t)BlockSize, 3 * (size_t)BlockSize + 7 };
+			for (size_t Size : Sizes)
+				Same = CompressesSame(Folder, MakeData(Size, 20261019 + (unsigned int)Size), &BlockPool) && Same;
+		}
+		ParallelBlockSize = DefaultBlockSize;
+		Same = CompressesSame(Folder, MakeData(5 * 1024 * 1024 + 3, 20261019), &BlockPool) && Same;
+
+		const std::string What = "blocks of 1 byte to 1MB, on " + std::to_string(Threads) +
+			" threads, make one gzip stream that reads back the same";
+		check(Same, What.c_str());
+	}
+
+	// Without a block pool, as with parallel compression off
+	check(CompressesSame(Folder, MakeData(1, 1), NULL) && CompressesSame(Folder, MakeData(300000, 1), NULL),
+		"without blocks, the output reads back the same");
+
+	// An empty input
+	{
+		ThreadPool BlockPool(2);
+		const std::string In = Folder + "/empty", Out = Folder + "/empty.gz";
+		WriteFile(In, "");
+		remove(Out.c_str());
+		Job job;
+		job.compress = true;
+		job.infilename = In;
+		job.outfilename = Out;
+		job.buffersize = 256 * 1024;
+		JobResult result = { false, "", 0.0, Out };
+		compress_one_file(job, result, &BlockPool);
+		check(!result.success && result.message == "Input file size 0 or nonexistent." && access(Out.c_str(), F_OK) != 0,
+			"an empty input is refused, and makes no output file");
+	}
+
+	// Timing; not checked, as it depends on the machine
+	const std::string Input = MakeData((size_t)(MB * 1048576), 20261019);
+	const std::string In = Folder + "/timed", Out = Folder + "/timed.gz";
+	WriteFile(In, Input);
+	printf("  %.1f MB, in blocks of %u bytes\n", MB, ParallelBlockSize);
+	for (size_t i = 0; i <= ThreadCounts.size(); ++i)
+	{
+		ThreadPool * BlockPool = i ? new ThreadPool(ThreadCounts[i - 1]) : NULL;
+		Job job;
+		job.compress = true;
+		job.infilename = In;
+		job.outfilename = Out;
+		job.buffersize = 256 * 1024;
+		JobResult result = { false, "", 0.0, Out };
+
+		const auto Start = std::chrono::steady_clock::now();
+		compress_one_file(job, result, BlockPool);
+		const double Time = std::chrono::duration<double>(std::chrono::steady_clock::now() - Start).count();
+		delete BlockPool;
+
+		std::string Compressed;
+		if (!result.success || !ReadFile(Out, Compressed) || !Inflates(Compressed, Input))
+			check(false, "the timed input reads back the same");
+		if (i)
+			printf("  %u threads: %.1f MB/s, %.2f%% of the input\n", ThreadCounts[i - 1], MB / Time, result.PercentageDifference);
+		else
+			printf("  without blocks: %.1f MB/s, %.2f%% of the input\n", MB / Time, result.PercentageDifference);
+	}
+
+	printf(failures ? "%d failed\n" : "all passed\n", failures);
+	return failures ? 1 : 0;
+}
@@ -0,0 +1,65 @@
+// Stands in for ZlibStream's Common.h when building its job code (Main.cpp, up to the conditions)
+// on Linux: the Windows CRT file calls the jobs make, done with their POSIX equivalents, the headers
+// Common.h brings in, and the system zlib in place of the SDK's.
+#pragma once
+#include <errno.h>
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include <zlib.h>
+
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <new>
+#include <sstream>
+#include <string>
+#include <vector>
+using namespace std;
+
+#include "../../../Inc/ThreadPool.h"
+
+#define __int64 long long
+
+#define _O_RDONLY O_RDONLY
+#define _O_WRONLY O_WRONLY
+#define _O_CREAT O_CREAT
+#define _O_APPEND O_APPEND
+#define _O_TRUNC O_TRUNC
+#define _O_BINARY 0
+#define _O_SEQUENTIAL 0
+#define _SH_DENYWR 0
+#define _S_IREAD S_IRUSR
+#define _S_IWRITE S_IWUSR
+
+#define _close close
+#define _dup dup
+#define _read read
+#define _write write
+
+static int _sopen_s(int * fd, const char * name, int flags, int, int mode)
+{
+	*fd = open(name, flags, mode);
+	return *fd == -1 ? errno : 0;
+}
+
+static __int64 _filelengthi64(int fd)
+{
+	struct stat st;
+	return fstat(fd, &st) ? -1 : st.st_size;
+}
+
+static int _chsize_s(int fd, __int64 size)
+{
+	return ftruncate(fd, size) ? errno : 0;
+}
+
+// What Data.h's RUNDATA needs from the SDK; MagicRDATA.h is the real one, from rSDK/Inc
+struct headerObject {};
+struct extHeader {};
+
+#include "../../Data.h"
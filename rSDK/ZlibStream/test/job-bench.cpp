@@ -0,0 +1,259 @@
+// Test and benchmark for ZlibStream's jobs (Main.cpp), built with Linux stand-ins in include/Common.h.
+//
+// Queues compress and decompress jobs as the actions do, on a pool of workers, and checks every file
+// comes back the same after a round trip, with a successful result for every job. Checks a read
+// buffer that can't be allocated fails its job with an error naming the size, and leaves no output,
+// rather than throwing on the worker; and that cancelled jobs fail and leave no output either.
+// "make check-tsan" runs it with ThreadSanitizer.
+//
+// Then times compressing and decompressing the files: with the old 8KB buffer on one worker, as
+// before the pool; with the default 256KB buffer on one worker; and on every worker. In MB/s of
+// uncompressed data.
+//
+// Usage: job-bench [-t threads] [-n files] [-m MB per file] folder
+
+#include "Main.cpp"
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <random>
+#include <thread>
+
+static int failures = 0;
+
+static void check(bool passed, const char * what)
+{
+	printf("%s: %s\n", passed ? "pass" : "FAIL", what);
+
+	if (!passed)
+		++failures;
+}
+
+static bool ReadFile(const std::string &Path, std::string &Data)
+{
+	FILE * File = fopen(Path.c_str(), "rb");
+	if (!File)
+		return false;
+	Data.clear();
+	char Buffer[64 * 1024];
+	size_t Read;
+	while ((Read = fread(Buffer, 1, sizeof(Buffer), File)) > 0)
+		Data.append(Buffer, Read);
+	fclose(File);
+	return true;
+}
+
+static bool WriteFile(const std::string &Path, const std::string &Data)
+{
+	FILE * File = fopen(Path.c_str(), "wb");
+	const bool Written = File && fwrite(Data.data(), 1, Data.size(), File) == Data.size();
+	if (File)
+		fclose(File);
+	return Written;
+}
+
+static bool Exists(const std::string &Path)
+{
+	return access(Path.c_str(), F_OK) == 0;
+}
+
+// Text-like data that compresses about as well as a save file: words from a small vocabulary,
+// with numbers and the odd run of random bytes
+static std::string MakeData(size_t Size, unsigned int Seed)
+{
+	static const char * const Words[] = { "player", "score", "level", "x", "y", "health", "inventory",
+		"item", "name", "enemy", "position", "speed", "\n", "=", ",", "{", "}" };
+	std::mt19937 Random(Seed);
+	std::string Data;
+	Data.reserve(Size + 32);
+	while (Data.size() < Size)
+	{
+		const unsigned int Pick = Random() % 40;
+		if (Pick < sizeof(Words) / sizeof(*Words))
+			Data += Words[Pick];
+		else if (Pick < 38)
+			Data += std::to_string(Random() % 10000);
+		else
+			for (int i = 0; i < 16; ++i)
+				Data += (char)Random();
+		Data += ' ';
+	}
+	Data.resize(Size);
+	return Data;
+}
+
+// Above this size, nothrow new fails, so a job's read buffer can't be allocated
+static std::atomic<size_t> FailAllocationsOver(SIZE_MAX);
+
+void * operator new[](size_t Size, const std::nothrow_t &) noexcept
+{
+	if (Size > FailAllocationsOver)
+		return NULL;
+	try
+	{
+		return ::operator new[](Size);
+	}
+	catch (const std::bad_alloc &)
+	{
+		return NULL;
+	}
+}
+
+// Waits for every queued job, as HandleRunObject checks each frame, and takes their results
+static std::deque<JobResult> Finish(RUNDATA &rd)
+{
+	while (true)
+	{
+		{
+			std::lock_guard<std::mutex> lock(rd.jobLock);
+			if (rd.jobs.empty())
+				return std::move(rd.results);
+		}
+		std::this_thread::sleep_for(std::chrono::milliseconds(1));
+	}
+}
+
+static bool AllSucceeded(const std::deque<JobResult> &Results, size_t Count)
+{
+	bool Succeeded = Results.size() == Count;
+	for (const JobResult &Result : Results)
+	{
+		if (!Result.success)
+			printf("  %s: %s\n", Result.outfilename.c_str(), Result.message.c_str());
+		Succeeded = Succeeded && Result.success;
+	}
+	return Succeeded;
+}
+
+// Compresses and then decompresses every file, with the given buffer size on a pool of the given
+// size; returns the seconds taken by each
+static bool RoundTrip(const std::vector<std::string> &Files, unsigned int BufferSize, unsigned int Threads,
+	double &CompressTime, double &DecompressTime)
+{
+	RUNDATA rd;
+	rd.inbuffersize = BufferSize;
+	rd.pool = new ThreadPool(Threads);
+
+	const auto Start = std::chrono::steady_clock::now();
+	for (const std::string &File : Files)
+		QueueJob(&rd, true, File.c_str(), (File + ".gz").c_str(), false);
+	bool Succeeded = AllSucceeded(Finish(rd), Files.size());
+	const auto Compressed = std::chrono::steady_clock::now();
+
+	for (const std::string &File : Files)
+		QueueJob(&rd, false, (File + ".gz").c_str(), (File + ".out").c_str(), false);
+	Succeeded = AllSucceeded(Finish(rd), Files.size()) && Succeeded;
+	const auto Decompressed = std::chrono::steady_clock::now();
+	delete rd.pool;
+
+	CompressTime = std::chrono::duration<double>(Compressed - Start).count();
+	DecompressTime = std::chrono::duration<double>(Decompressed - Compressed).count();
+	return Succeeded;
+}
+
+int main(int argc, char ** argv)
+{
+	unsigned int Threads = std::max(1U, std::thread::hardware_concurrency());
+	int Count = 8;
+	double MB = 4;
+	int Option;
+
+	while ((Option = getopt(argc, argv, "t:n:m:")) != -1)
+	{
+		switch (Option)
+		{
+			case 't': Threads = std::max(1, atoi(optarg)); break;
+			case 'n': Count = std::max(1, atoi(optarg)); break;
+			case 'm': MB = atof(optarg); break;
+			default: optind = argc + 1; break;
+		}
+	}
+	if (optind + 1 != argc || MB <= 0)
+	{
+		fprintf(stderr, "Usage: job-bench [-t threads] [-n files] [-m MB per file] folder\n");
+		return 2;
+	}
+	const std::string Folder = argv[optind];
+	system(("mkdir -p '" + Folder + "'").c_str());
+
+	std::vector<std::string> Files;
+	for (int i = 0; i < Count; ++i)
+	{
+		Files.push_back(Folder + "/file" + std::to_string(i));
+		WriteFile(Files.back(), MakeData((size_t)(MB * 1048576), 20261019 + i));
+	}
+	const double Total = Count * MB;
+
+	// Round trip on every worker
+	double CompressTime, DecompressTime;
+	check(RoundTrip(Files, 256 * 1024, Threads, CompressTime, DecompressTime), "every compress and decompress job succeeds");
+	bool Same = true;
+	std::string Source, Output;
+	for (const std::string &File : Files)
+		Same = Same && ReadFile(File, Source) && ReadFile(File + ".out", Output) && Source == Output;
+	check(Same, "every file is the same after a round trip");
+
+	// Buffers that can't be allocated
+	{
+		RUNDATA rd;
+		rd.inbuffersize = 64 * 1024 * 1024;
+		rd.pool = new ThreadPool(Threads);
+		const std::string Output = Folder + "/no-memory.gz", Restored = Folder + "/no-memory.out";
+		remove(Output.c_str());
+		remove(Restored.c_str());
+		struct stat Compressed;
+		stat((Files[0] + ".gz").c_str(), &Compressed);
+
+		FailAllocationsOver = 0;
+		QueueJob(&rd, true, Files[0].c_str(), Output.c_str(), false);
+		QueueJob(&rd, false, (Files[0] + ".gz").c_str(), Restored.c_str(), false);
+		std::deque<JobResult> Results = Finish(rd);
+		FailAllocationsOver = SIZE_MAX;
+		delete rd.pool;
+
+		// Each buffer is the smaller of the buffer size and the input file
+		bool Failed = Results.size() == 2;
+		for (const JobResult &Result : Results)
+		{
+			const size_t Size = Result.outfilename == Output ? (size_t)(MB * 1048576) : (size_t)Compressed.st_size;
+			Failed = Failed && !Result.success && Result.message == "Not enough memory for a buffer of " + std::to_string(Size) + " bytes.";
+		}
+		check(Failed, "a buffer that can't be allocated fails the job, naming its size");
+		check(!Exists(Output) && !Exists(Restored), "a job that can't allocate its buffer leaves no output");
+	}
+
+	// Cancelled jobs
+	{
+		RUNDATA rd;
+		rd.pool = new ThreadPool(1);
+		for (int i = 0; i < 4; ++i)
+			QueueJob(&rd, true, Files[i % Count].c_str(), (Folder + "/cancelled" + std::to_string(i) + ".gz").c_str(), false);
+		{
+			std::lock_guard<std::mutex> lock(rd.jobLock);
+			for (auto &job : rd.jobs)
+				job.second->cancel = true;
+		}
+		std::deque<JobResult> Results = Finish(rd);
+		delete rd.pool;
+
+		bool Cancelled = Results.size() == 4;
+		for (int i = 0; i < 4; ++i)
+			Cancelled = Cancelled && !Exists(Folder + "/cancelled" + std::to_string(i) + ".gz");
+		for (const JobResult &Result : Results)
+			Cancelled = Cancelled && !Result.success && Result.message == "Job cancelled.";
+		check(Cancelled, "cancelled jobs fail and leave no output");
+	}
+
+	// Timing; not checked, as it depends on the machine
+	printf("  %d files of %.1f MB\n", Count, MB);
+	RoundTrip(Files, 8 * 1024, 1, CompressTime, DecompressTime);
+	printf("  8KB buffer, 1 worker: compress %.1f MB/s, decompress %.0f MB/s\n", Total / CompressTime, Total / DecompressTime);
+	RoundTrip(Files, 256 * 1024, 1, CompressTime, DecompressTime);
+	printf("  256KB buffer, 1 worker: compress %.1f MB/s, decompress %.0f MB/s\n", Total / CompressTime, Total / DecompressTime);
+	RoundTrip(Files, 256 * 1024, Threads, CompressTime, DecompressTime);
+	printf("  256KB buffer, %u workers: compress %.1f MB/s, decompress %.0f MB/s\n", Threads, Total / CompressTime, Total / DecompressTime);
+
+	printf(failures ? "%d failed\n" : "all passed\n", failures);
+	return failures ? 1 : 0;
+}